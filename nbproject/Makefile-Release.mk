@@ -63,7 +63,31 @@ OBJECTFILES= \
 	${OBJECTDIR}/src/render_e/textures/TextureBase.o \
 	${OBJECTDIR}/src/render_e/math/Vector3.o \
 	${OBJECTDIR}/src/render_e/MeshFactory.o \
-	${OBJECTDIR}/src/render_e/shaders/ShaderDataSource.o
+	${OBJECTDIR}/src/render_e/shaders/ShaderDataSource.o \
+	${OBJECTDIR}/src/render_e/math/Bounds.o \
+	${OBJECTDIR}/src/render_e/math/Frustum.o \
+	${OBJECTDIR}/src/render_e/TransformStore.o \
+	${OBJECTDIR}/src/render_e/JobSystem.o \
+	${OBJECTDIR}/src/render_e/RenderQueue.o \
+	${OBJECTDIR}/src/render_e/InstanceBuffer.o \
+	${OBJECTDIR}/src/render_e/MeshAsset.o \
+	${OBJECTDIR}/src/render_e/MeshCache.o \
+	${OBJECTDIR}/src/render_e/NameTable.o \
+	${OBJECTDIR}/src/render_e/PoolAllocator.o \
+	${OBJECTDIR}/src/render_e/SceneArena.o \
+	${OBJECTDIR}/src/render_e/GLStateCache.o \
+	${OBJECTDIR}/src/render_e/FrameUniforms.o \
+	${OBJECTDIR}/src/render_e/GeometryHeap.o \
+	${OBJECTDIR}/src/render_e/RangeAllocator.o \
+	${OBJECTDIR}/src/render_e/VertexFormat.o \
+	${OBJECTDIR}/src/render_e/RenderGraph.o \
+	${OBJECTDIR}/src/render_e/DeferredRenderer.o \
+	${OBJECTDIR}/src/render_e/LightClusters.o \
+	${OBJECTDIR}/src/render_e/OcclusionCuller.o \
+	${OBJECTDIR}/src/render_e/MeshOptimizer.o \
+	${OBJECTDIR}/src/render_e/LODGroup.o \
+	${OBJECTDIR}/src/render_e/MeshSimplifier.o \
+	${OBJECTDIR}/src/render_e/MeshWelder.o
 
 # Test Directory
 TESTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}/tests
@@ -243,6 +267,126 @@ ${OBJECTDIR}/src/render_e/shaders/ShaderDataSource.o: src/render_e/shaders/Shade
 	${RM} $@.d
 	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/shaders/ShaderDataSource.o src/render_e/shaders/ShaderDataSource.cpp
 
+${OBJECTDIR}/src/render_e/math/Bounds.o: src/render_e/math/Bounds.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e/math
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/math/Bounds.o src/render_e/math/Bounds.cpp
+
+${OBJECTDIR}/src/render_e/math/Frustum.o: src/render_e/math/Frustum.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e/math
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/math/Frustum.o src/render_e/math/Frustum.cpp
+
+${OBJECTDIR}/src/render_e/TransformStore.o: src/render_e/TransformStore.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/TransformStore.o src/render_e/TransformStore.cpp
+
+${OBJECTDIR}/src/render_e/JobSystem.o: src/render_e/JobSystem.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/JobSystem.o src/render_e/JobSystem.cpp
+
+${OBJECTDIR}/src/render_e/RenderQueue.o: src/render_e/RenderQueue.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RenderQueue.o src/render_e/RenderQueue.cpp
+
+${OBJECTDIR}/src/render_e/InstanceBuffer.o: src/render_e/InstanceBuffer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/InstanceBuffer.o src/render_e/InstanceBuffer.cpp
+
+${OBJECTDIR}/src/render_e/MeshAsset.o: src/render_e/MeshAsset.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshAsset.o src/render_e/MeshAsset.cpp
+
+${OBJECTDIR}/src/render_e/MeshCache.o: src/render_e/MeshCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshCache.o src/render_e/MeshCache.cpp
+
+${OBJECTDIR}/src/render_e/NameTable.o: src/render_e/NameTable.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/NameTable.o src/render_e/NameTable.cpp
+
+${OBJECTDIR}/src/render_e/PoolAllocator.o: src/render_e/PoolAllocator.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/PoolAllocator.o src/render_e/PoolAllocator.cpp
+
+${OBJECTDIR}/src/render_e/SceneArena.o: src/render_e/SceneArena.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/SceneArena.o src/render_e/SceneArena.cpp
+
+${OBJECTDIR}/src/render_e/GLStateCache.o: src/render_e/GLStateCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/GLStateCache.o src/render_e/GLStateCache.cpp
+
+${OBJECTDIR}/src/render_e/FrameUniforms.o: src/render_e/FrameUniforms.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/FrameUniforms.o src/render_e/FrameUniforms.cpp
+
+${OBJECTDIR}/src/render_e/GeometryHeap.o: src/render_e/GeometryHeap.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/GeometryHeap.o src/render_e/GeometryHeap.cpp
+
+${OBJECTDIR}/src/render_e/RangeAllocator.o: src/render_e/RangeAllocator.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RangeAllocator.o src/render_e/RangeAllocator.cpp
+
+${OBJECTDIR}/src/render_e/VertexFormat.o: src/render_e/VertexFormat.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/VertexFormat.o src/render_e/VertexFormat.cpp
+
+${OBJECTDIR}/src/render_e/RenderGraph.o: src/render_e/RenderGraph.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RenderGraph.o src/render_e/RenderGraph.cpp
+
+${OBJECTDIR}/src/render_e/DeferredRenderer.o: src/render_e/DeferredRenderer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/DeferredRenderer.o src/render_e/DeferredRenderer.cpp
+
+${OBJECTDIR}/src/render_e/LightClusters.o: src/render_e/LightClusters.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/LightClusters.o src/render_e/LightClusters.cpp
+
+${OBJECTDIR}/src/render_e/OcclusionCuller.o: src/render_e/OcclusionCuller.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/OcclusionCuller.o src/render_e/OcclusionCuller.cpp
+
+${OBJECTDIR}/src/render_e/MeshOptimizer.o: src/render_e/MeshOptimizer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshOptimizer.o src/render_e/MeshOptimizer.cpp
+
+${OBJECTDIR}/src/render_e/LODGroup.o: src/render_e/LODGroup.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/LODGroup.o src/render_e/LODGroup.cpp
+
+${OBJECTDIR}/src/render_e/MeshSimplifier.o: src/render_e/MeshSimplifier.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshSimplifier.o src/render_e/MeshSimplifier.cpp
+
+${OBJECTDIR}/src/render_e/MeshWelder.o: src/render_e/MeshWelder.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshWelder.o src/render_e/MeshWelder.cpp
+
 # Subprojects
 .build-subprojects:
 
@@ -668,6 +812,318 @@ ${OBJECTDIR}/src/render_e/shaders/ShaderDataSource_nomain.o: ${OBJECTDIR}/src/re
 	    ${CP} ${OBJECTDIR}/src/render_e/shaders/ShaderDataSource.o ${OBJECTDIR}/src/render_e/shaders/ShaderDataSource_nomain.o;\
 	fi
 
+${OBJECTDIR}/src/render_e/math/Bounds_nomain.o: ${OBJECTDIR}/src/render_e/math/Bounds.o src/render_e/math/Bounds.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e/math
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/math/Bounds.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/math/Bounds_nomain.o src/render_e/math/Bounds.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/math/Bounds.o ${OBJECTDIR}/src/render_e/math/Bounds_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/math/Frustum_nomain.o: ${OBJECTDIR}/src/render_e/math/Frustum.o src/render_e/math/Frustum.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e/math
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/math/Frustum.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/math/Frustum_nomain.o src/render_e/math/Frustum.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/math/Frustum.o ${OBJECTDIR}/src/render_e/math/Frustum_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/TransformStore_nomain.o: ${OBJECTDIR}/src/render_e/TransformStore.o src/render_e/TransformStore.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/TransformStore.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/TransformStore_nomain.o src/render_e/TransformStore.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/TransformStore.o ${OBJECTDIR}/src/render_e/TransformStore_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/JobSystem_nomain.o: ${OBJECTDIR}/src/render_e/JobSystem.o src/render_e/JobSystem.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/JobSystem.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/JobSystem_nomain.o src/render_e/JobSystem.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/JobSystem.o ${OBJECTDIR}/src/render_e/JobSystem_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/RenderQueue_nomain.o: ${OBJECTDIR}/src/render_e/RenderQueue.o src/render_e/RenderQueue.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/RenderQueue.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RenderQueue_nomain.o src/render_e/RenderQueue.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/RenderQueue.o ${OBJECTDIR}/src/render_e/RenderQueue_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/InstanceBuffer_nomain.o: ${OBJECTDIR}/src/render_e/InstanceBuffer.o src/render_e/InstanceBuffer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/InstanceBuffer.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/InstanceBuffer_nomain.o src/render_e/InstanceBuffer.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/InstanceBuffer.o ${OBJECTDIR}/src/render_e/InstanceBuffer_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/MeshAsset_nomain.o: ${OBJECTDIR}/src/render_e/MeshAsset.o src/render_e/MeshAsset.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/MeshAsset.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshAsset_nomain.o src/render_e/MeshAsset.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/MeshAsset.o ${OBJECTDIR}/src/render_e/MeshAsset_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/MeshCache_nomain.o: ${OBJECTDIR}/src/render_e/MeshCache.o src/render_e/MeshCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/MeshCache.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshCache_nomain.o src/render_e/MeshCache.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/MeshCache.o ${OBJECTDIR}/src/render_e/MeshCache_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/NameTable_nomain.o: ${OBJECTDIR}/src/render_e/NameTable.o src/render_e/NameTable.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/NameTable.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/NameTable_nomain.o src/render_e/NameTable.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/NameTable.o ${OBJECTDIR}/src/render_e/NameTable_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/PoolAllocator_nomain.o: ${OBJECTDIR}/src/render_e/PoolAllocator.o src/render_e/PoolAllocator.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/PoolAllocator.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/PoolAllocator_nomain.o src/render_e/PoolAllocator.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/PoolAllocator.o ${OBJECTDIR}/src/render_e/PoolAllocator_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/SceneArena_nomain.o: ${OBJECTDIR}/src/render_e/SceneArena.o src/render_e/SceneArena.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/SceneArena.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/SceneArena_nomain.o src/render_e/SceneArena.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/SceneArena.o ${OBJECTDIR}/src/render_e/SceneArena_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/GLStateCache_nomain.o: ${OBJECTDIR}/src/render_e/GLStateCache.o src/render_e/GLStateCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/GLStateCache.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/GLStateCache_nomain.o src/render_e/GLStateCache.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/GLStateCache.o ${OBJECTDIR}/src/render_e/GLStateCache_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/FrameUniforms_nomain.o: ${OBJECTDIR}/src/render_e/FrameUniforms.o src/render_e/FrameUniforms.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/FrameUniforms.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/FrameUniforms_nomain.o src/render_e/FrameUniforms.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/FrameUniforms.o ${OBJECTDIR}/src/render_e/FrameUniforms_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/GeometryHeap_nomain.o: ${OBJECTDIR}/src/render_e/GeometryHeap.o src/render_e/GeometryHeap.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/GeometryHeap.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/GeometryHeap_nomain.o src/render_e/GeometryHeap.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/GeometryHeap.o ${OBJECTDIR}/src/render_e/GeometryHeap_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/RangeAllocator_nomain.o: ${OBJECTDIR}/src/render_e/RangeAllocator.o src/render_e/RangeAllocator.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/RangeAllocator.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RangeAllocator_nomain.o src/render_e/RangeAllocator.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/RangeAllocator.o ${OBJECTDIR}/src/render_e/RangeAllocator_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/VertexFormat_nomain.o: ${OBJECTDIR}/src/render_e/VertexFormat.o src/render_e/VertexFormat.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/VertexFormat.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/VertexFormat_nomain.o src/render_e/VertexFormat.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/VertexFormat.o ${OBJECTDIR}/src/render_e/VertexFormat_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/RenderGraph_nomain.o: ${OBJECTDIR}/src/render_e/RenderGraph.o src/render_e/RenderGraph.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/RenderGraph.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/RenderGraph_nomain.o src/render_e/RenderGraph.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/RenderGraph.o ${OBJECTDIR}/src/render_e/RenderGraph_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/DeferredRenderer_nomain.o: ${OBJECTDIR}/src/render_e/DeferredRenderer.o src/render_e/DeferredRenderer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/DeferredRenderer.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/DeferredRenderer_nomain.o src/render_e/DeferredRenderer.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/DeferredRenderer.o ${OBJECTDIR}/src/render_e/DeferredRenderer_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/LightClusters_nomain.o: ${OBJECTDIR}/src/render_e/LightClusters.o src/render_e/LightClusters.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/LightClusters.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/LightClusters_nomain.o src/render_e/LightClusters.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/LightClusters.o ${OBJECTDIR}/src/render_e/LightClusters_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/OcclusionCuller_nomain.o: ${OBJECTDIR}/src/render_e/OcclusionCuller.o src/render_e/OcclusionCuller.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/OcclusionCuller.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/OcclusionCuller_nomain.o src/render_e/OcclusionCuller.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/OcclusionCuller.o ${OBJECTDIR}/src/render_e/OcclusionCuller_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/MeshOptimizer_nomain.o: ${OBJECTDIR}/src/render_e/MeshOptimizer.o src/render_e/MeshOptimizer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/MeshOptimizer.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshOptimizer_nomain.o src/render_e/MeshOptimizer.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/MeshOptimizer.o ${OBJECTDIR}/src/render_e/MeshOptimizer_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/LODGroup_nomain.o: ${OBJECTDIR}/src/render_e/LODGroup.o src/render_e/LODGroup.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/LODGroup.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/LODGroup_nomain.o src/render_e/LODGroup.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/LODGroup.o ${OBJECTDIR}/src/render_e/LODGroup_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/MeshSimplifier_nomain.o: ${OBJECTDIR}/src/render_e/MeshSimplifier.o src/render_e/MeshSimplifier.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/MeshSimplifier.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshSimplifier_nomain.o src/render_e/MeshSimplifier.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/MeshSimplifier.o ${OBJECTDIR}/src/render_e/MeshSimplifier_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/render_e/MeshWelder_nomain.o: ${OBJECTDIR}/src/render_e/MeshWelder.o src/render_e/MeshWelder.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src/render_e
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/render_e/MeshWelder.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} $@.d;\
+	    $(COMPILE.cc) -O2 -DRENDER_E_PNG -I. -I. -I. -Dmain=__nomain -MMD -MP -MF $@.d -o ${OBJECTDIR}/src/render_e/MeshWelder_nomain.o src/render_e/MeshWelder.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/render_e/MeshWelder.o ${OBJECTDIR}/src/render_e/MeshWelder_nomain.o;\
+	fi
+
 # Run Test Targets
 .test-conf:
 	@if [ "${TEST}" = "" ]; \
@@ -0,0 +1,60 @@
+// Light pass of deferred shading (see DeferredRenderer). Reads the G-buffer
+// and either writes the scene ambient term and the depth (lightMode 0) or
+// adds the contribution of one light (lightMode 1, additive blending).
+// The lighting matches the forward shaders, which scale the lit color by 2.
+uniform sampler2D gbufferAlbedo;
+uniform sampler2D gbufferNormal;
+uniform sampler2D gbufferDepth;
+uniform mat4 inverseProjection;
+uniform vec2 inverseViewportSize;
+uniform int lightMode;
+
+// light in eye space (see LightUniforms)
+uniform vec4 lightPosition;
+uniform vec4 lightSpotDirection;
+uniform vec4 lightAmbient;
+uniform vec4 lightDiffuse;
+uniform vec4 lightSpecular;
+uniform vec4 lightAttenuation;
+
+void main(){
+    vec2 uv = gl_FragCoord.xy * inverseViewportSize;
+    float depth = texture2D(gbufferDepth, uv).r;
+    if (depth == 1.0){
+        discard; // background
+    }
+    vec4 albedo = texture2D(gbufferAlbedo, uv) * 2.0;
+    if (lightMode == 0){
+        gl_FragDepth = depth;
+        gl_FragColor = clamp(gl_FrontLightModelProduct.sceneColor * albedo, 0.0, 1.0);
+        return;
+    }
+    vec3 normal = re_DecodeNormal(texture2D(gbufferNormal, uv).rg * 2.0 - 1.0);
+    vec4 position = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    position.xyz /= position.w;
+
+    vec3 VP;
+    float attenuation = 1.0;
+    if (lightPosition.w == 0.0){
+        VP = normalize(lightPosition.xyz);
+    } else {
+        VP = lightPosition.xyz - position.xyz;
+        float d = length(VP);
+        VP /= d;
+        attenuation = 1.0 / dot(lightAttenuation.xyz, vec3(1.0, d, d * d));
+        if (lightSpotDirection.w > -1.0){
+            float spotDot = dot(-VP, normalize(lightSpotDirection.xyz));
+            attenuation *= spotDot < lightSpotDirection.w ? 0.0 : pow(spotDot, lightAttenuation.w);
+        }
+    }
+    vec3 eye = vec3(0.0, 0.0, 1.0); // as in shared.vs
+    vec3 halfVector = normalize(VP + eye);
+    float nDotVP = max(0.0, dot(normal, VP));
+    float nDotHV = max(0.0, dot(normal, halfVector));
+    float pf = nDotVP == 0.0 ? 0.0 : pow(nDotHV, gl_FrontMaterial.shininess);
+
+    vec4 color = lightAmbient * gl_FrontMaterial.ambient +
+        lightDiffuse * nDotVP * gl_FrontMaterial.diffuse +
+        lightSpecular * pf * gl_FrontMaterial.specular;
+    gl_FragColor = vec4((color * attenuation * albedo).rgb, 0.0);
+}
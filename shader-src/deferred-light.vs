@@ -0,0 +1,5 @@
+// Fullscreen quad of the light pass (see DeferredRenderer). The vertices
+// are given in normalized device coordinates.
+void main(){
+    gl_Position = vec4(re_VertexPosition.xy, 0.0, 1.0);
+}
@@ -1,10 +1,17 @@
-uniform vec4 color;
+varying vec4 materialColor;
+#ifdef RENDER_E_GBUFFER
+varying vec3 gbufferNormal;
+#endif
 
 void main (void) 
 {
+#ifdef RENDER_E_GBUFFER
+    re_GBufferOutput(materialColor.rgb, gbufferNormal);
+#else
     vec4 colorf;
     colorf = gl_Color*2.0;
-    colorf *= color;
+    colorf *= materialColor;
     colorf=clamp(colorf,0.0,1.0);
     gl_FragColor = colorf;
+#endif
 }
\ No newline at end of file
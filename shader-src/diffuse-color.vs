@@ -1,18 +1,31 @@
+uniform vec4 color;
+
+varying vec4 materialColor;
+#ifdef RENDER_E_GBUFFER
+varying vec3 gbufferNormal;
+#endif
+
 void main (void)
 {
 	vec3  transformedNormal;
 	float alphaFade = 1.0;
 
 	// Eye-coordinate position of vertex, needed in various calculations
-	vec4 ecPosition = gl_ModelViewMatrix * gl_Vertex;
+	vec4 ecPosition = re_EyePosition();
 
 	// Do fixed functionality vertex transform
-	gl_Position = ftransform();
-	transformedNormal = fnormal();
+	gl_Position = re_Position();
+	transformedNormal = re_Normal();
+	materialColor = re_InstanceParameterOr(color);
+#ifdef RENDER_E_GBUFFER
+	// lit in the light pass (see deferred-light.fs)
+	gbufferNormal = transformedNormal;
+#else
 	flight(transformedNormal, ecPosition, alphaFade);
+#endif
 
 	//Enable texture coordinates
-	gl_TexCoord[0] = gl_MultiTexCoord0;
+	gl_TexCoord[0] = re_VertexTexCoord0;
 	//gl_TexCoord[1] = gl_MultiTexCoord1;
 	//gl_TexCoord[2] = gl_MultiTexCoord2;
 	//gl_TexCoord[3] = gl_MultiTexCoord3;
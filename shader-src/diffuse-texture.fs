@@ -1,10 +1,17 @@
 uniform sampler2D texture;
+#ifdef RENDER_E_GBUFFER
+varying vec3 gbufferNormal;
+#endif
 
 void main (void) 
 {
+#ifdef RENDER_E_GBUFFER
+    re_GBufferOutput(texture2D(texture, gl_TexCoord[0].xy).rgb, gbufferNormal);
+#else
     vec4 color;
     color = gl_Color*2.0;
     color *= texture2D(texture, gl_TexCoord[0].xy);
     color=clamp(color,0.0,1.0);
     gl_FragColor = color;
+#endif
 }
\ No newline at end of file
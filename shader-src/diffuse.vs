@@ -1,6 +1,6 @@
 varying vec3 normal;
 
 void main(){
-    gl_Position = ftransform();
-    normal = gl_Normal;
+    gl_Position = gl_ModelViewProjectionMatrix * re_VertexPosition;
+    normal = re_VertexNormal;
 }
\ No newline at end of file
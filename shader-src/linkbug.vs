@@ -1,4 +1,4 @@
 
 void main(){
-    gl_Position =  gl_ModelViewProjectionMatrix*gl_Vertex;
+    gl_Position =  gl_ModelViewProjectionMatrix*re_VertexPosition;
 }
\ No newline at end of file
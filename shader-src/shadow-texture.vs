@@ -7,14 +7,14 @@ varying vec4 shadowTexCoord;
 void main (void)
 {	
 	// Eye-coordinate position of vertex, needed in various calculations
-	ecPosition = gl_ModelViewMatrix * gl_Vertex;
+	ecPosition = gl_ModelViewMatrix * re_VertexPosition;
 
 	// Do fixed functionality vertex transform
-	gl_Position = ftransform();
+	gl_Position = gl_ModelViewProjectionMatrix * re_VertexPosition;
 	transformedNormal = fnormal();
 
 	//Enable texture coordinates
-	gl_TexCoord[0] = gl_MultiTexCoord0;
+	gl_TexCoord[0] = re_VertexTexCoord0;
 
-	shadowTexCoord = textureMatrix * gl_Vertex;
+	shadowTexCoord = textureMatrix * re_VertexPosition;
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #version 120
+#ifdef RENDER_E_UNIFORM_BUFFER
+#extension GL_ARB_uniform_buffer_object : require
+#endif
 // Provides shared shader functions that can be used in fragment shaders
 
 
@@ -11,8 +14,93 @@ vec4 Ambient;
 vec4 Diffuse;
 vec4 Specular;
 
+#ifdef RENDER_E_UNIFORM_BUFFER
+// The camera and the lights are read from uniform buffers filled once per
+// frame (see FrameUniforms). Light positions and directions are stored in
+// world space and transformed to eye space here.
+layout(std140) uniform re_Camera
+{
+	mat4 re_ViewMatrix;
+	mat4 re_ProjectionMatrix;
+	vec4 re_ClusterParameters; // depth to cluster slice (see LightClusters)
+};
+
+struct re_LightData
+{
+	vec4 position;      // w is 0 for directional lights
+	vec4 spotDirection; // w is cosine of the spot cutoff (-1 if not a spot)
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 attenuation;   // constant, linear, quadratic, spot exponent
+};
+
+layout(std140) uniform re_Lights
+{
+	ivec4 re_LightCount; // x: all lights, y: lights without a finite range (first)
+	re_LightData re_Light[RE_MAX_LIGHTS];
+};
+
+int re_ActiveLights() { return re_LightCount.x; }
+vec4 re_LightPosition(in int i) { return re_ViewMatrix * re_Light[i].position; }
+vec3 re_LightSpotDirection(in int i) { return mat3(re_ViewMatrix) * re_Light[i].spotDirection.xyz; }
+float re_LightSpotCosCutoff(in int i) { return re_Light[i].spotDirection.w; }
+float re_LightSpotExponent(in int i) { return re_Light[i].attenuation.w; }
+bool re_LightIsSpot(in int i) { return re_Light[i].spotDirection.w > -1.0; }
+vec3 re_LightAttenuation(in int i) { return re_Light[i].attenuation.xyz; }
+vec3 re_LightHalfVector(in int i) { return normalize(normalize(re_LightPosition(i).xyz) + vec3(0.0, 0.0, 1.0)); }
+vec4 re_LightAmbient(in int i) { return re_Light[i].ambient; }
+vec4 re_LightDiffuse(in int i) { return re_Light[i].diffuse; }
+vec4 re_LightSpecular(in int i) { return re_Light[i].specular; }
+
+#ifdef RENDER_E_CLUSTERED_LIGHTS
+// Lights with a finite range are assigned to clusters of the view frustum
+// (see LightClusters). re_ClusterTexture stores the offset and the count of
+// the light indices of each cluster and re_LightIndexTexture the indices.
+uniform sampler2D re_ClusterTexture;
+uniform sampler2D re_LightIndexTexture;
+
+vec2 re_ClusterTexCoord(in vec3 ecPosition3)
+{
+	vec4 clip = re_ProjectionMatrix * vec4(ecPosition3, 1.0);
+	vec2 tile = clamp(floor((clip.xy / clip.w * 0.5 + 0.5) * RE_CLUSTER_SIZE.xy), vec2(0.0), RE_CLUSTER_SIZE.xy - 1.0);
+	float depth = -ecPosition3.z;
+	float slice = (re_ClusterParameters.z > 0.0 ? log(max(depth, 0.0001)) : depth) *
+		re_ClusterParameters.x + re_ClusterParameters.y;
+	slice = clamp(floor(slice), 0.0, RE_CLUSTER_SIZE.z - 1.0);
+	return vec2((tile.y * RE_CLUSTER_SIZE.x + tile.x + 0.5) / (RE_CLUSTER_SIZE.x * RE_CLUSTER_SIZE.y),
+		(slice + 0.5) / RE_CLUSTER_SIZE.z);
+}
+
+int re_ClusterLightIndex(in float index)
+{
+	vec2 texCoord = vec2((mod(index, RE_LIGHT_INDEX_SIZE.x) + 0.5) / RE_LIGHT_INDEX_SIZE.x,
+		(floor(index / RE_LIGHT_INDEX_SIZE.x) + 0.5) / RE_LIGHT_INDEX_SIZE.y);
+	return int(texture2D(re_LightIndexTexture, texCoord).r + 0.5);
+}
+#endif
+#else
+// Fixed-function light state
 uniform int activelights;
 
+int re_ActiveLights() { return activelights; }
+vec4 re_LightPosition(in int i) { return gl_LightSource[i].position; }
+vec3 re_LightSpotDirection(in int i) { return gl_LightSource[i].spotDirection; }
+float re_LightSpotCosCutoff(in int i) { return gl_LightSource[i].spotCosCutoff; }
+float re_LightSpotExponent(in int i) { return gl_LightSource[i].spotExponent; }
+bool re_LightIsSpot(in int i) { return gl_LightSource[i].spotCutoff != 180.0; }
+vec3 re_LightAttenuation(in int i)
+{
+	return vec3(gl_LightSource[i].constantAttenuation,
+		gl_LightSource[i].linearAttenuation,
+		gl_LightSource[i].quadraticAttenuation);
+}
+vec3 re_LightHalfVector(in int i) { return vec3(gl_LightSource[i].halfVector); }
+vec4 re_LightAmbient(in int i) { return gl_LightSource[i].ambient; }
+vec4 re_LightDiffuse(in int i) { return gl_LightSource[i].diffuse; }
+vec4 re_LightSpecular(in int i) { return gl_LightSource[i].specular; }
+#endif
+
 void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 {
    float nDotVP;       // normal . light direction
@@ -24,7 +112,7 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    vec3  halfVector;   // direction of maximum highlights
 
    // Compute vector from surface to light position
-   VP = vec3 (gl_LightSource[i].position) - ecPosition3;
+   VP = vec3 (re_LightPosition(i)) - ecPosition3;
 
    // Compute distance between surface and light position
    d = length(VP);
@@ -33,9 +121,7 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    VP = normalize(VP);
 
    // Compute attenuation
-   attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +
-       gl_LightSource[i].linearAttenuation * d +
-       gl_LightSource[i].quadraticAttenuation * d * d);
+   attenuation = 1.0 / dot(re_LightAttenuation(i), vec3(1.0, d, d * d));
 
    halfVector = normalize(VP + eye);
 
@@ -50,9 +136,9 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    {
        pf = pow(nDotHV, gl_FrontMaterial.shininess);
    }
-   Ambient  += gl_LightSource[i].ambient * attenuation;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP * attenuation;
-   Specular += gl_LightSource[i].specular * pf * attenuation;
+   Ambient  += re_LightAmbient(i) * attenuation;
+   Diffuse  += re_LightDiffuse(i) * nDotVP * attenuation;
+   Specular += re_LightSpecular(i) * pf * attenuation;
 }
 
 void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
@@ -68,7 +154,7 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    vec3  halfVector;		// direction of maximum highlights
 
    // Compute vector from surface to light position
-   VP = vec3 (gl_LightSource[i].position) - ecPosition3;
+   VP = vec3 (re_LightPosition(i)) - ecPosition3;
 
    // Compute distance between surface and light position
    d = length(VP);
@@ -77,20 +163,18 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    VP = normalize(VP);
 
    // Compute attenuation
-   attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +
-	   gl_LightSource[i].linearAttenuation * d +
-	   gl_LightSource[i].quadraticAttenuation * d * d);
+   attenuation = 1.0 / dot(re_LightAttenuation(i), vec3(1.0, d, d * d));
 
    // See if point on surface is inside cone of illumination
-   spotDot = dot(-VP, normalize(gl_LightSource[i].spotDirection));
+   spotDot = dot(-VP, normalize(re_LightSpotDirection(i)));
 
-   if (spotDot < gl_LightSource[i].spotCosCutoff)
+   if (spotDot < re_LightSpotCosCutoff(i))
    {
 	   spotAttenuation = 0.0; // light adds no contribution
    }
    else
    {
-	   spotAttenuation = pow(spotDot, gl_LightSource[i].spotExponent);
+	   spotAttenuation = pow(spotDot, re_LightSpotExponent(i));
 
    }
    // Combine the spotlight and distance attenuation.
@@ -110,9 +194,9 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 	   pf = pow(nDotHV, gl_FrontMaterial.shininess);
 
    }
-   Ambient  += gl_LightSource[i].ambient * attenuation;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP * attenuation;
-   Specular += gl_LightSource[i].specular * pf * attenuation;
+   Ambient  += re_LightAmbient(i) * attenuation;
+   Diffuse  += re_LightDiffuse(i) * nDotVP * attenuation;
+   Specular += re_LightSpecular(i) * pf * attenuation;
 }
 
 void directionalLight(in int i, in vec3 normal)
@@ -121,8 +205,8 @@ void directionalLight(in int i, in vec3 normal)
    float nDotHV;		 // normal . light half vector
    float pf;			 // power factor
 
-   nDotVP = max(0.0, dot(normal, normalize(vec3 (gl_LightSource[i].position))));
-   nDotHV = max(0.0, dot(normal, vec3 (gl_LightSource[i].halfVector)));
+   nDotVP = max(0.0, dot(normal, normalize(vec3 (re_LightPosition(i)))));
+   nDotHV = max(0.0, dot(normal, re_LightHalfVector(i)));
 
    if (nDotVP == 0.0)
    {
@@ -132,16 +216,16 @@ void directionalLight(in int i, in vec3 normal)
    {
 	   pf = pow(nDotHV, gl_FrontMaterial.shininess);
    }
-   Ambient  += gl_LightSource[i].ambient;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP;
-   Specular += gl_LightSource[i].specular * pf;
+   Ambient  += re_LightAmbient(i);
+   Diffuse  += re_LightDiffuse(i) * nDotVP;
+   Specular += re_LightSpecular(i) * pf;
 }
 
 void ProcessLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 {
-	if (gl_LightSource[i].spotCutoff==180.0)
+	if (!re_LightIsSpot(i))
 	{
-		if (gl_LightSource[i].position.w==0.0)
+		if (re_LightPosition(i).w==0.0)
 		{
 			directionalLight(i, normal);
 		}
@@ -171,22 +255,52 @@ void flight(in vec3 normal, in vec4 ecPosition, float alphaFade, float invShadow
 	Diffuse  = vec4 (0.0);
 	Specular = vec4 (0.0);
 
-	if (activelights>0)
+#if defined(RENDER_E_CLUSTERED_LIGHTS)
+	// lights without a finite range, then the lights of the cluster
+	for (i=0;i<RE_MAX_LIGHTS;i++)
+	{
+		if (i>=re_LightCount.y)
+		{
+			break;
+		}
+		ProcessLight(i,normal,eye,ecPosition3);
+	}
+	vec2 cluster = texture2D(re_ClusterTexture, re_ClusterTexCoord(ecPosition3)).ra;
+	for (i=0;i<RE_MAX_LIGHTS;i++)
+	{
+		if (float(i)>=cluster.y)
+		{
+			break;
+		}
+		ProcessLight(re_ClusterLightIndex(cluster.x+float(i)),normal,eye,ecPosition3);
+	}
+#elif defined(RENDER_E_UNIFORM_BUFFER)
+	for (i=0;i<RE_MAX_LIGHTS;i++)
+	{
+		if (i>=re_ActiveLights())
+		{
+			break;
+		}
+		ProcessLight(i,normal,eye,ecPosition3);
+	}
+#else
+	if (re_ActiveLights()>0)
 	{
 		ProcessLight(0,normal,eye,ecPosition3);
 	}
-	if (activelights>1)
+	if (re_ActiveLights()>1)
 	{
 		ProcessLight(1,normal,eye,ecPosition3);
 	}
-	if (activelights>2)
+	if (re_ActiveLights()>2)
 	{
 		ProcessLight(2,normal,eye,ecPosition3);
 	}
-	//if (activelights>3)
+	//if (re_ActiveLights()>3)
 	//{
 	//	ProcessLight(3,normal,eye,ecPosition3);
 	//}
+#endif
 
    color = 
       Ambient   +
@@ -197,3 +311,37 @@ void flight(in vec3 normal, in vec4 ecPosition, float alphaFade, float invShadow
     frontColor.a *= alphaFade;
 }
 
+
+// Octahedral normal encoding used by the G-buffer: a unit vector is mapped
+// to [-1;1]^2, so two channels store a normal (see DeferredRenderer)
+vec2 re_EncodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.xy;
+	if (n.z < 0.0)
+	{
+		e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return e;
+}
+
+vec3 re_DecodeNormal(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+
+#ifdef RENDER_E_GBUFFER
+// Shaders supporting deferred shading test RENDER_E_GBUFFER and write the
+// surface using this function instead of lighting it (the G-buffer variant
+// of the shader is compiled with RENDER_E_GBUFFER defined)
+void re_GBufferOutput(vec3 albedo, vec3 eyeNormal)
+{
+	gl_FragData[0] = vec4(albedo, 1.0);
+	gl_FragData[1] = vec4(re_EncodeNormal(normalize(eyeNormal)) * 0.5 + 0.5, 0.0, 1.0);
+}
+#endif
@@ -1,4 +1,7 @@
 #version 120
+#ifdef RENDER_E_UNIFORM_BUFFER
+#extension GL_ARB_uniform_buffer_object : require
+#endif
 // Provides shared shader functions that can be used in vertex shaders 
 
 // following light functions are from the book 
@@ -10,8 +13,66 @@ vec4 Ambient;
 vec4 Diffuse;
 vec4 Specular;
 
+#ifdef RENDER_E_UNIFORM_BUFFER
+// The camera and the lights are read from uniform buffers filled once per
+// frame (see FrameUniforms). Light positions and directions are stored in
+// world space and transformed to eye space here.
+layout(std140) uniform re_Camera
+{
+	mat4 re_ViewMatrix;
+	mat4 re_ProjectionMatrix;
+	vec4 re_ClusterParameters; // depth to cluster slice (see LightClusters)
+};
+
+struct re_LightData
+{
+	vec4 position;      // w is 0 for directional lights
+	vec4 spotDirection; // w is cosine of the spot cutoff (-1 if not a spot)
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 attenuation;   // constant, linear, quadratic, spot exponent
+};
+
+layout(std140) uniform re_Lights
+{
+	ivec4 re_LightCount; // x: all lights, y: lights without a finite range (first)
+	re_LightData re_Light[RE_MAX_LIGHTS];
+};
+
+int re_ActiveLights() { return re_LightCount.x; }
+vec4 re_LightPosition(in int i) { return re_ViewMatrix * re_Light[i].position; }
+vec3 re_LightSpotDirection(in int i) { return mat3(re_ViewMatrix) * re_Light[i].spotDirection.xyz; }
+float re_LightSpotCosCutoff(in int i) { return re_Light[i].spotDirection.w; }
+float re_LightSpotExponent(in int i) { return re_Light[i].attenuation.w; }
+bool re_LightIsSpot(in int i) { return re_Light[i].spotDirection.w > -1.0; }
+vec3 re_LightAttenuation(in int i) { return re_Light[i].attenuation.xyz; }
+vec3 re_LightHalfVector(in int i) { return normalize(normalize(re_LightPosition(i).xyz) + vec3(0.0, 0.0, 1.0)); }
+vec4 re_LightAmbient(in int i) { return re_Light[i].ambient; }
+vec4 re_LightDiffuse(in int i) { return re_Light[i].diffuse; }
+vec4 re_LightSpecular(in int i) { return re_Light[i].specular; }
+#else
+// Fixed-function light state
 uniform int activelights;
 
+int re_ActiveLights() { return activelights; }
+vec4 re_LightPosition(in int i) { return gl_LightSource[i].position; }
+vec3 re_LightSpotDirection(in int i) { return gl_LightSource[i].spotDirection; }
+float re_LightSpotCosCutoff(in int i) { return gl_LightSource[i].spotCosCutoff; }
+float re_LightSpotExponent(in int i) { return gl_LightSource[i].spotExponent; }
+bool re_LightIsSpot(in int i) { return gl_LightSource[i].spotCutoff != 180.0; }
+vec3 re_LightAttenuation(in int i)
+{
+	return vec3(gl_LightSource[i].constantAttenuation,
+		gl_LightSource[i].linearAttenuation,
+		gl_LightSource[i].quadraticAttenuation);
+}
+vec3 re_LightHalfVector(in int i) { return vec3(gl_LightSource[i].halfVector); }
+vec4 re_LightAmbient(in int i) { return gl_LightSource[i].ambient; }
+vec4 re_LightDiffuse(in int i) { return gl_LightSource[i].diffuse; }
+vec4 re_LightSpecular(in int i) { return gl_LightSource[i].specular; }
+#endif
+
 void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 {
    float nDotVP;       // normal . light direction
@@ -23,7 +84,7 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    vec3  halfVector;   // direction of maximum highlights
 
    // Compute vector from surface to light position
-   VP = vec3 (gl_LightSource[i].position) - ecPosition3;
+   VP = vec3 (re_LightPosition(i)) - ecPosition3;
 
    // Compute distance between surface and light position
    d = length(VP);
@@ -32,9 +93,7 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    VP = normalize(VP);
 
    // Compute attenuation
-   attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +
-       gl_LightSource[i].linearAttenuation * d +
-       gl_LightSource[i].quadraticAttenuation * d * d);
+   attenuation = 1.0 / dot(re_LightAttenuation(i), vec3(1.0, d, d * d));
 
    halfVector = normalize(VP + eye);
 
@@ -49,9 +108,9 @@ void pointLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    {
        pf = pow(nDotHV, gl_FrontMaterial.shininess);
    }
-   Ambient  += gl_LightSource[i].ambient * attenuation;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP * attenuation;
-   Specular += gl_LightSource[i].specular * pf * attenuation;
+   Ambient  += re_LightAmbient(i) * attenuation;
+   Diffuse  += re_LightDiffuse(i) * nDotVP * attenuation;
+   Specular += re_LightSpecular(i) * pf * attenuation;
 }
 
 void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
@@ -67,7 +126,7 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    vec3  halfVector;		// direction of maximum highlights
 
    // Compute vector from surface to light position
-   VP = vec3 (gl_LightSource[i].position) - ecPosition3;
+   VP = vec3 (re_LightPosition(i)) - ecPosition3;
 
    // Compute distance between surface and light position
    d = length(VP);
@@ -76,20 +135,18 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
    VP = normalize(VP);
 
    // Compute attenuation
-   attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +
-	   gl_LightSource[i].linearAttenuation * d +
-	   gl_LightSource[i].quadraticAttenuation * d * d);
+   attenuation = 1.0 / dot(re_LightAttenuation(i), vec3(1.0, d, d * d));
 
    // See if point on surface is inside cone of illumination
-   spotDot = dot(-VP, normalize(gl_LightSource[i].spotDirection));
+   spotDot = dot(-VP, normalize(re_LightSpotDirection(i)));
 
-   if (spotDot < gl_LightSource[i].spotCosCutoff)
+   if (spotDot < re_LightSpotCosCutoff(i))
    {
 	   spotAttenuation = 0.0; // light adds no contribution
    }
    else
    {
-	   spotAttenuation = pow(spotDot, gl_LightSource[i].spotExponent);
+	   spotAttenuation = pow(spotDot, re_LightSpotExponent(i));
 
    }
    // Combine the spotlight and distance attenuation.
@@ -109,9 +166,9 @@ void spotLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 	   pf = pow(nDotHV, gl_FrontMaterial.shininess);
 
    }
-   Ambient  += gl_LightSource[i].ambient * attenuation;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP * attenuation;
-   Specular += gl_LightSource[i].specular * pf * attenuation;
+   Ambient  += re_LightAmbient(i) * attenuation;
+   Diffuse  += re_LightDiffuse(i) * nDotVP * attenuation;
+   Specular += re_LightSpecular(i) * pf * attenuation;
 }
 
 void directionalLight(in int i, in vec3 normal)
@@ -120,8 +177,8 @@ void directionalLight(in int i, in vec3 normal)
    float nDotHV;		 // normal . light half vector
    float pf;			 // power factor
 
-   nDotVP = max(0.0, dot(normal, normalize(vec3 (gl_LightSource[i].position))));
-   nDotHV = max(0.0, dot(normal, vec3 (gl_LightSource[i].halfVector)));
+   nDotVP = max(0.0, dot(normal, normalize(vec3 (re_LightPosition(i)))));
+   nDotHV = max(0.0, dot(normal, re_LightHalfVector(i)));
 
    if (nDotVP == 0.0)
    {
@@ -131,16 +188,16 @@ void directionalLight(in int i, in vec3 normal)
    {
 	   pf = pow(nDotHV, gl_FrontMaterial.shininess);
    }
-   Ambient  += gl_LightSource[i].ambient;
-   Diffuse  += gl_LightSource[i].diffuse * nDotVP;
-   Specular += gl_LightSource[i].specular * pf;
+   Ambient  += re_LightAmbient(i);
+   Diffuse  += re_LightDiffuse(i) * nDotVP;
+   Specular += re_LightSpecular(i) * pf;
 }
 
 void ProcessLight(in int i, in vec3 normal, in vec3 eye, in vec3 ecPosition3)
 {
-	if (gl_LightSource[i].spotCutoff==180.0)
+	if (!re_LightIsSpot(i))
 	{
-		if (gl_LightSource[i].position.w==0.0)
+		if (re_LightPosition(i).w==0.0)
 		{
 			directionalLight(i, normal);
 		}
@@ -170,22 +227,33 @@ void flight(in vec3 normal, in vec4 ecPosition, float alphaFade)
 	Diffuse  = vec4 (0.0);
 	Specular = vec4 (0.0);
 
-	if (activelights>0)
+#ifdef RENDER_E_UNIFORM_BUFFER
+	for (i=0;i<RE_MAX_LIGHTS;i++)
+	{
+		if (i>=re_ActiveLights())
+		{
+			break;
+		}
+		ProcessLight(i,normal,eye,ecPosition3);
+	}
+#else
+	if (re_ActiveLights()>0)
 	{
 		ProcessLight(0,normal,eye,ecPosition3);
 	}
-	if (activelights>1)
+	if (re_ActiveLights()>1)
 	{
 		ProcessLight(1,normal,eye,ecPosition3);
 	}
-	if (activelights>2)
+	if (re_ActiveLights()>2)
 	{
 		ProcessLight(2,normal,eye,ecPosition3);
 	}
-	//if (activelights>3)
+	//if (re_ActiveLights()>3)
 	//{
 	//	ProcessLight(3,normal,eye,ecPosition3);
 	//}
+#endif
 
    color = gl_FrontLightModelProduct.sceneColor +
       Ambient  * gl_FrontMaterial.ambient +
@@ -197,10 +265,109 @@ void flight(in vec3 normal, in vec4 ecPosition, float alphaFade)
 }
 
 
+// Mesh attributes (bound to fixed locations, see MeshAsset). Positions,
+// normals and tangents may be compressed (see VertexCompression) and are
+// decoded by the re_VertexPosition, re_VertexNormal and re_VertexTangent
+// macros below.
+attribute vec4 re_VertexPositionData;
+attribute vec3 re_VertexNormalData;
+attribute vec4 re_VertexColor;
+attribute vec3 re_VertexTangentData;
+attribute vec4 re_VertexTexCoord0;
+attribute vec4 re_VertexTexCoord1;
+// Constant per mesh: xyz is the offset and w the scale of the quantized
+// positions (0,0,0,1 for float positions)
+attribute vec4 re_VertexDecodePosition;
+// Constant per mesh: x is 1 if the normals are octahedral encoded, y is 1 if
+// the tangents are octahedral encoded
+attribute vec4 re_VertexDecodeFlags;
+
+// Decode a unit vector stored as an octahedral projection in xy
+vec3 re_DecodeOctahedral(vec2 encoded)
+{
+	vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (v.z < 0.0)
+	{
+		vec2 signs = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+		v.xy = (1.0 - abs(v.yx)) * signs;
+	}
+	return normalize(v);
+}
+
+vec3 re_DecodeDirection(vec3 data, float octahedral)
+{
+	return octahedral > 0.5 ? re_DecodeOctahedral(data.xy) : data;
+}
+
+#define re_VertexPosition vec4(re_VertexPositionData.xyz * re_VertexDecodePosition.w + re_VertexDecodePosition.xyz, 1.0)
+#define re_VertexNormal re_DecodeDirection(re_VertexNormalData, re_VertexDecodeFlags.x)
+#define re_VertexTangent re_DecodeDirection(re_VertexTangentData, re_VertexDecodeFlags.y)
+
 vec3 fnormal(void)
 {
 	//Compute the normal 
-	vec3 normal = gl_NormalMatrix * gl_Normal;
+	vec3 normal = gl_NormalMatrix * re_VertexNormal;
 	normal = normalize(normal);
 	return normal;
-}
\ No newline at end of file
+}
+
+// Vertex transformation functions. Shaders using these functions get an
+// instanced variant (compiled with RENDER_E_INSTANCED defined), where the
+// model matrix and the instance parameter are per instance attributes.
+#ifdef RENDER_E_INSTANCED
+attribute vec4 re_InstanceModel0;
+attribute vec4 re_InstanceModel1;
+attribute vec4 re_InstanceModel2;
+attribute vec4 re_InstanceModel3;
+attribute vec4 re_InstanceParameter;
+
+mat4 re_ModelMatrix()
+{
+	return mat4(re_InstanceModel0, re_InstanceModel1, re_InstanceModel2, re_InstanceModel3);
+}
+
+// Eye-coordinate position of vertex
+vec4 re_EyePosition()
+{
+	return gl_ModelViewMatrix * (re_ModelMatrix() * re_VertexPosition);
+}
+
+vec4 re_Position()
+{
+	return gl_ProjectionMatrix * re_EyePosition();
+}
+
+// Eye-coordinate normal (assumes uniform scale of the instance)
+vec3 re_Normal()
+{
+	mat4 modelView = gl_ModelViewMatrix * re_ModelMatrix();
+	mat3 normalMatrix = mat3(modelView[0].xyz, modelView[1].xyz, modelView[2].xyz);
+	return normalize(normalMatrix * re_VertexNormal);
+}
+
+// Returns the per instance parameter (see Material::SetInstanceParameter)
+vec4 re_InstanceParameterOr(vec4 value)
+{
+	return re_InstanceParameter;
+}
+#else
+vec4 re_EyePosition()
+{
+	return gl_ModelViewMatrix * re_VertexPosition;
+}
+
+vec4 re_Position()
+{
+	return gl_ModelViewProjectionMatrix * re_VertexPosition;
+}
+
+vec3 re_Normal()
+{
+	return fnormal();
+}
+
+vec4 re_InstanceParameterOr(vec4 value)
+{
+	return value;
+}
+#endif
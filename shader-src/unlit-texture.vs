@@ -1,8 +1,8 @@
 void main (void)
 {
 	// Do fixed functionality vertex transform
-	gl_Position = ftransform();
+	gl_Position = re_Position();
 
 	//Enable texture coordinates
-	gl_TexCoord[0] = gl_MultiTexCoord0;
+	gl_TexCoord[0] = re_VertexTexCoord0;
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
 
 void main(){
-    gl_Position = ftransform();
+    gl_Position = re_Position();
 }
\ No newline at end of file
@@ -13,20 +13,35 @@
 #include "textures/Texture2D.h"
 #include "OpenGLHelper.h"
 #include "Log.h"
+#include "GLStateCache.h"
+#include "RenderGraph.h"
 
 namespace render_e {
 
+namespace {
+unsigned int nextCameraId = 1;
+}
+
 Camera::Camera()
-: Component(CameraType), cameraMode(ORTHOGRAPHIC),
+: Component(CameraType), cameraId(nextCameraId++), cameraMode(ORTHOGRAPHIC),
 nearPlane(-1), farPlane(1),
 left(-1), right(1),
-bottom(-1), top(1), clearColor(0, 0, 0, 1), renderToTexture(false) {
+bottom(-1), top(1), clearColor(0, 0, 0, 1), renderToTexture(false), depthPrePass(true),
+deferredShading(false), viewportWidth(0), viewportHeight(0), renderBufferId(0), depthBufferPool(NULL),
+framebufferTextureId(0) {
     SetClearMask(COLOR_BUFFER | DEPTH_BUFFER);
     SetClearColor(glm::vec4(0, 0, 0, 1));
+    depthPrePassQueries.prePassQuery = 0;
+    depthPrePassQueries.mainPassQuery = 0;
+    depthPrePassQueries.pending = false;
 }
 
 Camera::~Camera() {
     SetRenderToTexture(false, COLOR_BUFFER, NULL);
+    if (depthPrePassQueries.prePassQuery != 0){
+        glDeleteQueries(1, &depthPrePassQueries.prePassQuery);
+        glDeleteQueries(1, &depthPrePassQueries.mainPassQuery);
+    }
 }
 
 void Camera::SetProjection(float fieldOfView, float aspect, float nearPlane, float farPlane) {
@@ -78,14 +93,18 @@ int Camera::GetClearMask() {
 void Camera::Setup(int viewportWidth, int viewportHeight) {
     if (renderToTexture) {
         BindFrameBufferObject();
-        glViewport(0, 0, fboWidth, fboHeight);
+        GLStateCache::Instance()->Viewport(0, 0, fboWidth, fboHeight);
+        this->viewportWidth = fboWidth;
+        this->viewportHeight = fboHeight;
 
         // currently this should only be true on depth rendering
         //Disable color rendering, we only want to write to the Z-Buffer
-        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        GLStateCache::Instance()->ColorMask(false, false, false, false);
     } else {
-        glViewport(0, 0, viewportWidth, viewportHeight);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        GLStateCache::Instance()->Viewport(0, 0, viewportWidth, viewportHeight);
+        GLStateCache::Instance()->ColorMask(true, true, true, true);
+        this->viewportWidth = viewportWidth;
+        this->viewportHeight = viewportHeight;
     }
     glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
     glMatrixMode(GL_PROJECTION);
@@ -101,9 +120,10 @@ void Camera::Setup(int viewportWidth, int viewportHeight) {
 
     SceneObject *sceneObject = GetOwner();
     assert(sceneObject != NULL); // Cannot setup camera with it being owned by a scene object
-    glm::mat4 cameraMatrix = sceneObject->GetTransform()->GetLocalTransformInverse();
+    glm::mat4 cameraMatrix = GetViewMatrix();
     
     glLoadMatrixf(glm::value_ptr(cameraMatrix));
+    frustum.SetFromMatrix(GetProjectionMatrix()*cameraMatrix);
 
     if (renderToTexture) {
         //		float modelView[16];
@@ -135,7 +155,8 @@ void Camera::SetClearColor(glm::vec4 clearColor) {
     this->clearColor = clearColor;
 }
 
-void Camera::SetRenderToTexture(bool doRenderToTexture, CameraBuffer framebufferTargetType, TextureBase *texture) {
+void Camera::SetRenderToTexture(bool doRenderToTexture, CameraBuffer framebufferTargetType, TextureBase *texture,
+        RenderGraph *depthBufferPool) {
     if (renderToTexture == doRenderToTexture) {
         return;
     }
@@ -166,7 +187,7 @@ void Camera::SetRenderToTexture(bool doRenderToTexture, CameraBuffer framebuffer
         if (framebufferTargetType == DEPTH_BUFFER) {
 
 
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
+            GLStateCache::Instance()->BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
 
             // glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderBufferId);
             glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, framebufferTextureId, 0);
@@ -174,11 +195,17 @@ void Camera::SetRenderToTexture(bool doRenderToTexture, CameraBuffer framebuffer
             // create color buffer (not used though)
 
         } else {
-            // create render buffer
-            glGenRenderbuffers(1, &renderBufferId);
-            glBindRenderbuffer(GL_RENDERBUFFER, renderBufferId);
-            glRenderbufferStorage(GL_RENDERBUFFER, /* internalformat */GL_DEPTH_COMPONENT24, fboWidth, fboHeight);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
+            // the depth buffer is only used while rendering, so it may be
+            // shared with other cameras of the same size
+            this->depthBufferPool = depthBufferPool;
+            if (depthBufferPool != NULL){
+                renderBufferId = depthBufferPool->AcquireDepthBuffer(fboWidth, fboHeight);
+            } else {
+                glGenRenderbuffers(1, &renderBufferId);
+                glBindRenderbuffer(GL_RENDERBUFFER, renderBufferId);
+                glRenderbufferStorage(GL_RENDERBUFFER, /* internalformat */GL_DEPTH_COMPONENT24, fboWidth, fboHeight);
+            }
+            GLStateCache::Instance()->BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
             if (framebufferTextureType == GL_TEXTURE_2D) {
                 glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebufferTextureId, 0);
             } else {
@@ -196,7 +223,17 @@ void Camera::SetRenderToTexture(bool doRenderToTexture, CameraBuffer framebuffer
 
     } else {
         glDeleteFramebuffers(1, &framebufferId);
-        glDeleteRenderbuffers(1, &renderBufferId);
+        GLStateCache::Instance()->FramebufferDeleted(framebufferId);
+        if (renderBufferId != 0){
+            if (this->depthBufferPool != NULL){
+                this->depthBufferPool->ReleaseDepthBuffer(renderBufferId);
+            } else {
+                glDeleteRenderbuffers(1, &renderBufferId);
+            }
+            renderBufferId = 0;
+            this->depthBufferPool = NULL;
+        }
+        framebufferTextureId = 0;
     }
 
 }
@@ -205,13 +242,54 @@ void Camera::BindFrameBufferObject() {
     assert(renderToTexture);
 
     // target parameter : GL_FRAMEBUFFER = read/write, GL_DRAW_FRAMEBUFFER = write only
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
+    GLStateCache::Instance()->BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
 
 }
 
 void Camera::UnBindFrameBufferObject() {
     glGenerateMipmap(GL_TEXTURE_2D);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLStateCache::Instance()->BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Camera::BindRenderTarget() {
+    if (renderToTexture) {
+        BindFrameBufferObject();
+    } else {
+        GLStateCache::Instance()->BindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+glm::mat4 Camera::GetProjectionMatrix() {
+    // Same matrices as glFrustum and glOrtho
+    glm::mat4 m(0.0f);
+    if (cameraMode == PERSPECTIVE || (renderToTexture && framebufferTextureType == GL_TEXTURE_CUBE_MAP)) {
+        m[0][0] = 2*nearPlane/(right-left);
+        m[1][1] = 2*nearPlane/(top-bottom);
+        m[2][0] = (right+left)/(right-left);
+        m[2][1] = (top+bottom)/(top-bottom);
+        m[2][2] = -(farPlane+nearPlane)/(farPlane-nearPlane);
+        m[2][3] = -1;
+        m[3][2] = -2*farPlane*nearPlane/(farPlane-nearPlane);
+    } else {
+        m[0][0] = 2/(right-left);
+        m[1][1] = 2/(top-bottom);
+        m[2][2] = -2/(farPlane-nearPlane);
+        m[3][0] = -(right+left)/(right-left);
+        m[3][1] = -(top+bottom)/(top-bottom);
+        m[3][2] = -(farPlane+nearPlane)/(farPlane-nearPlane);
+        m[3][3] = 1;
+    }
+    return m;
+}
+
+bool Camera::IsDepthOnly() {
+    return renderToTexture && framebufferTargetType == GL_DEPTH_ATTACHMENT;
+}
+
+glm::mat4 Camera::GetViewMatrix() {
+    SceneObject *sceneObject = GetOwner();
+    assert(sceneObject != NULL);
+    return sceneObject->GetTransform()->GetLocalTransformInverse();
 }
 
 float *Camera::GetShadowMatrix(glm::mat4 &modelTransform) {
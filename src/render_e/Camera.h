@@ -12,7 +12,9 @@
 
 #include "RenderBase.h"
 #include "Component.h"
+#include "PoolAllocator.h"
 #include <glm/glm.hpp>
+#include "math/Frustum.h"
 
 namespace render_e {
 
@@ -25,8 +27,9 @@ enum CameraBuffer {
 
 //  forward declaration
 class Texture2D;
+class RenderGraph;
 
-class Camera : public Component {
+class Camera : public Component, public PoolAllocated<Camera> {
 public:
     Camera();
     virtual ~Camera();
@@ -50,11 +53,50 @@ public:
     void SetClearColor(glm::vec4 clearColor);
     glm::vec4 GetClearColor(){ return clearColor; }
     bool IsRenderToTexture(){ return renderToTexture; }
-    void SetRenderToTexture( bool doRenderToTexture , CameraBuffer framebufferTargetType, TextureBase *texture);
+    /// Returns the OpenGL name of the texture rendered to (0 if the camera
+    /// renders to the screen)
+    unsigned int GetRenderTextureId(){ return renderToTexture?framebufferTextureId:0; }
+    /// Returns true if the camera renders depth to a texture (shadow map)
+    bool IsDepthOnly();
+    /// When enabled (default) the opaque objects are rendered to the depth
+    /// buffer before the main pass, so only visible fragments are shaded.
+    /// Only used if enabled on the render base as well (see
+    /// RenderBase::SetDoubleSpeedZOnlyRendering())
+    void SetDepthPrePass(bool enabled) { depthPrePass = enabled; }
+    bool GetDepthPrePass() { return depthPrePass; }
+    /// When enabled, opaque objects with deferred materials are rendered
+    /// using deferred shading (see DeferredRenderer). Default is false
+    void SetDeferredShading(bool enabled) { deferredShading = enabled; }
+    bool GetDeferredShading() { return deferredShading; }
+    /// Returns the fragment count queries of the depth pre-pass of the camera
+    /// (the names are 0 until created by the render base). The queries are
+    /// deleted with the camera
+    DepthPrePassQueries &GetDepthPrePassQueries() { return depthPrePassQueries; }
+    /// Returns the id of the camera, unique for the lifetime of the
+    /// application (unlike the address, ids are never reused)
+    unsigned int GetCameraId() const { return cameraId; }
+    /// Returns the size of the viewport (updated in Setup)
+    int GetViewportWidth() { return viewportWidth; }
+    int GetViewportHeight() { return viewportHeight; }
+    /// Render to the texture instead of the screen. Color targets need a
+    /// depth buffer, which is shared with other cameras of the same size if
+    /// a pool is given (see RenderGraph::AcquireDepthBuffer()) and owned by
+    /// the camera otherwise
+    void SetRenderToTexture( bool doRenderToTexture , CameraBuffer framebufferTargetType, TextureBase *texture,
+            RenderGraph *depthBufferPool = NULL);
     void BindFrameBufferObject();
     void UnBindFrameBufferObject();
+    /// Bind the framebuffer object of the camera or the screen
+    void BindRenderTarget();
 	float *GetShadowMatrix(glm::mat4 &modelTransform);
+    /// Returns the projection matrix (same as the one loaded in Setup)
+    glm::mat4 GetProjectionMatrix();
+    /// Returns the view matrix (inverse camera transform)
+    glm::mat4 GetViewMatrix();
+    /// Returns the view frustum in world space (updated in Setup)
+    const Frustum &GetFrustum() const { return frustum; }
 private:
+    unsigned int cameraId;
     CameraMode cameraMode;
     float fieldOfView;
     float aspect;
@@ -68,8 +110,14 @@ private:
     int clearMaskNative;
     glm::vec4 clearColor;
     bool renderToTexture;
+    bool depthPrePass;
+    bool deferredShading;
+    int viewportWidth;
+    int viewportHeight;
     unsigned int framebufferId;
     unsigned int renderBufferId;
+    /// pool of renderBufferId (NULL if owned by the camera)
+    RenderGraph *depthBufferPool;
     int framebufferTargetType;
     unsigned int framebufferTextureId;
     unsigned int framebufferTextureType;
@@ -77,6 +125,8 @@ private:
     int fboHeight;
 	glm::mat4 shadowMatrix;
 	glm::mat4 shadowMatrixMultiplied;
+    Frustum frustum;
+    DepthPrePassQueries depthPrePassQueries;
 };
 }
 #endif	/* CAMERA_H */
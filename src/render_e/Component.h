@@ -23,9 +23,13 @@ enum ComponentType{
     MaterialType,
     LightComponentType,
     ParticleSystemType,
+    LODGroupType,
     CustomType
 };
 
+/// Number of component types
+const int COMPONENT_TYPE_COUNT = CustomType+1;
+
 class Component {
 public:
     Component(ComponentType componentType);
@@ -41,6 +45,13 @@ public:
     // Updates each component before every frame
     virtual void Update() {}
     
+    /// Thread safety trait. Components returning true have their Update()
+    /// invoked on the job system in parallel with other thread safe
+    /// components, so Update() must only modify the component itself (note
+    /// that modifying a Transform is not thread safe). Other components are
+    /// updated serially on the render thread afterwards.
+    virtual bool IsThreadSafe() const { return false; }
+    
     /// Get the component class name
     virtual const char* GetComponentName() const;
 private:
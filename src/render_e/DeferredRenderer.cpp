@@ -0,0 +1,283 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "DeferredRenderer.h"
+
+#include <cmath>
+#include <algorithm>
+#include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Camera.h"
+#include "SceneObject.h"
+#include "FrameUniforms.h"
+#include "LightClusters.h"
+#include "GLStateCache.h"
+#include "OpenGLHelper.h"
+#include "MeshAsset.h"
+#include "VertexFormat.h"
+#include "shaders/Shader.h"
+#include "Log.h"
+
+namespace render_e {
+
+namespace {
+/// Corners of the fullscreen quad in normalized device coordinates (drawn
+/// as a triangle fan)
+const float QUAD_VERTICES[12] = {-1, -1, 0, 1, -1, 0, 1, 1, 0, -1, 1, 0};
+
+/// Set the position attribute to the quad buffer (bound to GL_ARRAY_BUFFER)
+void setupQuadAttributes(){
+    VertexFormat format;
+    format.vertexOffset = 0;
+    format.stride = sizeof(float)*3;
+    format.SetupPositionAttribute();
+}
+}
+
+DeferredRenderer::DeferredRenderer()
+:framebufferId(0),width(0),height(0),quadBufferId(0),quadVertexArrayId(0) {
+    for (int i=0;i<GBUFFER_TEXTURE_COUNT;i++){
+        textureIds[i] = 0;
+    }
+}
+
+DeferredRenderer::~DeferredRenderer(){
+    DeleteTargets();
+    DeleteQuad();
+}
+
+bool DeferredRenderer::IsSupported(){
+    return GLEW_VERSION_2_0 && GLEW_ARB_framebuffer_object;
+}
+
+void DeferredRenderer::CreateTargets(int width, int height){
+    DeleteTargets();
+    this->width = width;
+    this->height = height;
+    GLStateCache *glState = GLStateCache::Instance();
+    glGenTextures(GBUFFER_TEXTURE_COUNT, textureIds);
+    const GLint internalFormats[GBUFFER_TEXTURE_COUNT] = {GL_RGBA8, GL_RGB10_A2, GL_DEPTH_COMPONENT24};
+    const GLenum formats[GBUFFER_TEXTURE_COUNT] = {GL_RGBA, GL_RGBA, GL_DEPTH_COMPONENT};
+    const GLenum types[GBUFFER_TEXTURE_COUNT] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_INT};
+    for (int i=0;i<GBUFFER_TEXTURE_COUNT;i++){
+        glState->BindTexture(0, GL_TEXTURE_2D, textureIds[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, formats[i], types[i], NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glState->BindTexture(0, GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebufferId);
+    glState->BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureIds[GBUFFER_ALBEDO], 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textureIds[GBUFFER_NORMAL], 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textureIds[GBUFFER_DEPTH], 0);
+    const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    GLenum frameBufferRes = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+    if (frameBufferRes != GL_FRAMEBUFFER_COMPLETE) {
+        ERROR(OpenGLHelper::GetFrameBufferStatusString(frameBufferRes));
+    }
+}
+
+void DeferredRenderer::DeleteTargets(){
+    if (framebufferId == 0){
+        return;
+    }
+    GLStateCache *glState = GLStateCache::Instance();
+    glDeleteFramebuffers(1, &framebufferId);
+    glState->FramebufferDeleted(framebufferId);
+    glDeleteTextures(GBUFFER_TEXTURE_COUNT, textureIds);
+    for (int i=0;i<GBUFFER_TEXTURE_COUNT;i++){
+        glState->TextureDeleted(textureIds[i]);
+        textureIds[i] = 0;
+    }
+    framebufferId = 0;
+}
+
+void DeferredRenderer::CreateQuad(){
+    GLStateCache *glState = GLStateCache::Instance();
+    if (MeshAsset::IsVertexArraySupported()){
+        glState->BindVertexArray(0);
+    }
+    glGenBuffers(1, &quadBufferId);
+    glState->BindBuffer(GL_ARRAY_BUFFER, quadBufferId);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+    if (MeshAsset::IsVertexArraySupported()){
+        glGenVertexArrays(1, &quadVertexArrayId);
+        glState->BindVertexArray(quadVertexArrayId);
+        setupQuadAttributes();
+        glState->BindVertexArray(0);
+    }
+    glState->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DeferredRenderer::DeleteQuad(){
+    if (quadBufferId == 0){
+        return;
+    }
+    GLStateCache *glState = GLStateCache::Instance();
+    if (quadVertexArrayId != 0){
+        glDeleteVertexArrays(1, &quadVertexArrayId);
+        glState->VertexArrayDeleted(quadVertexArrayId);
+        quadVertexArrayId = 0;
+    }
+    glDeleteBuffers(1, &quadBufferId);
+    glState->BufferDeleted(quadBufferId);
+    quadBufferId = 0;
+}
+
+void DeferredRenderer::BeginGeometryPass(Camera *camera){
+    if (camera->GetViewportWidth() != width || camera->GetViewportHeight() != height || framebufferId == 0){
+        CreateTargets(camera->GetViewportWidth(), camera->GetViewportHeight());
+    }
+    GLStateCache::Instance()->BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferId);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredRenderer::EndGeometryPass(Camera *camera){
+    camera->BindRenderTarget();
+}
+
+bool DeferredRenderer::GetScissorRectangle(const glm::vec3 &center, float radius, const glm::mat4 &projection,
+        float nearPlane, int outRectangle[4]){
+    // the view direction is -z
+    if (center.z-radius >= 0){
+        return false; // behind the camera
+    }
+    if (center.z+radius > -nearPlane){
+        // crosses the near plane: use the full viewport
+        outRectangle[0] = 0;
+        outRectangle[1] = 0;
+        outRectangle[2] = width;
+        outRectangle[3] = height;
+        return true;
+    }
+    // project the corners of the bounding box of the sphere
+    glm::vec2 minimum(1, 1);
+    glm::vec2 maximum(-1, -1);
+    for (int i=0;i<8;i++){
+        glm::vec4 corner(center.x+((i&1)?radius:-radius),
+                center.y+((i&2)?radius:-radius),
+                center.z+((i&4)?radius:-radius), 1.0f);
+        glm::vec4 clip = projection*corner;
+        glm::vec2 ndc(clip.x/clip.w, clip.y/clip.w);
+        minimum = glm::min(minimum, ndc);
+        maximum = glm::max(maximum, ndc);
+    }
+    minimum = glm::max(minimum, glm::vec2(-1, -1));
+    maximum = glm::min(maximum, glm::vec2(1, 1));
+    if (minimum.x >= maximum.x || minimum.y >= maximum.y){
+        return false;
+    }
+    outRectangle[0] = static_cast<int>(floor((minimum.x*0.5f+0.5f)*width));
+    outRectangle[1] = static_cast<int>(floor((minimum.y*0.5f+0.5f)*height));
+    outRectangle[2] = static_cast<int>(ceil((maximum.x*0.5f+0.5f)*width))-outRectangle[0];
+    outRectangle[3] = static_cast<int>(ceil((maximum.y*0.5f+0.5f)*height))-outRectangle[1];
+    return true;
+}
+
+void DeferredRenderer::DrawFullscreenQuad(){
+    GLStateCache *glState = GLStateCache::Instance();
+    if (quadBufferId == 0){
+        CreateQuad();
+    }
+    // the quad is read through re_VertexPosition, so it must not be decoded
+    MeshAsset::ResetDecoding();
+    if (quadVertexArrayId != 0){
+        glState->BindVertexArray(quadVertexArrayId);
+    } else {
+        glState->BindBuffer(GL_ARRAY_BUFFER, quadBufferId);
+        if (glState->SetVertexArraySource(quadBufferId)){
+            setupQuadAttributes();
+        }
+    }
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+int DeferredRenderer::RenderLights(Camera *camera, const std::vector<SceneObject*> &lights, Shader *lightShader){
+    GLStateCache *glState = GLStateCache::Instance();
+    lightShader->Bind();
+    for (int i=0;i<GBUFFER_TEXTURE_COUNT;i++){
+        glState->BindTexture(i, GL_TEXTURE_2D, textureIds[i]);
+    }
+    glState->Uniform1i(lightShader->GetUniformLocation("gbufferAlbedo"), GBUFFER_ALBEDO);
+    glState->Uniform1i(lightShader->GetUniformLocation("gbufferNormal"), GBUFFER_NORMAL);
+    glState->Uniform1i(lightShader->GetUniformLocation("gbufferDepth"), GBUFFER_DEPTH);
+    glm::mat4 projection = camera->GetProjectionMatrix();
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    glState->UniformMatrix4fv(lightShader->GetUniformLocation("inverseProjection"), glm::value_ptr(inverseProjection));
+    glm::vec2 inverseViewportSize(1.0f/width, 1.0f/height);
+    glState->Uniform2fv(lightShader->GetUniformLocation("inverseViewportSize"), glm::value_ptr(inverseViewportSize));
+    int lightModeId = lightShader->GetUniformLocation("lightMode");
+
+    // ambient term and depth of the G-buffer
+    glState->SetCapability(GL_BLEND, false);
+    glState->DepthMask(true);
+    glState->DepthFunc(GL_ALWAYS);
+    glState->Uniform1i(lightModeId, 0);
+    DrawFullscreenQuad();
+
+    // lights are added without depth test (the depth is read from the
+    // G-buffer)
+    glState->SetCapability(GL_DEPTH_TEST, false);
+    glState->DepthMask(false);
+    glState->SetCapability(GL_BLEND, true);
+    glState->BlendFunc(GL_ONE, GL_ONE);
+    glState->SetCapability(GL_SCISSOR_TEST, true);
+    glState->Uniform1i(lightModeId, 1);
+    int positionId = lightShader->GetUniformLocation("lightPosition");
+    int spotDirectionId = lightShader->GetUniformLocation("lightSpotDirection");
+    int ambientId = lightShader->GetUniformLocation("lightAmbient");
+    int diffuseId = lightShader->GetUniformLocation("lightDiffuse");
+    int specularId = lightShader->GetUniformLocation("lightSpecular");
+    int attenuationId = lightShader->GetUniformLocation("lightAttenuation");
+    glm::mat4 view = camera->GetViewMatrix();
+    int lightsDrawn = 0;
+    for (std::vector<SceneObject*>::const_iterator iter = lights.begin();iter != lights.end();iter++){
+        LightUniforms light;
+        FrameUniforms::PackLight(*iter, light);
+        glm::vec4 position = view*glm::vec4(light.position[0], light.position[1], light.position[2], light.position[3]);
+        glm::vec3 spotDirection = glm::vec3(view*glm::vec4(light.spotDirection[0], light.spotDirection[1],
+                light.spotDirection[2], 0.0f));
+        int rectangle[4] = {0, 0, width, height};
+        if (light.position[3] != 0){
+            float range = LightClusters::GetLightRange(light);
+            if (range == 0){
+                continue;
+            }
+            if (range > 0 && !GetScissorRectangle(glm::vec3(position), range, projection, camera->GetNearPlane(), rectangle)){
+                continue;
+            }
+        }
+        glScissor(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+        glState->Uniform4fv(positionId, glm::value_ptr(position));
+        glm::vec4 spot(spotDirection, light.spotDirection[3]);
+        glState->Uniform4fv(spotDirectionId, glm::value_ptr(spot));
+        glState->Uniform4fv(ambientId, light.ambient);
+        glState->Uniform4fv(diffuseId, light.diffuse);
+        glState->Uniform4fv(specularId, light.specular);
+        glState->Uniform4fv(attenuationId, light.attenuation);
+        DrawFullscreenQuad();
+        lightsDrawn++;
+    }
+
+    glState->SetCapability(GL_SCISSOR_TEST, false);
+    glState->SetCapability(GL_BLEND, false);
+    glState->SetCapability(GL_DEPTH_TEST, true);
+    glState->DepthMask(true);
+    glState->DepthFunc(GL_LEQUAL);
+    if (MeshAsset::IsVertexArraySupported()){
+        glState->BindVertexArray(0);
+    }
+    return lightsDrawn;
+}
+}
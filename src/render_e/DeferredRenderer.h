@@ -0,0 +1,87 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_DEFERREDRENDERER_H
+#define	RENDER_E_DEFERREDRENDERER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace render_e {
+
+// forward declaration
+class SceneObject;
+class Camera;
+class Shader;
+
+/// Textures of the G-buffer
+enum GBufferTexture {
+    /// RGBA8: albedo
+    GBUFFER_ALBEDO = 0,
+    /// RGB10_A2: eye space normal (octahedral encoding in RG)
+    GBUFFER_NORMAL = 1,
+    /// DEPTH_COMPONENT24: depth (the eye space position is reconstructed
+    /// from the depth)
+    GBUFFER_DEPTH = 2,
+    GBUFFER_TEXTURE_COUNT = 3
+};
+
+///
+/// Deferred shading: opaque objects with deferred materials (see
+/// Material::IsDeferred()) are rendered to the G-buffer (packed normals,
+/// albedo and depth). Then the lights are accumulated into the camera target,
+/// each light drawing only the screen rectangle covered by its light volume
+/// (the sphere of LightClusters::GetLightRange()). The light pass also
+/// copies the depth to the camera target, so the forward materials are
+/// rendered afterwards as usual.
+/// Requires OpenGL 2.0 (multiple render targets) and framebuffer objects.
+///
+class DeferredRenderer {
+public:
+    DeferredRenderer();
+    ~DeferredRenderer();
+
+    /// Returns true if the OpenGL driver supports deferred shading
+    static bool IsSupported();
+
+    /// Bind and clear the G-buffer (resized to the viewport of the camera
+    /// if needed)
+    void BeginGeometryPass(Camera *camera);
+    /// Bind the target of the camera again
+    void EndGeometryPass(Camera *camera);
+    /// Write the ambient term and the depth of the G-buffer to the camera
+    /// target and add the contribution of each light. Returns the number of
+    /// lights drawn (lights outside the view are skipped)
+    int RenderLights(Camera *camera, const std::vector<SceneObject*> &lights, Shader *lightShader);
+private:
+    DeferredRenderer(const DeferredRenderer& orig); // disallow copy constructor
+    DeferredRenderer& operator = (const DeferredRenderer&); // disallow copy constructor
+
+    void CreateTargets(int width, int height);
+    void DeleteTargets();
+    /// Compute the viewport rectangle covered by the sphere (eye space).
+    /// Returns false if the sphere is outside the view
+    bool GetScissorRectangle(const glm::vec3 &center, float radius, const glm::mat4 &projection,
+            float nearPlane, int outRectangle[4]);
+    /// Create the vertex buffer (and vertex array object if supported) of
+    /// the fullscreen quad
+    void CreateQuad();
+    void DeleteQuad();
+    void DrawFullscreenQuad();
+
+    unsigned int framebufferId;
+    unsigned int textureIds[GBUFFER_TEXTURE_COUNT];
+    int width;
+    int height;
+    /// fullscreen quad (created on first use)
+    unsigned int quadBufferId;
+    unsigned int quadVertexArrayId;
+};
+}
+
+#endif	/* RENDER_E_DEFERREDRENDERER_H */
+
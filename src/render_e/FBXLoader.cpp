@@ -15,6 +15,7 @@
 #include "MeshComponent.h"
 #include "SceneObject.h"
 #include "Mesh.h"
+#include "MeshWelder.h"
 #include "Log.h"
 
 using namespace std;
@@ -22,7 +23,8 @@ using namespace std;
 #ifndef NO_FBX_LOADER
 
 namespace render_e {
-FBXLoader::FBXLoader() {
+FBXLoader::FBXLoader()
+:computeTangents(false) {
    manager = KFbxSdkManager::Create();
    int major, minor, revision;
    KFbxSdkManager::GetFileFormatVersion(major, minor, revision);
@@ -31,7 +33,8 @@ FBXLoader::FBXLoader() {
    INFO(ss.str());
 }
 
-FBXLoader::FBXLoader(const FBXLoader& orig) {
+FBXLoader::FBXLoader(const FBXLoader& orig)
+:computeTangents(orig.computeTangents) {
 }
 
 FBXLoader::~FBXLoader() {
@@ -46,7 +49,114 @@ glm::vec3 toVector(const fbxDouble3 &v){
     return glm::vec3(v[0], v[1], v[2]);
 }
 
-SceneObject* parseNode(KFbxNode *node, int level = 0) {
+/// Returns the index into the direct array of the layer element for the
+/// polygon vertex (-1 if the mapping is not supported)
+int getLayerElementIndex(KFbxLayerElement *element, KFbxLayerElementArrayTemplate<int> &indexArray,
+        int controlPoint, int polygonVertex, int polygon){
+    int index;
+    switch (element->GetMappingMode()){
+        case KFbxLayerElement::eBY_CONTROL_POINT:
+            index = controlPoint;
+            break;
+        case KFbxLayerElement::eBY_POLYGON_VERTEX:
+            index = polygonVertex;
+            break;
+        case KFbxLayerElement::eBY_POLYGON:
+            index = polygon;
+            break;
+        case KFbxLayerElement::eALL_SAME:
+            index = 0;
+            break;
+        default:
+            return -1;
+    }
+    if (element->GetReferenceMode() != KFbxLayerElement::eDIRECT){
+        index = indexArray.GetAt(index);
+    }
+    return index;
+}
+
+Mesh *createMesh(KFbxMesh *fbxMesh, bool computeTangents, stringstream &ss){
+    KFbxVector4 *controlPoints = fbxMesh->GetControlPoints();
+    int polygonCount = fbxMesh->GetPolygonCount();
+    // normals and texture coordinates are read from the first layer
+    KFbxLayer *layer = fbxMesh->GetLayer(0);
+    KFbxLayerElementNormal *normalElement = layer != NULL ? layer->GetNormals() : NULL;
+    KFbxLayerElementUV *uvElement = layer != NULL ? layer->GetUVs() : NULL;
+
+    // the attributes are read per polygon vertex (so seams are kept) and
+    // the shared vertices are welded afterwards
+    vector<glm::vec3> vertices;
+    vector<glm::vec3> normals;
+    vector<glm::vec2> texCords;
+    vector<int> indices;
+    int polygonVertex = 0;
+    for (int i=0;i<polygonCount;i++){
+        int polygonSize = fbxMesh->GetPolygonSize(i);
+        int first = static_cast<int>(vertices.size());
+        for (int j=0;j<polygonSize;j++){
+            int controlPoint = fbxMesh->GetPolygonVertex(i,j);
+            vertices.push_back(toVector(controlPoints[controlPoint]));
+            if (normalElement != NULL){
+                int index = getLayerElementIndex(normalElement, normalElement->GetIndexArray(), controlPoint,
+                        polygonVertex, i);
+                normals.push_back(index >= 0 ? toVector(normalElement->GetDirectArray().GetAt(index)) :
+                        glm::vec3(0,0,0));
+            }
+            if (uvElement != NULL){
+                int index = getLayerElementIndex(uvElement, uvElement->GetIndexArray(), controlPoint,
+                        polygonVertex, i);
+                glm::vec2 uv(0,0);
+                if (index >= 0){
+                    KFbxVector2 v = uvElement->GetDirectArray().GetAt(index);
+                    uv = glm::vec2(v[0], v[1]);
+                }
+                texCords.push_back(uv);
+            }
+            if (j>1){
+                // triangulate the polygon as a fan
+                indices.push_back(first);
+                indices.push_back(first+j-1);
+                indices.push_back(first+j);
+            }
+            polygonVertex++;
+        }
+    }
+    
+    Mesh *mesh = new Mesh();
+    mesh->SetVertices(vertices);
+    mesh->SetNormals(normals);
+    mesh->SetTextureCoords1(texCords);
+    mesh->SetIndices(indices);
+    MeshWeldStats stats = MeshWelder::Weld(mesh);
+    if (normals.empty()){
+        mesh->ComputeNormals();
+    }
+    if (computeTangents && !texCords.empty()){
+        mesh->ComputeTangents();
+    }
+    ss<<"Creating mesh: polygon vertices "<<stats.verticesBefore<<" vertices "<<stats.verticesAfter
+            <<" normals "<<normals.size()<<" uvs "<<texCords.size()<<" indices "<<indices.size()
+            <<" bytes "<<stats.bytesBefore<<" -> "<<stats.bytesAfter<<endl;
+    return mesh;
+}
+
+/// Returns the first mesh in the node hierarchy (depth first) or NULL
+KFbxMesh *findMesh(KFbxNode *node){
+    if (node->GetNodeAttribute() != NULL &&
+            node->GetNodeAttribute()->GetAttributeType() == KFbxNodeAttribute::eMESH){
+        return node->GetMesh();
+    }
+    for (int i=0;i<node->GetChildCount();i++){
+        KFbxMesh *mesh = findMesh(node->GetChild(i));
+        if (mesh != NULL){
+            return mesh;
+        }
+    }
+    return NULL;
+}
+
+SceneObject* parseNode(KFbxNode *node, bool computeTangents, int level = 0) {
     KString s = node->GetName();
     KFbxNodeAttribute::EAttributeType attributeType;
     stringstream ss;
@@ -69,63 +179,12 @@ SceneObject* parseNode(KFbxNode *node, int level = 0) {
                 break;
             case KFbxNodeAttribute::eMESH:
                 {
-                KFbxMesh *fbxMesh = node->GetMesh();
-                KFbxVector4 *controlPoints = fbxMesh->GetControlPoints();
-                int polygonCount = fbxMesh->GetPolygonCount();
-                vector<glm::vec3> vertices;
-                vector<glm::vec3> normals;
-                vector<glm::vec2> texCords;
-                vector<int> polycount;
-                assert(fbxMesh->GetLayerCount(KFbxLayerElement::eNORMAL)==1); // assume only one normal layer
-                KFbxLayer *normalLayer = fbxMesh->GetLayer(0, KFbxLayerElement::eNORMAL);
-                KFbxLayerElementNormal *normalElement = normalLayer->GetNormals();
-                KFbxLayerElementArrayTemplate<KFbxVector4> *normalArray = &(normalElement->GetDirectArray());
-                
-                int normalCount = normalArray->GetCount();
-                vector<int> indices;
-                
-                assert(fbxMesh->GetControlPointsCount() <= USHRT_MAX);
-                for (int i=0;i<fbxMesh->GetControlPointsCount();i++){
-                    glm::vec3 v = toVector(controlPoints[i]);
-                    vertices.push_back(v);
-                    v = toVector(normalArray->GetAt(i));
-                    normals.push_back(v);
-                }
-                
-                
-                for (int i=0;i<polygonCount;i++){
-                    int polygonSize = fbxMesh->GetPolygonSize(i);
-                    polycount.push_back(polygonSize);
-                    for (int j=0;j<polygonSize;j++){
-                        if (j>2){
-                            // if polygon size > 2 then add first and last index
-                            // this triangulates the mesh
-                            int first = fbxMesh->GetPolygonVertex(i,0);
-                            int last = fbxMesh->GetPolygonVertex(i,j-1);
-                            indices.push_back(first);
-                            indices.push_back(last);
-                        }
-                        int polygonIndex = fbxMesh->GetPolygonVertex(i,j);
-                        indices.push_back(polygonIndex);
-                        /*KFbxVector4 vectorSrc = controlPoints[polygonIndex];
-                        Vector3 vectorDst = toVector(vectorSrc);
-                        vertices.push_back(vectorDst);
-                        texCords.push_back(Vector2(0,0)); 
-                        KFbxVector4 normalSrc = normalArray->GetAt(polygonIndex);
-                        Vector3 normalDst = toVector(normalSrc);
-                        normals.push_back(normalDst);*/
-                    }
-                }
-                
-                Mesh mesh;
-                ss<<"Creating mesh: vertices "<<vertices.size()<<" normals "<<normals.size()<<" indices "<<indices.size()<<endl;
-                mesh.SetVertices(vertices);
-                mesh.SetNormals(normals);
-                mesh.SetIndices(indices);
+                Mesh *mesh = createMesh(node->GetMesh(), computeTangents, ss);
                 sceneObject = new SceneObject();
                 
                 ga = new MeshComponent();
-                ga->SetMesh(&mesh);
+                ga->SetMesh(mesh);
+                delete mesh;
                 sceneObject->AddCompnent(ga);
                 
                 // Set translate
@@ -160,7 +219,7 @@ SceneObject* parseNode(KFbxNode *node, int level = 0) {
     
     if (node->GetChildCount()>0){
         for (int i=0;i<node->GetChildCount();i++){
-            SceneObject *res = parseNode(node->GetChild(i),level+1);
+            SceneObject *res = parseNode(node->GetChild(i), computeTangents, level+1);
             if (res!=NULL){
                 if (sceneObject == NULL){
                     sceneObject = new SceneObject();
@@ -173,38 +232,47 @@ SceneObject* parseNode(KFbxNode *node, int level = 0) {
     return sceneObject;
 }
 
-MeshComponent *getMeshComponent(SceneObject *sceneObject){
-	MeshComponent *mesh = sceneObject->GetMesh(); 
-	if (mesh!= NULL){
-		return mesh;
-	}
-
-	// search in children
-	const vector<Transform*> *children = sceneObject->GetTransform()->GetChildren();
-	for (vector<Transform*>::const_iterator iter = children->begin();iter != children->end();iter++){
-		Transform *childTransform = *iter;
-		SceneObject *child = childTransform->GetOwner();
-		if (child != NULL){
-			mesh = getMeshComponent(child);
-			if (mesh!=NULL){
-				return mesh;
-			}
-		}
+MeshComponent *FBXLoader::LoadMeshComponent(const char *filename){
+	Mesh *mesh = LoadMesh(filename);
+	if (mesh == NULL){
+		return NULL;
 	}
-
-	return NULL;
+	MeshComponent *meshComponent = new MeshComponent();
+	meshComponent->SetMesh(mesh);
+	delete mesh;
+	return meshComponent;
 }
 
-MeshComponent *FBXLoader::LoadMeshComponent(const char *filename){
-	SceneObject *sceneObject = Load(filename);
-	// Here there is a memory leak!!!
-	return getMeshComponent(sceneObject);
+Mesh *FBXLoader::LoadMesh(const char *filename){
+    KFbxScene *scene = Import(filename);
+    if (scene == NULL){
+        return NULL;
+    }
+    Mesh *mesh = NULL;
+    KFbxMesh *fbxMesh = findMesh(scene->GetRootNode());
+    if (fbxMesh != NULL){
+        stringstream ss;
+        mesh = createMesh(fbxMesh, computeTangents, ss);
+        DEBUG(ss.str());
+    }
+    scene->Destroy();
+    return mesh;
 }
 
 SceneObject *FBXLoader::Load(const char *filename){
     SceneObject *so = NULL;
+    KFbxScene *scene = Import(filename);
+    if (scene != NULL){
+        so = parseNode(scene->GetRootNode(), computeTangents);
+        scene->Destroy();
+    }
+    return so;
+}
+
+KFbxScene *FBXLoader::Import(const char *filename){
     KFbxScene *scene = KFbxScene::Create(manager, "");
     KFbxImporter *importer = KFbxImporter::Create(manager, "");
+    bool importSuccess = false;
     int fileFormat = -1;
     const bool fileFormatFound =
             manager->GetIOPluginRegistry()->DetectReaderFileFormat(filename, fileFormat);
@@ -212,11 +280,8 @@ SceneObject *FBXLoader::Load(const char *filename){
         bool initSuccess = importer->Initialize(filename, fileFormat);
         if (initSuccess) {
            
-            bool importSuccess = importer->Import(scene);   
-            if (importSuccess) {
-                KFbxNode *node = scene->GetRootNode();
-                so = parseNode(node);
-            } else {
+            importSuccess = importer->Import(scene);   
+            if (!importSuccess) {
                 stringstream ss;
                 ss<<"ModelLoad import error "<<importer->GetLastErrorString();
                 ERROR(ss.str());
@@ -228,8 +293,11 @@ SceneObject *FBXLoader::Load(const char *filename){
         }
     }
     importer->Destroy();
-    scene->Destroy();
-    return so;
+    if (!importSuccess){
+        scene->Destroy();
+        return NULL;
+    }
+    return scene;
 }
 }
-#endif /* NO_FBX_LOADER */
\ No newline at end of file
+#endif /* NO_FBX_LOADER */
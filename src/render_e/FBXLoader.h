@@ -27,8 +27,19 @@ public:
     virtual ~FBXLoader();
     SceneObject *Load(const char *filename);
 	MeshComponent *LoadMeshComponent(const char *filename);
+    /// Load the first mesh in the file (without creating scene objects).
+    /// Returns NULL if no mesh is found. The caller owns the mesh.
+    Mesh *LoadMesh(const char *filename);
+    /// When enabled the tangents of meshes with texture coordinates are
+    /// computed on import (see Mesh::ComputeTangents()). Default is false
+    void SetComputeTangents(bool enabled) { computeTangents = enabled; }
+    bool GetComputeTangents() const { return computeTangents; }
 private:
+    /// Import the file into a new scene (NULL if import fails). The scene
+    /// must be destroyed by the caller
+    KFbxScene *Import(const char *filename);
     KFbxSdkManager *manager;
+    bool computeTangents;
 };
 }
 
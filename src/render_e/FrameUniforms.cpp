@@ -0,0 +1,264 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "FrameUniforms.h"
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneObject.h"
+#include "Camera.h"
+#include "Light.h"
+#include "LightClusters.h"
+#include "GLStateCache.h"
+#include "Log.h"
+#include "OpenGLHelper.h"
+#include "math/Mathf.h"
+
+// GL_ARB_uniform_buffer_object is newer than the bundled GLEW, so the tokens
+// and entry points are declared here
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#endif
+#ifndef GL_MAX_UNIFORM_BLOCK_SIZE
+#define GL_MAX_UNIFORM_BLOCK_SIZE 0x8A30
+#endif
+#ifndef GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
+
+namespace render_e {
+
+namespace {
+typedef GLuint (RENDER_E_APIENTRY *GetUniformBlockIndexFunc)(GLuint program, const GLchar *uniformBlockName);
+typedef void (RENDER_E_APIENTRY *UniformBlockBindingFunc)(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+typedef void (RENDER_E_APIENTRY *BindBufferRangeFunc)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+typedef void (RENDER_E_APIENTRY *BindBufferBaseFunc)(GLenum target, GLuint index, GLuint buffer);
+
+GetUniformBlockIndexFunc getUniformBlockIndex = NULL;
+UniformBlockBindingFunc uniformBlockBinding = NULL;
+BindBufferRangeFunc bindBufferRange = NULL;
+BindBufferBaseFunc bindBufferBase = NULL;
+
+bool loadEntryPoints(){
+    if (!OpenGLHelper::HasExtension("GL_ARB_uniform_buffer_object")){
+        return false;
+    }
+    getUniformBlockIndex = (GetUniformBlockIndexFunc)OpenGLHelper::GetProcAddress("glGetUniformBlockIndex");
+    uniformBlockBinding = (UniformBlockBindingFunc)OpenGLHelper::GetProcAddress("glUniformBlockBinding");
+    bindBufferRange = (BindBufferRangeFunc)OpenGLHelper::GetProcAddress("glBindBufferRange");
+    bindBufferBase = (BindBufferBaseFunc)OpenGLHelper::GetProcAddress("glBindBufferBase");
+    return getUniformBlockIndex != NULL && uniformBlockBinding != NULL &&
+            bindBufferRange != NULL && bindBufferBase != NULL;
+}
+
+void copyVec4(float *dest, const glm::vec4 &v){
+    memcpy(dest, glm::value_ptr(v), 4*sizeof(float));
+}
+}
+
+FrameUniforms::FrameUniforms()
+:lightLimitWarned(false),cameraStride(0),lightBufferId(0),cameraBufferId(0),clusterTextureId(0),lightIndexTextureId(0) {
+    memset(lightCount, 0, sizeof(lightCount));
+}
+
+FrameUniforms::~FrameUniforms(){
+    if (lightBufferId != 0){
+        glDeleteBuffers(1, &lightBufferId);
+    }
+    if (cameraBufferId != 0){
+        glDeleteBuffers(1, &cameraBufferId);
+    }
+    if (clusterTextureId != 0){
+        glDeleteTextures(1, &clusterTextureId);
+        glDeleteTextures(1, &lightIndexTextureId);
+    }
+}
+
+bool FrameUniforms::IsSupported(){
+    static bool loaded = false;
+    static bool supported = false;
+    if (!loaded){
+        loaded = true;
+        supported = loadEntryPoints();
+        if (!supported){
+            INFO("GL_ARB_uniform_buffer_object not supported - using fixed-function lights");
+        }
+    }
+    return supported;
+}
+
+bool FrameUniforms::IsClusteringSupported(){
+    return IsSupported() && GLEW_ARB_texture_float;
+}
+
+int FrameUniforms::GetMaxLights(){
+    static int maxLights = 0;
+    if (maxLights == 0){
+        GLint maxBlockSize = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+        // the light count header is followed by the light array
+        int blockLights = (maxBlockSize - (int)(4*sizeof(int)))/(int)sizeof(LightUniforms);
+        maxLights = std::max(blockLights, MIN_UNIFORM_LIGHTS);
+    }
+    return maxLights;
+}
+
+void FrameUniforms::BindUniformBlocks(unsigned int programId){
+    if (!IsSupported()){
+        return;
+    }
+    GLuint cameraIndex = getUniformBlockIndex(programId, "re_Camera");
+    if (cameraIndex != GL_INVALID_INDEX){
+        uniformBlockBinding(programId, cameraIndex, UNIFORM_BLOCK_CAMERA);
+    }
+    GLuint lightsIndex = getUniformBlockIndex(programId, "re_Lights");
+    if (lightsIndex != GL_INVALID_INDEX){
+        uniformBlockBinding(programId, lightsIndex, UNIFORM_BLOCK_LIGHTS);
+    }
+    GLint clusterLocation = glGetUniformLocation(programId, "re_ClusterTexture");
+    GLint lightIndexLocation = glGetUniformLocation(programId, "re_LightIndexTexture");
+    if (clusterLocation != -1 || lightIndexLocation != -1){
+        GLStateCache *glState = GLStateCache::Instance();
+        GLuint program = glState->GetProgram();
+        glState->UseProgram(programId);
+        glState->Uniform1i(clusterLocation, CLUSTER_TEXTURE_UNIT);
+        glState->Uniform1i(lightIndexLocation, LIGHT_INDEX_TEXTURE_UNIT);
+        glState->UseProgram(program);
+    }
+}
+
+void FrameUniforms::PackLight(SceneObject *lightObject, LightUniforms &outData){
+    Light *light = lightObject->GetLight();
+    float w = light->GetLightType()==DirectionalLight ? 0.0f : 1.0f;
+    copyVec4(outData.position, glm::vec4(lightObject->GetTransform()->GetPosition(), w));
+    float cosCutoff = -1.0f;
+    if (light->GetLightType()==SpotLight && light->GetSpotCutoff() < 180){
+        cosCutoff = cos(light->GetSpotCutoff()*Mathf::DEGREE_TO_RADIAN);
+    }
+    copyVec4(outData.spotDirection, glm::vec4(light->GetSpotDirection(), cosCutoff));
+    copyVec4(outData.ambient, light->GetAmbient());
+    copyVec4(outData.diffuse, light->GetDiffuse());
+    copyVec4(outData.specular, light->GetSpecular());
+    outData.attenuation[0] = light->GetConstantAttenuation();
+    outData.attenuation[1] = light->GetLinearAttenuation();
+    outData.attenuation[2] = light->GetQuadraticAttenuation();
+    outData.attenuation[3] = 0.0f; // spot exponent
+}
+
+void FrameUniforms::Update(const std::vector<SceneObject*> &lights, const std::vector<SceneObject*> &cameras){
+    // lights
+    // lights without a finite range are processed by every fragment, so the
+    // clustered shaders find them first
+    int maxLights = GetMaxLights();
+    if ((int)lights.size() > maxLights && !lightLimitWarned){
+        lightLimitWarned = true;
+        std::stringstream ss;
+        ss<<"Scene has "<<lights.size()<<" lights - only the first "<<maxLights<<" are rendered";
+        WARN(ss.str());
+    }
+    this->lights.resize(maxLights);
+    int count = 0;
+    int globalLightCount = 0;
+    for (std::vector<SceneObject*>::const_iterator iter = lights.begin(); iter != lights.end() && count < maxLights;iter++){
+        LightUniforms &light = this->lights[count];
+        PackLight(*iter, light);
+        if (LightClusters::GetLightRange(light) < 0){
+            if (globalLightCount < count){
+                std::swap(light, this->lights[globalLightCount]);
+            }
+            globalLightCount++;
+        }
+        count++;
+    }
+    lightCount[0] = count;
+    lightCount[1] = globalLightCount;
+    if (lightBufferId == 0){
+        glGenBuffers(1, &lightBufferId);
+    }
+    // the buffer holds the whole block, but only the used part of the light
+    // array is uploaded
+    glBindBuffer(GL_UNIFORM_BUFFER, lightBufferId);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(lightCount) + maxLights*sizeof(LightUniforms), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(lightCount), lightCount);
+    if (count > 0){
+        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(lightCount), count*sizeof(LightUniforms), &this->lights[0]);
+    }
+
+    // cameras (each range must start at a multiple of the offset alignment)
+    if (cameraStride == 0){
+        int alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment < 1){
+            alignment = 256;
+        }
+        cameraStride = ((sizeof(CameraUniforms)+alignment-1)/alignment)*alignment;
+    }
+    cameraData.resize(cameras.size()*cameraStride);
+    for (unsigned int i=0;i<cameras.size();i++){
+        Camera *camera = cameras[i]->GetCamera();
+        CameraUniforms *data = reinterpret_cast<CameraUniforms*>(&cameraData[i*cameraStride]);
+        memcpy(data->viewMatrix, glm::value_ptr(camera->GetViewMatrix()), sizeof(data->viewMatrix));
+        glm::mat4 projection = camera->GetProjectionMatrix();
+        memcpy(data->projectionMatrix, glm::value_ptr(projection), sizeof(data->projectionMatrix));
+        // perspective projections divide by the depth
+        bool perspective = projection[2][3] != 0.0f;
+        copyVec4(data->clusterParameters, LightClusters::GetSliceParameters(camera->GetNearPlane(),
+                camera->GetFarPlane(), perspective));
+    }
+    if (!cameraData.empty()){
+        if (cameraBufferId == 0){
+            glGenBuffers(1, &cameraBufferId);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, cameraBufferId);
+        glBufferData(GL_UNIFORM_BUFFER, cameraData.size(), &cameraData[0], GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniforms::Bind(int cameraIndex){
+    assert(cameraIndex*cameraStride < (int)cameraData.size());
+    bindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_CAMERA, cameraBufferId, cameraIndex*cameraStride, sizeof(CameraUniforms));
+    bindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_LIGHTS, lightBufferId);
+}
+
+void FrameUniforms::UploadClusters(const LightClusters &lightClusters){
+    GLStateCache *glState = GLStateCache::Instance();
+    if (clusterTextureId == 0){
+        glGenTextures(1, &clusterTextureId);
+        glGenTextures(1, &lightIndexTextureId);
+        glState->BindTexture(CLUSTER_TEXTURE_UNIT, GL_TEXTURE_2D, clusterTextureId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA32F_ARB, CLUSTER_TILE_COUNT, CLUSTER_SLICES, 0,
+                GL_LUMINANCE_ALPHA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glState->BindTexture(LIGHT_INDEX_TEXTURE_UNIT, GL_TEXTURE_2D, lightIndexTextureId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE32F_ARB, LIGHT_INDEX_TEXTURE_WIDTH, LIGHT_INDEX_TEXTURE_HEIGHT, 0,
+                GL_LUMINANCE, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glState->BindTexture(CLUSTER_TEXTURE_UNIT, GL_TEXTURE_2D, clusterTextureId);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CLUSTER_TILE_COUNT, CLUSTER_SLICES, GL_LUMINANCE_ALPHA, GL_FLOAT,
+            &lightClusters.GetClusterData()[0]);
+    glState->BindTexture(LIGHT_INDEX_TEXTURE_UNIT, GL_TEXTURE_2D, lightIndexTextureId);
+    const std::vector<float> &lightIndices = lightClusters.GetLightIndices();
+    if (!lightIndices.empty()){
+        // only the used rows
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, LIGHT_INDEX_TEXTURE_WIDTH, lightIndices.size()/LIGHT_INDEX_TEXTURE_WIDTH,
+                GL_LUMINANCE, GL_FLOAT, &lightIndices[0]);
+    }
+}
+}
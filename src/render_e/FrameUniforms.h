@@ -0,0 +1,128 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_FRAMEUNIFORMS_H
+#define	RENDER_E_FRAMEUNIFORMS_H
+
+#include <vector>
+
+namespace render_e {
+
+// forward declaration
+class SceneObject;
+class LightClusters;
+
+/// Number of lights in the light uniform block when the driver reports no
+/// larger GL_MAX_UNIFORM_BLOCK_SIZE (see FrameUniforms::GetMaxLights()). The
+/// block fits in the 16 KB guaranteed by GL_ARB_uniform_buffer_object
+const int MIN_UNIFORM_LIGHTS = 128;
+
+/// Binding points of the uniform blocks of the shared shader library
+enum UniformBlockBinding {
+    UNIFORM_BLOCK_CAMERA = 0,
+    UNIFORM_BLOCK_LIGHTS = 1
+};
+
+/// Texture units of the cluster textures of the shared shader library (the
+/// last units guaranteed by OpenGL 2.0, so materials can use the first units)
+enum ClusterTextureUnit {
+    CLUSTER_TEXTURE_UNIT = 14,
+    LIGHT_INDEX_TEXTURE_UNIT = 15
+};
+
+/// std140 layout of the re_Camera uniform block
+struct CameraUniforms {
+    float viewMatrix[16];
+    float projectionMatrix[16];
+    /// maps the eye space depth to a cluster slice (see
+    /// LightClusters::GetSliceParameters())
+    float clusterParameters[4];
+};
+
+/// std140 layout of a light in the re_Lights uniform block. Positions and
+/// directions are in world space (transformed to eye space in the shader)
+struct LightUniforms {
+    /// w is 0 for directional lights
+    float position[4];
+    /// xyz is the spot direction, w the cosine of the spot cutoff (-1 for
+    /// point and directional lights)
+    float spotDirection[4];
+    float ambient[4];
+    float diffuse[4];
+    float specular[4];
+    /// constant, linear and quadratic attenuation and the spot exponent
+    float attenuation[4];
+};
+
+///
+/// Uniform buffers with the per frame data read by the shared shader library:
+/// the lights (uploaded once per frame) and the matrices of every camera
+/// (uploaded once per frame, each camera binds its own range of the buffer).
+/// This replaces the fixed-function light state, which had to be specified
+/// for each camera and was limited to the GL_MAX_LIGHTS lights.
+/// Requires GL_ARB_uniform_buffer_object.
+///
+class FrameUniforms {
+public:
+    FrameUniforms();
+    ~FrameUniforms();
+
+    /// Returns true if the OpenGL driver supports uniform buffers (the entry
+    /// points are loaded on the first call)
+    static bool IsSupported();
+    /// Returns true if clustered lighting is supported (uniform buffers and
+    /// float textures)
+    static bool IsClusteringSupported();
+    /// Maximum number of lights in the light uniform block (RE_MAX_LIGHTS in
+    /// the shared shader library): as many as fit in GL_MAX_UNIFORM_BLOCK_SIZE,
+    /// at least MIN_UNIFORM_LIGHTS
+    static int GetMaxLights();
+    /// Bind the uniform blocks of the linked program to the binding points
+    /// and the cluster samplers to their texture units (programs not
+    /// declaring them are ignored)
+    static void BindUniformBlocks(unsigned int programId);
+    /// Pack the light of the scene object (world space)
+    static void PackLight(SceneObject *lightObject, LightUniforms &outData);
+
+    /// Pack and upload the lights and the matrices of the cameras. Lights
+    /// without a finite range are stored first
+    void Update(const std::vector<SceneObject*> &lights, const std::vector<SceneObject*> &cameras);
+    /// Bind the camera data of the camera with the index (in the camera list
+    /// passed to Update()) and the light data
+    void Bind(int cameraIndex);
+
+    /// Number of lights in the light buffer (lights exceeding GetMaxLights()
+    /// are ignored)
+    int GetLightCount() const { return lightCount[0]; }
+    /// The packed lights (see GetLightCount())
+    const LightUniforms *GetLights() const { return lights.empty() ? NULL : &lights[0]; }
+
+    /// Upload the light clusters of the camera being rendered and bind the
+    /// cluster textures
+    void UploadClusters(const LightClusters &lightClusters);
+private:
+    FrameUniforms(const FrameUniforms& orig); // disallow copy constructor
+    FrameUniforms& operator = (const FrameUniforms&); // disallow copy constructor
+
+    /// header of the re_Lights uniform block (std140): x is the number of
+    /// lights, y the number of lights without a finite range (stored first)
+    int lightCount[4];
+    /// light array of the re_Lights uniform block (GetMaxLights() lights)
+    std::vector<LightUniforms> lights;
+    bool lightLimitWarned;
+    /// camera data padded to cameraStride bytes per camera
+    std::vector<char> cameraData;
+    int cameraStride;
+    unsigned int lightBufferId;
+    unsigned int cameraBufferId;
+    unsigned int clusterTextureId;
+    unsigned int lightIndexTextureId;
+};
+}
+
+#endif	/* RENDER_E_FRAMEUNIFORMS_H */
+
@@ -0,0 +1,403 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "GLStateCache.h"
+
+#include <cstring>
+
+namespace render_e {
+
+GLStateCache *GLStateCache::s_instance = NULL;
+
+namespace {
+/// Name used for unknown state
+const GLuint UNKNOWN = 0xffffffff;
+/// Uniforms with higher locations are not cached
+const GLint MAX_CACHED_LOCATION = 1024;
+
+inline int TextureTargetIndex(GLenum target){
+    switch (target){
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_CUBE_MAP:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+inline int BufferTargetIndex(GLenum target){
+    switch (target){
+        case GL_ARRAY_BUFFER:
+            return 0;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+inline int CapabilityIndex(GLenum capability){
+    switch (capability){
+        case GL_BLEND:
+            return 0;
+        case GL_DEPTH_TEST:
+            return 1;
+        case GL_CULL_FACE:
+            return 2;
+        default:
+            return -1;
+    }
+}
+}
+
+GLStateCache::GLStateCache()
+:currentUniforms(NULL) {
+    Invalidate();
+    ResetStats();
+}
+
+void GLStateCache::Invalidate(){
+    program = UNKNOWN;
+    currentUniforms = NULL;
+    activeTexture = -1;
+    for (int i=0;i<TEXTURE_UNIT_COUNT;i++){
+        for (int j=0;j<TEXTURE_TARGET_COUNT;j++){
+            textures[i][j] = UNKNOWN;
+        }
+    }
+    for (int i=0;i<BUFFER_TARGET_COUNT;i++){
+        buffers[i] = UNKNOWN;
+    }
+    vertexArraySource = UNKNOWN;
+    vertexArray = UNKNOWN;
+    drawFramebuffer = UNKNOWN;
+    readFramebuffer = UNKNOWN;
+    viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+    colorMask = -1;
+    depthMask = -1;
+    for (int i=0;i<CAPABILITY_COUNT;i++){
+        capabilities[i] = -1;
+    }
+    blendSource = UNKNOWN;
+    blendDestination = UNKNOWN;
+    depthFunction = UNKNOWN;
+    for (int i=0;i<VERTEX_ATTRIBUTE_COUNT;i++){
+        vertexAttributesKnown[i] = false;
+    }
+}
+
+void GLStateCache::ResetStats(){
+    memset(&stats, 0, sizeof(GLStateStats));
+}
+
+void GLStateCache::UseProgram(GLuint program){
+    if (this->program == program){
+        stats.programBindsSkipped++;
+        return;
+    }
+    glUseProgram(program);
+    stats.programBinds++;
+    this->program = program;
+    currentUniforms = program==0?NULL:&uniforms[program];
+}
+
+void GLStateCache::ActiveTexture(int unit){
+    if (activeTexture == unit){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0+unit);
+    stats.stateChanges++;
+    activeTexture = unit;
+}
+
+void GLStateCache::BindTexture(GLenum target, GLuint texture){
+    int targetIndex = TextureTargetIndex(target);
+    if (activeTexture == -1 || activeTexture >= TEXTURE_UNIT_COUNT || targetIndex == -1){
+        glBindTexture(target, texture);
+        stats.textureBinds++;
+        return;
+    }
+    if (textures[activeTexture][targetIndex] == texture){
+        stats.textureBindsSkipped++;
+        return;
+    }
+    glBindTexture(target, texture);
+    stats.textureBinds++;
+    textures[activeTexture][targetIndex] = texture;
+}
+
+void GLStateCache::BindTexture(int unit, GLenum target, GLuint texture){
+    int targetIndex = TextureTargetIndex(target);
+    if (unit < TEXTURE_UNIT_COUNT && targetIndex != -1 && textures[unit][targetIndex] == texture){
+        stats.textureBindsSkipped++;
+        return;
+    }
+    ActiveTexture(unit);
+    BindTexture(target, texture);
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer){
+    int targetIndex = BufferTargetIndex(target);
+    if (targetIndex != -1 && buffers[targetIndex] == buffer){
+        stats.bufferBindsSkipped++;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    stats.bufferBinds++;
+    if (targetIndex != -1){
+        buffers[targetIndex] = buffer;
+    }
+}
+
+bool GLStateCache::SetVertexArraySource(GLuint vertexBuffer){
+    if (vertexArraySource == vertexBuffer){
+        stats.vertexArraySetupsSkipped++;
+        return false;
+    }
+    stats.vertexArraySetups++;
+    vertexArraySource = vertexBuffer;
+    return true;
+}
+
+void GLStateCache::BindVertexArray(GLuint vertexArray){
+    if (this->vertexArray == vertexArray){
+        stats.vertexArraySetupsSkipped++;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    stats.vertexArraySetups++;
+    this->vertexArray = vertexArray;
+    buffers[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    // the pointers set by SetVertexArraySource() belong to the default object
+    vertexArraySource = UNKNOWN;
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint framebuffer){
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if ((!draw || drawFramebuffer == framebuffer) && (!read || readFramebuffer == framebuffer)){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glBindFramebuffer(target, framebuffer);
+    stats.stateChanges++;
+    if (draw){
+        drawFramebuffer = framebuffer;
+    }
+    if (read){
+        readFramebuffer = framebuffer;
+    }
+}
+
+void GLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    if (viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    stats.stateChanges++;
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+}
+
+void GLStateCache::ColorMask(bool red, bool green, bool blue, bool alpha){
+    int mask = (red?1:0) | (green?2:0) | (blue?4:0) | (alpha?8:0);
+    if (colorMask == mask){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glColorMask(red, green, blue, alpha);
+    stats.stateChanges++;
+    colorMask = mask;
+}
+
+void GLStateCache::DepthMask(bool enabled){
+    if (depthMask == (enabled?1:0)){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glDepthMask(enabled);
+    stats.stateChanges++;
+    depthMask = enabled?1:0;
+}
+
+void GLStateCache::SetCapability(GLenum capability, bool enabled){
+    int index = CapabilityIndex(capability);
+    if (index != -1 && capabilities[index] == (enabled?1:0)){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    if (enabled){
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+    stats.stateChanges++;
+    if (index != -1){
+        capabilities[index] = enabled?1:0;
+    }
+}
+
+void GLStateCache::BlendFunc(GLenum source, GLenum destination){
+    if (blendSource == source && blendDestination == destination){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glBlendFunc(source, destination);
+    stats.stateChanges++;
+    blendSource = source;
+    blendDestination = destination;
+}
+
+void GLStateCache::DepthFunc(GLenum function){
+    if (depthFunction == function){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glDepthFunc(function);
+    stats.stateChanges++;
+    depthFunction = function;
+}
+
+void GLStateCache::VertexAttrib4fv(GLuint index, const float *value){
+    bool cached = index < static_cast<GLuint>(VERTEX_ATTRIBUTE_COUNT);
+    if (cached && vertexAttributesKnown[index] && memcmp(vertexAttributes[index], value, sizeof(float)*4) == 0){
+        stats.stateChangesSkipped++;
+        return;
+    }
+    glVertexAttrib4fv(index, value);
+    stats.stateChanges++;
+    if (cached){
+        memcpy(vertexAttributes[index], value, sizeof(float)*4);
+        vertexAttributesKnown[index] = true;
+    }
+}
+
+bool GLStateCache::UniformChanged(GLint location, const void *value, int size){
+    if (currentUniforms == NULL || location >= MAX_CACHED_LOCATION){
+        return true;
+    }
+    if (location >= static_cast<GLint>(currentUniforms->size())){
+        UniformValue unknown;
+        unknown.size = 0;
+        currentUniforms->resize(location+1, unknown);
+    }
+    UniformValue &cached = (*currentUniforms)[location];
+    if (cached.size == size && memcmp(cached.data, value, size) == 0){
+        return false;
+    }
+    memcpy(cached.data, value, size);
+    cached.size = size;
+    return true;
+}
+
+void GLStateCache::Uniform1fv(GLint location, const float *value){
+    if (location < 0 || !UniformChanged(location, value, sizeof(float))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniform1fv(location, 1, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::Uniform2fv(GLint location, const float *value){
+    if (location < 0 || !UniformChanged(location, value, 2*sizeof(float))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniform2fv(location, 1, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::Uniform3fv(GLint location, const float *value){
+    if (location < 0 || !UniformChanged(location, value, 3*sizeof(float))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniform3fv(location, 1, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::Uniform4fv(GLint location, const float *value){
+    if (location < 0 || !UniformChanged(location, value, 4*sizeof(float))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniform4fv(location, 1, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::Uniform1i(GLint location, int value){
+    if (location < 0 || !UniformChanged(location, &value, sizeof(int))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniform1i(location, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::UniformMatrix4fv(GLint location, const float *value){
+    if (location < 0 || !UniformChanged(location, value, 16*sizeof(float))){
+        stats.uniformUploadsSkipped++;
+        return;
+    }
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    stats.uniformUploads++;
+}
+
+void GLStateCache::ProgramDeleted(GLuint program){
+    // deleting the current program is deferred by OpenGL, and the name may
+    // be reused by a new program
+    if (this->program == program){
+        this->program = UNKNOWN;
+        currentUniforms = NULL;
+    }
+    uniforms.erase(program);
+}
+
+void GLStateCache::TextureDeleted(GLuint texture){
+    // OpenGL binds 0 to units where the texture was bound
+    for (int i=0;i<TEXTURE_UNIT_COUNT;i++){
+        for (int j=0;j<TEXTURE_TARGET_COUNT;j++){
+            if (textures[i][j] == texture){
+                textures[i][j] = 0;
+            }
+        }
+    }
+}
+
+void GLStateCache::BufferDeleted(GLuint buffer){
+    for (int i=0;i<BUFFER_TARGET_COUNT;i++){
+        if (buffers[i] == buffer){
+            buffers[i] = 0;
+        }
+    }
+    if (vertexArraySource == buffer){
+        vertexArraySource = UNKNOWN;
+    }
+}
+
+void GLStateCache::VertexArrayDeleted(GLuint vertexArray){
+    if (this->vertexArray == vertexArray){
+        this->vertexArray = 0;
+        buffers[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void GLStateCache::FramebufferDeleted(GLuint framebuffer){
+    if (drawFramebuffer == framebuffer){
+        drawFramebuffer = 0;
+    }
+    if (readFramebuffer == framebuffer){
+        readFramebuffer = 0;
+    }
+}
+}
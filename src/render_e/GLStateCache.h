@@ -0,0 +1,164 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_GLSTATECACHE_H
+#define	RENDER_E_GLSTATECACHE_H
+
+#include <map>
+#include <vector>
+#include <GL/glew.h>
+
+namespace render_e {
+
+/// Number of calls passed to OpenGL and number of calls dropped since they
+/// would not change the state
+struct GLStateStats {
+    int programBinds;
+    int programBindsSkipped;
+    int textureBinds;
+    int textureBindsSkipped;
+    int bufferBinds;
+    int bufferBindsSkipped;
+    int uniformUploads;
+    int uniformUploadsSkipped;
+    /// Vertex pointer setups (see SetVertexArraySource()) and vertex array
+    /// object binds
+    int vertexArraySetups;
+    int vertexArraySetupsSkipped;
+    /// Active texture, framebuffer, viewport, masks, capabilities, blend
+    /// function and depth function
+    int stateChanges;
+    int stateChangesSkipped;
+};
+
+///
+/// Shadows the OpenGL state (program, texture units, buffers, framebuffers,
+/// viewport, masks, a few capabilities, the blend and depth functions and the
+/// uniform values of each program) and drops calls that would not change
+/// anything.
+/// All state changes of the tracked state must go through the cache, or be
+/// followed by Invalidate(). Uniform values are cached per program and must
+/// always be set using the cache.
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class GLStateCache {
+public:
+    /// Forget the shadowed state (except uniform values). The next call of
+    /// each kind is passed to OpenGL
+    void Invalidate();
+
+    void UseProgram(GLuint program);
+    GLuint GetProgram() const { return program; }
+
+    void ActiveTexture(int unit);
+    /// Bind the texture to the active texture unit
+    void BindTexture(GLenum target, GLuint texture);
+    /// Bind the texture to the texture unit
+    void BindTexture(int unit, GLenum target, GLuint texture);
+
+    void BindBuffer(GLenum target, GLuint buffer);
+    /// Returns true if the vertex pointers must be specified for the buffer,
+    /// i.e. if they were last specified for another buffer (the pointers of
+    /// a buffer are assumed not to change)
+    bool SetVertexArraySource(GLuint vertexBuffer);
+    /// Bind the vertex array object. The element array buffer binding is part
+    /// of the vertex array object, so it is forgotten when the object changes
+    void BindVertexArray(GLuint vertexArray);
+
+    void BindFramebuffer(GLenum target, GLuint framebuffer);
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void ColorMask(bool red, bool green, bool blue, bool alpha);
+    void DepthMask(bool enabled);
+    /// Enable or disable a capability. GL_BLEND, GL_DEPTH_TEST and
+    /// GL_CULL_FACE are tracked; other capabilities are passed on
+    void SetCapability(GLenum capability, bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+    void DepthFunc(GLenum function);
+    /// Set the constant value of a generic vertex attribute (used when the
+    /// attribute array is disabled)
+    void VertexAttrib4fv(GLuint index, const float *value);
+
+    /// Set uniforms of the current program
+    void Uniform1fv(GLint location, const float *value);
+    void Uniform2fv(GLint location, const float *value);
+    void Uniform3fv(GLint location, const float *value);
+    void Uniform4fv(GLint location, const float *value);
+    void Uniform1i(GLint location, int value);
+    void UniformMatrix4fv(GLint location, const float *value);
+
+    /// Must be invoked when OpenGL objects are deleted, since the names may
+    /// be reused
+    void ProgramDeleted(GLuint program);
+    void TextureDeleted(GLuint texture);
+    void BufferDeleted(GLuint buffer);
+    void VertexArrayDeleted(GLuint vertexArray);
+    void FramebufferDeleted(GLuint framebuffer);
+
+    const GLStateStats &GetStats() const { return stats; }
+    void ResetStats();
+
+    ///
+    /// Singleton pattern.
+    /// return the state cache instance
+    ///
+    static GLStateCache* Instance() {
+        if (!s_instance) {
+            s_instance = new GLStateCache();
+        }
+        return s_instance;
+    }
+private:
+    GLStateCache();
+    GLStateCache(const GLStateCache& orig); // disallow copy constructor
+    GLStateCache& operator = (const GLStateCache&); // disallow copy constructor
+
+    /// Value of a uniform (size is 0 if unknown)
+    struct UniformValue {
+        float data[16];
+        int size;
+    };
+    /// Returns true if the value differs from the cached value (and updates
+    /// the cache)
+    bool UniformChanged(GLint location, const void *value, int size);
+
+    static const int TEXTURE_UNIT_COUNT = 16;
+    static const int TEXTURE_TARGET_COUNT = 2; // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+    static const int BUFFER_TARGET_COUNT = 2; // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER
+    static const int CAPABILITY_COUNT = 3; // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE
+    static const int VERTEX_ATTRIBUTE_COUNT = 16;
+
+    static GLStateCache *s_instance;
+    GLuint program;
+    int activeTexture;
+    GLuint textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+    GLuint buffers[BUFFER_TARGET_COUNT];
+    GLuint vertexArraySource;
+    GLuint vertexArray;
+    GLuint drawFramebuffer;
+    GLuint readFramebuffer;
+    GLint viewport[4];
+    /// mask bits (red, green, blue, alpha) or -1 if unknown
+    int colorMask;
+    int depthMask;
+    int capabilities[CAPABILITY_COUNT];
+    GLenum blendSource;
+    GLenum blendDestination;
+    GLenum depthFunction;
+    /// constant vertex attribute values (vertexAttributesKnown is false if unknown)
+    float vertexAttributes[VERTEX_ATTRIBUTE_COUNT][4];
+    bool vertexAttributesKnown[VERTEX_ATTRIBUTE_COUNT];
+    /// uniform values by program and location
+    std::map<GLuint, std::vector<UniformValue> > uniforms;
+    /// uniform values of the current program (NULL if not known)
+    std::vector<UniformValue> *currentUniforms;
+    GLStateStats stats;
+};
+}
+
+#endif	/* RENDER_E_GLSTATECACHE_H */
+
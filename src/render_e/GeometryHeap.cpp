@@ -0,0 +1,248 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "GeometryHeap.h"
+
+#include <cassert>
+#include <sstream>
+#include <algorithm>
+#include <GL/glew.h>
+
+#include "GLStateCache.h"
+#include "OpenGLHelper.h"
+#include "Log.h"
+
+#define BUFFER_OFFSET(bytes) ((GLubyte*) NULL + (bytes))
+
+// GL_ARB_draw_indirect is newer than the bundled GLEW
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+namespace render_e {
+
+GeometryHeap *GeometryHeap::s_instance = NULL;
+
+namespace {
+/// Size of the buffers of a page (larger meshes get a page of their own)
+const int PAGE_VERTEX_BYTES = 4*1024*1024;
+const int PAGE_INDEX_BYTES = 2*1024*1024;
+
+typedef void (RENDER_E_APIENTRY *DrawElementsBaseVertexFunc)(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLint basevertex);
+typedef void (RENDER_E_APIENTRY *DrawElementsInstancedBaseVertexFunc)(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount, GLint basevertex);
+typedef void (RENDER_E_APIENTRY *MultiDrawElementsIndirectFunc)(GLenum mode, GLenum type, const GLvoid *indirect, GLsizei drawcount, GLsizei stride);
+
+DrawElementsBaseVertexFunc drawElementsBaseVertex = NULL;
+DrawElementsInstancedBaseVertexFunc drawElementsInstancedBaseVertex = NULL;
+MultiDrawElementsIndirectFunc multiDrawElementsIndirect = NULL;
+
+bool entryPointsLoaded = false;
+
+void loadEntryPoints(){
+    if (entryPointsLoaded){
+        return;
+    }
+    entryPointsLoaded = true;
+    if (OpenGLHelper::HasExtension("GL_ARB_draw_elements_base_vertex")){
+        drawElementsBaseVertex = (DrawElementsBaseVertexFunc)OpenGLHelper::GetProcAddress("glDrawElementsBaseVertex");
+        drawElementsInstancedBaseVertex = (DrawElementsInstancedBaseVertexFunc)OpenGLHelper::GetProcAddress("glDrawElementsInstancedBaseVertex");
+    }
+    if (OpenGLHelper::HasExtension("GL_ARB_multi_draw_indirect") && OpenGLHelper::HasExtension("GL_ARB_base_instance")){
+        multiDrawElementsIndirect = (MultiDrawElementsIndirectFunc)OpenGLHelper::GetProcAddress("glMultiDrawElementsIndirect");
+    }
+}
+
+int indexSize(unsigned int indexType){
+    switch (indexType){
+        case GL_UNSIGNED_BYTE:
+            return sizeof(GLubyte);
+        case GL_UNSIGNED_SHORT:
+            return sizeof(GLushort);
+        default:
+            return sizeof(GLuint);
+    }
+}
+}
+
+GeometryPage::GeometryPage(const VertexFormat &format, unsigned int indexType, int vertexCapacity, int indexCapacity)
+:id(0),format(format),indexType(indexType),vertexBufferId(0),indexBufferId(0),vertexArrayId(0),
+        positionArrayId(0),vertices(vertexCapacity),indices(indexCapacity) {
+}
+
+GeometryHeap::GeometryHeap()
+:meshCount(0),drawCommandBufferId(0),drawCommandCapacity(0) {
+}
+
+bool GeometryHeap::IsSupported(){
+    loadEntryPoints();
+    return GLEW_ARB_vertex_array_object && drawElementsBaseVertex != NULL &&
+            drawElementsInstancedBaseVertex != NULL;
+}
+
+bool GeometryHeap::IsMultiDrawIndirectSupported(){
+    return IsSupported() && multiDrawElementsIndirect != NULL;
+}
+
+GeometryPage *GeometryHeap::CreatePage(const VertexFormat &format, unsigned int indexType, int vertexCount, int indexCount){
+    int vertexCapacity = std::max(PAGE_VERTEX_BYTES/format.stride, vertexCount);
+    int indexCapacity = std::max(PAGE_INDEX_BYTES/indexSize(indexType), indexCount);
+    GeometryPage *page = new GeometryPage(format, indexType, vertexCapacity, indexCapacity);
+    page->id = pages.size();
+
+    GLStateCache *glState = GLStateCache::Instance();
+    unsigned int buffers[2];
+    glGenBuffers(2, buffers);
+    page->vertexBufferId = buffers[0];
+    page->indexBufferId = buffers[1];
+    glState->BindBuffer(GL_ARRAY_BUFFER, page->vertexBufferId);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity*format.stride, NULL, GL_STATIC_DRAW);
+
+    // the vertex array object captures the buffers and the layout once for
+    // all meshes in the page
+    glGenVertexArrays(1, &page->vertexArrayId);
+    glState->BindVertexArray(page->vertexArrayId);
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBufferId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity*indexSize(indexType), NULL, GL_STATIC_DRAW);
+    format.SetupVertexAttributes();
+    glGenVertexArrays(1, &page->positionArrayId);
+    glState->BindVertexArray(page->positionArrayId);
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBufferId);
+    format.SetupPositionAttribute();
+    glState->BindVertexArray(0);
+    glState->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    pages.push_back(page);
+    std::stringstream ss;
+    ss<<"Geometry heap page "<<page->id<<" created ("<<vertexCapacity<<" vertices, "<<indexCapacity<<" indices)";
+    DEBUG(ss.str());
+    return page;
+}
+
+bool GeometryHeap::Allocate(const VertexFormat &format, const void *vertexData, int vertexCount,
+        unsigned int indexType, const void *indexData, int indexCount, GeometryRange &outRange){
+    if (!IsSupported()){
+        return false;
+    }
+    assert(vertexCount > 0 && indexCount > 0);
+    GeometryPage *page = NULL;
+    int baseVertex = -1;
+    int firstIndex = -1;
+    for (std::vector<GeometryPage*>::iterator iter = pages.begin();iter != pages.end();iter++){
+        GeometryPage *candidate = *iter;
+        if (candidate->format != format || candidate->indexType != indexType){
+            continue;
+        }
+        baseVertex = candidate->vertices.Allocate(vertexCount);
+        if (baseVertex == -1){
+            continue;
+        }
+        firstIndex = candidate->indices.Allocate(indexCount);
+        if (firstIndex == -1){
+            candidate->vertices.Free(baseVertex, vertexCount);
+            continue;
+        }
+        page = candidate;
+        break;
+    }
+    if (page == NULL){
+        page = CreatePage(format, indexType, vertexCount, indexCount);
+        baseVertex = page->vertices.Allocate(vertexCount);
+        firstIndex = page->indices.Allocate(indexCount);
+    }
+    assert(baseVertex != -1 && firstIndex != -1);
+
+    GLStateCache *glState = GLStateCache::Instance();
+    // the element buffer binding would otherwise change the bound vertex
+    // array object
+    glState->BindVertexArray(0);
+    glState->BindBuffer(GL_ARRAY_BUFFER, page->vertexBufferId);
+    glBufferSubData(GL_ARRAY_BUFFER, baseVertex*format.stride, vertexCount*format.stride, vertexData);
+    glState->BindBuffer(GL_ARRAY_BUFFER, 0);
+    int size = indexSize(indexType);
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBufferId);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex*size, indexCount*size, indexData);
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    outRange.page = page;
+    outRange.baseVertex = baseVertex;
+    outRange.vertexCount = vertexCount;
+    outRange.firstIndex = firstIndex;
+    outRange.indexCount = indexCount;
+    meshCount++;
+    return true;
+}
+
+void GeometryHeap::Free(const GeometryRange &range){
+    assert(range.page != NULL);
+    range.page->vertices.Free(range.baseVertex, range.vertexCount);
+    range.page->indices.Free(range.firstIndex, range.indexCount);
+    meshCount--;
+}
+
+void GeometryHeap::Bind(GeometryPage *page){
+    GLStateCache::Instance()->BindVertexArray(page->vertexArrayId);
+}
+
+void GeometryHeap::BindPositionOnly(GeometryPage *page){
+    GLStateCache::Instance()->BindVertexArray(page->positionArrayId);
+}
+
+void GeometryHeap::Draw(const GeometryRange &range, int instanceCount){
+    const GLvoid *indices = BUFFER_OFFSET(range.firstIndex*indexSize(range.page->indexType));
+    if (instanceCount == 1){
+        drawElementsBaseVertex(GL_TRIANGLES, range.indexCount, range.page->indexType, indices, range.baseVertex);
+    } else {
+        drawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, range.page->indexType, indices,
+                instanceCount, range.baseVertex);
+    }
+}
+
+void GeometryHeap::UploadDrawCommands(const std::vector<DrawElementsIndirectCommand> &commands){
+    if (commands.empty()){
+        return;
+    }
+    if (drawCommandBufferId == 0){
+        glGenBuffers(1, &drawCommandBufferId);
+    }
+    GLStateCache *glState = GLStateCache::Instance();
+    glState->BindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBufferId);
+    int size = commands.size()*sizeof(DrawElementsIndirectCommand);
+    if ((int)commands.size() > drawCommandCapacity){
+        drawCommandCapacity = commands.size();
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, size, &commands[0], GL_STREAM_DRAW);
+    } else {
+        // orphan the storage used by the previous frame
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCommandCapacity*sizeof(DrawElementsIndirectCommand), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, &commands[0]);
+    }
+}
+
+void GeometryHeap::MultiDrawIndirect(GeometryPage *page, int firstCommand, int commandCount){
+    assert(multiDrawElementsIndirect != NULL);
+    GLStateCache::Instance()->BindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBufferId);
+    multiDrawElementsIndirect(GL_TRIANGLES, page->indexType,
+            BUFFER_OFFSET(firstCommand*sizeof(DrawElementsIndirectCommand)), commandCount, 0);
+}
+
+GeometryHeapStats GeometryHeap::GetStats() const{
+    GeometryHeapStats stats;
+    stats.pageCount = pages.size();
+    stats.meshCount = meshCount;
+    stats.usedVertexBytes = 0;
+    stats.vertexBytes = 0;
+    stats.usedIndexBytes = 0;
+    stats.indexBytes = 0;
+    for (std::vector<GeometryPage*>::const_iterator iter = pages.begin();iter != pages.end();iter++){
+        const GeometryPage *page = *iter;
+        stats.usedVertexBytes += page->vertices.GetUsed()*page->format.stride;
+        stats.vertexBytes += page->vertices.GetSize()*page->format.stride;
+        stats.usedIndexBytes += page->indices.GetUsed()*indexSize(page->indexType);
+        stats.indexBytes += page->indices.GetSize()*indexSize(page->indexType);
+    }
+    return stats;
+}
+}
@@ -0,0 +1,133 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_GEOMETRYHEAP_H
+#define	RENDER_E_GEOMETRYHEAP_H
+
+#include <vector>
+#include "VertexFormat.h"
+#include "RangeAllocator.h"
+
+namespace render_e {
+
+///
+/// A large vertex and index buffer shared by meshes with the same vertex
+/// format and index type. The vertex array object of the page is used by
+/// all its meshes.
+///
+struct GeometryPage {
+    GeometryPage(const VertexFormat &format, unsigned int indexType, int vertexCapacity, int indexCapacity);
+
+    int id;
+    VertexFormat format;
+    unsigned int indexType;
+    unsigned int vertexBufferId;
+    unsigned int indexBufferId;
+    unsigned int vertexArrayId;
+    /// vertex array object with only the position attribute enabled
+    unsigned int positionArrayId;
+    RangeAllocator vertices;
+    RangeAllocator indices;
+};
+
+/// Vertex and index range of a mesh in a page. Indices are relative to
+/// baseVertex
+struct GeometryRange {
+    GeometryPage *page;
+    int baseVertex;
+    int vertexCount;
+    int firstIndex;
+    int indexCount;
+};
+
+/// Layout of a command in the draw indirect buffer
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+/// Usage of the heap
+struct GeometryHeapStats {
+    int pageCount;
+    int meshCount;
+    int usedVertexBytes;
+    int vertexBytes;
+    int usedIndexBytes;
+    int indexBytes;
+};
+
+///
+/// Global geometry heap: the vertex and index data of all meshes is
+/// suballocated from a few large buffers (pages), so meshes are drawn without
+/// binding buffers (glDrawElementsBaseVertex), and draws of meshes in the same
+/// page can be submitted at once using glMultiDrawElementsIndirect.
+/// Requires GL_ARB_vertex_array_object and GL_ARB_draw_elements_base_vertex
+/// (multi-draw requires GL_ARB_multi_draw_indirect and GL_ARB_base_instance).
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class GeometryHeap {
+public:
+    /// Returns true if the driver supports drawing from the heap (the entry
+    /// points are loaded on the first call)
+    static bool IsSupported();
+    /// Returns true if the driver supports multi-draw indirect
+    static bool IsMultiDrawIndirectSupported();
+
+    /// Copy the mesh data to a page with the format and index type (a page is
+    /// created if no page has room). The indices must be relative to the
+    /// first vertex. Returns false if the heap is not supported
+    bool Allocate(const VertexFormat &format, const void *vertexData, int vertexCount,
+            unsigned int indexType, const void *indexData, int indexCount, GeometryRange &outRange);
+    void Free(const GeometryRange &range);
+
+    /// Bind the vertex array object of the page
+    void Bind(GeometryPage *page);
+    /// Bind the position-only vertex array object of the page
+    void BindPositionOnly(GeometryPage *page);
+    /// Draw the range (the page must be bound)
+    void Draw(const GeometryRange &range, int instanceCount = 1);
+
+    /// Copy the commands to the draw indirect buffer (replacing the previous
+    /// commands)
+    void UploadDrawCommands(const std::vector<DrawElementsIndirectCommand> &commands);
+    /// Submit commandCount uploaded commands starting at firstCommand. All
+    /// commands must refer to ranges in the page (which must be bound)
+    void MultiDrawIndirect(GeometryPage *page, int firstCommand, int commandCount);
+
+    GeometryHeapStats GetStats() const;
+
+    ///
+    /// Singleton pattern.
+    /// return the geometry heap instance
+    ///
+    static GeometryHeap* Instance() {
+        if (!s_instance) {
+            s_instance = new GeometryHeap();
+        }
+        return s_instance;
+    }
+private:
+    GeometryHeap();
+    GeometryHeap(const GeometryHeap& orig); // disallow copy constructor
+    GeometryHeap& operator = (const GeometryHeap&); // disallow copy constructor
+
+    GeometryPage *CreatePage(const VertexFormat &format, unsigned int indexType, int vertexCount, int indexCount);
+
+    static GeometryHeap *s_instance;
+    std::vector<GeometryPage*> pages;
+    int meshCount;
+    unsigned int drawCommandBufferId;
+    int drawCommandCapacity;
+};
+}
+
+#endif	/* RENDER_E_GEOMETRYHEAP_H */
+
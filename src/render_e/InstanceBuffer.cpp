@@ -0,0 +1,85 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "InstanceBuffer.h"
+
+#include <cstring>
+#include <cstddef>
+#include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shaders/Shader.h"
+#include "GLStateCache.h"
+
+#define BUFFER_OFFSET(bytes) ((GLubyte*) NULL + (bytes))
+
+namespace render_e {
+
+InstanceBuffer::InstanceBuffer()
+:bufferId(0) {
+}
+
+InstanceBuffer::~InstanceBuffer(){
+    if (bufferId != 0){
+        glDeleteBuffers(1, &bufferId);
+        GLStateCache::Instance()->BufferDeleted(bufferId);
+    }
+}
+
+bool InstanceBuffer::IsSupported(){
+    return GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+}
+
+void InstanceBuffer::Clear(){
+    instances.clear();
+}
+
+int InstanceBuffer::Add(const glm::mat4 &model, const glm::vec4 &parameter){
+    InstanceData data;
+    memcpy(data.model, glm::value_ptr(model), sizeof(data.model));
+    memcpy(data.parameter, glm::value_ptr(parameter), sizeof(data.parameter));
+    instances.push_back(data);
+    return instances.size()-1;
+}
+
+void InstanceBuffer::Upload(){
+    if (instances.empty()){
+        return;
+    }
+    if (bufferId == 0){
+        glGenBuffers(1, &bufferId);
+    }
+    GLStateCache::Instance()->BindBuffer(GL_ARRAY_BUFFER, bufferId);
+    // the data is replaced each frame, so the old storage is orphaned
+    glBufferData(GL_ARRAY_BUFFER, instances.size()*sizeof(InstanceData), &instances[0], GL_STREAM_DRAW);
+    GLStateCache::Instance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::Bind(int firstInstance){
+    GLStateCache::Instance()->BindBuffer(GL_ARRAY_BUFFER, bufferId);
+    int offset = firstInstance*sizeof(InstanceData);
+    for (int i=0;i<4;i++){
+        int location = INSTANCE_ATTRIBUTE_MODEL0+i;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                BUFFER_OFFSET(offset+i*4*sizeof(float)));
+        glVertexAttribDivisorARB(location, 1);
+    }
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_PARAMETER);
+    glVertexAttribPointer(INSTANCE_ATTRIBUTE_PARAMETER, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            BUFFER_OFFSET(offset+offsetof(InstanceData, parameter)));
+    glVertexAttribDivisorARB(INSTANCE_ATTRIBUTE_PARAMETER, 1);
+}
+
+void InstanceBuffer::Unbind(){
+    for (int i=INSTANCE_ATTRIBUTE_MODEL0;i<=INSTANCE_ATTRIBUTE_PARAMETER;i++){
+        glVertexAttribDivisorARB(i, 0);
+        glDisableVertexAttribArray(i);
+    }
+    GLStateCache::Instance()->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+}
@@ -0,0 +1,71 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_INSTANCEBUFFER_H
+#define	RENDER_E_INSTANCEBUFFER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace render_e {
+
+/// Per instance data as stored in the vertex buffer
+struct InstanceData {
+    float model[16];
+    float parameter[4];
+};
+
+/// Range [begin; end) of render queue items drawn with one instanced draw
+/// call using the instances starting at firstInstance. If commandCount is
+/// greater than 0 the items have different meshes in the same geometry heap
+/// page and are drawn using one multi-draw indirect call (see GeometryHeap)
+/// with the commands starting at firstCommand
+struct InstanceRange {
+    int begin;
+    int end;
+    int firstInstance;
+    int firstCommand;
+    int commandCount;
+};
+
+///
+/// Vertex buffer with per instance data (model matrix and instance parameter)
+/// used for GPU instancing. The data of all instanced draw calls is collected
+/// and uploaded once (Upload()), after which each draw call binds its range
+/// of instances (Bind()).
+/// Requires GL_ARB_instanced_arrays and GL_ARB_draw_instanced.
+///
+class InstanceBuffer {
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+
+    /// Returns true if the OpenGL driver supports instanced draw calls
+    static bool IsSupported();
+
+    void Clear();
+    /// Add an instance and return its index
+    int Add(const glm::mat4 &model, const glm::vec4 &parameter);
+    int GetSize() const { return static_cast<int>(instances.size()); }
+
+    /// Copy the instances to the vertex buffer (replacing the previous data)
+    void Upload();
+    /// Bind the per instance attributes to the instances starting at
+    /// firstInstance
+    void Bind(int firstInstance);
+    void Unbind();
+private:
+    InstanceBuffer(const InstanceBuffer& orig); // disallow copy constructor
+    InstanceBuffer& operator = (const InstanceBuffer&); // disallow copy constructor
+
+    std::vector<InstanceData> instances;
+    unsigned int bufferId;
+};
+}
+
+#endif	/* RENDER_E_INSTANCEBUFFER_H */
+
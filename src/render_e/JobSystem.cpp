@@ -0,0 +1,316 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "JobSystem.h"
+
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "Log.h"
+
+namespace render_e {
+
+JobSystem *JobSystem::s_instance = NULL;
+
+// Minimal platform layer (pthreads or Win32)
+namespace {
+
+#ifdef _WIN32
+
+class Mutex {
+public:
+    Mutex() { InitializeCriticalSection(&cs); }
+    ~Mutex() { DeleteCriticalSection(&cs); }
+    void Lock() { EnterCriticalSection(&cs); }
+    void Unlock() { LeaveCriticalSection(&cs); }
+    CRITICAL_SECTION cs;
+};
+
+class Condition {
+public:
+    Condition() { InitializeConditionVariable(&cv); }
+    void Wait(Mutex &mutex) { SleepConditionVariableCS(&cv, &mutex.cs, INFINITE); }
+    void Signal() { WakeConditionVariable(&cv); }
+    void Broadcast() { WakeAllConditionVariable(&cv); }
+    CONDITION_VARIABLE cv;
+};
+
+inline int AtomicAdd(volatile int *value, int delta) {
+    return InterlockedExchangeAdd(reinterpret_cast<volatile LONG*>(value), delta) + delta;
+}
+
+inline int AtomicLoad(volatile const int *value) {
+    MemoryBarrier();
+    return *value;
+}
+
+DWORD threadIndexKey = TlsAlloc();
+inline void SetThreadIndex(int index) { TlsSetValue(threadIndexKey, reinterpret_cast<void*>(static_cast<INT_PTR>(index))); }
+inline int GetThreadIndex() { return static_cast<int>(reinterpret_cast<INT_PTR>(TlsGetValue(threadIndexKey))); }
+
+#else
+
+class Mutex {
+public:
+    Mutex() { pthread_mutex_init(&mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&mutex); }
+    void Lock() { pthread_mutex_lock(&mutex); }
+    void Unlock() { pthread_mutex_unlock(&mutex); }
+    pthread_mutex_t mutex;
+};
+
+class Condition {
+public:
+    Condition() { pthread_cond_init(&cond, NULL); }
+    ~Condition() { pthread_cond_destroy(&cond); }
+    void Wait(Mutex &mutex) { pthread_cond_wait(&cond, &mutex.mutex); }
+    void Signal() { pthread_cond_signal(&cond); }
+    void Broadcast() { pthread_cond_broadcast(&cond); }
+    pthread_cond_t cond;
+};
+
+inline int AtomicAdd(volatile int *value, int delta) {
+    return __sync_add_and_fetch(value, delta);
+}
+
+inline int AtomicLoad(volatile const int *value) {
+    return __sync_add_and_fetch(const_cast<volatile int*>(value), 0);
+}
+
+pthread_key_t CreateThreadIndexKey() {
+    pthread_key_t key;
+    pthread_key_create(&key, NULL);
+    return key;
+}
+pthread_key_t threadIndexKey = CreateThreadIndexKey();
+inline void SetThreadIndex(int index) { pthread_setspecific(threadIndexKey, reinterpret_cast<void*>(static_cast<long>(index))); }
+inline int GetThreadIndex() { return static_cast<int>(reinterpret_cast<long>(pthread_getspecific(threadIndexKey))); }
+
+#endif
+
+class ScopedLock {
+public:
+    explicit ScopedLock(Mutex &mutex):mutex(mutex) { mutex.Lock(); }
+    ~ScopedLock() { mutex.Unlock(); }
+private:
+    Mutex &mutex;
+};
+
+struct RangeJob : public Job {
+    ParallelForJob *job;
+    int begin;
+    int end;
+    void Execute() { job->Execute(begin, end); }
+};
+}
+
+// Owned by the job system (and never destroyed, since the detached workers
+// may be waiting on the condition at exit)
+struct JobSleepState {
+    Mutex mutex;
+    /// signaled when a job is pushed
+    Condition condition;
+    /// broadcast when the count of a counter drops to zero
+    Condition jobDone;
+};
+
+struct JobEntry {
+    Job *job;
+    JobCounter *counter;
+};
+
+/// Queue protected by a mutex. The owner pops from the back (most recently
+/// pushed job, which is likely still in cache) and thieves steal from the
+/// front.
+struct JobQueue {
+    Mutex mutex;
+    std::deque<JobEntry> jobs;
+
+    void Push(const JobEntry &entry){
+        ScopedLock lock(mutex);
+        jobs.push_back(entry);
+    }
+    bool Pop(JobEntry &entry){
+        ScopedLock lock(mutex);
+        if (jobs.empty()){
+            return false;
+        }
+        entry = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+    bool Steal(JobEntry &entry){
+        ScopedLock lock(mutex);
+        if (jobs.empty()){
+            return false;
+        }
+        entry = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+};
+
+struct JobSystemWorker {
+    JobSystem *system;
+    int queueIndex;
+#ifdef _WIN32
+    HANDLE thread;
+    static DWORD WINAPI Main(LPVOID data){
+        JobSystemWorker *worker = static_cast<JobSystemWorker*>(data);
+        worker->system->WorkerLoop(worker->queueIndex);
+        return 0;
+    }
+    void Start(){
+        thread = CreateThread(NULL, 0, Main, this, 0, NULL);
+    }
+#else
+    pthread_t thread;
+    static void *Main(void *data){
+        JobSystemWorker *worker = static_cast<JobSystemWorker*>(data);
+        worker->system->WorkerLoop(worker->queueIndex);
+        return NULL;
+    }
+    void Start(){
+        pthread_create(&thread, NULL, Main, this);
+        pthread_detach(thread);
+    }
+#endif
+};
+
+bool JobCounter::IsDone() const{
+    return AtomicLoad(&count) == 0;
+}
+
+int JobSystem::GetCoreCount(){
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int cores = info.dwNumberOfProcessors;
+#else
+    int cores = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return cores<1?1:cores;
+}
+
+JobSystem::JobSystem()
+:sleepState(new JobSleepState()), pendingJobs(0) {
+    int workerCount = GetCoreCount()-1;
+    queues.push_back(new JobQueue());
+    for (int i=0;i<workerCount;i++){
+        queues.push_back(new JobQueue());
+        JobSystemWorker *worker = new JobSystemWorker();
+        worker->system = this;
+        worker->queueIndex = i+1;
+        workers.push_back(worker);
+    }
+    for (unsigned int i=0;i<workers.size();i++){
+        workers[i]->Start();
+    }
+    std::stringstream ss;
+    ss<<"Job system started with "<<workerCount<<" worker threads";
+    INFO(ss.str());
+}
+
+int JobSystem::GetCurrentQueueIndex(){
+    return GetThreadIndex();
+}
+
+void JobSystem::Run(Job *job, JobCounter *counter){
+    assert(counter != NULL);
+    AtomicAdd(&counter->count, 1);
+    JobEntry entry;
+    entry.job = job;
+    entry.counter = counter;
+    queues[GetCurrentQueueIndex()]->Push(entry);
+    AtomicAdd(&pendingJobs, 1);
+    // wake up a sleeping worker and any thread waiting for a counter (which
+    // may execute the job)
+    ScopedLock lock(sleepState->mutex);
+    sleepState->condition.Signal();
+    sleepState->jobDone.Broadcast();
+}
+
+bool JobSystem::ExecuteNext(int queueIndex){
+    JobEntry entry;
+    bool found = queues[queueIndex]->Pop(entry);
+    int queueCount = queues.size();
+    for (int i=1;!found && i<queueCount;i++){
+        found = queues[(queueIndex+i)%queueCount]->Steal(entry);
+    }
+    if (!found){
+        return false;
+    }
+    AtomicAdd(&pendingJobs, -1);
+    entry.job->Execute();
+    if (AtomicAdd(&entry.counter->count, -1) == 0){
+        // wake up threads waiting for the counter
+        ScopedLock lock(sleepState->mutex);
+        sleepState->jobDone.Broadcast();
+    }
+    return true;
+}
+
+void JobSystem::Wait(JobCounter *counter){
+    int queueIndex = GetCurrentQueueIndex();
+    while (!counter->IsDone()){
+        if (ExecuteNext(queueIndex)){
+            continue;
+        }
+        // the remaining jobs are being executed by other threads. Sleep until
+        // a counter is done or new jobs are pushed
+        ScopedLock lock(sleepState->mutex);
+        while (!counter->IsDone() && AtomicLoad(&pendingJobs) == 0){
+            sleepState->jobDone.Wait(sleepState->mutex);
+        }
+    }
+}
+
+void JobSystem::ParallelFor(ParallelForJob *job, int count, int batchSize){
+    if (count <= 0){
+        return;
+    }
+    if (batchSize < 1){
+        batchSize = 1;
+    }
+    if (workers.empty() || count <= batchSize){
+        job->Execute(0, count);
+        return;
+    }
+    int batchCount = (count+batchSize-1)/batchSize;
+    std::vector<RangeJob> rangeJobs(batchCount);
+    JobCounter counter;
+    for (int i=0;i<batchCount;i++){
+        rangeJobs[i].job = job;
+        rangeJobs[i].begin = i*batchSize;
+        rangeJobs[i].end = std::min(count, (i+1)*batchSize);
+        Run(&rangeJobs[i], &counter);
+    }
+    Wait(&counter);
+}
+
+void JobSystem::WorkerLoop(int queueIndex){
+    SetThreadIndex(queueIndex);
+    while (true){
+        if (ExecuteNext(queueIndex)){
+            continue;
+        }
+        ScopedLock lock(sleepState->mutex);
+        while (AtomicLoad(&pendingJobs) == 0){
+            sleepState->condition.Wait(sleepState->mutex);
+        }
+    }
+}
+}
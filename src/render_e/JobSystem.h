@@ -0,0 +1,112 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_JOBSYSTEM_H
+#define	RENDER_E_JOBSYSTEM_H
+
+#include <vector>
+
+namespace render_e {
+
+/// A unit of work executed by the JobSystem
+class Job {
+public:
+    virtual ~Job() {}
+    virtual void Execute() = 0;
+};
+
+/// Work that is split into ranges by JobSystem::ParallelFor
+class ParallelForJob {
+public:
+    virtual ~ParallelForJob() {}
+    /// Process the elements in [begin; end)
+    virtual void Execute(int begin, int end) = 0;
+};
+
+/// Counts the unfinished jobs in a group. Use JobSystem::Wait to wait for
+/// the group to complete.
+class JobCounter {
+public:
+    JobCounter():count(0) {}
+    bool IsDone() const;
+private:
+    friend class JobSystem;
+    volatile int count;
+};
+
+// forward declaration
+struct JobQueue;
+struct JobSystemWorker;
+struct JobSleepState;
+
+///
+/// Work stealing job scheduler with a fixed pool of worker threads (one less
+/// than the number of cores, since the thread waiting for jobs also executes
+/// jobs). Each worker has its own queue; an idle worker steals jobs from the
+/// other queues. Jobs pushed from threads outside the pool go to a shared
+/// queue.
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class JobSystem {
+public:
+    /// Schedule the job. The counter is increased and decreased again when the
+    /// job has been executed. The job is not deleted by the job system.
+    void Run(Job *job, JobCounter *counter);
+
+    /// Wait until all jobs of the counter are done. The calling thread
+    /// executes pending jobs while waiting and sleeps when the remaining jobs
+    /// are being executed by other threads.
+    void Wait(JobCounter *counter);
+
+    /// Invoke job->Execute(begin, end) for ranges of at most batchSize
+    /// elements covering [0; count) and wait for all ranges to be done.
+    void ParallelFor(ParallelForJob *job, int count, int batchSize);
+
+    /// Number of worker threads (not including the calling thread)
+    int GetWorkerCount() const { return workers.size(); }
+
+    /// Returns the number of cores reported by the operating system
+    static int GetCoreCount();
+
+    ///
+    /// Singleton pattern.
+    /// return the job system instance
+    ///
+    static JobSystem* Instance() {
+        if (!s_instance) {
+            s_instance = new JobSystem();
+        }
+        return s_instance;
+    }
+private:
+    JobSystem();
+    JobSystem(const JobSystem& orig); // disallow copy constructor
+    JobSystem& operator = (const JobSystem&); // disallow copy constructor
+    friend struct JobSystemWorker;
+
+    /// Pop a job from the queue of the thread or steal one from another
+    /// queue. Returns false if no jobs are pending.
+    bool ExecuteNext(int queueIndex);
+    void WorkerLoop(int queueIndex);
+    int GetCurrentQueueIndex();
+
+    static JobSystem *s_instance;
+
+    /// queue 0 is shared by threads outside the pool, queue i+1 is owned by
+    /// worker i
+    std::vector<JobQueue*> queues;
+    std::vector<JobSystemWorker*> workers;
+    /// used by idle threads to sleep until new jobs are pushed or a counter
+    /// is done
+    JobSleepState *sleepState;
+    volatile int pendingJobs;
+};
+}
+
+#endif	/* RENDER_E_JOBSYSTEM_H */
+
@@ -0,0 +1,177 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "LODGroup.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "SceneObject.h"
+#include "Camera.h"
+#include "Log.h"
+
+namespace render_e {
+
+namespace {
+/// Default screen size threshold of level 1. The thresholds of the following
+/// levels are scaled by the square root of the reduction, which keeps the
+/// number of triangles per screen area roughly constant
+const float FIRST_SCREEN_SIZE = 0.25f;
+}
+
+LODGroup::LODGroup()
+:Component(LODGroupType), hysteresis(0.1f), shadowLevelBias(0), shadowLevel(0) {
+}
+
+LODGroup::~LODGroup() {
+    Release();
+}
+
+bool LODGroup::Generate(MeshAsset *meshAsset, int levelCount, float reduction, float maxError){
+    assert(meshAsset != NULL);
+    Mesh *mesh = meshAsset->GetMesh();
+    if (mesh == NULL){
+        return false;
+    }
+    Release();
+    meshAsset->IncreaseUsageCount();
+    levels.push_back(meshAsset);
+    MeshCache *meshCache = MeshCache::Instance();
+    const std::string &key = meshAsset->GetCacheKey();
+    bool cached = key.length() > 0;
+    // levels are found in the cache in order, since they are generated as
+    // a chain
+    if (cached){
+        for (int i=1;i<levelCount;i++){
+            MeshAsset *level = meshCache->Find(MeshCache::GetLODKey(key, i, reduction, maxError));
+            if (level == NULL){
+                break;
+            }
+            level->IncreaseUsageCount();
+            levels.push_back(level);
+        }
+    }
+    if (static_cast<int>(levels.size()) == 1){
+        std::vector<Mesh*> meshes = MeshSimplifier::GenerateLODs(mesh, levelCount, reduction, maxError);
+        for (unsigned int i=0;i<meshes.size();i++){
+            MeshAsset *level;
+            if (cached){
+                level = meshCache->Add(MeshCache::GetLODKey(key, i+1, reduction, maxError), meshes[i]);
+            } else {
+                level = new MeshAsset(meshes[i], false);
+                delete meshes[i];
+            }
+            level->IncreaseUsageCount();
+            levels.push_back(level);
+        }
+        std::stringstream ss;
+        ss << "Mesh "<<meshAsset->GetMeshId()<<" LOD triangles:";
+        for (unsigned int i=0;i<levels.size();i++){
+            ss << " "<<levels[i]->GetIndicesCount()/3;
+        }
+        DEBUG(ss.str());
+    }
+    screenSizes.resize(levels.size());
+    screenSizes[0] = 1;
+    float scale = sqrt(reduction);
+    for (unsigned int i=1;i<levels.size();i++){
+        screenSizes[i] = i == 1 ? FIRST_SCREEN_SIZE : screenSizes[i-1]*scale;
+    }
+    cameraLevels.clear();
+    shadowLevel = 0;
+    return true;
+}
+
+void LODGroup::Release(){
+    // the mesh component must not render a released level
+    if (GetOwner() != NULL && GetOwner()->GetMesh() != NULL){
+        GetOwner()->GetMesh()->SetLODAsset(NULL);
+    }
+    for (std::vector<MeshAsset*>::iterator iter = levels.begin();iter != levels.end();iter++){
+        (*iter)->DecreaseUsageCount();
+    }
+    levels.clear();
+    screenSizes.clear();
+    cameraLevels.clear();
+    shadowLevel = 0;
+}
+
+void LODGroup::SetScreenSize(int level, float screenSize){
+    assert(level > 0 && level < GetLevelCount());
+    screenSizes[level] = screenSize;
+}
+
+int LODGroup::SelectLevel(Camera *camera, float screenSize){
+    int levelCount = GetLevelCount();
+    if (levelCount == 0){
+        return 0;
+    }
+    LODCameraLevel *cameraLevel = NULL;
+    for (std::vector<LODCameraLevel>::iterator iter = cameraLevels.begin();iter != cameraLevels.end();iter++){
+        if (iter->cameraId == camera->GetCameraId()){
+            cameraLevel = &(*iter);
+            break;
+        }
+    }
+    if (cameraLevel == NULL){
+        LODCameraLevel newLevel;
+        newLevel.cameraId = camera->GetCameraId();
+        newLevel.level = 0;
+        cameraLevels.push_back(newLevel);
+        cameraLevel = &cameraLevels.back();
+    }
+    int level = cameraLevel->level;
+    // switch to a coarser level when below the threshold by the hysteresis
+    // and back when above it by the hysteresis
+    while (level+1 < levelCount && screenSize < screenSizes[level+1]*(1.0f-hysteresis)){
+        level++;
+    }
+    while (level > 0 && screenSize > screenSizes[level]*(1.0f+hysteresis)){
+        level--;
+    }
+    cameraLevel->level = level;
+    return level;
+}
+
+int LODGroup::GetSelectedLevel(Camera *camera) const{
+    for (std::vector<LODCameraLevel>::const_iterator iter = cameraLevels.begin();iter != cameraLevels.end();iter++){
+        if (iter->cameraId == camera->GetCameraId()){
+            return iter->level;
+        }
+    }
+    return 0;
+}
+
+void LODGroup::SelectShadowLevel(Camera *mainCamera, float screenSize){
+    if (levels.empty()){
+        shadowLevel = 0;
+        return;
+    }
+    int level = mainCamera != NULL ? SelectLevel(mainCamera, screenSize) : 0;
+    shadowLevel = std::min(level+shadowLevelBias, GetLevelCount()-1);
+}
+
+float LODGroup::ComputeScreenSize(const Bounds &worldBounds, const glm::mat4 &view, const glm::mat4 &projection){
+    float radius = worldBounds.GetRadius();
+    // projection[1][1] scales the view space height to the viewport height
+    // (of 2); perspective projections divide by the distance
+    float size = radius*projection[1][1];
+    if (projection[2][3] != 0.0f){
+        glm::vec4 center = view*glm::vec4(worldBounds.GetCenter(), 1.0f);
+        float distance = glm::length(glm::vec3(center));
+        if (distance <= radius){
+            return 1; // inside the bounding sphere
+        }
+        size /= distance;
+    }
+    return size;
+}
+}
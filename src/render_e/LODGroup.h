@@ -0,0 +1,100 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_LODGROUP_H
+#define	RENDER_E_LODGROUP_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Component.h"
+#include "MeshAsset.h"
+#include "math/Bounds.h"
+
+namespace render_e {
+
+// forward declaration
+class Camera;
+
+/// Level selected for a camera (see LODGroup::SelectLevel())
+struct LODCameraLevel {
+    /// see Camera::GetCameraId()
+    unsigned int cameraId;
+    int level;
+};
+
+///
+/// Levels of detail of the mesh of a scene object. Level 0 is the mesh
+/// itself and each following level is a simplified mesh (see
+/// MeshSimplifier). The render base selects the level of the visible objects
+/// of each camera by the projected screen size of the world bounds: level i
+/// is used below the screen size threshold of the level (the fraction of the
+/// viewport height covered by the bounding sphere). Hysteresis around the
+/// thresholds keeps objects close to a threshold from switching every frame;
+/// the selected level is kept per camera id, so cameras at different distances
+/// do not make each other switch. Shadow casters use the level of the main
+/// camera (selected before the shadow cameras render) plus the shadow level
+/// bias, so shadow maps do not pop independently of the mesh.
+///
+class LODGroup : public Component {
+public:
+    LODGroup();
+    virtual ~LODGroup();
+    /// Generate the levels from the mesh of the asset, which must be kept
+    /// on the CPU (see MeshAsset::GetMesh()). Levels of cached assets are
+    /// cached too (see MeshCache::GetLODKey()), so objects sharing a mesh
+    /// share its levels. The screen sizes are reset to the defaults. Returns
+    /// false if the mesh is not kept
+    bool Generate(MeshAsset *meshAsset, int levelCount, float reduction = 0.5f, float maxError = 0.05f);
+    /// Release the levels
+    void Release();
+    /// Number of levels including level 0 (0 if not generated)
+    int GetLevelCount() const { return static_cast<int>(levels.size()); }
+    MeshAsset *GetLevel(int level) { return levels[level]; }
+    /// Screen size below which the level is used (level 0 is always 1)
+    void SetScreenSize(int level, float screenSize);
+    float GetScreenSize(int level) const { return screenSizes[level]; }
+    /// Relative distance from a threshold required to switch level (default
+    /// 0.1)
+    void SetHysteresis(float hysteresis) { this->hysteresis = hysteresis; }
+    float GetHysteresis() const { return hysteresis; }
+    /// Number of levels coarser than the selected level used by shadow casters
+    /// (default 0)
+    void SetShadowLevelBias(int shadowLevelBias) { this->shadowLevelBias = shadowLevelBias; }
+    int GetShadowLevelBias() const { return shadowLevelBias; }
+
+    /// Select the level of the screen size for the camera and return it. The
+    /// hysteresis is relative to the level selected last for the camera
+    int SelectLevel(Camera *camera, float screenSize);
+    /// Returns the level selected last for the camera (0 if none)
+    int GetSelectedLevel(Camera *camera) const;
+    /// Select the level used by shadow casters from the screen size in the
+    /// main camera (NULL if the frame has no main camera)
+    void SelectShadowLevel(Camera *mainCamera, float screenSize);
+    /// Returns the level used by shadow casters
+    int GetShadowLevel() const { return shadowLevel; }
+
+    /// Returns the fraction of the viewport height covered by the bounding
+    /// sphere of the world bounds
+    static float ComputeScreenSize(const Bounds &worldBounds, const glm::mat4 &view,
+            const glm::mat4 &projection);
+private:
+    LODGroup(const LODGroup& orig); // disallow copy constructor
+    LODGroup& operator = (const LODGroup&); // disallow copy constructor
+
+    std::vector<MeshAsset*> levels;
+    std::vector<float> screenSizes;
+    float hysteresis;
+    int shadowLevelBias;
+    int shadowLevel;
+    /// levels selected by camera
+    std::vector<LODCameraLevel> cameraLevels;
+};
+}
+
+#endif	/* RENDER_E_LODGROUP_H */
+
@@ -9,6 +9,7 @@
 #define	LIGHT_H
 
 #include "Component.h"
+#include "PoolAllocator.h"
 #include <glm/glm.hpp>
 
 namespace render_e {
@@ -19,7 +20,7 @@ enum LightType{
 	SpotLight
 };
 
-class Light : public Component {
+class Light : public Component, public PoolAllocated<Light> {
 public:
     Light();
     Light(LightType lightType);
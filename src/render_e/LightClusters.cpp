@@ -0,0 +1,362 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "LightClusters.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <sstream>
+
+#include "JobSystem.h"
+#include "Log.h"
+#include "math/SIMD.h"
+
+namespace render_e {
+
+namespace {
+/// Lights are assigned where their contribution is at least 1/256
+const float LIGHT_CUTOFF = 256.0f;
+
+float maxComponent(const float *color){
+    return std::max(color[0], std::max(color[1], color[2]));
+}
+}
+
+/// Builds the slices of the cluster grid (one slice per element)
+class BuildSlicesJob : public ParallelForJob {
+public:
+    explicit BuildSlicesJob(LightClusters *lightClusters):lightClusters(lightClusters){}
+    void Execute(int begin, int end){
+        for (int i=begin;i<end;i++){
+            lightClusters->BuildSlice(i);
+        }
+    }
+private:
+    LightClusters *lightClusters;
+};
+
+LightClusters::LightClusters()
+:nearPlane(0),farPlane(0),perspective(false),minX(CLUSTER_COUNT),minY(CLUSTER_COUNT),minZ(CLUSTER_COUNT),
+        maxX(CLUSTER_COUNT),maxY(CLUSTER_COUNT),maxZ(CLUSTER_COUNT),
+        centerX(CLUSTER_COUNT),centerY(CLUSTER_COUNT),centerZ(CLUSTER_COUNT),radius(CLUSTER_COUNT),
+        sliceCounts(CLUSTER_SLICES),sliceIndices(CLUSTER_SLICES),sliceClusters(CLUSTER_SLICES),
+        clusterData(CLUSTER_COUNT*2, 0.0f),lightIndexCount(0),overflowReported(false) {
+    // the tiles of a slice are tested four at a time
+    assert(CLUSTER_TILE_COUNT%4 == 0);
+    for (int i=0;i<=CLUSTER_SLICES;i++){
+        sliceDepths[i] = 0;
+    }
+}
+
+float LightClusters::GetLightRange(const LightUniforms &light){
+    if (light.position[3] == 0){
+        return -1; // directional
+    }
+    // the shaders scale the lit color by 2
+    float intensity = std::max(maxComponent(light.diffuse),
+            std::max(maxComponent(light.specular), maxComponent(light.ambient)))*2.0f;
+    // solve quadratic*d^2 + linear*d + constant = intensity*LIGHT_CUTOFF
+    float c = light.attenuation[0]-intensity*LIGHT_CUTOFF;
+    float l = light.attenuation[1];
+    float q = light.attenuation[2];
+    if (c >= 0){
+        return 0; // never above the cutoff
+    }
+    if (q > 0){
+        return (-l+sqrt(l*l-4*q*c))/(2*q);
+    }
+    if (l > 0){
+        return -c/l;
+    }
+    return -1;
+}
+
+glm::vec4 LightClusters::GetSliceParameters(float nearPlane, float farPlane, bool perspective){
+    if (perspective){
+        float scale = CLUSTER_SLICES/log(farPlane/nearPlane);
+        return glm::vec4(scale, -log(nearPlane)*scale, 1.0f, 0.0f);
+    }
+    float scale = CLUSTER_SLICES/(farPlane-nearPlane);
+    return glm::vec4(scale, -nearPlane*scale, 0.0f, 0.0f);
+}
+
+void LightClusters::SetLights(const LightUniforms *lightData, int lightCount){
+    lights.clear();
+    for (int i=0;i<lightCount;i++){
+        const LightUniforms &light = lightData[i];
+        float range = GetLightRange(light);
+        if (range <= 0){
+            continue;
+        }
+        ClusterLight clusterLight;
+        clusterLight.position = glm::vec3(light.position[0], light.position[1], light.position[2]);
+        clusterLight.range = range;
+        clusterLight.cosCutoff = light.spotDirection[3];
+        clusterLight.sinCutoff = sqrt(std::max(0.0f, 1.0f-clusterLight.cosCutoff*clusterLight.cosCutoff));
+        clusterLight.spotDirection = glm::vec3(light.spotDirection[0], light.spotDirection[1], light.spotDirection[2]);
+        if (clusterLight.cosCutoff > -1){
+            clusterLight.spotDirection = glm::normalize(clusterLight.spotDirection);
+        }
+        clusterLight.index = i;
+        lights.push_back(clusterLight);
+    }
+}
+
+void LightClusters::Build(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane, bool perspective){
+    // the cluster bounds only change with the projection
+    if (!(projection == this->projection) || nearPlane != this->nearPlane || farPlane != this->farPlane ||
+            perspective != this->perspective){
+        this->projection = projection;
+        this->nearPlane = nearPlane;
+        this->farPlane = farPlane;
+        this->perspective = perspective;
+        sliceParameters = GetSliceParameters(nearPlane, farPlane, perspective);
+        for (int i=0;i<=CLUSTER_SLICES;i++){
+            float t = i/(float)CLUSTER_SLICES;
+            sliceDepths[i] = perspective ? nearPlane*pow(farPlane/nearPlane, t) : nearPlane+(farPlane-nearPlane)*t;
+        }
+        ComputeClusterBounds(projection);
+    }
+
+    eyeLights.resize(lights.size());
+    for (unsigned int i=0;i<lights.size();i++){
+        ClusterLight &eyeLight = eyeLights[i];
+        eyeLight = lights[i];
+        eyeLight.position = glm::vec3(view*glm::vec4(lights[i].position, 1.0f));
+        if (eyeLight.cosCutoff > -1){
+            eyeLight.spotDirection = glm::normalize(glm::vec3(view*glm::vec4(lights[i].spotDirection, 0.0f)));
+        }
+    }
+
+    BuildSlicesJob job(this);
+    JobSystem::Instance()->ParallelFor(&job, CLUSTER_SLICES, 1);
+
+    // concatenate the slices
+    lightIndices.clear();
+    lightIndexCount = 0;
+    for (int slice=0;slice<CLUSTER_SLICES;slice++){
+        const std::vector<unsigned short> &counts = sliceCounts[slice];
+        const std::vector<unsigned short> &indices = sliceIndices[slice];
+        int offset = lightIndexCount;
+        for (int tile=0;tile<CLUSTER_TILE_COUNT;tile++){
+            int count = counts[tile];
+            if (offset+count > MAX_CLUSTER_LIGHT_INDICES){
+                count = std::max(0, MAX_CLUSTER_LIGHT_INDICES-offset);
+                if (!overflowReported){
+                    overflowReported = true;
+                    std::stringstream ss;
+                    ss<<"Light clusters: more than "<<MAX_CLUSTER_LIGHT_INDICES<<" light indices. Lights are dropped.";
+                    WARN(ss.str());
+                }
+            }
+            int cluster = slice*CLUSTER_TILE_COUNT+tile;
+            clusterData[cluster*2] = static_cast<float>(offset);
+            clusterData[cluster*2+1] = static_cast<float>(count);
+            offset += counts[tile];
+        }
+        int count = std::min(static_cast<int>(indices.size()), MAX_CLUSTER_LIGHT_INDICES-lightIndexCount);
+        for (int i=0;i<count;i++){
+            lightIndices.push_back(indices[i]);
+        }
+        lightIndexCount += count;
+    }
+    // whole rows of the index texture are uploaded
+    int rows = (lightIndexCount+LIGHT_INDEX_TEXTURE_WIDTH-1)/LIGHT_INDEX_TEXTURE_WIDTH;
+    lightIndices.resize(rows*LIGHT_INDEX_TEXTURE_WIDTH, 0.0f);
+}
+
+void LightClusters::ComputeClusterBounds(const glm::mat4 &projection){
+    // eye space points of the tile corners on the near and the far plane
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    const int cornerCount = (CLUSTER_TILES_X+1)*(CLUSTER_TILES_Y+1);
+    glm::vec3 nearCorners[cornerCount];
+    glm::vec3 farCorners[cornerCount];
+    for (int y=0;y<=CLUSTER_TILES_Y;y++){
+        for (int x=0;x<=CLUSTER_TILES_X;x++){
+            float u = x*2.0f/CLUSTER_TILES_X-1.0f;
+            float v = y*2.0f/CLUSTER_TILES_Y-1.0f;
+            glm::vec4 nearPoint = inverseProjection*glm::vec4(u, v, -1.0f, 1.0f);
+            glm::vec4 farPoint = inverseProjection*glm::vec4(u, v, 1.0f, 1.0f);
+            nearCorners[y*(CLUSTER_TILES_X+1)+x] = glm::vec3(nearPoint)/nearPoint.w;
+            farCorners[y*(CLUSTER_TILES_X+1)+x] = glm::vec3(farPoint)/farPoint.w;
+        }
+    }
+    float nearDepth = sliceDepths[0];
+    float farDepth = sliceDepths[CLUSTER_SLICES];
+    for (int slice=0;slice<CLUSTER_SLICES;slice++){
+        // points on the line through a near and a far corner are linear in
+        // the depth (for perspective and orthographic projections)
+        float t0 = (sliceDepths[slice]-nearDepth)/(farDepth-nearDepth);
+        float t1 = (sliceDepths[slice+1]-nearDepth)/(farDepth-nearDepth);
+        for (int y=0;y<CLUSTER_TILES_Y;y++){
+            for (int x=0;x<CLUSTER_TILES_X;x++){
+                glm::vec3 minimum(1e30f);
+                glm::vec3 maximum(-1e30f);
+                for (int corner=0;corner<4;corner++){
+                    int index = (y+corner/2)*(CLUSTER_TILES_X+1)+x+corner%2;
+                    glm::vec3 direction = farCorners[index]-nearCorners[index];
+                    glm::vec3 p0 = nearCorners[index]+direction*t0;
+                    glm::vec3 p1 = nearCorners[index]+direction*t1;
+                    minimum = glm::min(minimum, glm::min(p0, p1));
+                    maximum = glm::max(maximum, glm::max(p0, p1));
+                }
+                int cluster = slice*CLUSTER_TILE_COUNT+y*CLUSTER_TILES_X+x;
+                minX[cluster] = minimum.x;
+                minY[cluster] = minimum.y;
+                minZ[cluster] = minimum.z;
+                maxX[cluster] = maximum.x;
+                maxY[cluster] = maximum.y;
+                maxZ[cluster] = maximum.z;
+                glm::vec3 center = (minimum+maximum)*0.5f;
+                centerX[cluster] = center.x;
+                centerY[cluster] = center.y;
+                centerZ[cluster] = center.z;
+                radius[cluster] = glm::length(maximum-center);
+            }
+        }
+    }
+}
+
+void LightClusters::BuildSlice(int slice){
+    // hits are stored as (tile, light) pairs and sorted by tile
+    std::vector<unsigned short> &hits = sliceClusters[slice];
+    std::vector<unsigned short> &counts = sliceCounts[slice];
+    std::vector<unsigned short> &indices = sliceIndices[slice];
+    hits.clear();
+    counts.assign(CLUSTER_TILE_COUNT, 0);
+    std::vector<unsigned short> tiles;
+    float sliceNear = sliceDepths[slice];
+    float sliceFar = sliceDepths[slice+1];
+    for (unsigned int i=0;i<eyeLights.size();i++){
+        const ClusterLight &light = eyeLights[i];
+        float depth = -light.position.z;
+        if (depth+light.range < sliceNear || depth-light.range > sliceFar){
+            continue;
+        }
+        tiles.clear();
+        TestClusters(light, slice, tiles);
+        for (unsigned int j=0;j<tiles.size();j++){
+            hits.push_back(tiles[j]);
+            hits.push_back(static_cast<unsigned short>(light.index));
+            counts[tiles[j]]++;
+        }
+    }
+    // counting sort by tile
+    std::vector<int> offsets(CLUSTER_TILE_COUNT);
+    int offset = 0;
+    for (int tile=0;tile<CLUSTER_TILE_COUNT;tile++){
+        offsets[tile] = offset;
+        offset += counts[tile];
+    }
+    indices.resize(offset);
+    for (unsigned int i=0;i<hits.size();i+=2){
+        indices[offsets[hits[i]]++] = hits[i+1];
+    }
+}
+
+#ifdef RENDER_E_SSE
+
+void LightClusters::TestClusters(const ClusterLight &light, int slice, std::vector<unsigned short> &outClusters) const{
+    __m128 zero = _mm_setzero_ps();
+    __m128 lx = _mm_set1_ps(light.position.x);
+    __m128 ly = _mm_set1_ps(light.position.y);
+    __m128 lz = _mm_set1_ps(light.position.z);
+    __m128 range = _mm_set1_ps(light.range);
+    __m128 rangeSquared = _mm_set1_ps(light.range*light.range);
+    // spot lights with a cutoff of 90 degrees or more are tested as point
+    // lights
+    bool spot = light.cosCutoff > 0;
+    __m128 dx = _mm_set1_ps(light.spotDirection.x);
+    __m128 dy = _mm_set1_ps(light.spotDirection.y);
+    __m128 dz = _mm_set1_ps(light.spotDirection.z);
+    __m128 cosCutoff = _mm_set1_ps(light.cosCutoff);
+    __m128 sinCutoff = _mm_set1_ps(light.sinCutoff);
+    int first = slice*CLUSTER_TILE_COUNT;
+    for (int tile=0;tile<CLUSTER_TILE_COUNT;tile+=4){
+        int cluster = first+tile;
+        // sphere - box: squared distance from the center to the box
+        __m128 ex = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[cluster]), lx), zero),
+                _mm_max_ps(_mm_sub_ps(lx, _mm_loadu_ps(&maxX[cluster])), zero));
+        __m128 ey = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[cluster]), ly), zero),
+                _mm_max_ps(_mm_sub_ps(ly, _mm_loadu_ps(&maxY[cluster])), zero));
+        __m128 ez = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[cluster]), lz), zero),
+                _mm_max_ps(_mm_sub_ps(lz, _mm_loadu_ps(&maxZ[cluster])), zero));
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+        __m128 inside = _mm_cmple_ps(distanceSquared, rangeSquared);
+        int mask = _mm_movemask_ps(inside);
+        if (mask != 0 && spot){
+            // cone - bounding sphere of the cluster
+            __m128 r = _mm_loadu_ps(&radius[cluster]);
+            __m128 vx = _mm_sub_ps(_mm_loadu_ps(&centerX[cluster]), lx);
+            __m128 vy = _mm_sub_ps(_mm_loadu_ps(&centerY[cluster]), ly);
+            __m128 vz = _mm_sub_ps(_mm_loadu_ps(&centerZ[cluster]), lz);
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+            __m128 v1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dx), _mm_mul_ps(vy, dy)), _mm_mul_ps(vz, dz));
+            __m128 perpendicular = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(v1, v1)), zero));
+            __m128 distanceToCone = _mm_sub_ps(_mm_mul_ps(cosCutoff, perpendicular), _mm_mul_ps(v1, sinCutoff));
+            __m128 culled = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(distanceToCone, r),
+                    _mm_cmpgt_ps(v1, _mm_add_ps(r, range))),
+                    _mm_cmplt_ps(v1, _mm_sub_ps(zero, r)));
+            mask &= ~_mm_movemask_ps(culled);
+        }
+        for (int i=0;i<4;i++){
+            if (mask & (1<<i)){
+                outClusters.push_back(static_cast<unsigned short>(tile+i));
+            }
+        }
+    }
+}
+
+#else
+
+void LightClusters::TestClusters(const ClusterLight &light, int slice, std::vector<unsigned short> &outClusters) const{
+    bool spot = light.cosCutoff > 0;
+    int first = slice*CLUSTER_TILE_COUNT;
+    for (int tile=0;tile<CLUSTER_TILE_COUNT;tile++){
+        int cluster = first+tile;
+        // sphere - box: squared distance from the center to the box
+        float ex = std::max(minX[cluster]-light.position.x, 0.0f)+std::max(light.position.x-maxX[cluster], 0.0f);
+        float ey = std::max(minY[cluster]-light.position.y, 0.0f)+std::max(light.position.y-maxY[cluster], 0.0f);
+        float ez = std::max(minZ[cluster]-light.position.z, 0.0f)+std::max(light.position.z-maxZ[cluster], 0.0f);
+        if (ex*ex+ey*ey+ez*ez > light.range*light.range){
+            continue;
+        }
+        if (spot){
+            // cone - bounding sphere of the cluster
+            glm::vec3 v = glm::vec3(centerX[cluster], centerY[cluster], centerZ[cluster])-light.position;
+            float v1 = glm::dot(v, light.spotDirection);
+            float perpendicular = sqrt(std::max(glm::dot(v, v)-v1*v1, 0.0f));
+            float distanceToCone = light.cosCutoff*perpendicular-v1*light.sinCutoff;
+            if (distanceToCone > radius[cluster] || v1 > radius[cluster]+light.range || v1 < -radius[cluster]){
+                continue;
+            }
+        }
+        outClusters.push_back(static_cast<unsigned short>(tile));
+    }
+}
+
+#endif
+
+int LightClusters::GetCluster(const glm::vec3 &eyePosition) const{
+    glm::vec4 clip = projection*glm::vec4(eyePosition, 1.0f);
+    float u = clip.x/clip.w;
+    float v = clip.y/clip.w;
+    if (u < -1 || u > 1 || v < -1 || v > 1){
+        return -1;
+    }
+    float depth = -eyePosition.z;
+    float slice = sliceParameters.z > 0 ? log(depth)*sliceParameters.x+sliceParameters.y :
+            depth*sliceParameters.x+sliceParameters.y;
+    if (slice < 0 || slice >= CLUSTER_SLICES){
+        return -1;
+    }
+    int x = std::min(static_cast<int>(floor((u*0.5f+0.5f)*CLUSTER_TILES_X)), CLUSTER_TILES_X-1);
+    int y = std::min(static_cast<int>(floor((v*0.5f+0.5f)*CLUSTER_TILES_Y)), CLUSTER_TILES_Y-1);
+    return static_cast<int>(slice)*CLUSTER_TILE_COUNT+y*CLUSTER_TILES_X+x;
+}
+}
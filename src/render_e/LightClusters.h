@@ -0,0 +1,133 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_LIGHTCLUSTERS_H
+#define	RENDER_E_LIGHTCLUSTERS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "FrameUniforms.h"
+
+namespace render_e {
+
+/// Size of the cluster grid: screen tiles in x and y (in normalized device
+/// coordinates) and depth slices (RE_CLUSTER_SIZE in the shared shader
+/// library)
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 8;
+const int CLUSTER_SLICES = 24;
+const int CLUSTER_TILE_COUNT = CLUSTER_TILES_X*CLUSTER_TILES_Y;
+const int CLUSTER_COUNT = CLUSTER_TILE_COUNT*CLUSTER_SLICES;
+/// Size of the light index texture (RE_LIGHT_INDEX_SIZE in the shared
+/// shader library). Indices exceeding the texture are dropped
+const int LIGHT_INDEX_TEXTURE_WIDTH = 1024;
+const int LIGHT_INDEX_TEXTURE_HEIGHT = 64;
+const int MAX_CLUSTER_LIGHT_INDICES = LIGHT_INDEX_TEXTURE_WIDTH*LIGHT_INDEX_TEXTURE_HEIGHT;
+
+/// Light with a finite range (world space)
+struct ClusterLight {
+    glm::vec3 position;
+    float range;
+    /// Normalized spot direction (only used if cosCutoff > -1)
+    glm::vec3 spotDirection;
+    float cosCutoff;
+    float sinCutoff;
+    /// Index of the light in the light uniform block
+    int index;
+};
+
+///
+/// Clustered light assignment for forward shading. The view frustum of a
+/// camera is divided into a grid of clusters (screen tiles times depth slices,
+/// exponentially spaced for perspective cameras) and each light with a finite
+/// range is added to the clusters intersecting its sphere (or cone for spot
+/// lights). The shared fragment shader finds the cluster of a fragment and
+/// only processes the lights in the cluster (and the lights without a finite
+/// range, which are processed everywhere).
+/// Each depth slice is built by its own job and four clusters are tested at a
+/// time using SSE (if available). The class does not use OpenGL (the data is
+/// uploaded by FrameUniforms::UploadClusters()).
+///
+class LightClusters {
+public:
+    LightClusters();
+
+    /// Returns the distance at which the light falls below 1/256 of its
+    /// intensity, 0 if the light never exceeds 1/256 and a negative value if
+    /// the light has no finite range (directional lights and lights without
+    /// attenuation)
+    static float GetLightRange(const LightUniforms &light);
+    /// Returns the parameters mapping an eye space depth to a slice: x is the
+    /// scale, y the bias, z is 1 if the slice is computed from log(depth) and
+    /// 0 if computed from depth
+    static glm::vec4 GetSliceParameters(float nearPlane, float farPlane, bool perspective);
+
+    /// Set the lights of the frame (lights without a finite range are
+    /// skipped)
+    void SetLights(const LightUniforms *lights, int lightCount);
+    /// Assign the lights to the clusters of the camera
+    void Build(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane, bool perspective);
+
+    /// Returns the cluster containing the eye space position using the
+    /// mapping of the shared shader library (or -1 if outside the frustum)
+    int GetCluster(const glm::vec3 &eyePosition) const;
+    /// Offset and count in the light indices of each cluster (the tiles of a
+    /// slice are stored in a row, one row per slice)
+    const std::vector<float> &GetClusterData() const { return clusterData; }
+    /// Light indices of all clusters (padded to whole rows of the index
+    /// texture)
+    const std::vector<float> &GetLightIndices() const { return lightIndices; }
+    int GetLightIndexCount() const { return lightIndexCount; }
+    /// Number of lights with a finite range
+    int GetLightCount() const { return static_cast<int>(lights.size()); }
+private:
+    friend class BuildSlicesJob;
+    /// Compute the bounds of the clusters in eye space
+    void ComputeClusterBounds(const glm::mat4 &projection);
+    /// Assign the lights to the clusters of the slice
+    void BuildSlice(int slice);
+    /// Add the index of each cluster in the slice intersecting the light to
+    /// outClusters
+    void TestClusters(const ClusterLight &light, int slice, std::vector<unsigned short> &outClusters) const;
+
+    std::vector<ClusterLight> lights;
+    /// lights in eye space (updated in Build)
+    std::vector<ClusterLight> eyeLights;
+    glm::vec4 sliceParameters;
+    glm::mat4 projection;
+    float nearPlane;
+    float farPlane;
+    bool perspective;
+    /// eye space depth of the slice boundaries
+    float sliceDepths[CLUSTER_SLICES+1];
+    // Eye space bounding boxes and bounding spheres of the clusters stored
+    // as structure of arrays, so four clusters can be tested at a time
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> minZ;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+    std::vector<float> maxZ;
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+    /// light indices of each slice: count by cluster and the indices sorted
+    /// by cluster (written by the job building the slice)
+    std::vector<std::vector<unsigned short> > sliceCounts;
+    std::vector<std::vector<unsigned short> > sliceIndices;
+    std::vector<std::vector<unsigned short> > sliceClusters;
+    std::vector<float> clusterData;
+    std::vector<float> lightIndices;
+    int lightIndexCount;
+    bool overflowReported;
+};
+}
+
+#endif	/* RENDER_E_LIGHTCLUSTERS_H */
+
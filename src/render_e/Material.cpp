@@ -12,12 +12,44 @@
 #include <GL/glew.h>
 #include "Camera.h"
 #include "Log.h"
+#include "GLStateCache.h"
 
 using namespace std;
 
 namespace render_e {
+unsigned int Material::s_materialCount = 0;
+
+namespace {
+/// Compare the values of two parameters of the same type
+bool ParameterValueEquals(const ShaderParameters &p1, const ShaderParameters &p2){
+    const ShaderParameters::ShaderValue &v1 = p1.shaderValue;
+    const ShaderParameters::ShaderValue &v2 = p2.shaderValue;
+    switch (p1.paramType){
+        case SPT_FLOAT:
+            return v1.f[0]==v2.f[0];
+        case SPT_VECTOR2:
+            return v1.f[0]==v2.f[0] && v1.f[1]==v2.f[1];
+        case SPT_VECTOR3:
+            return v1.f[0]==v2.f[0] && v1.f[1]==v2.f[1] && v1.f[2]==v2.f[2];
+        case SPT_VECTOR4:
+            return v1.f[0]==v2.f[0] && v1.f[1]==v2.f[1] && v1.f[2]==v2.f[2] && v1.f[3]==v2.f[3];
+        case SPT_INT:
+            return v1.integer[0]==v2.integer[0];
+        case SPT_TEXTURE:
+            return v1.integer[0]==v2.integer[0] && v1.integer[1]==v2.integer[1];
+        case SPT_SHADOW_SETUP:
+        case SPT_SHADOW_SETUP_NAME:
+            // the shadow matrix includes the model transform of the owner,
+            // so the value differs per object even for the same camera
+            return false;
+    }
+    return false;
+}
+}
+
 Material::Material(Shader *shader)
-:Component(MaterialType), shader(shader) {
+:Component(MaterialType), shader(shader), materialId(s_materialCount++), blended(false),
+        source(NULL), instanceParameterId(-1) {
     shader->IncreaseUsageCount();
 }
 
@@ -25,69 +57,115 @@ Material::~Material() {
     shader->DecreaseUsageCount();
 }
 
-void Material::Bind(){
-    shader->Bind();
+void Material::Bind(bool instanced, bool gbuffer){
+    assert(!instanced || !gbuffer);
+    if (gbuffer){
+        assert(shader->GetGBufferVariant() != NULL);
+        shader->GetGBufferVariant()->Bind();
+    } else if (instanced){
+        assert(shader->GetInstancedVariant() != NULL);
+        shader->GetInstancedVariant()->Bind();
+    } else {
+        shader->Bind();
+    }
+    GLStateCache *glState = GLStateCache::Instance();
+    if (blended){
+        glState->SetCapability(GL_BLEND, true);
+        glState->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glState->DepthMask(false);
+    } else {
+        glState->SetCapability(GL_BLEND, false);
+        glState->DepthMask(true);
+    }
     int textureIndex = 0;
     std::vector<ShaderParameters>::iterator iter =  parameters.begin();
     for (;iter != parameters.end();iter++){
+        int id = gbuffer?(*iter).gbufferId:(instanced?(*iter).instancedId:(*iter).id);
         switch ((*iter).paramType){
             case SPT_FLOAT:
-                glUniform1fv((*iter).id,1, (*iter).shaderValue.f);
+                glState->Uniform1fv(id, (*iter).shaderValue.f);
                 break;
             case SPT_VECTOR2:
-                glUniform2fv((*iter).id,1, (*iter).shaderValue.f);
+                glState->Uniform2fv(id, (*iter).shaderValue.f);
                 break;
             case SPT_VECTOR3:
-                glUniform3fv((*iter).id,1, (*iter).shaderValue.f);
+                glState->Uniform3fv(id, (*iter).shaderValue.f);
                 break;
             case SPT_VECTOR4:
-                glUniform4fv((*iter).id,1, (*iter).shaderValue.f);
+                glState->Uniform4fv(id, (*iter).shaderValue.f);
                 break;
             case SPT_INT:
-                glUniform1i((*iter).id, (*iter).shaderValue.integer[0]);
+                glState->Uniform1i(id, (*iter).shaderValue.integer[0]);
                 break;
             case SPT_TEXTURE:
-                glActiveTexture(GL_TEXTURE0+textureIndex);
-                glBindTexture( (*iter).shaderValue.integer[1], (*iter).shaderValue.integer[0] );
-                glUniform1i((*iter).id, textureIndex);
+                glState->BindTexture(textureIndex, (*iter).shaderValue.integer[1], (*iter).shaderValue.integer[0]);
+                glState->Uniform1i(id, textureIndex);
                 textureIndex++;
                 break;
 			case SPT_SHADOW_SETUP_NAME:
-				{
-					SceneObject *sceneObj = GetOwner()->GetRenderBase()->Find((*iter).shaderValue.cameraName);
-					if (sceneObj==NULL){
-                        stringstream ss;
-						ss << "Cannot find shadow setup name "<<(*iter).shaderValue.cameraName;
-                        ERROR(ss.str());
-						continue;
-					}
-					Camera *cam = sceneObj->GetCamera();
-					if (cam==NULL){
-                        stringstream ss;
-						ss << "Cannot find shadow setup name "<<(*iter).shaderValue.cameraName<<" has no camera attached";
-                        ERROR(ss.str());
-						continue;
-					}
-					// clean up
-					delete [] (*iter).shaderValue.cameraName;
-					// change type
-					(*iter).paramType = SPT_SHADOW_SETUP;
-					(*iter).shaderValue.camera = cam;
+				if (!ResolveShadowSetup(*iter)){
+					continue;
 				}
 				break;
 			case SPT_SHADOW_SETUP:
 				glm::mat4 m = GetOwner()->GetTransform()->GetLocalTransform();
 				float *shadowMatrix = (*iter).shaderValue.camera->GetShadowMatrix(m);
-				glUniformMatrix4fv((*iter).id,1,false, shadowMatrix);
+				glState->UniformMatrix4fv(id, shadowMatrix);
 				break;
         }
     }
 }
 
+bool Material::ResolveShadowSetup(ShaderParameters &param){
+	assert(param.paramType == SPT_SHADOW_SETUP_NAME);
+	SceneObject *sceneObj = GetOwner()->GetRenderBase()->Find(param.shaderValue.cameraName);
+	if (sceneObj==NULL){
+		stringstream ss;
+		ss << "Cannot find shadow setup name "<<param.shaderValue.cameraName;
+		ERROR(ss.str());
+		return false;
+	}
+	Camera *cam = sceneObj->GetCamera();
+	if (cam==NULL){
+		stringstream ss;
+		ss << "Cannot find shadow setup name "<<param.shaderValue.cameraName<<" has no camera attached";
+		ERROR(ss.str());
+		return false;
+	}
+	// clean up
+	delete [] param.shaderValue.cameraName;
+	// change type
+	param.paramType = SPT_SHADOW_SETUP;
+	param.shaderValue.camera = cam;
+	return true;
+}
+
+void Material::GetDependencies(std::vector<unsigned int> &outTextureIds, std::vector<Camera*> &outCameras){
+    std::vector<ShaderParameters>::iterator iter = parameters.begin();
+    for (;iter != parameters.end();iter++){
+        if ((*iter).paramType == SPT_SHADOW_SETUP_NAME && GetOwner() != NULL && GetOwner()->GetRenderBase() != NULL){
+            ResolveShadowSetup(*iter);
+        }
+        switch ((*iter).paramType){
+            case SPT_TEXTURE:
+                outTextureIds.push_back((*iter).shaderValue.integer[0]);
+                break;
+            case SPT_SHADOW_SETUP:
+                outCameras.push_back((*iter).shaderValue.camera);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 Material *Material::Instance(){
 	Material *res = new Material(shader);
 	res->textures = textures;
 	res->name = name;
+	res->blended = blended;
+	res->source = GetSource();
+	res->instanceParameterId = instanceParameterId;
 	for (int i=0;i<parameters.size();i++){
 		ShaderParameters p = parameters[i];
 		if (p.paramType==SPT_SHADOW_SETUP_NAME){
@@ -103,12 +181,81 @@ Material *Material::Instance(){
 	return res;
 }
 
-void Material::AddParameter(ShaderParameters &param){
+unsigned int Material::GetFirstTextureId() const{
+    std::vector<ShaderParameters>::const_iterator iter = parameters.begin();
+    for (;iter != parameters.end();iter++){
+        if ((*iter).paramType == SPT_TEXTURE){
+            return (*iter).shaderValue.integer[0];
+        }
+    }
+    return 0;
+}
+
+void Material::SetInstanceParameter(std::string name){
+    instanceParameterId = shader->GetUniformLocation(name.c_str());
+}
+
+glm::vec4 Material::GetInstanceParameter() const{
+    std::vector<ShaderParameters>::const_iterator iter = parameters.begin();
+    for (;iter != parameters.end();iter++){
+        if ((*iter).id == instanceParameterId && (*iter).paramType == SPT_VECTOR4){
+            const float *f = (*iter).shaderValue.f;
+            return glm::vec4(f[0], f[1], f[2], f[3]);
+        }
+    }
+    return glm::vec4(1,1,1,1);
+}
+
+bool Material::HasShadowSetup() const{
+    std::vector<ShaderParameters>::const_iterator iter = parameters.begin();
+    for (;iter != parameters.end();iter++){
+        if ((*iter).paramType == SPT_SHADOW_SETUP || (*iter).paramType == SPT_SHADOW_SETUP_NAME){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Material::IsInstanceable() const{
+    return !blended && shader->GetInstancedVariant() != NULL && !HasShadowSetup();
+}
+
+bool Material::IsDeferred() const{
+    return !blended && shader->GetGBufferVariant() != NULL && !HasShadowSetup();
+}
+
+bool Material::IsInstanceCompatible(Material *other){
+    if (other == this){
+        return true;
+    }
+    if (GetSource() != other->GetSource() || shader != other->shader
+            || parameters.size() != other->parameters.size()){
+        return false;
+    }
+    // parameters are stored in the order they were first set
+    for (unsigned int i=0;i<parameters.size();i++){
+        const ShaderParameters &p1 = parameters[i];
+        const ShaderParameters &p2 = other->parameters[i];
+        if (p1.id != p2.id || p1.paramType != p2.paramType){
+            return false;
+        }
+        if (p1.id != instanceParameterId && !ParameterValueEquals(p1, p2)){
+            return false;
+        }
+    }
+    return true;
+}
+
+void Material::AddParameter(const std::string &name, ShaderParameters &param){
+    Shader *instancedShader = shader->GetInstancedVariant();
+    param.instancedId = instancedShader==NULL?-1:instancedShader->GetUniformLocation(name.c_str());
+    Shader *gbufferShader = shader->GetGBufferVariant();
+    param.gbufferId = gbufferShader==NULL?-1:gbufferShader->GetUniformLocation(name.c_str());
     // replace a existing parameter
     std::vector<ShaderParameters>::iterator iter = parameters.begin();
     for (;iter != parameters.end();iter++){
         if ((*iter).id == param.id){
-            memcpy(&((*iter).shaderValue), &(param.shaderValue), sizeof(ShaderParameters));
+            memcpy(&((*iter).shaderValue), &(param.shaderValue), sizeof(param.shaderValue));
             return;
         }
     }
@@ -126,7 +273,7 @@ bool Material::SetVector2(std::string name, glm::vec2 vec){
     param.paramType = SPT_VECTOR2;
     param.shaderValue.f[0] = vec[0];
     param.shaderValue.f[1] = vec[1];
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 
@@ -142,7 +289,7 @@ bool Material::SetShadowSetup(std::string name, const char *cameraName){
 	char *nameCopy = new char[nameLen+1];
 	strncpy(nameCopy, cameraName, nameLen+1);
     param.shaderValue.cameraName = nameCopy;
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 bool Material::SetVector3(std::string name, glm::vec3 vec){
@@ -156,7 +303,7 @@ bool Material::SetVector3(std::string name, glm::vec3 vec){
     param.shaderValue.f[0] = vec[0];
     param.shaderValue.f[1] = vec[1];
     param.shaderValue.f[2] = vec[2];
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 bool Material::SetVector4(std::string name, glm::vec4 vec){
@@ -171,7 +318,7 @@ bool Material::SetVector4(std::string name, glm::vec4 vec){
     param.shaderValue.f[1] = vec[1];
     param.shaderValue.f[2] = vec[2];
     param.shaderValue.f[3] = vec[3];
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 bool Material::SetFloat(std::string name, float f){
@@ -183,7 +330,7 @@ bool Material::SetFloat(std::string name, float f){
     param.id = id;
     param.paramType = SPT_FLOAT;
     param.shaderValue.f[0] = f;
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 bool Material::SetTexture(std::string name, TextureBase *texture){
@@ -196,7 +343,7 @@ bool Material::SetTexture(std::string name, TextureBase *texture){
     param.paramType = SPT_TEXTURE;
     param.shaderValue.integer[0] = texture->GetTextureId();
     param.shaderValue.integer[1] = texture->GetTextureType();
-    AddParameter(param);
+    AddParameter(name, param);
 }
 
 bool Material::SetInt(std::string name, int i){
@@ -208,6 +355,6 @@ bool Material::SetInt(std::string name, int i){
     param.id = id;
     param.paramType = SPT_INT;
     param.shaderValue.integer[0] = i;
-    AddParameter(param);
+    AddParameter(name, param);
 }
 }
@@ -13,6 +13,7 @@
 #include "shaders/Shader.h"
 #include "textures/TextureBase.h"
 #include "Component.h"
+#include "PoolAllocator.h"
 #include <glm/glm.hpp>
 
 namespace render_e {
@@ -32,6 +33,8 @@ enum ShaderParamType{
 
 struct ShaderParameters{
     int id;
+    int instancedId; // location in the instanced shader variant
+    int gbufferId; // location in the G-buffer shader variant
     ShaderParamType paramType;
     union ShaderValue {
         float f[4];
@@ -41,11 +44,14 @@ struct ShaderParameters{
     } shaderValue;
 };
 
-class Material : public Component{
+class Material : public Component, public PoolAllocated<Material> {
 public:
     Material(Shader *shader);
     virtual ~Material();
-    void Bind();
+    /// Bind the shader and the parameters. If instanced is true the
+    /// instanced variant of the shader is used, if gbuffer is true the
+    /// G-buffer variant (see IsDeferred()).
+    void Bind(bool instanced = false, bool gbuffer = false);
     
     bool SetVector2(std::string name, glm::vec2 vec);
     bool SetVector3(std::string name, glm::vec3 vec);
@@ -58,16 +64,69 @@ public:
     void SetName(std::string name) { this->name = name;}
     std::string GetName() {return name; }
 	Material *Instance(); // create a copy of material
+    
+    Shader *GetShader() { return shader; }
+    /// Unique id of the material (used for sorting draw calls)
+    unsigned int GetMaterialId() const { return materialId; }
+    /// Returns the OpenGL name of the first texture or 0 if no textures
+    unsigned int GetFirstTextureId() const;
+    
+    /// Blended materials are rendered after opaque materials (sorted back to
+    /// front) with alpha blending and without depth writes
+    void SetBlended(bool blended) { this->blended = blended; }
+    bool IsBlended() const { return blended; }
+    
+    /// Returns the material this material was created from using Instance()
+    /// (or the material itself). The source must outlive its instances.
+    Material *GetSource() { return source==NULL?this:source; }
+    
+    /// Mark a vector4 parameter as a per instance parameter. When objects are
+    /// drawn using GPU instancing the value is passed to the shader as the
+    /// per instance attribute re_InstanceParameter instead of the uniform.
+    void SetInstanceParameter(std::string name);
+    /// Returns the value of the instance parameter (or (1,1,1,1) if not set)
+    glm::vec4 GetInstanceParameter() const;
+    
+    /// Returns true if objects using the material can be drawn with GPU
+    /// instancing (the shader has an instanced variant, the material is not
+    /// blended and has no per object parameters such as shadow setups)
+    bool IsInstanceable() const;
+    /// Returns true if the materials share source and all parameters except
+    /// the instance parameter are equal (such objects may be drawn in one
+    /// instanced draw call). Shadow setups are never equal, since the shadow
+    /// matrix depends on the owner
+    bool IsInstanceCompatible(Material *other);
+    /// Returns true if objects using the material can be rendered to the
+    /// G-buffer by deferred shading (the shader has a G-buffer variant and
+    /// the material is not blended and has no shadow setups, which the light
+    /// pass does not apply). Other materials are rendered forward.
+    bool IsDeferred() const;
+    
+    /// Add the OpenGL names of the textures sampled by the material and the
+    /// cameras of its shadow setups (see RenderGraph)
+    void GetDependencies(std::vector<unsigned int> &outTextureIds, std::vector<Camera*> &outCameras);
 private:
     Material(const Material& orig); // disallow copy constructor
     Material& operator = (const Material&); // disallow copy constructor
     
-    void AddParameter(ShaderParameters &param);
+    void AddParameter(const std::string &name, ShaderParameters &param);
+    /// Find the camera of a SPT_SHADOW_SETUP_NAME parameter and change the
+    /// parameter to SPT_SHADOW_SETUP. Returns false if not found
+    bool ResolveShadowSetup(ShaderParameters &param);
+    /// Returns true if the material has a SPT_SHADOW_SETUP or
+    /// SPT_SHADOW_SETUP_NAME parameter
+    bool HasShadowSetup() const;
     
     Shader *shader;
     std::vector<TextureBase*> textures;    
     std::string name;
     std::vector<ShaderParameters> parameters;
+    unsigned int materialId;
+    bool blended;
+    Material *source;
+    int instanceParameterId;
+    
+    static unsigned int s_materialCount;
 };
 }
 #endif	/* MATERIAL_H */
@@ -7,18 +7,319 @@
 
 #include "Mesh.h"
 
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <limits>
 #include <glm/glm.hpp>
+#include "JobSystem.h"
+#include "math/SIMD.h"
 #include "Log.h"
 
 using namespace std;
 
 namespace render_e {
+
+namespace {
+/// Number of triangles and vertices processed by each job
+const int TRIANGLE_BATCH_SIZE = 4096;
+const int VERTEX_BATCH_SIZE = 4096;
+
+template <class T>
+T *dataOrNull(std::vector<T> &data){
+    return data.empty() ? NULL : &data[0];
+}
+
+/// Corners (index positions) referencing each vertex: the corners of
+/// vertex v are corners[offsets[v]] to corners[offsets[v+1]-1] (in
+/// increasing order, so sums over the corners are deterministic)
+void buildCornerAdjacency(const int *indices, int indicesCount, int vertexCount, std::vector<int> &offsets,
+        std::vector<int> &corners){
+    offsets.assign(vertexCount+1, 0);
+    for (int i=0;i<indicesCount;i++){
+        offsets[indices[i]+1]++;
+    }
+    for (int i=0;i<vertexCount;i++){
+        offsets[i+1] += offsets[i];
+    }
+    std::vector<int> next(offsets.begin(), offsets.end()-1);
+    corners.resize(indicesCount);
+    for (int i=0;i<indicesCount;i++){
+        corners[next[indices[i]]++] = i;
+    }
+}
+
+/// Returns a unit vector perpendicular to the normal
+glm::vec3 perpendicular(const glm::vec3 &normal){
+    glm::vec3 axis = fabs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    glm::vec3 tangent = axis-normal*glm::dot(normal, axis);
+    return glm::normalize(tangent);
+}
+
+/// Computes the normal of each face (the cross product of the edges for
+/// area weighting, otherwise unit length) and the angle of the face at
+/// each corner for angle weighting
+class FaceNormalsJob : public ParallelForJob {
+public:
+    FaceNormalsJob(const glm::vec3 *vertices, const int *indices, NormalWeighting weighting,
+            glm::vec3 *faceNormals, float *cornerAngles)
+    :vertices(vertices), indices(indices), weighting(weighting), faceNormals(faceNormals),
+            cornerAngles(cornerAngles) {}
+    virtual void Execute(int begin, int end);
+private:
+    void ComputeFace(int triangle);
+    /// Store the normal (cross product) and corner angles computed from the
+    /// length of the cross product and the dot products of the edges at
+    /// the corners
+    void StoreFace(int triangle, const glm::vec3 &cross, float crossLength, const float *cornerDots);
+    const glm::vec3 *vertices;
+    const int *indices;
+    NormalWeighting weighting;
+    glm::vec3 *faceNormals;
+    float *cornerAngles;
+};
+
+void FaceNormalsJob::StoreFace(int triangle, const glm::vec3 &cross, float crossLength, const float *cornerDots){
+    if (weighting == NORMAL_WEIGHT_AREA){
+        faceNormals[triangle] = cross;
+        return;
+    }
+    faceNormals[triangle] = crossLength > 0 ? cross/crossLength : glm::vec3(0, 0, 0);
+    if (weighting == NORMAL_WEIGHT_ANGLE){
+        for (int j=0;j<3;j++){
+            cornerAngles[triangle*3+j] = atan2(crossLength, cornerDots[j]);
+        }
+    }
+}
+
+void FaceNormalsJob::ComputeFace(int triangle){
+    const glm::vec3 &p0 = vertices[indices[triangle*3]];
+    const glm::vec3 &p1 = vertices[indices[triangle*3+1]];
+    const glm::vec3 &p2 = vertices[indices[triangle*3+2]];
+    glm::vec3 e01 = p1-p0;
+    glm::vec3 e02 = p2-p0;
+    glm::vec3 e12 = p2-p1;
+    glm::vec3 cross = glm::cross(e01, e02);
+    float cornerDots[3] = {glm::dot(e01, e02), -glm::dot(e01, e12), glm::dot(e02, e12)};
+    StoreFace(triangle, cross, glm::length(cross), cornerDots);
+}
+
+#ifdef RENDER_E_SSE
+
+void FaceNormalsJob::Execute(int begin, int end){
+    // four triangles at a time (the positions are transposed to one
+    // register per coordinate)
+    int triangle = begin;
+    for (;triangle+4<=end;triangle+=4){
+        __m128 p[3][3];
+        for (int j=0;j<3;j++){
+            const glm::vec3 &a = vertices[indices[triangle*3+j]];
+            const glm::vec3 &b = vertices[indices[triangle*3+3+j]];
+            const glm::vec3 &c = vertices[indices[triangle*3+6+j]];
+            const glm::vec3 &d = vertices[indices[triangle*3+9+j]];
+            p[j][0] = _mm_set_ps(d.x, c.x, b.x, a.x);
+            p[j][1] = _mm_set_ps(d.y, c.y, b.y, a.y);
+            p[j][2] = _mm_set_ps(d.z, c.z, b.z, a.z);
+        }
+        __m128 e01[3];
+        __m128 e02[3];
+        __m128 e12[3];
+        for (int k=0;k<3;k++){
+            e01[k] = _mm_sub_ps(p[1][k], p[0][k]);
+            e02[k] = _mm_sub_ps(p[2][k], p[0][k]);
+            e12[k] = _mm_sub_ps(p[2][k], p[1][k]);
+        }
+        __m128 cross[3];
+        cross[0] = _mm_sub_ps(_mm_mul_ps(e01[1], e02[2]), _mm_mul_ps(e01[2], e02[1]));
+        cross[1] = _mm_sub_ps(_mm_mul_ps(e01[2], e02[0]), _mm_mul_ps(e01[0], e02[2]));
+        cross[2] = _mm_sub_ps(_mm_mul_ps(e01[0], e02[1]), _mm_mul_ps(e01[1], e02[0]));
+        float crossX[4];
+        float crossY[4];
+        float crossZ[4];
+        if (weighting == NORMAL_WEIGHT_AREA){
+            _mm_storeu_ps(crossX, cross[0]);
+            _mm_storeu_ps(crossY, cross[1]);
+            _mm_storeu_ps(crossZ, cross[2]);
+            for (int i=0;i<4;i++){
+                faceNormals[triangle+i] = glm::vec3(crossX[i], crossY[i], crossZ[i]);
+            }
+            continue;
+        }
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cross[0], cross[0]),
+                _mm_mul_ps(cross[1], cross[1])), _mm_mul_ps(cross[2], cross[2])));
+        // degenerate faces get a zero normal
+        __m128 invLength = _mm_and_ps(_mm_cmpgt_ps(length, _mm_setzero_ps()),
+                _mm_div_ps(_mm_set1_ps(1.0f), length));
+        _mm_storeu_ps(crossX, _mm_mul_ps(cross[0], invLength));
+        _mm_storeu_ps(crossY, _mm_mul_ps(cross[1], invLength));
+        _mm_storeu_ps(crossZ, _mm_mul_ps(cross[2], invLength));
+        for (int i=0;i<4;i++){
+            faceNormals[triangle+i] = glm::vec3(crossX[i], crossY[i], crossZ[i]);
+        }
+        if (weighting == NORMAL_WEIGHT_ANGLE){
+            float lengths[4];
+            float dots[3][4];
+            _mm_storeu_ps(lengths, length);
+            _mm_storeu_ps(dots[0], _mm_add_ps(_mm_add_ps(_mm_mul_ps(e01[0], e02[0]), _mm_mul_ps(e01[1], e02[1])),
+                    _mm_mul_ps(e01[2], e02[2])));
+            _mm_storeu_ps(dots[1], _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(e01[0], e12[0]),
+                    _mm_mul_ps(e01[1], e12[1])), _mm_mul_ps(e01[2], e12[2]))));
+            _mm_storeu_ps(dots[2], _mm_add_ps(_mm_add_ps(_mm_mul_ps(e02[0], e12[0]), _mm_mul_ps(e02[1], e12[1])),
+                    _mm_mul_ps(e02[2], e12[2])));
+            for (int i=0;i<4;i++){
+                for (int j=0;j<3;j++){
+                    cornerAngles[(triangle+i)*3+j] = atan2(lengths[i], dots[j][i]);
+                }
+            }
+        }
+    }
+    for (;triangle<end;triangle++){
+        ComputeFace(triangle);
+    }
+}
+
+#else
+
+void FaceNormalsJob::Execute(int begin, int end){
+    for (int triangle=begin;triangle<end;triangle++){
+        ComputeFace(triangle);
+    }
+}
+
+#endif
+
+/// Sums the weighted face normals of each vertex
+class VertexNormalsJob : public ParallelForJob {
+public:
+    VertexNormalsJob(const glm::vec3 *faceNormals, const float *cornerWeights, const int *offsets,
+            const int *corners, glm::vec3 *normals)
+    :faceNormals(faceNormals), cornerWeights(cornerWeights), offsets(offsets), corners(corners),
+            normals(normals) {}
+    virtual void Execute(int begin, int end){
+        for (int vertex=begin;vertex<end;vertex++){
+            glm::vec3 sum(0, 0, 0);
+            for (int i=offsets[vertex];i<offsets[vertex+1];i++){
+                int corner = corners[i];
+                const glm::vec3 &faceNormal = faceNormals[corner/3];
+                sum += cornerWeights != NULL ? faceNormal*cornerWeights[corner] : faceNormal;
+            }
+            float length = glm::length(sum);
+            // vertices without faces (or only degenerate faces) get an
+            // arbitrary unit normal
+            normals[vertex] = length > 0 ? sum/length : glm::vec3(0, 0, 1);
+        }
+    }
+private:
+    const glm::vec3 *faceNormals;
+    const float *cornerWeights;
+    const int *offsets;
+    const int *corners;
+    glm::vec3 *normals;
+};
+
+/// Computes the unit tangent of each face from the texture coordinates
+/// (multiplied by the orientation of the texture space, as in MikkTSpace)
+/// and the orientation (1, -1 or 0 for degenerate texture coordinates)
+class FaceTangentsJob : public ParallelForJob {
+public:
+    FaceTangentsJob(const glm::vec3 *vertices, const glm::vec2 *textureCoords, const int *indices,
+            glm::vec3 *faceTangents, float *faceSigns)
+    :vertices(vertices), textureCoords(textureCoords), indices(indices), faceTangents(faceTangents),
+            faceSigns(faceSigns) {}
+    virtual void Execute(int begin, int end){
+        for (int triangle=begin;triangle<end;triangle++){
+            int i0 = indices[triangle*3];
+            int i1 = indices[triangle*3+1];
+            int i2 = indices[triangle*3+2];
+            glm::vec3 d1 = vertices[i1]-vertices[i0];
+            glm::vec3 d2 = vertices[i2]-vertices[i0];
+            glm::vec2 t21 = textureCoords[i1]-textureCoords[i0];
+            glm::vec2 t31 = textureCoords[i2]-textureCoords[i0];
+            float signedArea = t21.x*t31.y-t21.y*t31.x;
+            glm::vec3 tangent = d1*t31.y-d2*t21.y;
+            float length = glm::length(tangent);
+            if (signedArea == 0 || length == 0){
+                faceTangents[triangle] = glm::vec3(0, 0, 0);
+                faceSigns[triangle] = 0;
+                continue;
+            }
+            float sign = signedArea > 0 ? 1.0f : -1.0f;
+            faceTangents[triangle] = tangent*(sign/length);
+            faceSigns[triangle] = sign;
+        }
+    }
+private:
+    const glm::vec3 *vertices;
+    const glm::vec2 *textureCoords;
+    const int *indices;
+    glm::vec3 *faceTangents;
+    float *faceSigns;
+};
+
+/// Sums the face tangents of each vertex projected onto the plane of the
+/// vertex normal and weighted by the angle of the face at the vertex in
+/// that plane. Faces of each orientation are summed separately and the
+/// orientation with the largest weight is used
+class VertexTangentsJob : public ParallelForJob {
+public:
+    VertexTangentsJob(const glm::vec3 *vertices, const glm::vec3 *normals, const int *indices,
+            const glm::vec3 *faceTangents, const float *faceSigns, const int *offsets, const int *corners,
+            glm::vec3 *tangents)
+    :vertices(vertices), normals(normals), indices(indices), faceTangents(faceTangents), faceSigns(faceSigns),
+            offsets(offsets), corners(corners), tangents(tangents) {}
+    virtual void Execute(int begin, int end){
+        for (int vertex=begin;vertex<end;vertex++){
+            const glm::vec3 &normal = normals[vertex];
+            glm::vec3 sums[2] = {glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
+            float weights[2] = {0, 0};
+            for (int i=offsets[vertex];i<offsets[vertex+1];i++){
+                int corner = corners[i];
+                int triangle = corner/3;
+                if (faceSigns[triangle] == 0){
+                    continue;
+                }
+                glm::vec3 tangent = Project(faceTangents[triangle], normal);
+                // the edges leaving the corner
+                int first = triangle*3;
+                const glm::vec3 &position = vertices[indices[corner]];
+                glm::vec3 edge1 = Project(vertices[indices[first+(corner-first+1)%3]]-position, normal);
+                glm::vec3 edge2 = Project(vertices[indices[first+(corner-first+2)%3]]-position, normal);
+                float cosAngle = std::max(-1.0f, std::min(1.0f, glm::dot(edge1, edge2)));
+                float angle = acos(cosAngle);
+                int group = faceSigns[triangle] > 0 ? 0 : 1;
+                sums[group] += tangent*angle;
+                weights[group] += angle;
+            }
+            glm::vec3 sum = weights[0] >= weights[1] ? sums[0] : sums[1];
+            float length = glm::length(sum);
+            tangents[vertex] = length > 0 ? sum/length : perpendicular(normal);
+        }
+    }
+private:
+    /// Returns the vector projected onto the plane of the normal and
+    /// normalized (zero if the projection is zero)
+    static glm::vec3 Project(const glm::vec3 &v, const glm::vec3 &normal){
+        glm::vec3 projected = v-normal*glm::dot(normal, v);
+        float length = glm::length(projected);
+        return length > 0 ? projected/length : glm::vec3(0, 0, 0);
+    }
+    const glm::vec3 *vertices;
+    const glm::vec3 *normals;
+    const int *indices;
+    const glm::vec3 *faceTangents;
+    const float *faceSigns;
+    const int *offsets;
+    const int *corners;
+    glm::vec3 *tangents;
+};
+}
+
 Mesh::Mesh() {
 }
 
-Mesh::Mesh(const Mesh& orig) {
+Mesh::Mesh(const Mesh& orig)
+:vertices(orig.vertices), normals(orig.normals), tangents(orig.tangents), colors(orig.colors),
+        textureCoords1(orig.textureCoords1), textureCoords2(orig.textureCoords2), indices(orig.indices) {
 }
 
 Mesh::~Mesh() {
@@ -81,39 +382,60 @@ int Mesh::GetIndicesCount(){
     return indices.size();
 }
 
-void Mesh::ComputeNormals(){
-    // compute the normal for each face
-    
-    normals.clear();
-    // fill normal vector
-    while (normals.size()<vertices.size()){
-        normals.push_back(glm::vec3(0,0,0));
+void Mesh::ComputeNormals(NormalWeighting weighting){
+    int vertexCount = static_cast<int>(vertices.size());
+    int triangleCount = static_cast<int>(indices.size())/3;
+    normals.resize(vertexCount);
+    if (vertexCount == 0){
+        return;
     }
-    
-    for (int i=0;i<indices.size();i=i+3){
-        int index1 = indices[i];
-        int index2 = indices[i+1];
-        int index3 = indices[i+2];
-        glm::vec3 v1 = vertices[index1];
-        glm::vec3 v2 = vertices[index2];
-        glm::vec3 v3 = vertices[index3];
-        
-        glm::vec3 v1v2 = v2-v1;
-        glm::vec3 v1v3 = v3-v1;
-        
-        glm::vec3 normal = glm::normalize(glm::cross(v1v2,v1v3));
-        
-        normals[index1] = normals[index1]+normal;
-        normals[index2] = normals[index2]+normal;
-        normals[index3] = normals[index3]+normal;
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<float> cornerWeights;
+    if (weighting == NORMAL_WEIGHT_ANGLE){
+        cornerWeights.resize(triangleCount*3);
     }
-    
-    for (vector<glm::vec3>::iterator iter = normals.begin();iter != normals.end();iter++){
-        (*iter) = glm::normalize(*iter);
+    FaceNormalsJob faceJob(&vertices[0], GetIndices(), weighting, dataOrNull(faceNormals),
+            dataOrNull(cornerWeights));
+    JobSystem::Instance()->ParallelFor(&faceJob, triangleCount, TRIANGLE_BATCH_SIZE);
+
+    std::vector<int> offsets;
+    std::vector<int> corners;
+    buildCornerAdjacency(GetIndices(), triangleCount*3, vertexCount, offsets, corners);
+    VertexNormalsJob vertexJob(dataOrNull(faceNormals), dataOrNull(cornerWeights), &offsets[0],
+            dataOrNull(corners), &normals[0]);
+    JobSystem::Instance()->ParallelFor(&vertexJob, vertexCount, VERTEX_BATCH_SIZE);
+}
+
+bool Mesh::ComputeTangents(){
+    int vertexCount = static_cast<int>(vertices.size());
+    if (textureCoords1.size() != vertices.size() || vertexCount == 0){
+        return false;
     }
+    if (normals.size() != vertices.size()){
+        ComputeNormals();
+    }
+    int triangleCount = static_cast<int>(indices.size())/3;
+    tangents.resize(vertexCount);
+    std::vector<glm::vec3> faceTangents(triangleCount);
+    std::vector<float> faceSigns(triangleCount);
+    FaceTangentsJob faceJob(&vertices[0], &textureCoords1[0], GetIndices(), dataOrNull(faceTangents),
+            dataOrNull(faceSigns));
+    JobSystem::Instance()->ParallelFor(&faceJob, triangleCount, TRIANGLE_BATCH_SIZE);
+
+    std::vector<int> offsets;
+    std::vector<int> corners;
+    buildCornerAdjacency(GetIndices(), triangleCount*3, vertexCount, offsets, corners);
+    VertexTangentsJob vertexJob(&vertices[0], &normals[0], GetIndices(), dataOrNull(faceTangents),
+            dataOrNull(faceSigns), &offsets[0], dataOrNull(corners), &tangents[0]);
+    JobSystem::Instance()->ParallelFor(&vertexJob, vertexCount, VERTEX_BATCH_SIZE);
+    return true;
 }
 
 
+Bounds Mesh::ComputeBounds(){
+    return Bounds::FromPoints(GetVertices(), vertices.size());
+}
+
 void Mesh::SetVertices(glm::vec3 *vertices, int length){
     this->vertices.clear();
     for (int i=0;i<length;i++){
@@ -10,16 +10,45 @@
 
 #include <vector>
 #include <glm/glm.hpp>
+#include "math/Bounds.h"
 
 
 namespace render_e {
+
+/// Weighting of the face normals summed at each vertex (see
+/// Mesh::ComputeNormals())
+enum NormalWeighting {
+    /// Faces are weighted by their area
+    NORMAL_WEIGHT_AREA,
+    /// Faces are weighted by their angle at the vertex (independent of the
+    /// tessellation)
+    NORMAL_WEIGHT_ANGLE,
+    /// All faces have the same weight
+    NORMAL_WEIGHT_UNIFORM
+};
+
 class Mesh {
 public:
     Mesh();
     Mesh(const Mesh& orig);
     virtual ~Mesh();
     
-    void ComputeNormals();
+    /// Compute the vertex normals as the weighted sum of the normals of the
+    /// adjacent faces. The faces are processed using SIMD and both passes
+    /// run on the job system
+    void ComputeNormals(NormalWeighting weighting = NORMAL_WEIGHT_AREA);
+    /// Compute the vertex tangents from the first texture coordinates
+    /// (normals are computed first if missing). Uses the MikkTSpace
+    /// weighting: the face tangents are projected onto the plane of the
+    /// vertex normal and weighted by the angle of the face at the vertex.
+    /// Tangents have no handedness, so at a vertex shared by faces with
+    /// mirrored texture coordinates only the faces with the dominant
+    /// orientation are used. Returns false if the mesh has no texture
+    /// coordinates
+    bool ComputeTangents();
+    
+    /// Computes the bounding box and bounding sphere of the vertices
+    Bounds ComputeBounds();
 
     glm::vec3 *GetVertices();
     glm::vec3 *GetNormals();
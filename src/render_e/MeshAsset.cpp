@@ -0,0 +1,574 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "MeshAsset.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Log.h"
+#include "GLStateCache.h"
+#include "shaders/Shader.h"
+
+#define BUFFER_OFFSET(bytes) ((GLubyte*) NULL + (bytes))
+
+namespace render_e {
+
+int MeshAsset::s_nextMeshId = 1;
+bool MeshAsset::s_optimizeMeshes = true;
+VertexCompression MeshAsset::s_defaultVertexCompression;
+
+namespace {
+const float IDENTITY_POSITION_DECODE[4] = {0, 0, 0, 1};
+const float IDENTITY_DECODE_FLAGS[4] = {0, 0, 0, 0};
+const float RADIANS_TO_DEGREES = 57.2957795f;
+
+inline float clampFloat(float value, float minimum, float maximum){
+    return std::min(std::max(value, minimum), maximum);
+}
+
+inline int roundToInt(float value){
+    return static_cast<int>(floor(value+0.5f));
+}
+
+/// Convert to a 16 bit float (rounded to nearest, out of range values
+/// become infinity)
+unsigned short floatToHalf(float value){
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(float));
+    unsigned short sign = static_cast<unsigned short>((bits>>16) & 0x8000);
+    int exponent = static_cast<int>((bits>>23) & 0xff)-127+15;
+    unsigned int mantissa = bits & 0x7fffff;
+    if (exponent >= 31){
+        return sign | 0x7c00;
+    }
+    if (exponent <= 0){
+        if (exponent < -10){
+            return sign;
+        }
+        // denormalized half
+        mantissa |= 0x800000;
+        unsigned int shift = 14-exponent;
+        unsigned int half = mantissa>>shift;
+        if ((mantissa>>(shift-1)) & 1){
+            half++;
+        }
+        return sign | static_cast<unsigned short>(half);
+    }
+    unsigned int half = (exponent<<10) | (mantissa>>13);
+    if (mantissa & 0x1000){
+        half++; // may carry into the exponent, which rounds up correctly
+    }
+    return sign | static_cast<unsigned short>(half);
+}
+
+float halfToFloat(unsigned short half){
+    int exponent = (half>>10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    float value;
+    if (exponent == 0){
+        value = ldexp(static_cast<float>(mantissa), -24);
+    } else if (exponent == 31){
+        value = HUGE_VAL;
+    } else {
+        value = ldexp(static_cast<float>(mantissa|0x400), exponent-25);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/// Decode an octahedral encoded unit vector (as in shared.vs)
+glm::vec3 decodeOctahedral(const glm::vec2 &encoded){
+    glm::vec3 v(encoded.x, encoded.y, 1.0f-fabs(encoded.x)-fabs(encoded.y));
+    if (v.z < 0){
+        float x = v.x;
+        v.x = (1.0f-fabs(v.y))*(x >= 0 ? 1.0f : -1.0f);
+        v.y = (1.0f-fabs(x))*(v.y >= 0 ? 1.0f : -1.0f);
+    }
+    return glm::normalize(v);
+}
+
+/// Write the direction to dest using the encoding and return the direction
+/// decoded by the shader
+glm::vec3 encodeDirection(const glm::vec3 &direction, VertexEncoding encoding, unsigned char *dest){
+    if (encoding == VERTEX_ENCODING_FLOAT){
+        memcpy(dest, glm::value_ptr(direction), sizeof(glm::vec3));
+        return direction;
+    }
+    float length = glm::length(direction);
+    glm::vec3 unit = length > 0 ? direction/length : glm::vec3(0, 0, 1);
+    if (encoding == VERTEX_ENCODING_INT_2_10_10_10){
+        int x = roundToInt(clampFloat(unit.x, -1, 1)*511);
+        int y = roundToInt(clampFloat(unit.y, -1, 1)*511);
+        int z = roundToInt(clampFloat(unit.z, -1, 1)*511);
+        unsigned int packed = (x & 0x3ff) | ((y & 0x3ff)<<10) | ((z & 0x3ff)<<20);
+        memcpy(dest, &packed, sizeof(packed));
+        return glm::vec3(x, y, z)/511.0f;
+    }
+    // octahedral: project onto the octahedron and fold the lower half
+    float invL1 = 1.0f/(fabs(unit.x)+fabs(unit.y)+fabs(unit.z));
+    float px = unit.x*invL1;
+    float py = unit.y*invL1;
+    if (unit.z < 0){
+        float x = px;
+        px = (1.0f-fabs(py))*(x >= 0 ? 1.0f : -1.0f);
+        py = (1.0f-fabs(x))*(py >= 0 ? 1.0f : -1.0f);
+    }
+    // use the rounding (of the four nearest values) with the smallest error
+    short best[2] = {0, 0};
+    glm::vec3 bestDecoded(0, 0, 1);
+    float bestDot = -2;
+    for (int i=0;i<4;i++){
+        int x = static_cast<int>(floor(px*32767))+(i&1);
+        int y = static_cast<int>(floor(py*32767))+((i>>1)&1);
+        x = std::min(std::max(x, -32767), 32767);
+        y = std::min(std::max(y, -32767), 32767);
+        glm::vec3 decoded = decodeOctahedral(glm::vec2(x/32767.0f, y/32767.0f));
+        float d = glm::dot(decoded, unit);
+        if (d > bestDot){
+            bestDot = d;
+            bestDecoded = decoded;
+            best[0] = static_cast<short>(x);
+            best[1] = static_cast<short>(y);
+        }
+    }
+    memcpy(dest, best, sizeof(best));
+    return bestDecoded;
+}
+
+/// Angle in degrees between the (unnormalized) directions
+float angleDegrees(const glm::vec3 &a, const glm::vec3 &b){
+    if (glm::dot(a, a) == 0 || glm::dot(b, b) == 0){
+        return 0;
+    }
+    // more precise than acos for small angles
+    return atan2(glm::length(glm::cross(a, b)), glm::dot(a, b))*RADIANS_TO_DEGREES;
+}
+
+/// Write the texture coordinate to dest using the encoding and return the
+/// largest error
+float encodeTextureCoord(const glm::vec2 &textureCoord, VertexEncoding encoding, unsigned char *dest){
+    if (encoding == VERTEX_ENCODING_FLOAT){
+        memcpy(dest, glm::value_ptr(textureCoord), sizeof(glm::vec2));
+        return 0;
+    }
+    unsigned short half[2] = {floatToHalf(textureCoord.x), floatToHalf(textureCoord.y)};
+    memcpy(dest, half, sizeof(half));
+    return std::max(fabs(halfToFloat(half[0])-textureCoord.x), fabs(halfToFloat(half[1])-textureCoord.y));
+}
+}
+
+VertexPrecisionError::VertexPrecisionError()
+:position(0),normal(0),tangent(0),color(0),textureCoords(0) {
+}
+
+MeshAsset::MeshAsset(Mesh *mesh, bool keepMesh, const VertexCompression &compression)
+:mesh(keepMesh?mesh:NULL), usageCount(0), meshId(s_nextMeshId++), vboName(0), vboElements(0), vaoName(0),
+        positionVaoName(0) {
+    geometryRange.page = NULL;
+    memcpy(positionDecode, IDENTITY_POSITION_DECODE, sizeof(positionDecode));
+    memcpy(decodeFlags, IDENTITY_DECODE_FLAGS, sizeof(decodeFlags));
+    Upload(mesh, compression);
+}
+
+MeshAsset::~MeshAsset() {
+    if (geometryRange.page != NULL){
+        GeometryHeap::Instance()->Free(geometryRange);
+    }
+    if (vaoName != 0){
+        glDeleteVertexArrays(1, &vaoName);
+        GLStateCache::Instance()->VertexArrayDeleted(vaoName);
+        glDeleteVertexArrays(1, &positionVaoName);
+        GLStateCache::Instance()->VertexArrayDeleted(positionVaoName);
+    }
+    if (vboName != 0){
+        glDeleteBuffers(1, &vboName);
+        glDeleteBuffers(1, &vboElements);
+        GLStateCache::Instance()->BufferDeleted(vboName);
+        GLStateCache::Instance()->BufferDeleted(vboElements);
+    }
+    delete mesh;
+}
+
+void MeshAsset::DecreaseUsageCount(){
+    assert(usageCount > 0);
+    usageCount--;
+    if (usageCount == 0){
+        if (cacheKey.length()>0){
+            MeshCache::Instance()->Remove(this);
+        }
+        delete this;
+    }
+}
+
+void MeshAsset::Render(){
+    if (indicesCount==0){
+        return;
+        ERROR("Mesh not initialized");
+    }
+    BindBuffers();
+    Draw(1);
+}
+
+void MeshAsset::RenderInstanced(int instanceCount){
+    if (indicesCount==0){
+        return;
+    }
+    BindBuffers();
+    Draw(instanceCount);
+}
+
+void MeshAsset::RenderPositionOnly(int instanceCount){
+    if (indicesCount==0){
+        return;
+    }
+    BindPositionBuffers();
+    Draw(instanceCount);
+}
+
+void MeshAsset::Draw(int instanceCount){
+    if (geometryRange.page != NULL){
+        GeometryHeap::Instance()->Draw(geometryRange, instanceCount);
+    } else if (instanceCount == 1){
+        glDrawElements(GL_TRIANGLES, indicesCount, indexType, BUFFER_OFFSET(0) );
+    } else {
+        glDrawElementsInstancedARB(GL_TRIANGLES, indicesCount, indexType, BUFFER_OFFSET(0), instanceCount);
+    }
+}
+
+unsigned int MeshAsset::GetVertexBufferId() const{
+    if (geometryRange.page != NULL){
+        return geometryRange.page->vertexBufferId;
+    }
+    return vboName;
+}
+
+unsigned int MeshAsset::GetSortId() const{
+    const int MESH_ID_BITS = 10;
+    unsigned int pageId = geometryRange.page != NULL ? geometryRange.page->id+1 : 0;
+    return (pageId<<MESH_ID_BITS) | (meshId & ((1<<MESH_ID_BITS)-1));
+}
+
+bool MeshAsset::IsVertexArraySupported(){
+    return GLEW_ARB_vertex_array_object != 0;
+}
+
+void MeshAsset::BindBuffers(){
+    GLStateCache *glState = GLStateCache::Instance();
+    SetupDecoding();
+    if (geometryRange.page != NULL){
+        GeometryHeap::Instance()->Bind(geometryRange.page);
+        return;
+    }
+    assert(vboName != 0);
+    if (vaoName != 0){
+        // the vertex array object holds the element buffer and the layout
+        glState->BindVertexArray(vaoName);
+        return;
+    }
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements);
+    if (!glState->SetVertexArraySource(vboName)){
+        return; // the pointers are already set up for this buffer
+    }
+    SetupVertexAttributes();
+}
+
+void MeshAsset::BindPositionBuffers(){
+    if (geometryRange.page != NULL){
+        SetupDecoding();
+        GeometryHeap::Instance()->BindPositionOnly(geometryRange.page);
+        return;
+    }
+    if (positionVaoName != 0){
+        SetupDecoding();
+        GLStateCache::Instance()->BindVertexArray(positionVaoName);
+        return;
+    }
+    BindBuffers();
+}
+
+void MeshAsset::SetupDecoding(){
+    // the decoding is constant per mesh, so it is passed as the current
+    // value of disabled attribute arrays (not part of the vertex array
+    // object state)
+    GLStateCache *glState = GLStateCache::Instance();
+    glState->VertexAttrib4fv(VERTEX_ATTRIBUTE_DECODE_POSITION, positionDecode);
+    glState->VertexAttrib4fv(VERTEX_ATTRIBUTE_DECODE_FLAGS, decodeFlags);
+}
+
+void MeshAsset::ResetDecoding(){
+    GLStateCache *glState = GLStateCache::Instance();
+    glState->VertexAttrib4fv(VERTEX_ATTRIBUTE_DECODE_POSITION, IDENTITY_POSITION_DECODE);
+    glState->VertexAttrib4fv(VERTEX_ATTRIBUTE_DECODE_FLAGS, IDENTITY_DECODE_FLAGS);
+}
+
+void MeshAsset::SetupVertexAttributes(){
+    // bind buffer (set active)
+    GLStateCache::Instance()->BindBuffer(GL_ARRAY_BUFFER, vboName);
+    format.SetupVertexAttributes();
+}
+
+void MeshAsset::Upload(Mesh *mesh, const VertexCompression &compression){
+    assert (mesh->GetVertices() != NULL);
+    assert (mesh->IsValid());
+    // a mesh not kept by the asset belongs to the caller, so a staging copy
+    // is optimized instead
+    Mesh *stagingMesh = NULL;
+    if (s_optimizeMeshes){
+        if (mesh != this->mesh){
+            stagingMesh = new Mesh(*mesh);
+            mesh = stagingMesh;
+        }
+        optimizerStats = MeshOptimizer::Optimize(mesh);
+    }
+    glm::vec3 *vertices = mesh->GetVertices();
+    glm::vec3 *normals = mesh->GetNormals();
+    glm::vec3 *tangents = mesh->GetTangents();
+    glm::vec3 *colors = mesh->GetColors();
+    glm::vec2 *textureCoords = mesh->GetTextureCoords1();
+    glm::vec2 *textureCoords2 = mesh->GetTextureCoords2();
+    int primitiveCount = mesh->GetPrimitiveCount();
+    int *indices = mesh->GetIndices(); // todo rename
+    indicesCount = mesh->GetIndicesCount();
+    bounds = mesh->ComputeBounds();
+
+    // Encoding of each attribute (encodings not supported by the driver
+    // fall back to a supported encoding)
+    VertexEncoding directionEncoding = compression.normals;
+    if (!VertexFormat::IsEncodingSupported(directionEncoding)){
+        directionEncoding = VERTEX_ENCODING_OCTAHEDRAL;
+    }
+    VertexEncoding textureEncoding = VERTEX_ENCODING_FLOAT;
+    if (compression.textureCoords && VertexFormat::IsEncodingSupported(VERTEX_ENCODING_HALF)){
+        textureEncoding = VERTEX_ENCODING_HALF;
+    }
+    format.normalEncoding = normals != NULL ? directionEncoding : VERTEX_ENCODING_FLOAT;
+    format.tangentEncoding = tangents != NULL ? directionEncoding : VERTEX_ENCODING_FLOAT;
+    format.colorEncoding = colors != NULL && compression.colors ? VERTEX_ENCODING_UNORM8 : VERTEX_ENCODING_FLOAT;
+    format.texture1Encoding = textureCoords != NULL ? textureEncoding : VERTEX_ENCODING_FLOAT;
+    format.texture2Encoding = textureCoords2 != NULL ? textureEncoding : VERTEX_ENCODING_FLOAT;
+    format.vertexEncoding = compression.positions ? VERTEX_ENCODING_SHORT : VERTEX_ENCODING_FLOAT;
+    decodeFlags[0] = format.normalEncoding == VERTEX_ENCODING_OCTAHEDRAL ? 1.0f : 0.0f;
+    decodeFlags[1] = format.tangentEncoding == VERTEX_ENCODING_OCTAHEDRAL ? 1.0f : 0.0f;
+
+    // Quantized positions are stored relative to the center of the bounds
+    // using the same scale on all axes
+    glm::vec3 positionOffset(0, 0, 0);
+    float positionScale = 1;
+    if (format.vertexEncoding == VERTEX_ENCODING_SHORT){
+        glm::vec3 extent = bounds.GetExtent();
+        float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+        positionOffset = bounds.GetCenter();
+        positionScale = maxExtent > 0 ? maxExtent/32767.0f : 1.0f;
+    }
+    positionDecode[0] = positionOffset.x;
+    positionDecode[1] = positionOffset.y;
+    positionDecode[2] = positionOffset.z;
+    positionDecode[3] = positionScale;
+
+    // Calculate size of data
+
+    int sizeDirection = VertexFormat::GetAttributeSize(directionEncoding, 3);
+    int offset = 0;
+    if (normals != NULL){
+        format.normalOffset = offset;
+        offset += sizeDirection;
+    } else {
+        format.normalOffset = -1;
+    }
+
+    if (tangents != NULL){
+        format.tangentOffset = offset;
+        offset += sizeDirection;
+    } else {
+        format.tangentOffset = -1;
+    }
+
+    if (colors != NULL){
+        format.colorOffset = offset;
+        offset += VertexFormat::GetAttributeSize(format.colorEncoding, 3);
+    } else {
+        format.colorOffset = -1;
+    }
+    int sizeTexCoords = VertexFormat::GetAttributeSize(textureEncoding, 2);
+    if (textureCoords != NULL) {
+        format.texture1Offset = offset;
+        offset += sizeTexCoords;
+    } else {
+        format.texture1Offset = -1;
+    }
+    if (textureCoords2 != NULL) {
+        format.texture2Offset = offset;
+        offset += sizeTexCoords;
+    } else {
+        format.texture2Offset = -1;
+    }
+    // vertices
+    format.vertexOffset = offset;
+    offset += VertexFormat::GetAttributeSize(format.vertexEncoding, 3);
+    // keep the attributes 4 byte aligned
+    offset = (offset+3) & ~3;
+    format.stride = offset;
+
+    // create temp buffer
+    unsigned int buffersize = offset*primitiveCount;
+
+    void *indicesDest;
+    int indicesSize;
+
+    // 8 bit indices are converted on the fly by many drivers, so at least
+    // 16 bit indices are used
+    if (primitiveCount <= 0x10000){
+        indicesSize = sizeof(unsigned short);
+        this->indexType = GL_UNSIGNED_SHORT;
+        GLushort *shortBuffer = new GLushort[indicesCount];
+        for (int i=0;i<indicesCount;i++){
+            shortBuffer[i] = static_cast<unsigned short>(indices[i]);
+        }
+        indicesDest = shortBuffer;
+    } else {
+        indicesSize = sizeof(int);
+        this->indexType = GL_UNSIGNED_INT;
+        GLuint *intBuffer = new GLuint[indicesCount];
+        memcpy(intBuffer, indices, indicesCount*indicesSize);
+        indicesDest = intBuffer;
+    }
+
+
+	unsigned char *buffer;
+    buffer = new unsigned char[buffersize];
+    memset(buffer, 0, buffersize);
+
+    // Memory layout: Normal0, ..., Vertex0,  Normal1, ..., Vertex1, ...
+    // This layout gives a better performance, since the data that belongs
+    // together are located close to each other. The error of each encoded
+    // attribute is measured by decoding it again
+
+    precisionError = VertexPrecisionError();
+    for (int i=0;i<primitiveCount;i++){
+        unsigned char *vertex = &(buffer[i*offset]);
+        if (normals != NULL){
+            glm::vec3 decoded = encodeDirection(normals[i], format.normalEncoding, vertex+format.normalOffset);
+            precisionError.normal = std::max(precisionError.normal, angleDegrees(decoded, normals[i]));
+        }
+        if (tangents != NULL){
+            glm::vec3 decoded = encodeDirection(tangents[i], format.tangentEncoding, vertex+format.tangentOffset);
+            precisionError.tangent = std::max(precisionError.tangent, angleDegrees(decoded, tangents[i]));
+        }
+        if (colors != NULL){
+            if (format.colorEncoding == VERTEX_ENCODING_UNORM8){
+                unsigned char *color = vertex+format.colorOffset;
+                for (int j=0;j<3;j++){
+                    color[j] = static_cast<unsigned char>(roundToInt(clampFloat(colors[i][j], 0, 1)*255));
+                    precisionError.color = std::max(precisionError.color, std::fabs(color[j]/255.0f-colors[i][j]));
+                }
+                color[3] = 255;
+            } else {
+                memcpy(vertex+format.colorOffset, glm::value_ptr(colors[i]), sizeof(glm::vec3));
+            }
+        }
+        if (textureCoords != NULL){
+            precisionError.textureCoords = std::max(precisionError.textureCoords,
+                    encodeTextureCoord(textureCoords[i], textureEncoding, vertex+format.texture1Offset));
+        }
+        if (textureCoords2 != NULL){
+            precisionError.textureCoords = std::max(precisionError.textureCoords,
+                    encodeTextureCoord(textureCoords2[i], textureEncoding, vertex+format.texture2Offset));
+        }
+        // vertices
+        if (format.vertexEncoding == VERTEX_ENCODING_SHORT){
+            glm::vec3 quantized = (vertices[i]-positionOffset)/positionScale;
+            short position[4];
+            for (int j=0;j<3;j++){
+                position[j] = static_cast<short>(std::min(std::max(roundToInt(quantized[j]), -32767), 32767));
+            }
+            position[3] = 1;
+            memcpy(vertex+format.vertexOffset, position, sizeof(position));
+            glm::vec3 decoded(position[0], position[1], position[2]);
+            decoded = decoded*positionScale+positionOffset;
+            precisionError.position = std::max(precisionError.position, glm::length(decoded-vertices[i]));
+        } else {
+            memcpy(vertex+format.vertexOffset, glm::value_ptr(vertices[i]), sizeof(glm::vec3));
+        }
+    }
+    bool compressed = format.normalEncoding != VERTEX_ENCODING_FLOAT ||
+            format.tangentEncoding != VERTEX_ENCODING_FLOAT || format.colorEncoding != VERTEX_ENCODING_FLOAT ||
+            textureEncoding != VERTEX_ENCODING_FLOAT || format.vertexEncoding != VERTEX_ENCODING_FLOAT;
+    if (compressed){
+        std::stringstream ss;
+        ss << "Mesh "<<meshId<<" vertex size "<<format.stride<<" bytes, precision error: position "
+                <<precisionError.position<<" normal "<<precisionError.normal<<" deg tangent "
+                <<precisionError.tangent<<" deg color "<<precisionError.color<<" texture coords "
+                <<precisionError.textureCoords;
+        DEBUG(ss.str());
+    }
+
+    // meshes are suballocated from the geometry heap when supported
+    bool inHeap = indicesCount > 0 && GeometryHeap::Instance()->Allocate(format, buffer, primitiveCount,
+            indexType, indicesDest, indicesCount, geometryRange);
+    if (!inHeap){
+        UploadBuffers(buffer, buffersize, indicesDest, indicesCount*indicesSize);
+    }
+
+    // clean up cpu memory
+    delete []buffer;
+    switch (indexType){
+        case GL_UNSIGNED_SHORT:
+            delete []static_cast<GLushort*>(indicesDest);
+            break;
+        case GL_UNSIGNED_INT:
+            delete []static_cast<int*>(indicesDest);
+            break;
+    }
+    delete stagingMesh;
+}
+
+void MeshAsset::UploadBuffers(const void *vertexData, int vertexBytes, const void *indexData, int indexBytes){
+    unsigned int buffernames[2];
+    glGenBuffers(2,buffernames);
+    vboName = buffernames[0];
+    vboElements = buffernames[1];
+    // Bind buffer (set buffer active)
+    GLStateCache *glState = GLStateCache::Instance();
+    if (IsVertexArraySupported()){
+        // the element buffer binding would otherwise change the bound
+        // vertex array object
+        glState->BindVertexArray(0);
+    }
+	glState->BindBuffer(GL_ARRAY_BUFFER, vboName); // bind
+	// copy data to buffer
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData,GL_STATIC_DRAW);
+    glState->BindBuffer(GL_ARRAY_BUFFER, 0); // bind
+    
+    // Bind buffer (set buffer active)
+	glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements); // bind
+    // copy data to buffer
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData,GL_STATIC_DRAW);
+    glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // bind
+    
+    if (IsVertexArraySupported()){
+        // capture the element buffer and the vertex layout once, so
+        // rendering only binds the vertex array object
+        glGenVertexArrays(1, &vaoName);
+        glState->BindVertexArray(vaoName);
+        glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements);
+        SetupVertexAttributes();
+        glGenVertexArrays(1, &positionVaoName);
+        glState->BindVertexArray(positionVaoName);
+        glState->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements);
+        format.SetupPositionAttribute();
+        glState->BindVertexArray(0);
+    }
+}
+
+}
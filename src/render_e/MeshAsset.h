@@ -0,0 +1,169 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_MESHASSET_H
+#define	RENDER_E_MESHASSET_H
+
+#include <string>
+#include "Mesh.h"
+#include "VertexFormat.h"
+#include "GeometryHeap.h"
+#include "MeshOptimizer.h"
+#include "math/Bounds.h"
+
+namespace render_e {
+
+/// Largest error introduced by the vertex compression of a mesh (0 for
+/// uncompressed attributes)
+struct VertexPrecisionError {
+    VertexPrecisionError();
+    /// distance in local space units
+    float position;
+    /// angle in degrees
+    float normal;
+    float tangent;
+    /// difference of a color component
+    float color;
+    /// difference of a texture coordinate
+    float textureCoords;
+};
+
+///
+/// Mesh data uploaded to the GPU (vertex and index buffer) which may be
+/// shared by several MeshComponents. The data is suballocated from the
+/// GeometryHeap when supported, otherwise the asset has buffers of its own.
+/// The asset is reference counted: it is deleted (and removed from the
+/// MeshCache) when the usage count drops to 0.
+///
+class MeshAsset {
+public:
+    /// Upload the mesh to the GPU. If keepMesh is true the asset takes
+    /// ownership of the mesh (returned by GetMesh()), otherwise the mesh is
+    /// only used during construction. The triangles and vertices are
+    /// reordered by the MeshOptimizer before upload (unless disabled using
+    /// SetOptimizeMeshes()): a kept mesh is reordered in place, otherwise a
+    /// copy is reordered and the mesh is not changed. The vertex attributes
+    /// are compressed as described by compression.
+    MeshAsset(Mesh *mesh, bool keepMesh,
+            const VertexCompression &compression = GetDefaultVertexCompression());
+
+    /// When enabled (default) meshes are optimized for the vertex cache
+    /// and vertex fetch before upload (see MeshOptimizer)
+    static void SetOptimizeMeshes(bool enabled) { s_optimizeMeshes = enabled; }
+    static bool GetOptimizeMeshes() { return s_optimizeMeshes; }
+    /// Compression of the meshes created without an explicit compression
+    /// (such as the meshes of the MeshCache). The default is no compression
+    static void SetDefaultVertexCompression(const VertexCompression &compression) {
+        s_defaultVertexCompression = compression;
+    }
+    static const VertexCompression &GetDefaultVertexCompression() { return s_defaultVertexCompression; }
+
+    void IncreaseUsageCount() { usageCount++; }
+    /// Decrease the usage count. The asset is deleted when the count
+    /// reaches 0
+    void DecreaseUsageCount();
+    int GetUsageCount() { return usageCount; }
+
+    /// Returns true if vertex array objects are supported
+    /// (GL_ARB_vertex_array_object)
+    static bool IsVertexArraySupported();
+
+    /// Bind the vertex array object of the mesh (or of its geometry heap
+    /// page) and set the decoding of the compressed attributes. Without
+    /// vertex array object support the buffers are bound and the vertex
+    /// pointers are set
+    void BindBuffers();
+    /// Bind the position-only vertex array object of the mesh (or of its
+    /// geometry heap page). Without vertex array object support all
+    /// attributes are bound (see BindBuffers())
+    void BindPositionBuffers();
+    void Render();
+    /// Render the mesh instanceCount times using glDrawElementsInstancedARB
+    void RenderInstanced(int instanceCount);
+    /// Render the mesh instanceCount times using only the position attribute
+    void RenderPositionOnly(int instanceCount = 1);
+    /// Set the attribute decoding of uncompressed vertices. Must be invoked
+    /// before drawing vertices not in a MeshAsset
+    static void ResetDecoding();
+
+    /// Returns the mesh (or NULL if the mesh was not kept)
+    Mesh *GetMesh() { return mesh; }
+    /// Local space bounds of the mesh
+    const Bounds &GetBounds() const { return bounds; }
+    /// Returns the OpenGL name of the vertex buffer (shared by the meshes in
+    /// the same geometry heap page)
+    unsigned int GetVertexBufferId() const;
+    int GetIndicesCount() const { return indicesCount; }
+    /// Unique id of the asset
+    int GetMeshId() const { return meshId; }
+    /// Id used to sort draw calls: meshes in the same geometry heap page are
+    /// adjacent
+    unsigned int GetSortId() const;
+    /// Returns the range of the mesh in the geometry heap (the page is NULL
+    /// if the mesh is not in the heap)
+    const GeometryRange &GetGeometryRange() const { return geometryRange; }
+    const VertexFormat &GetVertexFormat() const { return format; }
+    /// Returns true if the positions are quantized. Such meshes must be
+    /// drawn with their own decoding (they cannot share a draw call with
+    /// other meshes)
+    bool IsPositionCompressed() const { return format.vertexEncoding != VERTEX_ENCODING_FLOAT; }
+    /// Largest error of each attribute introduced by the compression
+    const VertexPrecisionError &GetPrecisionError() const { return precisionError; }
+    /// Vertex cache efficiency before and after the MeshOptimizer (zero if
+    /// the mesh was not optimized)
+    const MeshOptimizerStats &GetOptimizerStats() const { return optimizerStats; }
+
+    /// Returns the key of the asset in the MeshCache (empty if not cached)
+    const std::string &GetCacheKey() const { return cacheKey; }
+private:
+    friend class MeshCache;
+    ~MeshAsset(); // use DecreaseUsageCount()
+    MeshAsset(const MeshAsset& orig); // disallow copy constructor
+    MeshAsset& operator = (const MeshAsset&); // disallow copy constructor
+
+    void Upload(Mesh *mesh, const VertexCompression &compression);
+    /// Set the constant attributes decoding the compressed attributes
+    void SetupDecoding();
+    /// Upload the data to buffers owned by the asset
+    void UploadBuffers(const void *vertexData, int vertexBytes, const void *indexData, int indexBytes);
+    /// Bind the vertex buffer and set the vertex attributes
+    void SetupVertexAttributes();
+    /// Draw the mesh using the bound buffers
+    void Draw(int instanceCount);
+
+    static int s_nextMeshId;
+    static bool s_optimizeMeshes;
+    static VertexCompression s_defaultVertexCompression;
+
+    Mesh *mesh;
+    std::string cacheKey;
+    int usageCount;
+    int meshId;
+    /// buffers owned by the asset (0 if the mesh is in the geometry heap)
+    unsigned int vboName;
+    unsigned int vboElements;
+    /// vertex array object capturing the buffers and the vertex layout (0 if
+    /// not supported)
+    unsigned int vaoName;
+    /// vertex array object with only the position attribute enabled
+    unsigned int positionVaoName;
+    int indicesCount;
+    VertexFormat format;
+    GeometryRange geometryRange;
+    unsigned short indexType;
+    Bounds bounds;
+    /// offset (xyz) and scale (w) of the quantized positions
+    float positionDecode[4];
+    /// octahedral encoding of normals (x) and tangents (y)
+    float decodeFlags[4];
+    VertexPrecisionError precisionError;
+    MeshOptimizerStats optimizerStats;
+};
+}
+
+#endif	/* RENDER_E_MESHASSET_H */
+
@@ -0,0 +1,86 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "MeshCache.h"
+
+#include <cassert>
+#include <sstream>
+
+#include "MeshFactory.h"
+
+namespace render_e {
+
+MeshCache *MeshCache::s_instance = NULL;
+
+MeshCache::MeshCache(){
+}
+
+MeshAsset *MeshCache::Find(const std::string &key){
+    std::map<std::string, MeshAsset*>::iterator iter = assets.find(key);
+    if (iter != assets.end()){
+        return iter->second;
+    }
+    return NULL;
+}
+
+MeshAsset *MeshCache::Add(const std::string &key, Mesh *mesh){
+    assert(Find(key) == NULL);
+    MeshAsset *asset = new MeshAsset(mesh, true);
+    asset->cacheKey = key;
+    assets[key] = asset;
+    return asset;
+}
+
+void MeshCache::Remove(MeshAsset *asset){
+    std::map<std::string, MeshAsset*>::iterator iter = assets.find(asset->GetCacheKey());
+    if (iter != assets.end() && iter->second == asset){
+        assets.erase(iter);
+    }
+}
+
+MeshAsset *MeshCache::GetPrimitive(const std::string &name){
+    if (name.compare("sphere")==0){
+        return GetICOSphere(2, 1.0f);
+    }
+    std::string key = "primitive:"+name;
+    MeshAsset *asset = Find(key);
+    if (asset != NULL){
+        return asset;
+    }
+    Mesh *mesh = NULL;
+    if (name.compare("cube")==0){
+        mesh = MeshFactory::CreateCube();
+    } else if (name.compare("tetrahedron")==0){
+        mesh = MeshFactory::CreateTetrahedron();
+    } else if (name.compare("plane")==0){
+        mesh = MeshFactory::CreatePlane();
+    } else {
+        return NULL;
+    }
+    return Add(key, mesh);
+}
+
+MeshAsset *MeshCache::GetICOSphere(int subdivisions, float radius){
+    std::stringstream ss;
+    ss<<"primitive:sphere:"<<subdivisions<<":"<<radius;
+    MeshAsset *asset = Find(ss.str());
+    if (asset != NULL){
+        return asset;
+    }
+    return Add(ss.str(), MeshFactory::CreateICOSphere(subdivisions, radius));
+}
+
+std::string MeshCache::GetImportKey(const std::string &path){
+    return "import:"+path;
+}
+
+std::string MeshCache::GetLODKey(const std::string &key, int level, float reduction, float maxError){
+    std::stringstream ss;
+    ss<<key<<":lod:"<<level<<":"<<reduction<<":"<<maxError;
+    return ss.str();
+}
+}
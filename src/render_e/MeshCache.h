@@ -0,0 +1,72 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_MESHCACHE_H
+#define	RENDER_E_MESHCACHE_H
+
+#include <map>
+#include <string>
+#include "MeshAsset.h"
+
+namespace render_e {
+
+///
+/// Cache of mesh assets keyed by a string (such as "import:<path>" or
+/// "primitive:sphere:2:1"). Components referencing the same key share one
+/// MeshAsset (one Mesh and one set of GPU buffers). The cache does not hold
+/// a reference: an asset is removed when its last user releases it.
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class MeshCache {
+public:
+    /// Returns the asset with the key or NULL if not found
+    MeshAsset *Find(const std::string &key);
+    /// Create an asset from the mesh and add it to the cache. The asset takes
+    /// ownership of the mesh.
+    MeshAsset *Add(const std::string &key, Mesh *mesh);
+
+    /// Returns a primitive mesh (cube, sphere, tetrahedron or plane) or NULL
+    /// if the name is unknown
+    MeshAsset *GetPrimitive(const std::string &name);
+    MeshAsset *GetICOSphere(int subdivisions, float radius);
+
+    /// Returns the key used for imported meshes
+    static std::string GetImportKey(const std::string &path);
+    /// Returns the key used for a simplified level of the mesh with the key
+    /// (see LODGroup)
+    static std::string GetLODKey(const std::string &key, int level, float reduction, float maxError);
+
+    /// Number of assets in the cache
+    int GetSize() const { return static_cast<int>(assets.size()); }
+
+    ///
+    /// Singleton pattern.
+    /// return the mesh cache instance
+    ///
+    static MeshCache* Instance() {
+        if (!s_instance) {
+            s_instance = new MeshCache();
+        }
+        return s_instance;
+    }
+private:
+    MeshCache();
+    MeshCache(const MeshCache& orig); // disallow copy constructor
+    MeshCache& operator = (const MeshCache&); // disallow copy constructor
+    friend class MeshAsset;
+
+    /// Invoked by the asset when it is deleted
+    void Remove(MeshAsset *asset);
+
+    static MeshCache *s_instance;
+    std::map<std::string, MeshAsset*> assets;
+};
+}
+
+#endif	/* RENDER_E_MESHCACHE_H */
+
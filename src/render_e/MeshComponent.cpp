@@ -8,212 +8,114 @@
 #include "MeshComponent.h"
 
 #include <cassert>
-#include <cstring>
-#include <GL/glew.h>
-#include <glm/gtc/type_ptr.hpp>
 
-#include "Log.h"
-
-#define BUFFER_OFFSET(bytes) ((GLubyte*) NULL + (bytes))
+#include "SceneObject.h"
 
 namespace render_e {
+Bounds MeshComponent::s_emptyBounds;
+
 MeshComponent::MeshComponent()
-:Component(MeshType), vboName(0),vboElements(0)
+:Component(MeshType), meshAsset(NULL), lodAsset(NULL), occluderProxy(NULL), castShadows(true), occluder(false)
 {
 }
 
 MeshComponent::~MeshComponent() {
     Release();
+    SetOccluderProxy(NULL);
 }
 
 void MeshComponent::Render(){
-    if (indicesCount==0){
-        return;
-        ERROR("Mesh not initialized");
-    }
-    assert(vboName != 0);
-    
-    // bind buffer (set active)
-    glBindBuffer(GL_ARRAY_BUFFER, vboName);
-
-    if (normalOffset != -1){
-        // normal pointer to buffer
-        glNormalPointer(GL_FLOAT, stride, BUFFER_OFFSET(normalOffset));
+    MeshAsset *asset = GetMeshAsset();
+    if (asset == NULL){
+        return; // mesh not initialized
     }
-    if (texture1Offset != -1){
-        // texcoord pointer to buffer
-        glTexCoordPointer(2, GL_FLOAT, stride, BUFFER_OFFSET(texture1Offset));
+    asset->Render();
+}
+
+void MeshComponent::RenderInstanced(int instanceCount){
+    MeshAsset *asset = GetMeshAsset();
+    if (asset == NULL){
+        return; // mesh not initialized
     }
+    asset->RenderInstanced(instanceCount);
+}
 
-    if (colorOffset != -1){
-        glColorPointer(3, GL_FLOAT, stride, BUFFER_OFFSET(colorOffset));
+void MeshComponent::RenderPositionOnly(int instanceCount){
+    MeshAsset *asset = GetMeshAsset();
+    if (asset == NULL){
+        return; // mesh not initialized
     }
-    // vertex pointer to buffer
-    glVertexPointer(3, GL_FLOAT, stride,BUFFER_OFFSET(vertexOffset));
-    // bind buffer (set active)
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements);
-    glDrawElements(GL_TRIANGLES, indicesCount, indexType, BUFFER_OFFSET(0) );
+    asset->RenderPositionOnly(instanceCount);
 }
 
 void MeshComponent::SetMesh(Mesh *mesh){
-    assert (mesh->GetVertices() != NULL);
-    assert (mesh->IsValid());
-    glm::vec3 *vertices = mesh->GetVertices();
-    glm::vec3 *normals = mesh->GetNormals();
-    glm::vec3 *tangents = mesh->GetTangents();
-    glm::vec3 *colors = mesh->GetColors();
-    glm::vec2 *textureCoords = mesh->GetTextureCoords1();
-    glm::vec2 *textureCoords2 = mesh->GetTextureCoords2();
-    int primitiveCount = mesh->GetPrimitiveCount();
-    int *indices = mesh->GetIndices(); // todo rename
-    indicesCount = mesh->GetIndicesCount();
+    SetMeshAsset(new MeshAsset(mesh, false));
+}
+
+void MeshComponent::SetMesh(Mesh *mesh, const VertexCompression &compression){
+    SetMeshAsset(new MeshAsset(mesh, false, compression));
+}
+
+void MeshComponent::SetMeshAsset(MeshAsset *meshAsset){
+    assert(meshAsset != NULL);
+    // increase first in case the asset is already used by the component
+    meshAsset->IncreaseUsageCount();
     Release();
-    
-    // Calculate size of data
-    
-    int sizePrimitives = sizeof(glm::vec3);
-    int offset = 0;
-    if (normals != NULL){
-        normalOffset = offset;
-        offset += sizePrimitives;
-    } else {
-        normalOffset = -1;
+    this->meshAsset = meshAsset;
+    if (GetOwner() != NULL){
+        GetOwner()->SetBoundsDirty();
     }
-    
-    if (tangents != NULL){
-        tangentOffset = offset;
-        offset += sizePrimitives;
-    } else {
-        tangentOffset = -1;
+}
+
+void MeshComponent::Release(){
+    lodAsset = NULL;
+    if (meshAsset != NULL){
+        meshAsset->DecreaseUsageCount();
+        meshAsset = NULL;
     }
-    
-    if (colors != NULL){
-        colorOffset = offset;
-        offset += sizePrimitives;
-    } else {
-        colorOffset = -1;
+}
+
+void MeshComponent::SetOccluderProxy(MeshAsset *occluderProxy){
+    if (occluderProxy != NULL){
+        occluderProxy->IncreaseUsageCount();
     }
-    int sizeTexCoords = sizeof(glm::vec2);
-    if (textureCoords != NULL) {
-        texture1Offset = offset;
-        offset += sizeTexCoords;
-    } else {
-        texture1Offset = -1;
+    if (this->occluderProxy != NULL){
+        this->occluderProxy->DecreaseUsageCount();
     }
-    if (textureCoords2 != NULL) {
-        texture2Offset = offset;
-        offset += sizeTexCoords;
-    } else {
-        texture2Offset = -1;
+    this->occluderProxy = occluderProxy;
+}
+
+Mesh *MeshComponent::GetOccluderMesh(){
+    if (occluderProxy != NULL){
+        return occluderProxy->GetMesh();
     }
-    // vertices
-    vertexOffset = offset;
-    offset += sizePrimitives;
-    stride = offset;
-    
-    // create temp buffer
-    unsigned int buffersize = offset*primitiveCount*sizeof(float);
-    
-    void *indicesDest;
-    int indicesSize;
-    
-    if (primitiveCount < 0xff){
-        indicesSize = sizeof(unsigned char);
-        this->indexType = GL_UNSIGNED_BYTE;
-        GLubyte *byteBuffer = new GLubyte[indicesCount];
-        for (int i=0;i<indicesCount;i++){
-            byteBuffer[i] = static_cast<unsigned char>(indices[i]);
-        }
-        indicesDest = byteBuffer;
-    } else if (primitiveCount < 0xffff){
-        indicesSize = sizeof(unsigned short);
-        this->indexType = GL_UNSIGNED_SHORT;
-        GLushort *shortBuffer = new GLushort[indicesCount];
-        for (int i=0;i<indicesCount;i++){
-            shortBuffer[i] = static_cast<unsigned short>(indices[i]);
-        }
-        indicesDest = shortBuffer;
-    } else {
-        indicesSize = sizeof(int);
-        this->indexType = GL_UNSIGNED_INT;
-        GLuint *intBuffer = new GLuint[indicesCount];
-        memcpy(intBuffer, indices, indicesCount*indicesSize);
-        indicesDest = intBuffer;
+    if (meshAsset == NULL){
+        return NULL;
     }
-         
-    
-	unsigned char *buffer;
-    buffer = new unsigned char[buffersize];
-    
-    // Memory layout: Normal0, ..., Vertex0,  Normal1, ..., Vertex1, ...
-    // This layout gives a better performance, since the data that belongs
-    // together are located close to each other
-    
-    int destIndex = 0;
-    for (int i=0;i<primitiveCount;i++){
-        if (normals != NULL){
-            memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(normals[i]), sizePrimitives);
-            destIndex += 3;
-        }
-        if (tangents != NULL){
-            memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(tangents[i]), sizePrimitives);
-            destIndex += 3;
-        }
-        if (colors != NULL){
-            memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(colors[i]), sizePrimitives);
-            destIndex += 3;
-        }
-        if (textureCoords != NULL){
-            memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(textureCoords[i]), sizeTexCoords);
-            destIndex += 2;
-        }
-        if (textureCoords2 != NULL){
-            memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(textureCoords2[i]), sizeTexCoords);
-            destIndex += 2;
-        }
-        // vertices
-        memcpy(&(buffer[destIndex*sizeof(float)]), glm::value_ptr(vertices[i]), sizePrimitives);
-        destIndex += 3;
-        
+    return meshAsset->GetMesh();
+}
+
+const Bounds &MeshComponent::GetBounds() const{
+    if (meshAsset == NULL){
+        return s_emptyBounds;
     }
-        
-    
-    unsigned int buffernames[2];
-    glGenBuffers(2,buffernames);
-    vboName = buffernames[0];
-    vboElements = buffernames[1];
-    // Bind buffer (set buffer active)
-	glBindBuffer(GL_ARRAY_BUFFER, vboName); // bind
-	// copy data to buffer
-	glBufferData(GL_ARRAY_BUFFER, buffersize, buffer,GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0); // bind
-    
-    // Bind buffer (set buffer active)
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboElements); // bind
-    // copy data to buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesCount*indicesSize, indicesDest,GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // bind
-    
-    // clean up cpu memory
-    switch (indexType){
-        case GL_UNSIGNED_BYTE:
-            delete []static_cast<GLubyte*>(indicesDest);
-            break;
-        case GL_UNSIGNED_SHORT:
-            delete []static_cast<GLushort*>(indicesDest);
-            break;
-        case GL_UNSIGNED_INT:
-            delete []static_cast<int*>(indicesDest);
-            break;
+    return meshAsset->GetBounds();
+}
+
+unsigned int MeshComponent::GetVertexBufferId() const{
+    const MeshAsset *asset = lodAsset != NULL ? lodAsset : meshAsset;
+    if (asset == NULL){
+        return 0;
     }
+    return asset->GetVertexBufferId();
 }
 
-void MeshComponent::Release(){
-    if (vboName != 0){
-        glDeleteBuffers(1, &vboName);
-        glDeleteBuffers(1, &vboElements);
-        vboName = 0;
+unsigned int MeshComponent::GetSortId() const{
+    const MeshAsset *asset = lodAsset != NULL ? lodAsset : meshAsset;
+    if (asset == NULL){
+        return 0;
     }
+    return asset->GetSortId();
 }
 
 }
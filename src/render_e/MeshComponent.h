@@ -9,29 +9,77 @@
 #define	MESH_COMPONENT_H
 
 #include "Component.h"
+#include "PoolAllocator.h"
 #include "Mesh.h"
+#include "MeshAsset.h"
+#include "math/Bounds.h"
 
 namespace render_e {
-class MeshComponent : public Component {
+class MeshComponent : public Component, public PoolAllocated<MeshComponent> {
 public:
     MeshComponent();
     virtual ~MeshComponent();
     void Render();
+    /// Render the mesh instanceCount times using glDrawElementsInstancedARB.
+    /// The per instance attributes must be bound (see InstanceBuffer)
+    void RenderInstanced(int instanceCount);
+    /// Render the mesh using only the position attribute (see
+    /// MeshAsset::RenderPositionOnly())
+    void RenderPositionOnly(int instanceCount = 1);
+    /// When enabled (default) the mesh is rendered into shadow maps (depth
+    /// render-to-texture cameras)
+    void SetCastShadows(bool enabled) { castShadows = enabled; }
+    bool GetCastShadows() const { return castShadows; }
+    /// When enabled the mesh hides the objects behind it in the software
+    /// occlusion culling (see OcclusionCuller). Occluders should be few
+    /// and large, like walls. The mesh data must be kept on the CPU (see
+    /// MeshAsset::GetMesh()) unless an occluder proxy is set
+    void SetOccluder(bool enabled) { occluder = enabled; }
+    bool GetOccluder() const { return occluder; }
+    /// Set a simplified mesh rasterized instead of the mesh in the
+    /// occlusion culling (NULL to use the mesh itself). The proxy must not
+    /// extend beyond the mesh. The usage count of the asset is increased
+    void SetOccluderProxy(MeshAsset *occluderProxy);
+    MeshAsset *GetOccluderProxy() { return occluderProxy; }
+    /// Returns the mesh rasterized by the occlusion culling: the proxy if
+    /// set, otherwise the mesh (NULL if the mesh data is not kept)
+    Mesh *GetOccluderMesh();
+    /// Upload the mesh to a new mesh asset used only by this component. The
+    /// mesh is not retained. Use SetMeshAsset to share the mesh between
+    /// components (see MeshCache).
     void SetMesh(Mesh *mesh);
+    /// Upload the mesh with the vertex attributes compressed (see
+    /// VertexCompression and MeshAsset::GetPrecisionError())
+    void SetMesh(Mesh *mesh, const VertexCompression &compression);
+    /// Set the (shared) mesh asset. The usage count of the asset is increased
+    void SetMeshAsset(MeshAsset *meshAsset);
+    /// Returns the asset rendered: the level of detail if set, otherwise the
+    /// mesh asset
+    MeshAsset *GetMeshAsset() { return lodAsset != NULL ? lodAsset : meshAsset; }
+    /// Set the level of detail rendered instead of the mesh asset (NULL to
+    /// render the mesh asset). Set by the render base from the LODGroup of
+    /// the object, which owns the asset. The bounds and the occluder mesh
+    /// remain those of the mesh asset
+    void SetLODAsset(MeshAsset *lodAsset) { this->lodAsset = lodAsset; }
+    MeshAsset *GetLODAsset() { return lodAsset; }
+    /// Returns the mesh asset (level 0)
+    MeshAsset *GetBaseMeshAsset() { return meshAsset; }
+    /// Release the mesh asset
     void Release();
+    /// Local space bounds of the mesh
+    const Bounds &GetBounds() const;
+    /// Returns the OpenGL name of the vertex buffer (0 if no mesh is set)
+    unsigned int GetVertexBufferId() const;
+    /// Returns the sort id of the mesh (see MeshAsset::GetSortId()), 0 if no
+    /// mesh is set
+    unsigned int GetSortId() const;
 private:
-    unsigned int vboName;
-    unsigned int vboElements;
-    int indicesCount;
-    int vertexOffset;
-    int normalOffset;
-    int tangentOffset;
-    int colorOffset;
-    int texture1Offset;
-    int texture2Offset;
-    int triangleOffset;
-    int stride;
-    unsigned short indexType;
+    MeshAsset *meshAsset;
+    MeshAsset *lodAsset;
+    MeshAsset *occluderProxy;
+    bool castShadows;
+    bool occluder;
+    static Bounds s_emptyBounds;
 };
 }
 #endif	/* MESH_COMPONENT_H */
@@ -10,6 +10,7 @@
 #include <vector>
 #include <iostream>
 #include "math/Mathf.h"
+#include "MeshWelder.h"
 #include <glm/gtx/fast_square_root.hpp>
 
 using std::vector;
@@ -180,15 +181,13 @@ Mesh *MeshFactory::CreateICOSphere(int subdivisions, float radius){
     for (int i=0;i<20;i++)
         drawtri(vdata[tindices[i][0]], vdata[tindices[i][1]], vdata[tindices[i][2]], subdivisions, radius, vertices, normals, uvs);
 
-    vector<int> indices;
-    for (int i=0;i<vertices.size();i++){
-        indices.push_back(i);
-    }
+    // the triangles are generated separately, so each vertex is shared
+    // by welding
     Mesh *m = new Mesh();
     m->SetVertices(vertices);
     m->SetNormals(normals);
     m->SetTextureCoords1(uvs);
-    m->SetIndices(indices);
+    MeshWelder::Weld(m);
     return m;
 }
 
@@ -226,6 +225,8 @@ Mesh *MeshFactory::CreatePlane(){
     m->SetVertices(vertices);
     m->SetTextureCoords1(uvs);
     m->SetIndices(indices);
+    // share the corners of adjacent quads
+    MeshWelder::Weld(m);
     m->ComputeNormals();
     return m;
 }
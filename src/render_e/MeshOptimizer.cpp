@@ -0,0 +1,319 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+namespace render_e {
+
+namespace {
+/// Triangles adjacent to each vertex (the triangles of vertex v are
+/// triangles[offsets[v]] to triangles[offsets[v+1]-1]) and the number of
+/// adjacent triangles of each vertex
+void buildAdjacency(const int *indices, int indicesCount, int vertexCount, std::vector<int> &offsets,
+        std::vector<int> &triangles, std::vector<int> &triangleCounts){
+    triangleCounts.assign(vertexCount, 0);
+    for (int i=0;i<indicesCount;i++){
+        triangleCounts[indices[i]]++;
+    }
+    offsets.resize(vertexCount+1);
+    offsets[0] = 0;
+    for (int i=0;i<vertexCount;i++){
+        offsets[i+1] = offsets[i]+triangleCounts[i];
+    }
+    std::vector<int> next(offsets.begin(), offsets.end()-1);
+    triangles.resize(indicesCount);
+    for (int i=0;i<indicesCount;i++){
+        triangles[next[indices[i]]++] = i/3;
+    }
+}
+
+/// Returns the most recently used vertex with remaining triangles, or the
+/// next vertex with remaining triangles in input order (-1 when done)
+int skipDeadEnd(std::vector<int> &deadEnd, const std::vector<int> &liveCounts, int &cursor){
+    while (!deadEnd.empty()){
+        int vertex = deadEnd.back();
+        deadEnd.pop_back();
+        if (liveCounts[vertex] > 0){
+            return vertex;
+        }
+    }
+    int vertexCount = static_cast<int>(liveCounts.size());
+    while (cursor < vertexCount){
+        if (liveCounts[cursor] > 0){
+            return cursor;
+        }
+        cursor++;
+    }
+    return -1;
+}
+
+/// Returns the number of vertices transformed by a FIFO cache
+int countCacheMisses(const int *indices, int indicesCount, int vertexCount){
+    std::vector<int> cacheTime(vertexCount, 0);
+    int time = MeshOptimizer::VERTEX_CACHE_SIZE+1;
+    int misses = 0;
+    for (int i=0;i<indicesCount;i++){
+        int vertex = indices[i];
+        if (time-cacheTime[vertex] > MeshOptimizer::VERTEX_CACHE_SIZE){
+            cacheTime[vertex] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+/// Cluster of triangles and its sort key (clusters with a larger key are
+/// drawn first)
+struct TriangleCluster {
+    int begin;
+    int end;
+    float key;
+    bool operator<(const TriangleCluster &other) const {
+        return key > other.key;
+    }
+};
+
+template <class T>
+void remapAttribute(T *data, const std::vector<int> &remap){
+    if (data == NULL){
+        return;
+    }
+    std::vector<T> source(data, data+remap.size());
+    for (unsigned int i=0;i<remap.size();i++){
+        data[remap[i]] = source[i];
+    }
+}
+}
+
+MeshOptimizerStats::MeshOptimizerStats()
+:acmrBefore(0),acmrAfter(0),atvrBefore(0),atvrAfter(0) {
+}
+
+MeshOptimizerStats MeshOptimizer::Optimize(Mesh *mesh){
+    MeshOptimizerStats stats;
+    int vertexCount = mesh->GetPrimitiveCount();
+    int indicesCount = mesh->GetIndicesCount();
+    stats.acmrBefore = ComputeACMR(mesh->GetIndices(), indicesCount, vertexCount);
+    stats.atvrBefore = ComputeATVR(mesh->GetIndices(), indicesCount, vertexCount);
+    if (indicesCount >= 3){
+        std::vector<int> clusters;
+        OptimizeVertexCache(mesh->GetIndices(), indicesCount, vertexCount, &clusters);
+        OptimizeOverdraw(mesh->GetIndices(), indicesCount, mesh->GetVertices(), vertexCount, clusters);
+        OptimizeVertexFetch(mesh);
+    }
+    stats.acmrAfter = ComputeACMR(mesh->GetIndices(), indicesCount, vertexCount);
+    stats.atvrAfter = ComputeATVR(mesh->GetIndices(), indicesCount, vertexCount);
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(int *indices, int indicesCount, int vertexCount,
+        std::vector<int> *outClusters){
+    int triangleCount = indicesCount/3;
+    if (triangleCount == 0){
+        return;
+    }
+    indicesCount = triangleCount*3;
+    std::vector<int> offsets;
+    std::vector<int> adjacentTriangles;
+    std::vector<int> liveCounts;
+    buildAdjacency(indices, indicesCount, vertexCount, offsets, adjacentTriangles, liveCounts);
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<int> deadEnd;
+    std::vector<int> candidates;
+    std::vector<int> result;
+    result.reserve(indicesCount);
+    int time = VERTEX_CACHE_SIZE+1;
+    int cursor = 0;
+    int fanningVertex = skipDeadEnd(deadEnd, liveCounts, cursor);
+    if (outClusters != NULL){
+        outClusters->push_back(0);
+    }
+    while (fanningVertex >= 0){
+        // emit the remaining triangles of the fanning vertex
+        candidates.clear();
+        for (int i=offsets[fanningVertex];i<offsets[fanningVertex+1];i++){
+            int triangle = adjacentTriangles[i];
+            if (emitted[triangle]){
+                continue;
+            }
+            for (int j=0;j<3;j++){
+                int vertex = indices[triangle*3+j];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveCounts[vertex]--;
+                if (time-cacheTime[vertex] > VERTEX_CACHE_SIZE){
+                    cacheTime[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+        // continue with the oldest candidate still in the cache after
+        // emitting its remaining triangles
+        int nextVertex = -1;
+        int bestPriority = -1;
+        for (std::vector<int>::iterator iter = candidates.begin();iter != candidates.end();iter++){
+            int vertex = *iter;
+            if (liveCounts[vertex] <= 0){
+                continue;
+            }
+            int priority = 0;
+            if (time-cacheTime[vertex]+2*liveCounts[vertex] <= VERTEX_CACHE_SIZE){
+                priority = time-cacheTime[vertex];
+            }
+            if (priority > bestPriority){
+                bestPriority = priority;
+                nextVertex = vertex;
+            }
+        }
+        if (nextVertex == -1){
+            nextVertex = skipDeadEnd(deadEnd, liveCounts, cursor);
+            if (nextVertex >= 0 && outClusters != NULL){
+                outClusters->push_back(static_cast<int>(result.size()/3));
+            }
+        }
+        fanningVertex = nextVertex;
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(int *indices, int indicesCount, const glm::vec3 *vertices, int vertexCount,
+        const std::vector<int> &clusters, float threshold){
+    int triangleCount = indicesCount/3;
+    if (triangleCount == 0){
+        return;
+    }
+    indicesCount = triangleCount*3;
+    // split the clusters where the cluster has a good cache miss ratio (the
+    // cache is assumed to be empty at the start of a cluster)
+    float maxACMR = ComputeACMR(indices, indicesCount, vertexCount)*threshold;
+    std::vector<TriangleCluster> splitClusters;
+    std::vector<int> cacheTime(vertexCount, 0);
+    int time = VERTEX_CACHE_SIZE+1;
+    unsigned int hardCluster = 0;
+    int misses = 0;
+    TriangleCluster cluster;
+    cluster.begin = 0;
+    cluster.key = 0;
+    for (int i=0;i<triangleCount;i++){
+        bool hardBoundary = hardCluster < clusters.size() && clusters[hardCluster] == i;
+        if (hardBoundary){
+            hardCluster++;
+        }
+        if (i > cluster.begin && (hardBoundary || misses <= maxACMR*(i-cluster.begin))){
+            cluster.end = i;
+            splitClusters.push_back(cluster);
+            cluster.begin = i;
+            time += VERTEX_CACHE_SIZE+1; // flush the cache
+            misses = 0;
+        }
+        for (int j=0;j<3;j++){
+            int vertex = indices[i*3+j];
+            if (time-cacheTime[vertex] > VERTEX_CACHE_SIZE){
+                cacheTime[vertex] = time++;
+                misses++;
+            }
+        }
+    }
+    cluster.end = triangleCount;
+    splitClusters.push_back(cluster);
+
+    // clusters facing away from the center are drawn first, since they are
+    // likely to occlude the rest of the mesh
+    glm::vec3 meshCenter(0, 0, 0);
+    float meshArea = 0;
+    for (int i=0;i<triangleCount;i++){
+        const glm::vec3 &p0 = vertices[indices[i*3]];
+        const glm::vec3 &p1 = vertices[indices[i*3+1]];
+        const glm::vec3 &p2 = vertices[indices[i*3+2]];
+        float area = glm::length(glm::cross(p1-p0, p2-p0));
+        meshCenter += (p0+p1+p2)*(area/3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0){
+        meshCenter /= meshArea;
+    }
+    for (std::vector<TriangleCluster>::iterator iter = splitClusters.begin();iter != splitClusters.end();iter++){
+        glm::vec3 center(0, 0, 0);
+        glm::vec3 normal(0, 0, 0);
+        float clusterArea = 0;
+        for (int i=iter->begin;i<iter->end;i++){
+            const glm::vec3 &p0 = vertices[indices[i*3]];
+            const glm::vec3 &p1 = vertices[indices[i*3+1]];
+            const glm::vec3 &p2 = vertices[indices[i*3+2]];
+            glm::vec3 areaNormal = glm::cross(p1-p0, p2-p0);
+            float area = glm::length(areaNormal);
+            center += (p0+p1+p2)*(area/3.0f);
+            normal += areaNormal;
+            clusterArea += area;
+        }
+        float normalLength = glm::length(normal);
+        if (clusterArea > 0 && normalLength > 0){
+            iter->key = glm::dot(center/clusterArea-meshCenter, normal/normalLength);
+        }
+    }
+    std::stable_sort(splitClusters.begin(), splitClusters.end());
+    std::vector<int> result;
+    result.reserve(indicesCount);
+    for (std::vector<TriangleCluster>::iterator iter = splitClusters.begin();iter != splitClusters.end();iter++){
+        result.insert(result.end(), indices+iter->begin*3, indices+iter->end*3);
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(Mesh *mesh){
+    int vertexCount = mesh->GetPrimitiveCount();
+    int indicesCount = mesh->GetIndicesCount();
+    int *indices = mesh->GetIndices();
+    std::vector<int> remap(vertexCount, -1);
+    int nextVertex = 0;
+    for (int i=0;i<indicesCount;i++){
+        int &newIndex = remap[indices[i]];
+        if (newIndex == -1){
+            newIndex = nextVertex++;
+        }
+        indices[i] = newIndex;
+    }
+    for (int i=0;i<vertexCount;i++){
+        if (remap[i] == -1){
+            remap[i] = nextVertex++;
+        }
+    }
+    remapAttribute(mesh->GetVertices(), remap);
+    remapAttribute(mesh->GetNormals(), remap);
+    remapAttribute(mesh->GetTangents(), remap);
+    remapAttribute(mesh->GetColors(), remap);
+    remapAttribute(mesh->GetTextureCoords1(), remap);
+    remapAttribute(mesh->GetTextureCoords2(), remap);
+}
+
+float MeshOptimizer::ComputeACMR(const int *indices, int indicesCount, int vertexCount){
+    int triangleCount = indicesCount/3;
+    if (triangleCount == 0){
+        return 0;
+    }
+    return countCacheMisses(indices, triangleCount*3, vertexCount)/static_cast<float>(triangleCount);
+}
+
+float MeshOptimizer::ComputeATVR(const int *indices, int indicesCount, int vertexCount){
+    std::vector<bool> referenced(vertexCount, false);
+    int referencedCount = 0;
+    for (int i=0;i<indicesCount;i++){
+        if (!referenced[indices[i]]){
+            referenced[indices[i]] = true;
+            referencedCount++;
+        }
+    }
+    if (referencedCount == 0){
+        return 0;
+    }
+    return countCacheMisses(indices, indicesCount, vertexCount)/static_cast<float>(referencedCount);
+}
+}
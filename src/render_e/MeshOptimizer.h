@@ -0,0 +1,75 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_MESHOPTIMIZER_H
+#define	RENDER_E_MESHOPTIMIZER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+namespace render_e {
+
+/// Vertex cache efficiency of a mesh before and after MeshOptimizer::Optimize()
+struct MeshOptimizerStats {
+    MeshOptimizerStats();
+    /// Average cache miss ratio: transformed vertices per triangle (0.5 is
+    /// optimal for large regular meshes, 3 is the worst case)
+    float acmrBefore;
+    float acmrAfter;
+    /// Average transform to vertex ratio: transformed vertices per vertex
+    /// (1 is optimal)
+    float atvrBefore;
+    float atvrAfter;
+};
+
+///
+/// Reorders the triangles and vertices of a mesh for the GPU: the triangles
+/// are ordered for the post-transform vertex cache (Tipsify by Sander, Nehab
+/// and Barczak), the clusters of the ordering are sorted so the outward
+/// facing clusters are drawn first (reducing overdraw) and the vertices are
+/// ordered by first use (improving vertex fetch locality). The cache is
+/// modeled as a FIFO cache of VERTEX_CACHE_SIZE vertices.
+///
+class MeshOptimizer {
+public:
+    /// Size of the simulated post-transform vertex cache
+    static const int VERTEX_CACHE_SIZE = 16;
+
+    /// Apply all optimizations to the mesh (in place) and return the cache
+    /// efficiency before and after
+    static MeshOptimizerStats Optimize(Mesh *mesh);
+
+    /// Reorder the triangles for the vertex cache. If outClusters is not
+    /// NULL the index of the first triangle of each cluster (where the
+    /// ordering jumps to a new region of the mesh) is added to it
+    static void OptimizeVertexCache(int *indices, int indicesCount, int vertexCount,
+            std::vector<int> *outClusters = NULL);
+    /// Reorder the clusters of a vertex cache optimized triangle list, so
+    /// clusters facing away from the center of the mesh are drawn first.
+    /// Clusters are split further where the cache miss ratio of the cluster
+    /// is below threshold times the miss ratio of the whole mesh
+    static void OptimizeOverdraw(int *indices, int indicesCount, const glm::vec3 *vertices, int vertexCount,
+            const std::vector<int> &clusters, float threshold = 1.05f);
+    /// Reorder the vertices of the mesh by first use in the indices.
+    /// Unreferenced vertices are moved to the end
+    static void OptimizeVertexFetch(Mesh *mesh);
+
+    /// Returns the average cache miss ratio (transformed vertices per
+    /// triangle)
+    static float ComputeACMR(const int *indices, int indicesCount, int vertexCount);
+    /// Returns the average transform to vertex ratio (transformed vertices
+    /// per referenced vertex)
+    static float ComputeATVR(const int *indices, int indicesCount, int vertexCount);
+private:
+    MeshOptimizer();
+};
+}
+
+#endif	/* RENDER_E_MESHOPTIMIZER_H */
+
@@ -0,0 +1,662 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <cmath>
+
+namespace render_e {
+
+namespace {
+/// Weight of the attribute difference (squared) relative to the squared
+/// position error
+const float ATTRIBUTE_WEIGHT = 0.02f;
+/// Weight of the planes keeping unlocked borders in place
+const double BORDER_WEIGHT = 10.0;
+
+enum PointKind {
+    POINT_MANIFOLD,
+    POINT_BORDER,
+    POINT_LOCKED
+};
+
+/// Symmetric 4x4 matrix summing the squared distances to planes, and the
+/// area of the planes
+struct Quadric {
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+    double weight;
+
+    Quadric()
+    :a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0), weight(0) {
+    }
+
+    /// Add the plane (normal n, distance d) with the weight
+    void AddPlane(const glm::vec3 &n, float d, double w){
+        a00 += w*n.x*n.x; a01 += w*n.x*n.y; a02 += w*n.x*n.z; a03 += w*n.x*d;
+        a11 += w*n.y*n.y; a12 += w*n.y*n.z; a13 += w*n.y*d;
+        a22 += w*n.z*n.z; a23 += w*n.z*d;
+        a33 += w*d*d;
+        weight += w;
+    }
+
+    void Add(const Quadric &q){
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    /// Weighted mean squared distance of the point to the planes
+    double Error(const glm::vec3 &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double r = a00*x*x + a11*y*y + a22*z*z + 2*(a01*x*y + a02*x*z + a12*y*z + a03*x + a13*y + a23*z) + a33;
+        return weight > 0 ? fabs(r)/weight : 0;
+    }
+};
+
+struct PositionLess {
+    const glm::vec3 *vertices;
+    bool operator()(int a, int b) const {
+        const glm::vec3 &p = vertices[a];
+        const glm::vec3 &q = vertices[b];
+        if (p.x != q.x){
+            return p.x < q.x;
+        }
+        if (p.y != q.y){
+            return p.y < q.y;
+        }
+        return p.z < q.z;
+    }
+};
+
+/// Collapse candidate of a point. The version is the version of the point
+/// when the cost was computed
+struct Collapse {
+    int point;
+    int target;
+    double cost;
+    int version;
+    bool operator>(const Collapse &other) const {
+        return cost > other.cost;
+    }
+};
+
+/// Queue of collapses, cheapest first
+typedef std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > CollapseQueue;
+
+///
+/// State of the simplification of one mesh. Topology is tracked on points
+/// (vertices welded by position); the triangles reference the vertices.
+///
+class Simplifier {
+public:
+    Simplifier(Mesh *mesh, bool lockBorders);
+    /// Collapse edges until the target is reached or the error would exceed
+    /// maxError. Returns the largest error of the collapses
+    float Run(int targetTriangleCount, float maxError);
+    /// Returns a new mesh with the remaining triangles and the vertices used
+    /// by them
+    Mesh *CreateMesh();
+    int GetTriangleCount() const { return static_cast<int>(indices.size()/3)-removedCount; }
+private:
+    void BuildPoints();
+    void BuildQuadrics();
+    /// Build the triangles of each point and classify the points
+    void BuildAdjacency();
+    /// Classify the point by the edges of its triangles
+    int ComputeKind(int point);
+    /// Add the points sharing a triangle with the point (and the point itself)
+    void GetNeighbors(int point, std::vector<int> &outNeighbors);
+    bool IsBorderEdge(int a, int b) const;
+    /// Returns the vertex of point b the vertex of point a is moved to by
+    /// collapsing a onto b and the attribute difference of the two
+    int FindTargetVertex(int vertex, int a, int b, float &outDifference) const;
+    float AttributeDifference(int v0, int v1) const;
+    /// Quadric error of collapsing a onto b (negative if not allowed)
+    double ComputePositionCost(int a, int b) const;
+    /// Weighted attribute difference of collapsing a onto b. The cost of a
+    /// collapse is the sum of the position and attribute costs
+    double ComputeAttributeCost(int a, int b) const;
+    /// Returns true if moving point a onto b does not flip or fold a
+    /// triangle
+    bool IsValid(int a, int b) const;
+    /// Queue the cheapest valid collapse of the point (if any)
+    void PushCollapse(int point);
+    /// Collapse a onto b and remove the degenerate triangles
+    void Apply(int a, int b);
+
+    Mesh *mesh;
+    bool lockBorders;
+    int vertexCount;
+    std::vector<int> indices;
+    /// point of each vertex and the next vertex with the same point
+    /// (circular list)
+    std::vector<int> pointOf;
+    std::vector<int> nextWedge;
+    /// first vertex of each point
+    std::vector<int> pointVertex;
+    /// positions relative to the mesh bounds (unit radius)
+    std::vector<glm::vec3> positions;
+    std::vector<Quadric> quadrics;
+    std::vector<int> kinds;
+    /// triangles of each point (may include removed triangles)
+    std::vector<std::vector<int> > pointTriangles;
+    /// increased when the collapses of the point must be recomputed, which
+    /// invalidates the queued collapses of the point
+    std::vector<int> versions;
+    std::vector<bool> referenced;
+    std::vector<bool> removed;
+    int removedCount;
+    /// the cheapest collapse of each point. A collapse changes the costs of
+    /// the neighborhood only, so the neighbors are queued again with a new
+    /// version and the old entries are skipped when popped. The queue is
+    /// kept between runs
+    CollapseQueue queue;
+    /// used by Run(), PushCollapse() and ComputeKind()
+    std::vector<int> neighbors;
+    std::vector<int> ring;
+    std::vector<int> kindNeighbors;
+    std::vector<std::pair<double, int> > candidates;
+    /// number of triangles using the edge to each point (zero outside
+    /// ComputeKind())
+    std::vector<int> edgeCounts;
+    /// points found by the last GetNeighbors() call are marked with
+    /// searchMark
+    std::vector<int> marks;
+    int searchMark;
+};
+
+Simplifier::Simplifier(Mesh *mesh, bool lockBorders)
+:mesh(mesh), lockBorders(lockBorders), vertexCount(mesh->GetPrimitiveCount()), removedCount(0), searchMark(0) {
+    int *meshIndices = mesh->GetIndices();
+    int indicesCount = mesh->GetIndicesCount()/3*3;
+    indices.assign(meshIndices, meshIndices+indicesCount);
+    BuildPoints();
+    // triangles degenerate in point space are removed first
+    std::vector<int> valid;
+    valid.reserve(indices.size());
+    for (unsigned int i=0;i<indices.size();i+=3){
+        int p0 = pointOf[indices[i]];
+        int p1 = pointOf[indices[i+1]];
+        int p2 = pointOf[indices[i+2]];
+        if (p0 != p1 && p1 != p2 && p0 != p2){
+            valid.insert(valid.end(), indices.begin()+i, indices.begin()+i+3);
+        }
+    }
+    indices.swap(valid);
+    BuildAdjacency();
+    BuildQuadrics();
+    int pointCount = static_cast<int>(positions.size());
+    for (int p=0;p<pointCount;p++){
+        PushCollapse(p);
+    }
+}
+
+void Simplifier::BuildPoints(){
+    glm::vec3 *vertices = mesh->GetVertices();
+    std::vector<int> order(vertexCount);
+    for (int i=0;i<vertexCount;i++){
+        order[i] = i;
+    }
+    PositionLess less;
+    less.vertices = vertices;
+    std::sort(order.begin(), order.end(), less);
+    pointOf.resize(vertexCount);
+    nextWedge.resize(vertexCount);
+    Bounds bounds = Bounds::FromPoints(vertices, vertexCount);
+    float scale = bounds.GetRadius() > 0 ? 1.0f/bounds.GetRadius() : 1.0f;
+    int i = 0;
+    while (i < vertexCount){
+        int end = i+1;
+        while (end < vertexCount && !less(order[i], order[end])){
+            end++;
+        }
+        int point = static_cast<int>(pointVertex.size());
+        pointVertex.push_back(order[i]);
+        positions.push_back((vertices[order[i]]-bounds.GetCenter())*scale);
+        for (int j=i;j<end;j++){
+            pointOf[order[j]] = point;
+            nextWedge[order[j]] = order[j+1<end ? j+1 : i];
+        }
+        i = end;
+    }
+}
+
+void Simplifier::BuildQuadrics(){
+    quadrics.assign(positions.size(), Quadric());
+    for (unsigned int i=0;i<indices.size();i+=3){
+        int p[3] = {pointOf[indices[i]], pointOf[indices[i+1]], pointOf[indices[i+2]]};
+        glm::vec3 normal = glm::cross(positions[p[1]]-positions[p[0]], positions[p[2]]-positions[p[0]]);
+        float length = glm::length(normal);
+        if (length == 0){
+            continue;
+        }
+        normal /= length;
+        float d = -glm::dot(normal, positions[p[0]]);
+        for (int j=0;j<3;j++){
+            quadrics[p[j]].AddPlane(normal, d, length*0.5f);
+        }
+        if (lockBorders){
+            continue;
+        }
+        // planes perpendicular to the triangle keep the borders in place
+        for (int j=0;j<3;j++){
+            int a = p[j];
+            int b = p[(j+1)%3];
+            if (!IsBorderEdge(a, b)){
+                continue;
+            }
+            glm::vec3 edge = positions[b]-positions[a];
+            glm::vec3 borderNormal = glm::cross(edge, normal);
+            float borderLength = glm::length(borderNormal);
+            if (borderLength == 0){
+                continue;
+            }
+            borderNormal /= borderLength;
+            float borderD = -glm::dot(borderNormal, positions[a]);
+            double weight = glm::dot(edge, edge)*BORDER_WEIGHT;
+            quadrics[a].AddPlane(borderNormal, borderD, weight);
+            quadrics[b].AddPlane(borderNormal, borderD, weight);
+        }
+    }
+}
+
+void Simplifier::BuildAdjacency(){
+    int pointCount = static_cast<int>(positions.size());
+    int triangleCount = static_cast<int>(indices.size()/3);
+    pointTriangles.assign(pointCount, std::vector<int>());
+    for (unsigned int i=0;i<indices.size();i++){
+        pointTriangles[pointOf[indices[i]]].push_back(i/3);
+    }
+    removed.assign(triangleCount, false);
+    removedCount = 0;
+    edgeCounts.assign(pointCount, 0);
+    marks.assign(pointCount, 0);
+    kinds.resize(pointCount);
+    for (int p=0;p<pointCount;p++){
+        kinds[p] = ComputeKind(p);
+    }
+    referenced.assign(vertexCount, false);
+    for (unsigned int j=0;j<indices.size();j++){
+        referenced[indices[j]] = true;
+    }
+    versions.assign(pointCount, 0);
+}
+
+int Simplifier::ComputeKind(int point){
+    // count the triangles using each edge of the point: edges used by one
+    // triangle are borders, edges used by more than two are non-manifold
+    kindNeighbors.clear();
+    GetNeighbors(point, kindNeighbors);
+    const std::vector<int> &triangles = pointTriangles[point];
+    for (unsigned int i=0;i<triangles.size();i++){
+        if (removed[triangles[i]]){
+            continue;
+        }
+        const int *triangle = &indices[triangles[i]*3];
+        for (int j=0;j<3;j++){
+            edgeCounts[pointOf[triangle[j]]]++;
+        }
+    }
+    int kind = POINT_MANIFOLD;
+    for (unsigned int i=0;i<kindNeighbors.size();i++){
+        int other = kindNeighbors[i];
+        if (other != point && edgeCounts[other] == 1){
+            kind = std::max(kind, static_cast<int>(lockBorders ? POINT_LOCKED : POINT_BORDER));
+        } else if (other != point && edgeCounts[other] > 2){
+            kind = POINT_LOCKED;
+        }
+        edgeCounts[other] = 0;
+    }
+    return kind;
+}
+
+void Simplifier::GetNeighbors(int point, std::vector<int> &outNeighbors){
+    searchMark++;
+    const std::vector<int> &triangles = pointTriangles[point];
+    for (unsigned int i=0;i<triangles.size();i++){
+        if (removed[triangles[i]]){
+            continue;
+        }
+        const int *triangle = &indices[triangles[i]*3];
+        for (int j=0;j<3;j++){
+            int other = pointOf[triangle[j]];
+            if (marks[other] != searchMark){
+                marks[other] = searchMark;
+                outNeighbors.push_back(other);
+            }
+        }
+    }
+}
+
+bool Simplifier::IsBorderEdge(int a, int b) const{
+    int count = 0;
+    const std::vector<int> &triangles = pointTriangles[a];
+    for (unsigned int i=0;i<triangles.size();i++){
+        if (removed[triangles[i]]){
+            continue;
+        }
+        const int *triangle = &indices[triangles[i]*3];
+        if (pointOf[triangle[0]] == b || pointOf[triangle[1]] == b || pointOf[triangle[2]] == b){
+            count++;
+        }
+    }
+    return count == 1;
+}
+
+float Simplifier::AttributeDifference(int v0, int v1) const{
+    float difference = 0;
+    glm::vec3 *normals = mesh->GetNormals();
+    if (normals != NULL){
+        glm::vec3 d = normals[v0]-normals[v1];
+        difference += glm::dot(d, d);
+    }
+    glm::vec3 *colors = mesh->GetColors();
+    if (colors != NULL){
+        glm::vec3 d = colors[v0]-colors[v1];
+        difference += glm::dot(d, d);
+    }
+    glm::vec2 *textureCoords = mesh->GetTextureCoords1();
+    if (textureCoords != NULL){
+        glm::vec2 d = textureCoords[v0]-textureCoords[v1];
+        difference += glm::dot(d, d);
+    }
+    textureCoords = mesh->GetTextureCoords2();
+    if (textureCoords != NULL){
+        glm::vec2 d = textureCoords[v0]-textureCoords[v1];
+        difference += glm::dot(d, d);
+    }
+    return difference;
+}
+
+int Simplifier::FindTargetVertex(int vertex, int a, int b, float &outDifference) const{
+    // a vertex of b sharing a triangle with the vertex continues its
+    // attribute interpolation
+    const std::vector<int> &triangles = pointTriangles[a];
+    for (unsigned int i=0;i<triangles.size();i++){
+        if (removed[triangles[i]]){
+            continue;
+        }
+        const int *triangle = &indices[triangles[i]*3];
+        if (triangle[0] != vertex && triangle[1] != vertex && triangle[2] != vertex){
+            continue;
+        }
+        for (int j=0;j<3;j++){
+            if (pointOf[triangle[j]] == b){
+                outDifference = AttributeDifference(vertex, triangle[j]);
+                return triangle[j];
+            }
+        }
+    }
+    // otherwise the most similar vertex of b is used
+    int best = -1;
+    outDifference = 0;
+    int wedge = pointVertex[b];
+    do {
+        if (referenced[wedge]){
+            float difference = AttributeDifference(vertex, wedge);
+            if (best == -1 || difference < outDifference){
+                best = wedge;
+                outDifference = difference;
+            }
+        }
+        wedge = nextWedge[wedge];
+    } while (wedge != pointVertex[b]);
+    return best;
+}
+
+double Simplifier::ComputePositionCost(int a, int b) const{
+    if (kinds[a] == POINT_LOCKED || (kinds[a] == POINT_BORDER && !IsBorderEdge(a, b))){
+        return -1;
+    }
+    Quadric quadric = quadrics[a];
+    quadric.Add(quadrics[b]);
+    return quadric.Error(positions[b]);
+}
+
+double Simplifier::ComputeAttributeCost(int a, int b) const{
+    float maxDifference = 0;
+    int wedge = pointVertex[a];
+    do {
+        if (referenced[wedge]){
+            float difference;
+            FindTargetVertex(wedge, a, b, difference);
+            maxDifference = std::max(maxDifference, difference);
+        }
+        wedge = nextWedge[wedge];
+    } while (wedge != pointVertex[a]);
+    return ATTRIBUTE_WEIGHT*ATTRIBUTE_WEIGHT*maxDifference;
+}
+
+bool Simplifier::IsValid(int a, int b) const{
+    const std::vector<int> &triangles = pointTriangles[a];
+    for (unsigned int i=0;i<triangles.size();i++){
+        int t = triangles[i];
+        if (removed[t]){
+            continue;
+        }
+        int p[3] = {pointOf[indices[t*3]], pointOf[indices[t*3+1]], pointOf[indices[t*3+2]]};
+        if (p[0] == b || p[1] == b || p[2] == b){
+            continue; // removed by the collapse
+        }
+        glm::vec3 normal = glm::cross(positions[p[1]]-positions[p[0]], positions[p[2]]-positions[p[0]]);
+        glm::vec3 moved[3];
+        for (int j=0;j<3;j++){
+            moved[j] = positions[p[j] == a ? b : p[j]];
+        }
+        glm::vec3 newNormal = glm::cross(moved[1]-moved[0], moved[2]-moved[0]);
+        // rotations of more than about 75 degrees are rejected, since they
+        // fold the surface
+        if (glm::dot(normal, newNormal) < 0.25f*glm::length(normal)*glm::length(newNormal)){
+            return false;
+        }
+    }
+    return true;
+}
+
+void Simplifier::PushCollapse(int point){
+    neighbors.clear();
+    GetNeighbors(point, neighbors);
+    candidates.clear();
+    for (unsigned int i=0;i<neighbors.size();i++){
+        if (neighbors[i] == point){
+            continue;
+        }
+        double cost = ComputePositionCost(point, neighbors[i]);
+        if (cost >= 0){
+            candidates.push_back(std::make_pair(cost, neighbors[i]));
+        }
+    }
+    // the cheapest collapse not flipping a triangle. The position cost is a
+    // lower bound of the cost, so the search stops at the first candidate
+    // whose position cost exceeds the best cost found
+    std::sort(candidates.begin(), candidates.end());
+    Collapse collapse;
+    collapse.point = point;
+    collapse.target = -1;
+    collapse.cost = 0;
+    collapse.version = versions[point];
+    for (unsigned int i=0;i<candidates.size();i++){
+        if (collapse.target != -1 && candidates[i].first >= collapse.cost){
+            break;
+        }
+        double cost = candidates[i].first+ComputeAttributeCost(point, candidates[i].second);
+        if ((collapse.target == -1 || cost < collapse.cost) && IsValid(point, candidates[i].second)){
+            collapse.target = candidates[i].second;
+            collapse.cost = cost;
+        }
+    }
+    if (collapse.target != -1){
+        queue.push(collapse);
+    }
+}
+
+void Simplifier::Apply(int a, int b){
+    // move each vertex of a to its target vertex of b
+    int wedge = pointVertex[a];
+    std::vector<std::pair<int, int> > remap;
+    do {
+        if (referenced[wedge]){
+            float difference;
+            remap.push_back(std::make_pair(wedge, FindTargetVertex(wedge, a, b, difference)));
+        }
+        wedge = nextWedge[wedge];
+    } while (wedge != pointVertex[a]);
+    std::vector<int> &triangles = pointTriangles[a];
+    for (unsigned int i=0;i<triangles.size();i++){
+        int t = triangles[i];
+        if (removed[t]){
+            continue;
+        }
+        int *triangle = &indices[t*3];
+        bool degenerate = false;
+        for (int j=0;j<3;j++){
+            if (pointOf[triangle[j]] == b){
+                degenerate = true;
+            }
+        }
+        if (degenerate){
+            removed[t] = true;
+            removedCount++;
+            continue;
+        }
+        for (int j=0;j<3;j++){
+            for (unsigned int k=0;k<remap.size();k++){
+                if (triangle[j] == remap[k].first){
+                    triangle[j] = remap[k].second;
+                    referenced[remap[k].second] = true;
+                    break;
+                }
+            }
+        }
+    }
+    for (unsigned int k=0;k<remap.size();k++){
+        referenced[remap[k].first] = false;
+    }
+    quadrics[b].Add(quadrics[a]);
+    // the remaining triangles of a now belong to b
+    std::vector<int> &targetTriangles = pointTriangles[b];
+    unsigned int count = 0;
+    for (unsigned int i=0;i<targetTriangles.size();i++){
+        if (!removed[targetTriangles[i]]){
+            targetTriangles[count++] = targetTriangles[i];
+        }
+    }
+    targetTriangles.resize(count);
+    for (unsigned int i=0;i<triangles.size();i++){
+        if (!removed[triangles[i]]){
+            targetTriangles.push_back(triangles[i]);
+        }
+    }
+    std::vector<int>().swap(triangles);
+    versions[a]++;
+}
+
+float Simplifier::Run(int targetTriangleCount, float maxError){
+    double maxCost = static_cast<double>(maxError)*maxError;
+    double resultCost = 0;
+    while (GetTriangleCount() > targetTriangleCount && !queue.empty()){
+        Collapse collapse = queue.top();
+        queue.pop();
+        if (collapse.version != versions[collapse.point]){
+            continue;
+        }
+        if (collapse.cost > maxCost){
+            // kept for a later run with a larger error
+            queue.push(collapse);
+            break;
+        }
+        Apply(collapse.point, collapse.target);
+        resultCost = std::max(resultCost, collapse.cost);
+        ring.clear();
+        GetNeighbors(collapse.target, ring);
+        for (unsigned int i=0;i<ring.size();i++){
+            versions[ring[i]]++;
+            kinds[ring[i]] = ComputeKind(ring[i]);
+        }
+        for (unsigned int i=0;i<ring.size();i++){
+            PushCollapse(ring[i]);
+        }
+    }
+    return static_cast<float>(sqrt(resultCost));
+}
+
+template <class T>
+void copyAttribute(T *source, const std::vector<int> &vertices, void (Mesh::*setter)(std::vector<T>), Mesh *mesh){
+    if (source == NULL){
+        return;
+    }
+    std::vector<T> data(vertices.size());
+    for (unsigned int i=0;i<vertices.size();i++){
+        data[i] = source[vertices[i]];
+    }
+    (mesh->*setter)(data);
+}
+
+Mesh *Simplifier::CreateMesh(){
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<int> vertices;
+    std::vector<int> newIndices;
+    newIndices.reserve(GetTriangleCount()*3);
+    for (unsigned int i=0;i<indices.size();i++){
+        if (removed[i/3]){
+            continue;
+        }
+        int &newIndex = remap[indices[i]];
+        if (newIndex == -1){
+            newIndex = static_cast<int>(vertices.size());
+            vertices.push_back(indices[i]);
+        }
+        newIndices.push_back(newIndex);
+    }
+    Mesh *result = new Mesh();
+    copyAttribute(mesh->GetVertices(), vertices, &Mesh::SetVertices, result);
+    copyAttribute(mesh->GetNormals(), vertices, &Mesh::SetNormals, result);
+    copyAttribute(mesh->GetTangents(), vertices, &Mesh::SetTangents, result);
+    copyAttribute(mesh->GetColors(), vertices, &Mesh::SetColors, result);
+    copyAttribute(mesh->GetTextureCoords1(), vertices, &Mesh::SetTextureCoords1, result);
+    copyAttribute(mesh->GetTextureCoords2(), vertices, &Mesh::SetTextureCoords2, result);
+    result->SetIndices(newIndices);
+    return result;
+}
+}
+
+Mesh *MeshSimplifier::Simplify(Mesh *mesh, int targetTriangleCount, float maxError, bool lockBorders,
+        float *outError){
+    Simplifier simplifier(mesh, lockBorders);
+    float error = simplifier.Run(targetTriangleCount, maxError);
+    if (outError != NULL){
+        *outError = error;
+    }
+    return simplifier.CreateMesh();
+}
+
+std::vector<Mesh*> MeshSimplifier::GenerateLODs(Mesh *mesh, int levelCount, float reduction, float maxError,
+        bool lockBorders){
+    std::vector<Mesh*> levels;
+    // each level is simplified further from the previous level. The
+    // quadrics accumulate the planes of the collapsed points, so the error
+    // is still measured against the original surface
+    Simplifier simplifier(mesh, lockBorders);
+    int triangleCount = simplifier.GetTriangleCount();
+    for (int i=1;i<levelCount;i++){
+        int target = static_cast<int>(triangleCount*reduction);
+        simplifier.Run(target, maxError);
+        if (simplifier.GetTriangleCount() > triangleCount*0.9f){
+            break;
+        }
+        triangleCount = simplifier.GetTriangleCount();
+        levels.push_back(simplifier.CreateMesh());
+    }
+    return levels;
+}
+}
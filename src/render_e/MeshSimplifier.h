@@ -0,0 +1,53 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_MESHSIMPLIFIER_H
+#define	RENDER_E_MESHSIMPLIFIER_H
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace render_e {
+
+///
+/// Reduces the triangle count of a mesh using edge collapses ordered by the
+/// quadric error metric (Garland and Heckbert). Vertices are collapsed onto
+/// a neighbor vertex, so the simplified mesh only contains vertices of the
+/// original mesh and stays inside its bounds.
+/// Vertices with the same position (attribute seams) are collapsed
+/// together. Each of their attribute variants is moved to the variant of
+/// the neighbor sharing a triangle with it, or to the most similar variant,
+/// and the attribute difference is added to the cost of the collapse.
+/// Points on open borders are locked (or only collapsed along the border)
+/// and collapses flipping triangles are rejected.
+/// Errors are relative to the radius of the mesh bounds.
+///
+class MeshSimplifier {
+public:
+    /// Returns a simplified copy of the mesh with at most targetTriangleCount
+    /// triangles, unless no more collapses are possible within maxError. If
+    /// lockBorders is false, border points may collapse along the border.
+    /// outError (if not NULL) is set to the largest error of the collapses
+    static Mesh *Simplify(Mesh *mesh, int targetTriangleCount, float maxError, bool lockBorders = true,
+            float *outError = NULL);
+
+    /// Returns the simplified levels of detail 1 to levelCount-1 of the
+    /// mesh (level 0 is the mesh itself). Each level has reduction times the
+    /// triangles of the previous level and is simplified further from it,
+    /// keeping the error relative to the original mesh. Fewer levels are
+    /// returned when a level cannot be reduced by at least 10% within
+    /// maxError
+    static std::vector<Mesh*> GenerateLODs(Mesh *mesh, int levelCount, float reduction = 0.5f,
+            float maxError = 0.05f, bool lockBorders = true);
+private:
+    MeshSimplifier();
+};
+}
+
+#endif	/* RENDER_E_MESHSIMPLIFIER_H */
+
@@ -0,0 +1,205 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "MeshWelder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace render_e {
+
+namespace {
+/// Cell coordinates are clamped to keep far away positions in range
+const double MAX_CELL = 1073741824.0;
+
+/// Cell of the position. Neighbor is set to the direction (-1 or 1) of
+/// the nearest neighbor cell on each axis
+void computeCell(const glm::vec3 &position, float epsilon, int *cell, int *neighbor){
+    for (int i=0;i<3;i++){
+        if (epsilon > 0){
+            double scaled = position[i]/(2.0*epsilon);
+            double floored = floor(scaled);
+            floored = std::max(-MAX_CELL, std::min(MAX_CELL, floored));
+            cell[i] = static_cast<int>(floored);
+            neighbor[i] = scaled-floored < 0.5 ? -1 : 1;
+        } else {
+            // exact matches only (the cell is the bit pattern)
+            memcpy(&cell[i], &position[i], sizeof(int));
+            neighbor[i] = 0;
+        }
+    }
+}
+
+unsigned int hashCell(const int *cell){
+    return static_cast<unsigned int>(cell[0])*73856093u ^ static_cast<unsigned int>(cell[1])*19349663u ^
+            static_cast<unsigned int>(cell[2])*83492791u;
+}
+
+/// Returns true if the components of the attribute of the two vertices
+/// differ by at most epsilon (true if the mesh has no such attribute)
+template <class T>
+bool attributeEqual(const T *data, int a, int b, float epsilon){
+    if (data == NULL){
+        return true;
+    }
+    const float *valuesA = &(data[a].x);
+    const float *valuesB = &(data[b].x);
+    for (unsigned int i=0;i<sizeof(T)/sizeof(float);i++){
+        if (std::fabs(valuesA[i]-valuesB[i]) > epsilon){
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T>
+void copyAttribute(const T *data, const std::vector<int> &remap, int vertexCount, std::vector<T> &dest){
+    dest.clear();
+    if (data == NULL){
+        return;
+    }
+    dest.resize(vertexCount);
+    for (unsigned int i=0;i<remap.size();i++){
+        if (remap[i] >= 0){
+            dest[remap[i]] = data[i];
+        }
+    }
+}
+
+template <class T>
+int attributeSize(const T *data, int vertexCount){
+    return data != NULL ? static_cast<int>(sizeof(T))*vertexCount : 0;
+}
+}
+
+MeshWeldStats MeshWelder::Weld(Mesh *mesh, float epsilon){
+    MeshWeldStats stats;
+    stats.verticesBefore = mesh->GetPrimitiveCount();
+    stats.bytesBefore = ComputeMeshSize(mesh);
+    if (mesh->GetIndicesCount() == 0){
+        std::vector<int> indices(mesh->GetPrimitiveCount());
+        for (unsigned int i=0;i<indices.size();i++){
+            indices[i] = i;
+        }
+        mesh->SetIndices(indices);
+    }
+    std::vector<int> remap;
+    int vertexCount = ComputeRemap(mesh, epsilon, remap);
+
+    std::vector<int> indices(mesh->GetIndices(), mesh->GetIndices()+mesh->GetIndicesCount());
+    for (std::vector<int>::iterator iter = indices.begin();iter != indices.end();iter++){
+        *iter = remap[*iter];
+    }
+    std::vector<glm::vec3> vec3Data;
+    std::vector<glm::vec2> vec2Data;
+    copyAttribute(mesh->GetVertices(), remap, vertexCount, vec3Data);
+    mesh->SetVertices(vec3Data);
+    copyAttribute(mesh->GetNormals(), remap, vertexCount, vec3Data);
+    mesh->SetNormals(vec3Data);
+    copyAttribute(mesh->GetTangents(), remap, vertexCount, vec3Data);
+    mesh->SetTangents(vec3Data);
+    copyAttribute(mesh->GetColors(), remap, vertexCount, vec3Data);
+    mesh->SetColors(vec3Data);
+    copyAttribute(mesh->GetTextureCoords1(), remap, vertexCount, vec2Data);
+    mesh->SetTextureCoords1(vec2Data);
+    copyAttribute(mesh->GetTextureCoords2(), remap, vertexCount, vec2Data);
+    mesh->SetTextureCoords2(vec2Data);
+    mesh->SetIndices(indices);
+
+    stats.verticesAfter = vertexCount;
+    stats.bytesAfter = ComputeMeshSize(mesh);
+    return stats;
+}
+
+int MeshWelder::ComputeRemap(Mesh *mesh, float epsilon, std::vector<int> &remap){
+    int vertexCount = mesh->GetPrimitiveCount();
+    int indicesCount = mesh->GetIndicesCount();
+    const int *indices = mesh->GetIndices();
+    const glm::vec3 *vertices = mesh->GetVertices();
+    const glm::vec3 *normals = mesh->GetNormals();
+    const glm::vec3 *tangents = mesh->GetTangents();
+    const glm::vec3 *colors = mesh->GetColors();
+    const glm::vec2 *textureCoords1 = mesh->GetTextureCoords1();
+    const glm::vec2 *textureCoords2 = mesh->GetTextureCoords2();
+    remap.assign(vertexCount, -1);
+
+    // open addressing hash table of the unique vertices (indices into
+    // uniqueVertices) keyed by the cell of the position
+    unsigned int tableSize = 1;
+    while (tableSize < static_cast<unsigned int>(vertexCount)*2){
+        tableSize *= 2;
+    }
+    unsigned int mask = tableSize-1;
+    std::vector<int> table(tableSize, -1);
+    std::vector<int> uniqueVertices;
+    std::vector<int> uniqueCells;
+    for (int i=0;i<indicesCount;i++){
+        int vertex = indices[i];
+        if (remap[vertex] != -1){
+            continue;
+        }
+        int cell[3];
+        int neighbor[3];
+        computeCell(vertices[vertex], epsilon, cell, neighbor);
+        // search the cell and the nearest neighbor cells (a duplicate is at
+        // most epsilon away, which is half a cell)
+        int found = -1;
+        for (int n=0;n<8 && found == -1;n++){
+            int searchCell[3];
+            bool skip = false;
+            for (int j=0;j<3;j++){
+                int offset = (n>>j)&1;
+                skip = skip || (offset == 1 && neighbor[j] == 0);
+                searchCell[j] = cell[j]+offset*neighbor[j];
+            }
+            if (skip){
+                continue;
+            }
+            for (unsigned int h = hashCell(searchCell)&mask;table[h] != -1;h = (h+1)&mask){
+                int unique = table[h];
+                const int *uniqueCell = &uniqueCells[unique*3];
+                if (uniqueCell[0] != searchCell[0] || uniqueCell[1] != searchCell[1] ||
+                        uniqueCell[2] != searchCell[2]){
+                    continue;
+                }
+                int other = uniqueVertices[unique];
+                if (attributeEqual(vertices, vertex, other, epsilon) &&
+                        attributeEqual(normals, vertex, other, epsilon) &&
+                        attributeEqual(tangents, vertex, other, epsilon) &&
+                        attributeEqual(colors, vertex, other, epsilon) &&
+                        attributeEqual(textureCoords1, vertex, other, epsilon) &&
+                        attributeEqual(textureCoords2, vertex, other, epsilon)){
+                    found = unique;
+                    break;
+                }
+            }
+        }
+        if (found == -1){
+            found = static_cast<int>(uniqueVertices.size());
+            uniqueVertices.push_back(vertex);
+            uniqueCells.insert(uniqueCells.end(), cell, cell+3);
+            unsigned int h = hashCell(cell)&mask;
+            while (table[h] != -1){
+                h = (h+1)&mask;
+            }
+            table[h] = found;
+        }
+        remap[vertex] = found;
+    }
+    return static_cast<int>(uniqueVertices.size());
+}
+
+int MeshWelder::ComputeMeshSize(Mesh *mesh){
+    int vertexCount = mesh->GetPrimitiveCount();
+    return attributeSize(mesh->GetVertices(), vertexCount)+attributeSize(mesh->GetNormals(), vertexCount)+
+            attributeSize(mesh->GetTangents(), vertexCount)+attributeSize(mesh->GetColors(), vertexCount)+
+            attributeSize(mesh->GetTextureCoords1(), vertexCount)+
+            attributeSize(mesh->GetTextureCoords2(), vertexCount)+
+            mesh->GetIndicesCount()*static_cast<int>(sizeof(int));
+}
+}
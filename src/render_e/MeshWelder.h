@@ -0,0 +1,60 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_MESHWELDER_H
+#define	RENDER_E_MESHWELDER_H
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace render_e {
+
+/// Size of a mesh before and after MeshWelder::Weld()
+struct MeshWeldStats {
+    int verticesBefore;
+    int verticesAfter;
+    /// Bytes of vertex attributes and indices on the CPU (the GPU buffers
+    /// shrink proportionally)
+    int bytesBefore;
+    int bytesAfter;
+};
+
+///
+/// Merges the duplicate vertices of a mesh and rebuilds the indices. Two
+/// vertices are duplicates if every component of every attribute (position,
+/// normal, tangent, color and texture coordinates) differs by at most
+/// epsilon. Candidates are found by hashing the positions into cells of
+/// twice epsilon, so each vertex is compared with the vertices of the 8
+/// nearest cells only. Use it on triangle soups (such as generated meshes or
+/// meshes imported per polygon vertex) to reduce memory and the number of
+/// vertices shaded.
+///
+class MeshWelder {
+public:
+    /// Weld the vertices of the mesh (in place) and return the size before
+    /// and after. Each vertex is merged into the first vertex it duplicates
+    /// (welding is not transitive). Vertices not referenced by the indices
+    /// are removed. A mesh without indices is treated as a triangle soup
+    static MeshWeldStats Weld(Mesh *mesh, float epsilon = 1e-5f);
+
+    /// Find the duplicate vertices of the mesh without changing it. Returns
+    /// the number of unique vertices and sets remap to the new index of each
+    /// vertex (-1 if not referenced). Vertices are numbered in order of first
+    /// use by the indices
+    static int ComputeRemap(Mesh *mesh, float epsilon, std::vector<int> &remap);
+
+    /// Returns the number of bytes used by the vertex attributes and indices
+    /// of the mesh
+    static int ComputeMeshSize(Mesh *mesh);
+private:
+    MeshWelder();
+};
+}
+
+#endif	/* RENDER_E_MESHWELDER_H */
+
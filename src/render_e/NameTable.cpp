@@ -0,0 +1,77 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "NameTable.h"
+
+#include <cstring>
+
+namespace render_e {
+
+NameTable *NameTable::s_instance = NULL;
+
+NameTable::NameTable()
+:buckets(64, -1) {
+    Intern(""); // EMPTY_NAME
+}
+
+unsigned int NameTable::Hash(const char *name){
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (;*name != 0;name++){
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int NameTable::FindBucket(const char *name, unsigned int hash) const{
+    int mask = buckets.size()-1;
+    int bucket = hash & mask;
+    // linear probing
+    while (buckets[bucket] != -1){
+        int id = buckets[bucket];
+        if (hashes[id] == hash && strcmp(names[id].c_str(), name) == 0){
+            return bucket;
+        }
+        bucket = (bucket+1) & mask;
+    }
+    return bucket;
+}
+
+int NameTable::Find(const char *name) const{
+    return buckets[FindBucket(name, Hash(name))];
+}
+
+int NameTable::Intern(const std::string &name){
+    unsigned int hash = Hash(name.c_str());
+    int bucket = FindBucket(name.c_str(), hash);
+    if (buckets[bucket] != -1){
+        return buckets[bucket];
+    }
+    int id = names.size();
+    names.push_back(name);
+    hashes.push_back(hash);
+    buckets[bucket] = id;
+    // keep the load factor below 0.5
+    if (names.size()*2 > buckets.size()){
+        Rehash(buckets.size()*2);
+    }
+    return id;
+}
+
+void NameTable::Rehash(int bucketCount){
+    buckets.assign(bucketCount, -1);
+    int mask = bucketCount-1;
+    for (unsigned int id=0;id<names.size();id++){
+        int bucket = hashes[id] & mask;
+        while (buckets[bucket] != -1){
+            bucket = (bucket+1) & mask;
+        }
+        buckets[bucket] = id;
+    }
+}
+}
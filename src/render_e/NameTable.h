@@ -0,0 +1,67 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_NAMETABLE_H
+#define	RENDER_E_NAMETABLE_H
+
+#include <string>
+#include <vector>
+
+namespace render_e {
+
+///
+/// Table of interned strings. Each distinct string is stored once and is
+/// identified by a small integer id (ids are never reused), which allows
+/// names to be compared and used as indices in O(1). Lookup uses a hash
+/// table with open addressing.
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class NameTable {
+public:
+    /// Returns the id of the name. The name is added if not found
+    int Intern(const std::string &name);
+    /// Returns the id of the name or -1 if the name has not been interned
+    int Find(const char *name) const;
+    const std::string &GetName(int id) const { return names[id]; }
+    /// Number of interned names (all ids are less than this value)
+    int GetSize() const { return static_cast<int>(names.size()); }
+
+    /// Id of the empty string
+    static const int EMPTY_NAME = 0;
+
+    ///
+    /// Singleton pattern.
+    /// return the name table instance
+    ///
+    static NameTable* Instance() {
+        if (!s_instance) {
+            s_instance = new NameTable();
+        }
+        return s_instance;
+    }
+private:
+    NameTable();
+    NameTable(const NameTable& orig); // disallow copy constructor
+    NameTable& operator = (const NameTable&); // disallow copy constructor
+
+    static unsigned int Hash(const char *name);
+    /// Returns the bucket containing the name or the empty bucket where it
+    /// should be inserted
+    int FindBucket(const char *name, unsigned int hash) const;
+    void Rehash(int bucketCount);
+
+    static NameTable *s_instance;
+    std::vector<std::string> names;
+    std::vector<unsigned int> hashes;
+    /// name id or -1 if empty. The size is a power of two
+    std::vector<int> buckets;
+};
+}
+
+#endif	/* RENDER_E_NAMETABLE_H */
+
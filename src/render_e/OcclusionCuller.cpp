@@ -0,0 +1,337 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "OcclusionCuller.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "JobSystem.h"
+#include "math/SIMD.h"
+
+namespace render_e {
+
+namespace {
+/// Clip the triangle (clip space) against the near plane (z >= -w). Returns
+/// the number of vertices of the clipped polygon (0, 3 or 4)
+int clipNearPlane(const glm::vec4 *in, glm::vec4 *out){
+    int count = 0;
+    for (int i=0;i<3;i++){
+        const glm::vec4 &a = in[i];
+        const glm::vec4 &b = in[(i+1)%3];
+        float distanceA = a.z+a.w;
+        float distanceB = b.z+b.w;
+        if (distanceA >= 0){
+            out[count++] = a;
+        }
+        if ((distanceA >= 0) != (distanceB >= 0)){
+            float t = distanceA/(distanceA-distanceB);
+            out[count++] = a+(b-a)*t;
+        }
+    }
+    return count;
+}
+
+/// Returns the index of the first pixel with a center at or after the
+/// coordinate (clamped to [0; size])
+int firstPixel(float coordinate, int size){
+    return static_cast<int>(ceil(std::min(std::max(coordinate-0.5f, 0.0f), static_cast<float>(size))));
+}
+
+/// Returns the index of the last pixel with a center at or before the
+/// coordinate (clamped to [-1; size-1])
+int lastPixel(float coordinate, int size){
+    return static_cast<int>(floor(std::min(std::max(coordinate-0.5f, -1.0f), size-1.0f)));
+}
+}
+
+/// Rasterizes the tiles of the occlusion buffer (one tile per element)
+class RasterizeTilesJob : public ParallelForJob {
+public:
+    explicit RasterizeTilesJob(OcclusionCuller *occlusionCuller):occlusionCuller(occlusionCuller){}
+    void Execute(int begin, int end){
+        for (int i=begin;i<end;i++){
+            occlusionCuller->RasterizeTile(i);
+        }
+    }
+private:
+    OcclusionCuller *occlusionCuller;
+};
+
+OcclusionCuller::OcclusionCuller()
+:bins(OCCLUSION_TILE_COUNT) {
+    // rows of a tile are rasterized four pixels at a time
+    assert(OCCLUSION_TILE_SIZE%4 == 0);
+    int width = OCCLUSION_BUFFER_WIDTH;
+    int height = OCCLUSION_BUFFER_HEIGHT;
+    while (true){
+        levels.push_back(std::vector<float>(width*height, 1.0f));
+        levelWidths.push_back(width);
+        levelHeights.push_back(height);
+        if (width == 1 && height == 1){
+            break;
+        }
+        width = std::max(1, width/2);
+        height = std::max(1, height/2);
+    }
+}
+
+void OcclusionCuller::Begin(const glm::mat4 &viewProjection){
+    this->viewProjection = viewProjection;
+    triangles.clear();
+    for (int i=0;i<OCCLUSION_TILE_COUNT;i++){
+        bins[i].clear();
+    }
+}
+
+void OcclusionCuller::AddOccluder(const glm::mat4 &modelMatrix, const glm::vec3 *vertices, const int *indices,
+        int indicesCount){
+    glm::mat4 modelViewProjection = viewProjection*modelMatrix;
+    glm::vec4 triangle[3];
+    glm::vec4 clipped[4];
+    for (int i=0;i+2<indicesCount;i+=3){
+        bool inside = true;
+        bool outside = true;
+        for (int j=0;j<3;j++){
+            triangle[j] = modelViewProjection*glm::vec4(vertices[indices[i+j]], 1.0f);
+            bool inFront = triangle[j].z+triangle[j].w >= 0;
+            inside &= inFront;
+            outside &= !inFront;
+        }
+        if (outside){
+            continue;
+        }
+        if (inside){
+            AddTriangle(triangle[0], triangle[1], triangle[2]);
+            continue;
+        }
+        int count = clipNearPlane(triangle, clipped);
+        for (int j=2;j<count;j++){
+            AddTriangle(clipped[0], clipped[j-1], clipped[j]);
+        }
+    }
+}
+
+void OcclusionCuller::AddTriangle(const glm::vec4 &p0, const glm::vec4 &p1, const glm::vec4 &p2){
+    if (p0.w <= 0 || p1.w <= 0 || p2.w <= 0){
+        return;
+    }
+    const glm::vec4 *clip[3] = {&p0, &p1, &p2};
+    glm::vec3 screen[3];
+    for (int i=0;i<3;i++){
+        float inverseW = 1.0f/clip[i]->w;
+        screen[i] = glm::vec3((clip[i]->x*inverseW*0.5f+0.5f)*OCCLUSION_BUFFER_WIDTH,
+                (clip[i]->y*inverseW*0.5f+0.5f)*OCCLUSION_BUFFER_HEIGHT,
+                clip[i]->z*inverseW*0.5f+0.5f);
+    }
+    if (screen[0].z > 1 && screen[1].z > 1 && screen[2].z > 1){
+        return; // behind the far plane
+    }
+    float area = (screen[1].x-screen[0].x)*(screen[2].y-screen[0].y)-
+            (screen[2].x-screen[0].x)*(screen[1].y-screen[0].y);
+    if (area == 0){
+        return;
+    }
+    // both sides are rasterized, so the vertices are ordered counterclockwise
+    if (area < 0){
+        std::swap(screen[1], screen[2]);
+        area = -area;
+    }
+    OccluderTriangle triangle;
+    for (int i=0;i<3;i++){
+        const glm::vec3 &from = screen[i];
+        const glm::vec3 &to = screen[(i+1)%3];
+        float a = from.y-to.y;
+        float b = to.x-from.x;
+        triangle.edges[i] = glm::vec3(a, b, -(a*from.x+b*from.y));
+    }
+    float depthX = ((screen[1].z-screen[0].z)*(screen[2].y-screen[0].y)-
+            (screen[2].z-screen[0].z)*(screen[1].y-screen[0].y))/area;
+    float depthY = ((screen[2].z-screen[0].z)*(screen[1].x-screen[0].x)-
+            (screen[1].z-screen[0].z)*(screen[2].x-screen[0].x))/area;
+    triangle.depthPlane = glm::vec3(depthX, depthY, screen[0].z-depthX*screen[0].x-depthY*screen[0].y);
+    triangle.minX = firstPixel(std::min(screen[0].x, std::min(screen[1].x, screen[2].x)), OCCLUSION_BUFFER_WIDTH);
+    triangle.minY = firstPixel(std::min(screen[0].y, std::min(screen[1].y, screen[2].y)), OCCLUSION_BUFFER_HEIGHT);
+    triangle.maxX = lastPixel(std::max(screen[0].x, std::max(screen[1].x, screen[2].x)), OCCLUSION_BUFFER_WIDTH);
+    triangle.maxY = lastPixel(std::max(screen[0].y, std::max(screen[1].y, screen[2].y)), OCCLUSION_BUFFER_HEIGHT);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY){
+        return; // outside the buffer or between pixel centers
+    }
+    int index = static_cast<int>(triangles.size());
+    triangles.push_back(triangle);
+    for (int y=triangle.minY/OCCLUSION_TILE_SIZE;y<=triangle.maxY/OCCLUSION_TILE_SIZE;y++){
+        for (int x=triangle.minX/OCCLUSION_TILE_SIZE;x<=triangle.maxX/OCCLUSION_TILE_SIZE;x++){
+            bins[y*OCCLUSION_TILES_X+x].push_back(index);
+        }
+    }
+}
+
+void OcclusionCuller::Rasterize(){
+    if (triangles.empty()){
+        return; // IsOccluded() does not read the buffer
+    }
+    RasterizeTilesJob job(this);
+    JobSystem::Instance()->ParallelFor(&job, OCCLUSION_TILE_COUNT, 1);
+    BuildPyramid();
+}
+
+#ifdef RENDER_E_SSE
+void OcclusionCuller::RasterizeTile(int tile){
+    int tileX = (tile%OCCLUSION_TILES_X)*OCCLUSION_TILE_SIZE;
+    int tileY = (tile/OCCLUSION_TILES_X)*OCCLUSION_TILE_SIZE;
+    float *depth = &levels[0][0];
+    const __m128 farDepth = _mm_set1_ps(1.0f);
+    for (int y=tileY;y<tileY+OCCLUSION_TILE_SIZE;y++){
+        for (int x=tileX;x<tileX+OCCLUSION_TILE_SIZE;x+=4){
+            _mm_storeu_ps(depth+y*OCCLUSION_BUFFER_WIDTH+x, farDepth);
+        }
+    }
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 pixelOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const std::vector<int> &bin = bins[tile];
+    for (std::vector<int>::const_iterator iter = bin.begin();iter != bin.end();iter++){
+        const OccluderTriangle &triangle = triangles[*iter];
+        // the tile origin is a multiple of 4, so rows start at a multiple of 4
+        int minX = std::max(triangle.minX, tileX) & ~3;
+        int maxX = std::min(triangle.maxX, tileX+OCCLUSION_TILE_SIZE-1);
+        int minY = std::max(triangle.minY, tileY);
+        int maxY = std::min(triangle.maxY, tileY+OCCLUSION_TILE_SIZE-1);
+        __m128 edgeX0 = _mm_set1_ps(triangle.edges[0].x);
+        __m128 edgeX1 = _mm_set1_ps(triangle.edges[1].x);
+        __m128 edgeX2 = _mm_set1_ps(triangle.edges[2].x);
+        __m128 depthX = _mm_set1_ps(triangle.depthPlane.x);
+        for (int y=minY;y<=maxY;y++){
+            float pixelY = y+0.5f;
+            __m128 row0 = _mm_set1_ps(triangle.edges[0].y*pixelY+triangle.edges[0].z);
+            __m128 row1 = _mm_set1_ps(triangle.edges[1].y*pixelY+triangle.edges[1].z);
+            __m128 row2 = _mm_set1_ps(triangle.edges[2].y*pixelY+triangle.edges[2].z);
+            __m128 rowDepth = _mm_set1_ps(triangle.depthPlane.y*pixelY+triangle.depthPlane.z);
+            float *rowPixels = depth+y*OCCLUSION_BUFFER_WIDTH;
+            for (int x=minX;x<=maxX;x+=4){
+                __m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+                __m128 edge0 = _mm_add_ps(_mm_mul_ps(edgeX0, pixelX), row0);
+                __m128 edge1 = _mm_add_ps(_mm_mul_ps(edgeX1, pixelX), row1);
+                __m128 edge2 = _mm_add_ps(_mm_mul_ps(edgeX2, pixelX), row2);
+                __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)),
+                        _mm_cmpge_ps(edge2, zero));
+                if (_mm_movemask_ps(mask) == 0){
+                    continue;
+                }
+                __m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthX, pixelX), rowDepth);
+                __m128 oldDepth = _mm_loadu_ps(rowPixels+x);
+                __m128 newDepth = _mm_min_ps(oldDepth, pixelDepth);
+                _mm_storeu_ps(rowPixels+x, _mm_or_ps(_mm_and_ps(mask, newDepth), _mm_andnot_ps(mask, oldDepth)));
+            }
+        }
+    }
+}
+#else
+void OcclusionCuller::RasterizeTile(int tile){
+    int tileX = (tile%OCCLUSION_TILES_X)*OCCLUSION_TILE_SIZE;
+    int tileY = (tile/OCCLUSION_TILES_X)*OCCLUSION_TILE_SIZE;
+    float *depth = &levels[0][0];
+    for (int y=tileY;y<tileY+OCCLUSION_TILE_SIZE;y++){
+        std::fill(depth+y*OCCLUSION_BUFFER_WIDTH+tileX, depth+y*OCCLUSION_BUFFER_WIDTH+tileX+OCCLUSION_TILE_SIZE, 1.0f);
+    }
+    const std::vector<int> &bin = bins[tile];
+    for (std::vector<int>::const_iterator iter = bin.begin();iter != bin.end();iter++){
+        const OccluderTriangle &triangle = triangles[*iter];
+        int minX = std::max(triangle.minX, tileX);
+        int maxX = std::min(triangle.maxX, tileX+OCCLUSION_TILE_SIZE-1);
+        int minY = std::max(triangle.minY, tileY);
+        int maxY = std::min(triangle.maxY, tileY+OCCLUSION_TILE_SIZE-1);
+        for (int y=minY;y<=maxY;y++){
+            float pixelY = y+0.5f;
+            float *rowPixels = depth+y*OCCLUSION_BUFFER_WIDTH;
+            for (int x=minX;x<=maxX;x++){
+                float pixelX = x+0.5f;
+                bool inside = true;
+                for (int i=0;i<3 && inside;i++){
+                    inside = triangle.edges[i].x*pixelX+triangle.edges[i].y*pixelY+triangle.edges[i].z >= 0;
+                }
+                if (inside){
+                    float pixelDepth = triangle.depthPlane.x*pixelX+triangle.depthPlane.y*pixelY+triangle.depthPlane.z;
+                    rowPixels[x] = std::min(rowPixels[x], pixelDepth);
+                }
+            }
+        }
+    }
+}
+#endif
+
+void OcclusionCuller::BuildPyramid(){
+    for (unsigned int level=1;level<levels.size();level++){
+        const std::vector<float> &source = levels[level-1];
+        int sourceWidth = levelWidths[level-1];
+        int sourceHeight = levelHeights[level-1];
+        std::vector<float> &destination = levels[level];
+        for (int y=0;y<levelHeights[level];y++){
+            int y0 = std::min(y*2, sourceHeight-1);
+            int y1 = std::min(y*2+1, sourceHeight-1);
+            for (int x=0;x<levelWidths[level];x++){
+                int x0 = std::min(x*2, sourceWidth-1);
+                int x1 = std::min(x*2+1, sourceWidth-1);
+                destination[y*levelWidths[level]+x] = std::max(
+                        std::max(source[y0*sourceWidth+x0], source[y0*sourceWidth+x1]),
+                        std::max(source[y1*sourceWidth+x0], source[y1*sourceWidth+x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsOccluded(const Bounds &worldBounds) const{
+    if (triangles.empty() || worldBounds.IsEmpty()){
+        return false;
+    }
+    glm::vec3 minimum = worldBounds.GetMin();
+    glm::vec3 maximum = worldBounds.GetMax();
+    float minX = static_cast<float>(OCCLUSION_BUFFER_WIDTH);
+    float minY = static_cast<float>(OCCLUSION_BUFFER_HEIGHT);
+    float maxX = 0;
+    float maxY = 0;
+    float nearestDepth = 1;
+    for (int i=0;i<8;i++){
+        glm::vec4 corner((i&1)?maximum.x:minimum.x, (i&2)?maximum.y:minimum.y, (i&4)?maximum.z:minimum.z, 1.0f);
+        glm::vec4 clip = viewProjection*corner;
+        if (clip.w <= 0 || clip.z < -clip.w){
+            return false; // crosses the near plane
+        }
+        float inverseW = 1.0f/clip.w;
+        float x = (clip.x*inverseW*0.5f+0.5f)*OCCLUSION_BUFFER_WIDTH;
+        float y = (clip.y*inverseW*0.5f+0.5f)*OCCLUSION_BUFFER_HEIGHT;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        nearestDepth = std::min(nearestDepth, clip.z*inverseW*0.5f+0.5f);
+    }
+    // pixels overlapped by the screen rectangle of the box
+    int x0 = static_cast<int>(floor(std::min(std::max(minX, 0.0f), static_cast<float>(OCCLUSION_BUFFER_WIDTH))));
+    int y0 = static_cast<int>(floor(std::min(std::max(minY, 0.0f), static_cast<float>(OCCLUSION_BUFFER_HEIGHT))));
+    int x1 = static_cast<int>(floor(std::min(maxX, OCCLUSION_BUFFER_WIDTH-1.0f)));
+    int y1 = static_cast<int>(floor(std::min(maxY, OCCLUSION_BUFFER_HEIGHT-1.0f)));
+    if (x0 > x1 || y0 > y1){
+        return false; // outside the view (left to frustum culling)
+    }
+    // use the level where the rectangle covers at most 2x2 texels
+    int level = 0;
+    int lastLevel = static_cast<int>(levels.size())-1;
+    while (level < lastLevel && std::max((x1>>level)-(x0>>level), (y1>>level)-(y0>>level)) > 1){
+        level++;
+    }
+    const std::vector<float> &depth = levels[level];
+    int width = levelWidths[level];
+    float farthestDepth = 0;
+    for (int y=y0>>level;y<=(y1>>level);y++){
+        for (int x=x0>>level;x<=(x1>>level);x++){
+            farthestDepth = std::max(farthestDepth, depth[y*width+x]);
+        }
+    }
+    return nearestDepth > farthestDepth;
+}
+}
@@ -0,0 +1,97 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_OCCLUSIONCULLER_H
+#define	RENDER_E_OCCLUSIONCULLER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "math/Bounds.h"
+
+namespace render_e {
+
+/// Size of the occlusion depth buffer in pixels and of the tiles rasterized
+/// by the jobs (the tile width must be a multiple of 4)
+const int OCCLUSION_BUFFER_WIDTH = 256;
+const int OCCLUSION_BUFFER_HEIGHT = 128;
+const int OCCLUSION_TILE_SIZE = 32;
+const int OCCLUSION_TILES_X = OCCLUSION_BUFFER_WIDTH/OCCLUSION_TILE_SIZE;
+const int OCCLUSION_TILES_Y = OCCLUSION_BUFFER_HEIGHT/OCCLUSION_TILE_SIZE;
+const int OCCLUSION_TILE_COUNT = OCCLUSION_TILES_X*OCCLUSION_TILES_Y;
+
+/// Triangle in the pixel coordinates of the occlusion buffer. The edge
+/// functions are positive inside the triangle and depth = depthPlane.x*x +
+/// depthPlane.y*y + depthPlane.z
+struct OccluderTriangle {
+    glm::vec3 edges[3];
+    glm::vec3 depthPlane;
+    /// bounding rectangle in pixels (inclusive)
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+};
+
+///
+/// Software occlusion culling: the occluder meshes (see
+/// MeshComponent::SetOccluder()) are rasterized into a low resolution depth
+/// buffer and a hierarchical-Z pyramid (the farthest depth of each 2x2 block
+/// in the level below) is built from it. An object is occluded if the
+/// nearest depth of its bounding box is behind the farthest depth of the
+/// pyramid texels covering the screen rectangle of the box.
+/// Triangles are binned into screen tiles and each tile is rasterized by its
+/// own job, testing four pixels at a time using SSE (if available). The
+/// class does not use OpenGL.
+/// Usage: Begin(), AddOccluder() for each occluder, Rasterize() and then
+/// IsOccluded() for each object.
+///
+class OcclusionCuller {
+public:
+    OcclusionCuller();
+
+    /// Remove the occluders of the previous camera
+    void Begin(const glm::mat4 &viewProjection);
+    /// Transform the triangles of the mesh to the occlusion buffer and add
+    /// them to the bins of the tiles they overlap. Triangles are clipped
+    /// against the near plane
+    void AddOccluder(const glm::mat4 &modelMatrix, const glm::vec3 *vertices, const int *indices, int indicesCount);
+    /// Rasterize the occluders and build the hierarchical-Z pyramid
+    void Rasterize();
+    /// Returns true if the bounds (world space) are hidden behind the
+    /// occluders. Bounds crossing the near plane are never occluded
+    bool IsOccluded(const Bounds &worldBounds) const;
+
+    /// Number of occluder triangles rasterized since Begin()
+    int GetTriangleCount() const { return static_cast<int>(triangles.size()); }
+    /// Depth of the pixel (0 is near and 1 is far)
+    float GetDepth(int x, int y) const { return levels[0][y*OCCLUSION_BUFFER_WIDTH+x]; }
+    int GetLevelCount() const { return static_cast<int>(levels.size()); }
+private:
+    OcclusionCuller(const OcclusionCuller& orig); // disallow copy constructor
+    OcclusionCuller& operator = (const OcclusionCuller&); // disallow copy constructor
+    friend class RasterizeTilesJob;
+
+    /// Setup the edge functions and bin the triangle (clip space vertices)
+    void AddTriangle(const glm::vec4 &p0, const glm::vec4 &p1, const glm::vec4 &p2);
+    /// Clear the tile and rasterize the triangles in its bin
+    void RasterizeTile(int tile);
+    void BuildPyramid();
+
+    glm::mat4 viewProjection;
+    std::vector<OccluderTriangle> triangles;
+    /// triangle indices of each tile
+    std::vector<std::vector<int> > bins;
+    /// depth buffer (level 0) and the levels of the hierarchical-Z pyramid
+    std::vector<std::vector<float> > levels;
+    std::vector<int> levelWidths;
+    std::vector<int> levelHeights;
+};
+}
+
+#endif	/* RENDER_E_OCCLUSIONCULLER_H */
+
@@ -8,6 +8,15 @@
 #include "OpenGLHelper.h"
 
 #include <sstream>
+#include <cstring>
+#if defined(_WIN32)
+// wglGetProcAddress is declared by windows.h (included by glew.h)
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#else
+#include <GL/glx.h>
+#endif
+
 #include "Log.h"
 
 namespace render_e {
@@ -61,4 +70,30 @@ void OpenGLHelper::PrintErrors(){
         ERROR(ss.str());
     }
 }
-}
\ No newline at end of file
+
+bool OpenGLHelper::HasExtension(const char *name){
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions == NULL){
+        return false;
+    }
+    size_t length = strlen(name);
+    const char *pos = extensions;
+    while ((pos = strstr(pos, name)) != NULL){
+        if ((pos == extensions || pos[-1] == ' ') && (pos[length] == ' ' || pos[length] == '\0')){
+            return true;
+        }
+        pos += length;
+    }
+    return false;
+}
+
+void *OpenGLHelper::GetProcAddress(const char *name){
+#if defined(_WIN32)
+    return (void*)wglGetProcAddress(name);
+#elif defined(__APPLE__)
+    return dlsym(RTLD_DEFAULT, name);
+#else
+    return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+}
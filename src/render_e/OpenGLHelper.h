@@ -11,6 +11,14 @@
 #include <string>
 #include "GL/glew.h"
 
+// glew.h undefines GLAPIENTRY. Calling convention of entry points loaded
+// using OpenGLHelper::GetProcAddress
+#if defined(_WIN32)
+#define RENDER_E_APIENTRY __stdcall
+#else
+#define RENDER_E_APIENTRY
+#endif
+
 namespace render_e {
 ///
 /// Helper class that contains OpenGL specific code
@@ -20,6 +28,11 @@ public:
     static std::string GetFrameBufferStatusString(GLenum code);
     /// helper function that prints OpenGL errors (if any)
     static void PrintErrors();
+    /// Returns true if the extension is in the extension string
+    static bool HasExtension(const char *name);
+    /// Returns the entry point (or NULL). Used for extensions newer than the
+    /// bundled GLEW
+    static void *GetProcAddress(const char *name);
 private:
     OpenGLHelper();
     OpenGLHelper(const OpenGLHelper& orig);
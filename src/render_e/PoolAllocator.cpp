@@ -0,0 +1,81 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "PoolAllocator.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace render_e {
+
+namespace {
+/// Elements are aligned to 16 bytes (sufficient for SSE types)
+const size_t ELEMENT_ALIGNMENT = 16;
+}
+
+PoolAllocator::PoolAllocator(size_t elementSize, int elementsPerSlab)
+:elementsPerSlab(elementsPerSlab), freeList(NULL) {
+    assert(elementsPerSlab > 0);
+    if (elementSize < sizeof(FreeElement)){
+        elementSize = sizeof(FreeElement);
+    }
+    this->elementSize = (elementSize+ELEMENT_ALIGNMENT-1) & ~(ELEMENT_ALIGNMENT-1);
+    memset(&stats, 0, sizeof(PoolStats));
+}
+
+PoolAllocator::~PoolAllocator(){
+    // elements may still be referenced (e.g. by static objects destroyed
+    // later), in which case the slabs are kept
+    if (stats.liveCount != 0){
+        return;
+    }
+    for (unsigned int i=0;i<slabs.size();i++){
+        free(slabs[i]);
+    }
+}
+
+void PoolAllocator::AllocateSlab(){
+    char *slab = static_cast<char*>(malloc(elementSize*elementsPerSlab+ELEMENT_ALIGNMENT));
+    if (slab == NULL){
+        throw std::bad_alloc();
+    }
+    slabs.push_back(slab);
+    stats.slabCount++;
+    // malloc only guarantees alignment of the largest standard type
+    char *first = slab + ((ELEMENT_ALIGNMENT - (reinterpret_cast<size_t>(slab) & (ELEMENT_ALIGNMENT-1))) & (ELEMENT_ALIGNMENT-1));
+    // link the elements in address order
+    for (int i=elementsPerSlab-1;i>=0;i--){
+        FreeElement *element = reinterpret_cast<FreeElement*>(first+i*elementSize);
+        element->next = freeList;
+        freeList = element;
+    }
+}
+
+void *PoolAllocator::Allocate(){
+    if (freeList == NULL){
+        AllocateSlab();
+    }
+    FreeElement *element = freeList;
+    freeList = element->next;
+    stats.allocations++;
+    stats.liveCount++;
+    if (stats.liveCount > stats.peakCount){
+        stats.peakCount = stats.liveCount;
+    }
+    return element;
+}
+
+void PoolAllocator::Free(void *element){
+    assert(element != NULL);
+    FreeElement *freeElement = static_cast<FreeElement*>(element);
+    freeElement->next = freeList;
+    freeList = freeElement;
+    stats.frees++;
+    stats.liveCount--;
+}
+}
@@ -0,0 +1,108 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_POOLALLOCATOR_H
+#define	RENDER_E_POOLALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace render_e {
+
+/// Allocation counters of a pool
+struct PoolStats {
+    /// Number of allocations served by the pool
+    int allocations;
+    /// Number of elements returned to the pool
+    int frees;
+    /// Number of elements currently allocated
+    int liveCount;
+    /// Highest number of elements allocated at the same time
+    int peakCount;
+    /// Number of slabs allocated
+    int slabCount;
+};
+
+///
+/// Allocator of fixed size elements. Memory is allocated in slabs of
+/// elementsPerSlab elements, and freed elements are kept in a free list
+/// (stored in the elements themselves), so elements allocated together are
+/// close in memory. Slabs are only released when the pool is destroyed
+/// with no live elements.
+/// Note that the pool is not thread safe.
+///
+class PoolAllocator {
+public:
+    PoolAllocator(size_t elementSize, int elementsPerSlab = 256);
+    ~PoolAllocator();
+
+    void *Allocate();
+    void Free(void *element);
+
+    size_t GetElementSize() const { return elementSize; }
+    const PoolStats &GetStats() const { return stats; }
+private:
+    PoolAllocator(const PoolAllocator& orig); // disallow copy constructor
+    PoolAllocator& operator = (const PoolAllocator&); // disallow copy constructor
+
+    void AllocateSlab();
+
+    struct FreeElement {
+        FreeElement *next;
+    };
+
+    size_t elementSize;
+    int elementsPerSlab;
+    FreeElement *freeList;
+    std::vector<char*> slabs;
+    PoolStats stats;
+};
+
+///
+/// Base class that makes new and delete of T use a PoolAllocator shared by
+/// all objects of type T. Subclasses of T (having a different size) use the
+/// global operator new and delete. Placement new is supported (see
+/// SceneArena).
+/// Usage: class Camera : public Component, public PoolAllocated<Camera>
+///
+template <class T>
+class PoolAllocated {
+public:
+    static void *operator new(size_t size){
+        if (size != sizeof(T)){
+            return ::operator new(size);
+        }
+        return GetPool().Allocate();
+    }
+    static void operator delete(void *object, size_t size){
+        if (object == NULL){
+            return;
+        }
+        if (size != sizeof(T)){
+            ::operator delete(object);
+            return;
+        }
+        GetPool().Free(object);
+    }
+    static void *operator new(size_t size, void *memory){
+        return memory;
+    }
+    static void operator delete(void *object, void *memory){
+    }
+
+    /// Returns the pool of T (the allocation counters are found using
+    /// GetPool().GetStats())
+    static PoolAllocator &GetPool(){
+        static PoolAllocator pool(sizeof(T));
+        return pool;
+    }
+};
+}
+
+#endif	/* RENDER_E_POOLALLOCATOR_H */
+
@@ -0,0 +1,61 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "RangeAllocator.h"
+
+#include <cassert>
+
+namespace render_e {
+
+RangeAllocator::RangeAllocator(int size)
+:size(size),used(0) {
+    if (size > 0){
+        freeRanges[0] = size;
+    }
+}
+
+int RangeAllocator::Allocate(int count){
+    assert(count > 0);
+    for (std::map<int, int>::iterator iter = freeRanges.begin();iter != freeRanges.end();iter++){
+        if (iter->second < count){
+            continue;
+        }
+        int offset = iter->first;
+        int remaining = iter->second-count;
+        freeRanges.erase(iter);
+        if (remaining > 0){
+            freeRanges[offset+count] = remaining;
+        }
+        used += count;
+        return offset;
+    }
+    return -1;
+}
+
+void RangeAllocator::Free(int offset, int count){
+    assert(offset >= 0 && offset+count <= size);
+    used -= count;
+    std::map<int, int>::iterator next = freeRanges.lower_bound(offset);
+    assert(next == freeRanges.end() || next->first >= offset+count); // not already free
+    // merge with the following range
+    if (next != freeRanges.end() && next->first == offset+count){
+        count += next->second;
+        freeRanges.erase(next++);
+    }
+    // merge with the preceding range
+    if (next != freeRanges.begin()){
+        std::map<int, int>::iterator previous = next;
+        previous--;
+        assert(previous->first+previous->second <= offset); // not already free
+        if (previous->first+previous->second == offset){
+            previous->second += count;
+            return;
+        }
+    }
+    freeRanges.insert(next, std::pair<const int, int>(offset, count));
+}
+}
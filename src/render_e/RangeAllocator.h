@@ -0,0 +1,45 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_RANGEALLOCATOR_H
+#define	RENDER_E_RANGEALLOCATOR_H
+
+#include <map>
+
+namespace render_e {
+
+///
+/// Suballocates ranges of elements [0; size) using a free list ordered by
+/// offset. Allocation is first fit; freed ranges are merged with adjacent
+/// free ranges. Only the bookkeeping is done here (the elements are
+/// typically vertices or indices of a GPU buffer).
+///
+class RangeAllocator {
+public:
+    explicit RangeAllocator(int size);
+
+    /// Returns the offset of a free range of count elements, or -1 if no
+    /// free range is large enough
+    int Allocate(int count);
+    /// Release a range returned by Allocate()
+    void Free(int offset, int count);
+
+    int GetSize() const { return size; }
+    /// Number of allocated elements
+    int GetUsed() const { return used; }
+    /// Number of free ranges (1 if the free space is not fragmented)
+    int GetFreeRangeCount() const { return static_cast<int>(freeRanges.size()); }
+private:
+    int size;
+    int used;
+    /// count of each free range by offset
+    std::map<int, int> freeRanges;
+};
+}
+
+#endif	/* RENDER_E_RANGEALLOCATOR_H */
+
@@ -12,7 +12,13 @@
 
 #include "RenderBase.h"
 #include "Camera.h"
+#include "LODGroup.h"
+#include "NameTable.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include "math/Frustum.h"
 #include "OpenGLHelper.h"
+#include "GLStateCache.h"
 #include "shaders/ShaderFileDataSource.h"
 
 #include <glm/gtc/type_ptr.hpp>
@@ -24,9 +30,49 @@ namespace render_e {
 
 RenderBase *RenderBase::s_instance = NULL;
 
-Shader *zOnlyShader = NULL;
+namespace {
+/// Number of components updated by each job
+const int UPDATE_BATCH_SIZE = 64;
 
-RenderBase::RenderBase():swapBuffersFunc(NULL),doubleSpeedZOnlyRendering(true){
+const std::vector<SceneObject*> s_noObjects;
+
+void PrintPoolStats(std::stringstream &ss, const char *name, const PoolAllocator &pool){
+    const PoolStats &stats = pool.GetStats();
+    ss << name<<" pool: live "<<stats.liveCount<<" peak "<<stats.peakCount
+            <<" allocations "<<stats.allocations<<" frees "<<stats.frees
+            <<" slabs "<<stats.slabCount<<std::endl;
+}
+
+/// Lists in SceneObjectSlot::positions
+const int LIST_OBJECTS = 0;
+const int LIST_NAME = 1;
+const int LIST_TAG = 2;
+const int LIST_COMPONENT = 3; // first component type
+
+/// Name lists keep the insertion order (Find() returns the first object
+/// added) and so does the camera list (cameras render in the order added).
+/// Other lists use swap-and-pop.
+inline bool KeepsOrder(int listIndex){
+    return listIndex == LIST_NAME || listIndex == LIST_COMPONENT+CameraType;
+}
+
+class UpdateComponentsJob : public ParallelForJob {
+public:
+    explicit UpdateComponentsJob(std::vector<Component*> &components):components(components){}
+    void Execute(int begin, int end){
+        for (int i=begin;i<end;i++){
+            components[i]->Update();
+        }
+    }
+private:
+    std::vector<Component*> &components;
+};
+}
+
+RenderBase::RenderBase():deferredLightShader(NULL),uniformBuffers(false),clusteredLighting(false),
+        occlusionCulling(true),instancing(true),swapBuffersFunc(NULL),doubleSpeedZOnlyRendering(true),
+        depthOnlyShader(NULL){
+    memset(&renderStats, 0, sizeof(RenderStats));
     shaderDataSource = new ShaderFileDataSource();
 }
 
@@ -56,20 +102,13 @@ void RenderBase::SetShaderDataSource(ShaderDataSource *newShaderDataSource){
 void RenderBase::Reshape(int width, int height){
     this->width = width;
     this->height = height;
-   /* if (doubleSpeedZOnlyRendering){
-        glDepthFunc(GL_LEQUAL);
-        if (zOnlyShader == NULL){
-            zOnlyShader = DefaultShaders::Instance()->GetZOnly();
-        }
-    } else {
-        glDepthFunc(GL_LESS);
-    }*/
 }
 
 void RenderBase::SetupLight(){
     // Setup light
     // todo: this need not to run every frame
     int lightIndex=0;
+    std::vector<SceneObject*> &lights = componentIndex[LightComponentType];
     for (std::vector<SceneObject*>::iterator iter = lights.begin(); iter != lights.end();iter++){
         SceneObject *sceneObject = *iter;
         Light *light = sceneObject->GetLight(); 
@@ -82,14 +121,113 @@ void RenderBase::Update(float timeSeconds){
     assert(swapBuffersFunc!=NULL);
     
     FrameTime::updateTime(timeSeconds);
+    GLStateCache *glState = GLStateCache::Instance();
+    // the application may have changed the state between frames
+    glState->Invalidate();
+    glState->ResetStats();
+    TransformStore *transformStore = TransformStore::Instance();
+    // revalidate changes made since the last frame, so thread safe components
+    // only read valid world matrices
+    transformStore->UpdateWorldMatrices();
     UpdateScene();
+    transformStore->UpdateWorldMatrices();
+    UpdateBounds();
     
-    for (std::vector<SceneObject *>::iterator iter = cameras.begin();iter!=cameras.end();iter++){
-        SceneObject *sceneObject = *iter;
-        Camera *camera = sceneObject->GetCamera();
+    memset(&renderStats, 0, sizeof(RenderStats));
+    renderStats.transformsRecomputed = transformStore->GetRecomputedCount();
+    transformStore->ResetRecomputedCount();
+    std::vector<SceneObject*> &cameras = componentIndex[CameraType];
+    if (uniformBuffers){
+        // lights and camera matrices are uploaded once per frame
+        frameUniforms.Update(componentIndex[LightComponentType], cameras);
+        if (clusteredLighting){
+            lightClusters.SetLights(frameUniforms.GetLights(), frameUniforms.GetLightCount());
+        }
+    }
+    // cameras producing textures are rendered before the cameras using them
+    renderGraph.Build(cameras, componentIndex[MaterialType]);
+    const std::vector<int> &schedule = renderGraph.GetSchedule();
+    renderStats.renderedCameras = schedule.size();
+    renderStats.skippedCameras = renderGraph.GetSkippedPassCount();
+    // shadow cameras render before the main camera, so the shadow levels are
+    // selected up front from the first camera rendering to the screen
+    Camera *mainCamera = NULL;
+    for (unsigned int s=0;s<schedule.size() && mainCamera == NULL;s++){
+        Camera *camera = cameras[schedule[s]]->GetCamera();
+        if (!camera->IsRenderToTexture()){
+            mainCamera = camera;
+        }
+    }
+    SelectShadowLevels(mainCamera);
+    for (unsigned int s=0;s<schedule.size();s++){
+        unsigned int i = schedule[s];
+        Camera *camera = cameras[i]->GetCamera();
         camera->Setup(width, height);
-        SetupLight();
-        RenderScene();
+        if (uniformBuffers){
+            frameUniforms.Bind(i);
+        } else {
+            SetupLight();
+        }
+        // culled against the light frustum for shadow cameras
+        CullScene(camera->GetFrustum());
+        if (camera->IsDepthOnly() && GetDepthOnlyShader() != NULL){
+            SelectLevelsOfDetail(camera, true);
+            RenderShadowCasters(camera);
+            camera->TearDown();
+            continue;
+        }
+        if (occlusionCulling){
+            CullOccludedObjects(camera);
+        }
+        SelectLevelsOfDetail(camera, false);
+        if (clusteredLighting){
+            glm::mat4 projection = camera->GetProjectionMatrix();
+            lightClusters.Build(camera->GetViewMatrix(), projection, camera->GetNearPlane(),
+                    camera->GetFarPlane(), projection[2][3] != 0.0f);
+            frameUniforms.UploadClusters(lightClusters);
+            renderStats.clusterLightIndices += lightClusters.GetLightIndexCount();
+        }
+        // render-to-texture cameras only write depth (see Camera::Setup())
+        bool deferred = camera->GetDeferredShading() && !camera->IsRenderToTexture() &&
+                DeferredRenderer::IsSupported() && GetDeferredLightShader() != NULL;
+        BuildRenderQueue(camera, deferred);
+        if (deferred){
+            // the light pass writes the depth of the G-buffer, so the
+            // forward objects are depth tested against the deferred objects
+            RenderDeferred(camera);
+            RenderScene();
+            camera->TearDown();
+            continue;
+        }
+        // color writes are disabled for render-to-texture cameras (see
+        // Camera::Setup()), so they only write depth anyway
+        bool depthPrePass = doubleSpeedZOnlyRendering && camera->GetDepthPrePass() &&
+                !camera->IsRenderToTexture() && GetDepthOnlyShader() != NULL;
+        if (depthPrePass){
+            DepthPrePassQueries &queries = camera->GetDepthPrePassQueries();
+            if (queries.prePassQuery == 0){
+                glGenQueries(1, &queries.prePassQuery);
+                glGenQueries(1, &queries.mainPassQuery);
+            }
+            ReadDepthPrePassQueries(queries);
+            // queries still in flight are not restarted
+            bool countFragments = !queries.pending;
+            if (countFragments){
+                glBeginQuery(GL_SAMPLES_PASSED, queries.prePassQuery);
+            }
+            RenderDepthPrePass();
+            if (countFragments){
+                glEndQuery(GL_SAMPLES_PASSED);
+                glBeginQuery(GL_SAMPLES_PASSED, queries.mainPassQuery);
+            }
+            RenderScene();
+            if (countFragments){
+                glEndQuery(GL_SAMPLES_PASSED);
+                queries.pending = true;
+            }
+        } else {
+            RenderScene();
+        }
         camera->TearDown();
     }
     swapBuffersFunc();
@@ -98,101 +236,702 @@ void RenderBase::Update(float timeSeconds){
 
 
 void RenderBase::UpdateScene(){
-    // iterate all objects in scene and call their update function
+    // update the thread safe components in parallel batches
+    parallelComponents.clear();
     for (std::vector<SceneObject *>::iterator iter = sceneObjects.begin();iter!=sceneObjects.end();iter++){
         const std::vector<Component*> *comps = (*iter)->GetComponents();
         for (std::vector<Component*>::const_iterator componentIter = comps->begin();componentIter != comps->end(); componentIter++){
-            (*componentIter)->Update();
+            if ((*componentIter)->IsThreadSafe()){
+                parallelComponents.push_back(*componentIter);
+            }
         }
     }
-}
+    UpdateComponentsJob job(parallelComponents);
+    JobSystem::Instance()->ParallelFor(&job, parallelComponents.size(), UPDATE_BATCH_SIZE);
     
-void RenderBase::RenderScene(){
-    // Main idea here is to <-- currently disabled
-    /*if (doubleSpeedZOnlyRendering){
-        //Disable color writes, and use flat shading for speed
-        glShadeModel(GL_FLAT);
-        glColorMask(0, 0, 0, 0);
-        zOnlyShader->Bind();
-        for (std::vector<SceneObject*>::iterator sIter = sceneObjects.begin();sIter!=sceneObjects.end();sIter++){
-           MeshComponent *mesh = (*sIter)->GetMesh();
-            Material *currentMaterial = (*sIter)->GetMaterial();
-            if (mesh!=NULL){
-                Matrix44 modelView = cameraMatrix*((*sIter)->GetTransform()->GetLocalTransform());
-                glLoadMatrixf(modelView.GetReference());
-                mesh->Render();
+    // iterate all objects in scene and call the update function of the
+    // remaining components
+    for (std::vector<SceneObject *>::iterator iter = sceneObjects.begin();iter!=sceneObjects.end();iter++){
+        const std::vector<Component*> *comps = (*iter)->GetComponents();
+        for (std::vector<Component*>::const_iterator componentIter = comps->begin();componentIter != comps->end(); componentIter++){
+            if (!(*componentIter)->IsThreadSafe()){
+                (*componentIter)->Update();
+            }
+        }
+    }
+}
+
+bool RenderBase::IsRootObject(SceneObject *sceneObject){
+    Transform *parent = sceneObject->GetTransform()->GetParent();
+    return parent == NULL || parent->GetOwner() == NULL || parent->GetOwner()->GetRenderBase() != this;
+}
+
+void RenderBase::UpdateBounds(){
+    for (std::vector<SceneObject *>::iterator iter = sceneObjects.begin();iter!=sceneObjects.end();iter++){
+        if (IsRootObject(*iter)){
+            (*iter)->UpdateSubtreeBounds();
+        }
+    }
+}
+
+void RenderBase::CullScene(const Frustum &frustum){
+    visibleObjects.clear();
+    for (std::vector<SceneObject *>::iterator iter = sceneObjects.begin();iter!=sceneObjects.end();iter++){
+        if (IsRootObject(*iter)){
+            CullSceneObject(*iter, frustum, false);
+        }
+    }
+}
+
+void RenderBase::CullSceneObject(SceneObject *sceneObject, const Frustum &frustum, bool parentInside){
+    bool inside = parentInside;
+    if (!inside){
+        FrustumTestResult res = frustum.Test(sceneObject->GetSubtreeBounds());
+        if (res == FRUSTUM_OUTSIDE){
+            // reject the whole subtree
+            renderStats.culledObjects += sceneObject->GetSubtreeMeshCount();
+            return;
+        }
+        inside = res == FRUSTUM_INSIDE;
+    }
+    if (sceneObject->GetMesh() != NULL){
+        // empty bounds (no mesh asset) are outside, as in Frustum::Test()
+        const Bounds &worldBounds = sceneObject->GetWorldBounds();
+        if (inside ? !worldBounds.IsEmpty() : frustum.Test(worldBounds) != FRUSTUM_OUTSIDE){
+            visibleObjects.push_back(sceneObject);
+        } else {
+            renderStats.culledObjects++;
+        }
+    }
+    const std::vector<Transform*> *children = sceneObject->GetTransform()->GetChildren();
+    for (std::vector<Transform*>::const_iterator iter = children->begin();iter != children->end();iter++){
+        SceneObject *child = (*iter)->GetOwner();
+        if (child != NULL){
+            CullSceneObject(child, frustum, inside);
+        }
+    }
+}
+
+void RenderBase::CullOccludedObjects(Camera *camera){
+    occlusionCuller.Begin(camera->GetProjectionMatrix()*camera->GetViewMatrix());
+    for (std::vector<SceneObject*>::iterator iter = visibleObjects.begin();iter!=visibleObjects.end();iter++){
+        MeshComponent *meshComponent = (*iter)->GetMesh();
+        if (!meshComponent->GetOccluder()){
+            continue;
+        }
+        Mesh *mesh = meshComponent->GetOccluderMesh();
+        if (mesh == NULL){
+            continue; // the mesh data is not kept on the CPU
+        }
+        occlusionCuller.AddOccluder((*iter)->GetTransform()->GetGlobalTransform(), mesh->GetVertices(),
+                mesh->GetIndices(), mesh->GetIndicesCount());
+    }
+    if (occlusionCuller.GetTriangleCount() == 0){
+        return;
+    }
+    occlusionCuller.Rasterize();
+    renderStats.occluderTriangles += occlusionCuller.GetTriangleCount();
+    // occluders are kept (they are rendered anyway and a flat occluder may
+    // be hidden by its own depth)
+    unsigned int count = 0;
+    for (unsigned int i=0;i<visibleObjects.size();i++){
+        SceneObject *sceneObject = visibleObjects[i];
+        if (!sceneObject->GetMesh()->GetOccluder() && occlusionCuller.IsOccluded(sceneObject->GetWorldBounds())){
+            renderStats.occludedObjects++;
+        } else {
+            visibleObjects[count++] = sceneObject;
+        }
+    }
+    visibleObjects.resize(count);
+}
+
+void RenderBase::SelectShadowLevels(Camera *mainCamera){
+    glm::mat4 view;
+    glm::mat4 projection;
+    if (mainCamera != NULL){
+        view = mainCamera->GetViewMatrix();
+        projection = mainCamera->GetProjectionMatrix();
+    }
+    std::vector<SceneObject*> &lodObjects = componentIndex[LODGroupType];
+    for (std::vector<SceneObject*>::iterator iter = lodObjects.begin();iter!=lodObjects.end();iter++){
+        LODGroup *lodGroup = (*iter)->GetLODGroup();
+        if (!lodGroup->IsEnabled() || lodGroup->GetLevelCount() == 0 || (*iter)->GetMesh() == NULL){
+            continue;
+        }
+        float screenSize = mainCamera != NULL ? LODGroup::ComputeScreenSize((*iter)->GetWorldBounds(), view,
+                projection) : 1.0f;
+        lodGroup->SelectShadowLevel(mainCamera, screenSize);
+    }
+}
+
+void RenderBase::SelectLevelsOfDetail(Camera *camera, bool shadowPass){
+    glm::mat4 view = camera->GetViewMatrix();
+    glm::mat4 projection = camera->GetProjectionMatrix();
+    for (std::vector<SceneObject*>::iterator iter = visibleObjects.begin();iter!=visibleObjects.end();iter++){
+        LODGroup *lodGroup = (*iter)->GetLODGroup();
+        if (lodGroup == NULL){
+            continue;
+        }
+        // disabled groups render the mesh itself
+        int level = 0;
+        if (lodGroup->IsEnabled() && lodGroup->GetLevelCount() > 0){
+            if (shadowPass){
+                level = lodGroup->GetShadowLevel();
+            } else {
+                level = lodGroup->SelectLevel(camera, LODGroup::ComputeScreenSize((*iter)->GetWorldBounds(), view,
+                        projection));
             }
         }
-        glShadeModel(GL_SMOOTH);
-        glColorMask(1, 1, 1, 1);
-    }*/
+        MeshComponent *meshComponent = (*iter)->GetMesh();
+        if (level == 0){
+            meshComponent->SetLODAsset(NULL);
+            continue;
+        }
+        MeshAsset *lodAsset = lodGroup->GetLevel(level);
+        meshComponent->SetLODAsset(lodAsset);
+        renderStats.lodObjects++;
+        renderStats.lodTrianglesSaved += (lodGroup->GetLevel(0)->GetIndicesCount()-lodAsset->GetIndicesCount())/3;
+    }
+}
     
+void RenderBase::BuildRenderQueue(Camera *camera, bool deferred){
+    renderQueue.Clear();
+    gbufferQueue.Clear();
+    glm::mat4 view = camera->GetViewMatrix();
+    float farPlane = camera->GetFarPlane();
+    for (std::vector<SceneObject*>::iterator iter = visibleObjects.begin();iter!=visibleObjects.end();iter++){
+        glm::vec4 center = view*glm::vec4((*iter)->GetWorldBounds().GetCenter(), 1.0f);
+        Material *material = (*iter)->GetMaterial();
+        if (deferred && material != NULL && material->IsDeferred()){
+            gbufferQueue.Add(*iter, -center.z, farPlane);
+        } else {
+            renderQueue.Add(*iter, -center.z, farPlane);
+        }
+    }
+    int unsortedStateChanges = renderQueue.CountStateChanges()+gbufferQueue.CountStateChanges();
+    renderQueue.Sort();
+    gbufferQueue.Sort();
+    int stateChanges = renderQueue.CountStateChanges()+gbufferQueue.CountStateChanges();
+    renderStats.stateChanges += stateChanges;
+    renderStats.stateChangesSaved += unsortedStateChanges-stateChanges;
+}
+
+void RenderBase::BuildInstanceRanges(){
+    instanceBuffer.Clear();
+    instanceRanges.clear();
+    drawCommands.clear();
+    if (!instancing || !InstanceBuffer::IsSupported()){
+        return;
+    }
+    // different meshes in the same geometry heap page can be drawn using one
+    // multi-draw indirect call
+    bool multiDraw = GeometryHeap::IsMultiDrawIndirectSupported();
+    int count = renderQueue.GetSize();
+    int i = 0;
+    while (i<count){
+        SceneObject *first = renderQueue.GetItem(i).sceneObject;
+        Material *material = first->GetMaterial();
+        MeshAsset *meshAsset = first->GetMesh()->GetMeshAsset();
+        GeometryPage *page = meshAsset != NULL ? meshAsset->GetGeometryRange().page : NULL;
+        bool sameMesh = true;
+        int end = i+1;
+        if (material != NULL && material->IsInstanceable()){
+            // compatible objects are adjacent in the sorted queue
+            while (end<count){
+                SceneObject *other = renderQueue.GetItem(end).sceneObject;
+                if (other->GetMaterial() == NULL || !material->IsInstanceCompatible(other->GetMaterial())){
+                    break;
+                }
+                MeshAsset *otherAsset = other->GetMesh()->GetMeshAsset();
+                if (otherAsset != meshAsset){
+                    // quantized positions are decoded per mesh, so such
+                    // meshes are not merged with other meshes
+                    if (!multiDraw || page == NULL || otherAsset == NULL || otherAsset->GetGeometryRange().page != page ||
+                            meshAsset->IsPositionCompressed() || otherAsset->IsPositionCompressed()){
+                        break;
+                    }
+                    sameMesh = false;
+                }
+                end++;
+            }
+        }
+        if (end-i>1){
+            InstanceRange range;
+            range.begin = i;
+            range.end = end;
+            range.firstInstance = instanceBuffer.GetSize();
+            range.firstCommand = drawCommands.size();
+            range.commandCount = 0;
+            MeshAsset *lastAsset = NULL;
+            for (int j=i;j<end;j++){
+                SceneObject *sceneObject = renderQueue.GetItem(j).sceneObject;
+                instanceBuffer.Add(sceneObject->GetTransform()->GetGlobalTransform(),
+                        sceneObject->GetMaterial()->GetInstanceParameter());
+                if (sameMesh){
+                    continue;
+                }
+                // one command per mesh, drawing its adjacent instances
+                MeshAsset *asset = sceneObject->GetMesh()->GetMeshAsset();
+                if (asset == lastAsset){
+                    drawCommands.back().instanceCount++;
+                    continue;
+                }
+                const GeometryRange &geometryRange = asset->GetGeometryRange();
+                DrawElementsIndirectCommand command;
+                command.count = geometryRange.indexCount;
+                command.instanceCount = 1;
+                command.firstIndex = geometryRange.firstIndex;
+                command.baseVertex = geometryRange.baseVertex;
+                command.baseInstance = j-i; // relative to the bound instances
+                drawCommands.push_back(command);
+                range.commandCount++;
+                lastAsset = asset;
+            }
+            instanceRanges.push_back(range);
+        }
+        i = end;
+    }
+    instanceBuffer.Upload();
+    if (multiDraw){
+        GeometryHeap::Instance()->UploadDrawCommands(drawCommands);
+    }
+}
+
+Shader *RenderBase::GetDepthOnlyShader(){
+    if (depthOnlyShader == NULL){
+        ShaderLoadStatus status;
+        depthOnlyShader = CreateShader("zonly", "zonly", shaderDataSource, status);
+        if (status != SHADER_OK){
+            ERROR("Cannot load shader zonly. Depth pre-pass disabled.");
+            doubleSpeedZOnlyRendering = false;
+        }
+    }
+    return depthOnlyShader;
+}
+
+Shader *RenderBase::GetDeferredLightShader(){
+    if (deferredLightShader == NULL){
+        ShaderLoadStatus status;
+        deferredLightShader = CreateShader("deferred-light", "deferred-light", shaderDataSource, status);
+        if (status != SHADER_OK){
+            ERROR("Cannot load shader deferred-light. Deferred shading disabled.");
+        }
+    }
+    return deferredLightShader;
+}
+
+void RenderBase::RenderDeferred(Camera *camera){
+    deferredRenderer.BeginGeometryPass(camera);
     Material *lastMaterial = NULL;
-    for (std::vector<SceneObject*>::iterator sIter = sceneObjects.begin();sIter!=sceneObjects.end();sIter++){
-        MeshComponent *mesh = (*sIter)->GetMesh();
-        Material *currentMaterial = (*sIter)->GetMaterial();
+    int count = gbufferQueue.GetSize();
+    for (int i=0;i<count;i++){
+        SceneObject *sceneObject = gbufferQueue.GetItem(i).sceneObject;
+        Material *currentMaterial = sceneObject->GetMaterial();
         if (currentMaterial != lastMaterial){
-            if (currentMaterial != NULL){
-                currentMaterial->Bind();
-            }
+            currentMaterial->Bind(false, true);
             lastMaterial = currentMaterial;
         }
-        if (mesh!=NULL){
+        glPushMatrix();
+        glMultMatrixf(glm::value_ptr(sceneObject->GetTransform()->GetGlobalTransform()));
+        sceneObject->GetMesh()->Render();
+        glPopMatrix();
+        renderStats.drawCalls++;
+    }
+    if (MeshAsset::IsVertexArraySupported()){
+        GLStateCache::Instance()->BindVertexArray(0);
+    }
+    deferredRenderer.EndGeometryPass(camera);
+    renderStats.deferredLights += deferredRenderer.RenderLights(camera, componentIndex[LightComponentType],
+            deferredLightShader);
+    renderStats.deferredObjects += count;
+    renderStats.visibleObjects += count;
+    GLStateCache::Instance()->UseProgram(0);
+}
+
+void RenderBase::RenderDepthPrePass(){
+    // front to back, so the depth test rejects most occluded fragments in
+    // the pre-pass as well
+    renderQueue.GetOpaqueFrontToBack(depthPrePassOrder);
+    GLStateCache *glState = GLStateCache::Instance();
+    glState->ColorMask(false, false, false, false);
+    glState->DepthMask(true);
+    depthOnlyShader->Bind();
+    for (unsigned int i=0;i<depthPrePassOrder.size();i++){
+        SceneObject *sceneObject = renderQueue.GetItem(depthPrePassOrder[i]).sceneObject;
+        glPushMatrix();
+        glMultMatrixf(glm::value_ptr(sceneObject->GetTransform()->GetGlobalTransform()));
+        sceneObject->GetMesh()->RenderPositionOnly();
+        glPopMatrix();
+        renderStats.depthPrePassDrawCalls++;
+    }
+    glState->ColorMask(true, true, true, true);
+    // objects without a material are rendered using the fixed function
+    // pipeline
+    glState->UseProgram(0);
+    // the main pass keeps the GL_LEQUAL depth test: the instanced shader
+    // variants do not compute bitwise identical depth values, so GL_EQUAL
+    // would reject visible fragments
+}
+
+void RenderBase::RenderShadowCasters(Camera *camera){
+    renderQueue.Clear();
+    glm::mat4 view = camera->GetViewMatrix();
+    float farPlane = camera->GetFarPlane();
+    for (std::vector<SceneObject*>::iterator iter = visibleObjects.begin();iter!=visibleObjects.end();iter++){
+        if (!(*iter)->GetMesh()->GetCastShadows()){
+            renderStats.shadowCastersSkipped++;
+            continue;
+        }
+        glm::vec4 center = view*glm::vec4((*iter)->GetWorldBounds().GetCenter(), 1.0f);
+        renderQueue.AddDepthOnly(*iter, -center.z, farPlane);
+    }
+    renderQueue.Sort();
+
+    // objects sharing a mesh are adjacent and drawn using GPU instancing
+    instanceBuffer.Clear();
+    instanceRanges.clear();
+    Shader *instancedShader = depthOnlyShader->GetInstancedVariant();
+    int count = renderQueue.GetSize();
+    if (instancing && InstanceBuffer::IsSupported() && instancedShader != NULL){
+        int i = 0;
+        while (i<count){
+            MeshAsset *meshAsset = renderQueue.GetItem(i).sceneObject->GetMesh()->GetMeshAsset();
+            int end = i+1;
+            // objects without a mesh asset are not grouped (drawing them
+            // does nothing)
+            while (meshAsset != NULL && end<count &&
+                    renderQueue.GetItem(end).sceneObject->GetMesh()->GetMeshAsset() == meshAsset){
+                end++;
+            }
+            if (end-i>1){
+                InstanceRange range;
+                range.begin = i;
+                range.end = end;
+                range.firstInstance = instanceBuffer.GetSize();
+                range.firstCommand = 0;
+                range.commandCount = 0;
+                for (int j=i;j<end;j++){
+                    instanceBuffer.Add(renderQueue.GetItem(j).sceneObject->GetTransform()->GetGlobalTransform(),
+                            glm::vec4(0.0f));
+                }
+                instanceRanges.push_back(range);
+            }
+            i = end;
+        }
+        instanceBuffer.Upload();
+    }
+
+    GLStateCache *glState = GLStateCache::Instance();
+    glState->DepthMask(true);
+    unsigned int rangeIndex = 0;
+    int drawCalls = 0;
+    int i = 0;
+    while (i<count){
+        SceneObject *sceneObject = renderQueue.GetItem(i).sceneObject;
+        if (rangeIndex < instanceRanges.size() && instanceRanges[rangeIndex].begin == i){
+            const InstanceRange &range = instanceRanges[rangeIndex];
+            rangeIndex++;
+            instancedShader->Bind();
+            MeshAsset *meshAsset = sceneObject->GetMesh()->GetMeshAsset();
+            // the instance attributes are stored in the vertex array object
+            meshAsset->BindPositionBuffers();
+            instanceBuffer.Bind(range.firstInstance);
+            meshAsset->RenderPositionOnly(range.end-range.begin);
+            instanceBuffer.Unbind();
+            renderStats.instancedObjects += range.end-range.begin;
+            i = range.end;
+        } else {
+            depthOnlyShader->Bind();
             glPushMatrix();
-            Transform *t = (*sIter)->GetTransform();
-            glMultMatrixf(glm::value_ptr(t->GetGlobalTransform()));
-            mesh->Render();
+            glMultMatrixf(glm::value_ptr(sceneObject->GetTransform()->GetGlobalTransform()));
+            sceneObject->GetMesh()->RenderPositionOnly();
             glPopMatrix();
+            i++;
         }
+        drawCalls++;
+    }
+    glState->UseProgram(0);
+    if (MeshAsset::IsVertexArraySupported()){
+        glState->BindVertexArray(0);
     }
+    // each object of the queue is drawn once, by one of the draw calls
+    renderStats.drawCalls += drawCalls;
+    renderStats.shadowCasters += count;
 }
 
-void RenderBase::AddSceneObject(SceneObject *sceneObject){
-	assert(sceneObject != NULL);
-    
-	sceneObject->SetRenderBase(this);
-    sceneObjects.push_back(sceneObject);
-    if (sceneObject->GetCamera() != NULL){
-        cameras.push_back(sceneObject);
+void RenderBase::ReadDepthPrePassQueries(DepthPrePassQueries &queries){
+    if (!queries.pending){
+        return;
     }
-    
-    if (sceneObject->GetLight() != NULL){
-        lights.push_back(sceneObject);
+    // the main pass query ends last
+    GLuint available = 0;
+    glGetQueryObjectuiv(queries.mainPassQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available){
+        return;
     }
+    GLuint fragments;
+    glGetQueryObjectuiv(queries.prePassQuery, GL_QUERY_RESULT, &fragments);
+    renderStats.depthPrePassFragments += fragments;
+    glGetQueryObjectuiv(queries.mainPassQuery, GL_QUERY_RESULT, &fragments);
+    renderStats.shadedFragments += fragments;
+    queries.pending = false;
+}
+
+void RenderBase::RenderScene(){
+    BuildInstanceRanges();
     
-    // add child components to the scene as well
-    using std::vector;
-    const vector<Transform*> *children = sceneObject->GetTransform()->GetChildren();
-    for (vector<Transform*>::const_iterator iter = children->begin();iter != children->end();iter++){
-        AddSceneObject((*iter)->GetOwner());
+    // the queue is sorted by state, so objects sharing a material are adjacent
+    Material *lastMaterial = NULL;
+    unsigned int rangeIndex = 0;
+    int count = renderQueue.GetSize();
+    for (int i=0;i<count;i++){
+        SceneObject *sceneObject = renderQueue.GetItem(i).sceneObject;
+        if (rangeIndex < instanceRanges.size() && instanceRanges[rangeIndex].begin == i){
+            const InstanceRange &range = instanceRanges[rangeIndex];
+            rangeIndex++;
+            sceneObject->GetMaterial()->Bind(true);
+            lastMaterial = NULL; // the instanced variant of the shader is bound
+            MeshAsset *meshAsset = sceneObject->GetMesh()->GetMeshAsset();
+            if (meshAsset != NULL){
+                // the instance attributes are stored in the vertex array
+                // object of the mesh, so it must be bound first
+                meshAsset->BindBuffers();
+            }
+            instanceBuffer.Bind(range.firstInstance);
+            if (range.commandCount > 0){
+                GeometryHeap::Instance()->MultiDrawIndirect(meshAsset->GetGeometryRange().page,
+                        range.firstCommand, range.commandCount);
+                renderStats.multiDrawCommands += range.commandCount;
+            } else {
+                sceneObject->GetMesh()->RenderInstanced(range.end-range.begin);
+            }
+            instanceBuffer.Unbind();
+            renderStats.drawCalls++;
+            renderStats.instancedObjects += range.end-range.begin;
+            i = range.end-1;
+            continue;
+        }
+        MeshComponent *mesh = sceneObject->GetMesh();
+        Material *currentMaterial = sceneObject->GetMaterial();
+        if (currentMaterial != lastMaterial){
+            if (currentMaterial != NULL){
+                currentMaterial->Bind();
+            }
+            lastMaterial = currentMaterial;
+        }
+        glPushMatrix();
+        Transform *t = sceneObject->GetTransform();
+        glMultMatrixf(glm::value_ptr(t->GetGlobalTransform()));
+        mesh->Render();
+        glPopMatrix();
+        renderStats.drawCalls++;
     }
+    // restore the state changed by blended materials
+    GLStateCache::Instance()->SetCapability(GL_BLEND, false);
+    GLStateCache::Instance()->DepthMask(true);
+    if (MeshAsset::IsVertexArraySupported()){
+        // later buffer binds must not change the vertex array object of a mesh
+        GLStateCache::Instance()->BindVertexArray(0);
+    }
+    renderStats.visibleObjects += count;
+}
+
+SceneObjectHandle RenderBase::AddSceneObject(SceneObject *sceneObject){
+    return AddSubtree(sceneObject);
 }
 
 void RenderBase::DeleteSceneObject(SceneObject *sceneObject){
-	sceneObject->SetRenderBase(NULL);
-    std::vector<SceneObject*>::iterator pos = find(sceneObjects.begin(), sceneObjects.end(), sceneObject);
-    if (pos!=sceneObjects.end()){
-        sceneObjects.erase(pos);
+    assert(sceneObject != NULL);
+    Remove(sceneObject);
+}
+
+void RenderBase::DeleteSceneObject(SceneObjectHandle handle){
+    SceneObject *sceneObject = GetSceneObject(handle);
+    if (sceneObject != NULL){
+        Remove(sceneObject);
+    }
+}
+
+SceneObjectHandle RenderBase::AddSubtree(SceneObject *root){
+	assert(root != NULL);
+    CollectSubtree(root);
+    sceneObjects.reserve(sceneObjects.size()+subtreeBuffer.size());
+    for (std::vector<SceneObject*>::iterator iter = subtreeBuffer.begin();iter != subtreeBuffer.end();iter++){
+        Insert(*iter);
+    }
+    return root->handle;
+}
+
+void RenderBase::RemoveSubtree(SceneObject *root){
+	assert(root != NULL);
+    CollectSubtree(root);
+    for (std::vector<SceneObject*>::iterator iter = subtreeBuffer.begin();iter != subtreeBuffer.end();iter++){
+        Remove(*iter);
+    }
+}
+
+SceneObject *RenderBase::GetSceneObject(SceneObjectHandle handle) const{
+    if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation){
+        return NULL;
+    }
+    return slots[handle.index].sceneObject;
+}
+
+void RenderBase::CollectSubtree(SceneObject *root){
+    using std::vector;
+    subtreeBuffer.clear();
+    subtreeBuffer.push_back(root);
+    // breadth first (parents are added before their children)
+    for (unsigned int i=0;i<subtreeBuffer.size();i++){
+        const vector<Transform*> *children = subtreeBuffer[i]->GetTransform()->GetChildren();
+        for (vector<Transform*>::const_iterator iter = children->begin();iter != children->end();iter++){
+            subtreeBuffer.push_back((*iter)->GetOwner());
+        }
+    }
+}
+
+bool RenderBase::Contains(SceneObject *sceneObject) const{
+    return sceneObject->renderBase == this && GetSceneObject(sceneObject->handle) == sceneObject;
+}
+
+void RenderBase::Insert(SceneObject *sceneObject){
+    if (Contains(sceneObject)){
+        return;
+    }
+    unsigned int index;
+    if (freeSlots.empty()){
+        index = slots.size();
+        SceneObjectSlot slot;
+        slot.generation = 1;
+        slots.push_back(slot);
+    } else {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    SceneObjectSlot &slot = slots[index];
+    slot.sceneObject = sceneObject;
+    for (int i=0;i<SCENE_LIST_COUNT;i++){
+        slot.positions[i] = -1;
     }
+    sceneObject->handle.index = index;
+    sceneObject->handle.generation = slot.generation;
+	sceneObject->SetRenderBase(this);
     
-    pos = find(cameras.begin(), cameras.end(), sceneObject);
-    if (pos!=cameras.end()){
-        cameras.erase(pos);
+    InsertInList(sceneObjects, LIST_OBJECTS, sceneObject);
+    InsertInList(GetIndexList(nameIndex, sceneObject->GetNameId()), LIST_NAME, sceneObject);
+    InsertInList(GetIndexList(tagIndex, sceneObject->GetTagId()), LIST_TAG, sceneObject);
+    for (int type=0;type<COMPONENT_TYPE_COUNT;type++){
+        if (sceneObject->HasComponent(static_cast<ComponentType>(type))){
+            InsertInList(componentIndex[type], LIST_COMPONENT+type, sceneObject);
+        }
+    }
+}
+
+void RenderBase::Remove(SceneObject *sceneObject){
+    if (!Contains(sceneObject)){
+        return;
+    }
+    unsigned int index = sceneObject->handle.index;
+    RemoveFromList(sceneObjects, LIST_OBJECTS, sceneObject);
+    RemoveFromList(GetIndexList(nameIndex, sceneObject->GetNameId()), LIST_NAME, sceneObject);
+    RemoveFromList(GetIndexList(tagIndex, sceneObject->GetTagId()), LIST_TAG, sceneObject);
+    for (int type=0;type<COMPONENT_TYPE_COUNT;type++){
+        RemoveFromList(componentIndex[type], LIST_COMPONENT+type, sceneObject);
     }
     
-    pos = find(lights.begin(), lights.end(), sceneObject);
-    if (pos!=cameras.end()){
-        lights.erase(pos);
+    SceneObjectSlot &slot = slots[index];
+    slot.sceneObject = NULL;
+    slot.generation++;
+    if (slot.generation == 0){
+        slot.generation = 1;
     }
+    freeSlots.push_back(index);
+    sceneObject->handle.generation = 0;
+	sceneObject->SetRenderBase(NULL);
+}
+
+std::vector<SceneObject*> &RenderBase::GetIndexList(std::vector<std::vector<SceneObject*> > &index, int id){
+    if (id >= static_cast<int>(index.size())){
+        index.resize(NameTable::Instance()->GetSize());
+    }
+    return index[id];
+}
+
+void RenderBase::InsertInList(std::vector<SceneObject*> &list, int listIndex, SceneObject *sceneObject){
+    slots[sceneObject->handle.index].positions[listIndex] = list.size();
+    list.push_back(sceneObject);
+}
+
+void RenderBase::RemoveFromList(std::vector<SceneObject*> &list, int listIndex, SceneObject *sceneObject){
+    int position = slots[sceneObject->handle.index].positions[listIndex];
+    if (position == -1){
+        return;
+    }
+    if (KeepsOrder(listIndex)){
+        list.erase(list.begin()+position);
+        for (unsigned int i=position;i<list.size();i++){
+            slots[list[i]->handle.index].positions[listIndex] = i;
+        }
+    } else {
+        SceneObject *last = list.back();
+        list[position] = last;
+        slots[last->handle.index].positions[listIndex] = position;
+        list.pop_back();
+    }
+    slots[sceneObject->handle.index].positions[listIndex] = -1;
+}
+
+const std::vector<SceneObject*> &RenderBase::FindInIndex(const std::vector<std::vector<SceneObject*> > &index, const char *name){
+    int id = NameTable::Instance()->Find(name);
+    if (id == -1 || id >= static_cast<int>(index.size())){
+        return s_noObjects;
+    }
+    return index[id];
+}
+
+void RenderBase::NameChanged(SceneObject *sceneObject, int oldNameId){
+    RemoveFromList(GetIndexList(nameIndex, oldNameId), LIST_NAME, sceneObject);
+    InsertInList(GetIndexList(nameIndex, sceneObject->GetNameId()), LIST_NAME, sceneObject);
+}
+
+void RenderBase::TagChanged(SceneObject *sceneObject, int oldTagId){
+    RemoveFromList(GetIndexList(tagIndex, oldTagId), LIST_TAG, sceneObject);
+    InsertInList(GetIndexList(tagIndex, sceneObject->GetTagId()), LIST_TAG, sceneObject);
+}
+
+void RenderBase::ComponentAdded(SceneObject *sceneObject, Component *component){
+    int type = component->GetComponentType();
+    if (slots[sceneObject->handle.index].positions[LIST_COMPONENT+type] == -1){
+        InsertInList(componentIndex[type], LIST_COMPONENT+type, sceneObject);
+    }
+}
+
+void RenderBase::ComponentRemoved(SceneObject *sceneObject, Component *component){
+    ComponentType type = component->GetComponentType();
+    if (sceneObject->HasComponent(type)){
+        return; // another component of the same type is attached
+    }
+    RemoveFromList(componentIndex[type], LIST_COMPONENT+type, sceneObject);
 }
 
 SceneObject *RenderBase::Find(const char *name) const{
-    for (std::vector<SceneObject*>::const_iterator iter = sceneObjects.begin();iter != sceneObjects.end();iter++){
-		if ((*iter)->GetName().compare(name)==0){
-			return *iter;
-		}
+    const std::vector<SceneObject*> &objects = FindInIndex(nameIndex, name);
+    if (objects.empty()){
+        return NULL;
     }
-	return NULL;
+	return objects[0];
+}
+
+const std::vector<SceneObject*> &RenderBase::FindAll(const char *name) const{
+    return FindInIndex(nameIndex, name);
+}
+
+const std::vector<SceneObject*> &RenderBase::FindWithTag(const char *tag) const{
+    return FindInIndex(tagIndex, tag);
+}
+
+const std::vector<SceneObject*> &RenderBase::FindWithComponent(ComponentType type) const{
+    return componentIndex[type];
 }
 
 void RenderBase::SetRenderMode(RenderMode renderMode){
@@ -215,10 +954,7 @@ void RenderBase::SetRenderMode(RenderMode renderMode){
 
 void RenderBase::Init(void (*swapBuffersFunc)()){
     this->swapBuffersFunc = swapBuffersFunc;
-    glEnableClientState(GL_NORMAL_ARRAY);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_COLOR_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    // vertex arrays are enabled per mesh (see MeshAsset)
     glCullFace(GL_BACK);
 	glEnable(GL_CULL_FACE);
     glEnable(GL_LIGHTING);
@@ -227,7 +963,9 @@ void RenderBase::Init(void (*swapBuffersFunc)()){
 	glEnable(GL_DEPTH_TEST);
 
     glClearDepth(1.0f);                         // 0 is near, 1 is far
-    glDepthFunc(GL_LEQUAL);
+    GLStateCache::Instance()->DepthFunc(GL_LEQUAL);
+    uniformBuffers = FrameUniforms::IsSupported();
+    clusteredLighting = FrameUniforms::IsClusteringSupported();
 }
 
 void RenderBase::SetDoubleSpeedZOnlyRendering(bool enabled){
@@ -260,15 +998,66 @@ void RenderBase::PrintDebug(){
         
     }
     
+    const vector<SceneObject*> &cameras = componentIndex[CameraType];
     ss << "Camera objects: "<<cameras.size()<<endl;
     for (unsigned int i=0;i<cameras.size();i++){
         ss <<cameras[i]->GetName()<<endl;
     }
     
+    const vector<SceneObject*> &lights = componentIndex[LightComponentType];
     ss << "lights objects: "<<lights.size()<<endl;
     for (unsigned int i=0;i<lights.size();i++){
         ss <<lights[i]->GetName()<<endl;
     }
+    
+    ss << "Last frame: visible "<<renderStats.visibleObjects<<" culled "<<renderStats.culledObjects
+            <<" draw calls "<<renderStats.drawCalls<<" state changes "<<renderStats.stateChanges
+            <<" (saved "<<renderStats.stateChangesSaved<<") instanced "<<renderStats.instancedObjects
+            <<" (multi-draw commands "<<renderStats.multiDrawCommands
+            <<") transforms recomputed "<<renderStats.transformsRecomputed<<endl;
+    ss << "Cameras: rendered "<<renderStats.renderedCameras<<" skipped "<<renderStats.skippedCameras
+            <<" shared depth buffers "<<renderGraph.GetDepthBufferCount()<<endl;
+    if (renderStats.deferredObjects > 0){
+        ss << "Deferred shading: objects "<<renderStats.deferredObjects
+                <<" lights "<<renderStats.deferredLights<<endl;
+    }
+    if (clusteredLighting){
+        ss << "Light clusters: lights "<<lightClusters.GetLightCount()
+                <<" light indices "<<renderStats.clusterLightIndices<<endl;
+    }
+    if (renderStats.occluderTriangles > 0){
+        ss << "Occlusion culling: occluded "<<renderStats.occludedObjects
+                <<" occluder triangles "<<renderStats.occluderTriangles<<endl;
+    }
+    if (renderStats.lodObjects > 0){
+        ss << "Levels of detail: objects "<<renderStats.lodObjects
+                <<" triangles saved "<<renderStats.lodTrianglesSaved<<endl;
+    }
+    ss << "Shadow casters: rendered "<<renderStats.shadowCasters
+            <<" skipped "<<renderStats.shadowCastersSkipped<<endl;
+    if (renderStats.depthPrePassFragments > 0){
+        ss << "Depth pre-pass: draw calls "<<renderStats.depthPrePassDrawCalls
+                <<" fragments "<<renderStats.depthPrePassFragments<<" shaded "<<renderStats.shadedFragments
+                <<" (saved "<<renderStats.depthPrePassFragments-renderStats.shadedFragments<<")"<<endl;
+    }
+    const GLStateStats &glStats = GLStateCache::Instance()->GetStats();
+    ss << "GL calls (skipped): programs "<<glStats.programBinds<<" ("<<glStats.programBindsSkipped
+            <<") textures "<<glStats.textureBinds<<" ("<<glStats.textureBindsSkipped
+            <<") buffers "<<glStats.bufferBinds<<" ("<<glStats.bufferBindsSkipped
+            <<") uniforms "<<glStats.uniformUploads<<" ("<<glStats.uniformUploadsSkipped
+            <<") vertex arrays "<<glStats.vertexArraySetups<<" ("<<glStats.vertexArraySetupsSkipped
+            <<") other "<<glStats.stateChanges<<" ("<<glStats.stateChangesSkipped<<")"<<endl;
+    
+    GeometryHeapStats heapStats = GeometryHeap::Instance()->GetStats();
+    ss << "Geometry heap: meshes "<<heapStats.meshCount<<" pages "<<heapStats.pageCount
+            <<" vertex bytes "<<heapStats.usedVertexBytes<<"/"<<heapStats.vertexBytes
+            <<" index bytes "<<heapStats.usedIndexBytes<<"/"<<heapStats.indexBytes<<endl;
+    PrintPoolStats(ss, "SceneObject", SceneObject::GetPool());
+    PrintPoolStats(ss, "Transform", Transform::GetPool());
+    PrintPoolStats(ss, "Camera", Camera::GetPool());
+    PrintPoolStats(ss, "Light", Light::GetPool());
+    PrintPoolStats(ss, "MeshComponent", MeshComponent::GetPool());
+    PrintPoolStats(ss, "Material", Material::GetPool());
     DEBUG(ss.str());
 }
 }
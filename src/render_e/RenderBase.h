@@ -11,6 +11,14 @@
 #include <vector>
 #include <map>
 #include "SceneObject.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "GeometryHeap.h"
+#include "FrameUniforms.h"
+#include "RenderGraph.h"
+#include "DeferredRenderer.h"
+#include "LightClusters.h"
+#include "OcclusionCuller.h"
 #include "shaders/Shader.h"
 #include "shaders/ShaderDataSource.h"
 
@@ -18,6 +26,8 @@ namespace render_e {
 
 // forward declaration
 class SceneObject;
+class Frustum;
+class Camera;
 
 enum RenderMode {
     RENDER_MODE_FILL,
@@ -25,6 +35,84 @@ enum RenderMode {
     RENDER_MODE_POINT
 };
 
+///
+/// Statistics collected during a frame (summed over all cameras)
+///
+struct RenderStats {
+    /// Number of objects with a mesh that was rendered
+    int visibleObjects;
+    /// Number of objects with a mesh that was rejected by frustum culling
+    int culledObjects;
+    /// Number of draw calls issued
+    int drawCalls;
+    /// Number of program, material, texture and mesh changes
+    int stateChanges;
+    /// Number of state changes avoided by sorting the render queue
+    int stateChangesSaved;
+    /// Number of objects drawn using GPU instancing
+    int instancedObjects;
+    /// Number of world matrices recomputed
+    int transformsRecomputed;
+    /// Number of indirect commands submitted using multi-draw calls
+    int multiDrawCommands;
+    /// Number of draw calls issued by the depth pre-pass
+    int depthPrePassDrawCalls;
+    /// Fragments passing the depth test in the depth pre-pass and in the
+    /// main pass (including blended objects) of the cameras using a
+    /// pre-pass. Counted using occlusion queries, so the values are from the
+    /// previous frame. The difference is the number of fragments the pre-pass
+    /// saved from being shaded
+    int depthPrePassFragments;
+    int shadedFragments;
+    /// Number of objects rendered and skipped (see
+    /// MeshComponent::SetCastShadows()) by the shadow caster passes
+    int shadowCasters;
+    int shadowCastersSkipped;
+    /// Number of cameras rendered and skipped by the render graph
+    int renderedCameras;
+    int skippedCameras;
+    /// Number of objects rendered to the G-buffer and number of lights
+    /// drawn by the deferred light pass
+    int deferredObjects;
+    int deferredLights;
+    /// Number of light indices in the light clusters of the cameras
+    int clusterLightIndices;
+    /// Number of visible objects rejected by the occlusion culling and
+    /// number of occluder triangles rasterized
+    int occludedObjects;
+    int occluderTriangles;
+    /// Number of objects rendered using a simplified level of detail (see
+    /// LODGroup) and the number of triangles saved by the levels
+    int lodObjects;
+    int lodTrianglesSaved;
+};
+
+///
+/// Occlusion queries counting the fragments of the depth pre-pass and the
+/// main pass of a camera (see Camera::GetDepthPrePassQueries())
+///
+struct DepthPrePassQueries {
+    unsigned int prePassQuery;
+    unsigned int mainPassQuery;
+    /// true while the results have not been read
+    bool pending;
+};
+
+/// Number of object lists maintained by the render base: all objects, the
+/// name list, the tag list and one list per component type
+const int SCENE_LIST_COUNT = 3+COMPONENT_TYPE_COUNT;
+
+///
+/// Slot of a scene object in the render base. Contains the generation of the
+/// handle and the position of the object in each list (-1 if not in the list)
+/// used to remove the object in constant time.
+///
+struct SceneObjectSlot {
+    SceneObject *sceneObject;
+    unsigned int generation;
+    int positions[SCENE_LIST_COUNT];
+};
+
 ///
 /// The render base is the main class responsible updating and rendering
 /// each component in the scene.
@@ -36,25 +124,65 @@ public:
     /// Should be invoked repeatedly from a render loop
     void Update(float timeSeconds = 0.1667f);
 
-    void AddSceneObject(SceneObject *sceneObject);
+    /// Add the object and its descendants to the scene. Returns the handle
+    /// of the object
+    SceneObjectHandle AddSceneObject(SceneObject *sceneObject);
+    /// Remove the object from the scene (its descendants are not removed)
     void DeleteSceneObject(SceneObject *sceneObject);
+    void DeleteSceneObject(SceneObjectHandle handle);
+    /// Add the object and all its descendants in one batch
+    SceneObjectHandle AddSubtree(SceneObject *root);
+    /// Remove the object and all its descendants in one batch
+    void RemoveSubtree(SceneObject *root);
+    /// Returns the object of the handle, or NULL if the object has been removed
+    SceneObject *GetSceneObject(SceneObjectHandle handle) const;
     
     void Init(void (*swapBuffersFunc)());
     void Reshape(int width, int height);
     
-    
+    /// When enabled (default) the opaque objects are first rendered front to
+    /// back using a depth-only shader, so the main pass only shades the
+    /// visible fragments. Can be disabled per camera (see
+    /// Camera::SetDepthPrePass())
     void SetDoubleSpeedZOnlyRendering(bool enabled);
     bool GetDoubleSpeedZOnlyRendering();
     
+    /// When enabled (default) objects sharing mesh and material are drawn
+    /// using GPU instancing (if supported by the driver)
+    void SetInstancing(bool enabled) { instancing = enabled; }
+    bool GetInstancing() { return instancing; }
+    /// When enabled (default) objects hidden behind the occluders (see
+    /// MeshComponent::SetOccluder()) are not rendered by the cameras
+    void SetOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+    bool GetOcclusionCulling() { return occlusionCulling; }
+    
     void SetRenderMode(RenderMode renderMode);
     void SetBackfaceCulling(bool enabled);
 
     void PrintDebug();
+    
+    /// Returns the render graph scheduling the cameras
+    RenderGraph *GetRenderGraph() { return &renderGraph; }
+    
+    /// Return the statistics of the last frame. The OpenGL calls of the last
+    /// frame are counted by GLStateCache::GetStats()
+    const RenderStats &GetRenderStats() const { return renderStats; }
 
+    /// Returns the first object added to the scene with the name (or NULL).
+    /// Lookups by name, tag and component type use indices maintained when
+    /// objects are added, removed or renamed, and run in constant time.
 	SceneObject *Find(const char *name) const;
+    /// Returns all objects in the scene with the name
+    const std::vector<SceneObject*> &FindAll(const char *name) const;
+    /// Returns all objects in the scene with the tag
+    const std::vector<SceneObject*> &FindWithTag(const char *tag) const;
+    /// Returns all objects in the scene having a component of the type
+    const std::vector<SceneObject*> &FindWithComponent(ComponentType type) const;
     
+    /// Returns the objects in the scene. Objects are removed by moving the
+    /// last object into the empty position, so the order is not preserved
     std::vector<SceneObject*> *GetSceneObjects() { return &sceneObjects; }
-    std::vector<SceneObject*> *GetCameras() { return &cameras; }
+    std::vector<SceneObject*> *GetCameras() { return &componentIndex[CameraType]; }
     
     ///
     /// Create a shader and store it in the shaders map.
@@ -93,19 +221,114 @@ public:
         return s_instance;
     }
 private:
+    friend class SceneObject;
+    /// Index maintenance (invoked by SceneObject)
+    void NameChanged(SceneObject *sceneObject, int oldNameId);
+    void TagChanged(SceneObject *sceneObject, int oldTagId);
+    void ComponentAdded(SceneObject *sceneObject, Component *component);
+    void ComponentRemoved(SceneObject *sceneObject, Component *component);
+    /// Assign a slot to the object and add it to all lists
+    void Insert(SceneObject *sceneObject);
+    /// Remove the object from all lists and release the slot
+    void Remove(SceneObject *sceneObject);
+    /// Returns true if the object is in the scene
+    bool Contains(SceneObject *sceneObject) const;
+    /// Collect the object and its descendants in subtreeBuffer
+    void CollectSubtree(SceneObject *root);
+    /// Returns the list of the id in the name or tag index
+    static std::vector<SceneObject*> &GetIndexList(std::vector<std::vector<SceneObject*> > &index, int id);
+    void InsertInList(std::vector<SceneObject*> &list, int listIndex, SceneObject *sceneObject);
+    void RemoveFromList(std::vector<SceneObject*> &list, int listIndex, SceneObject *sceneObject);
+    /// Returns the index list of the name (empty if not found)
+    static const std::vector<SceneObject*> &FindInIndex(const std::vector<std::vector<SceneObject*> > &index, const char *name);
+    
+    /// Setup the fixed-function lights (used when uniform buffers are not
+    /// supported)
     inline void SetupLight();
     RenderBase();
-    /// Render all objects in scene
+    /// Render all objects in the render queue
     void RenderScene();
+    /// Render the opaque objects of the render queue to the depth buffer
+    void RenderDepthPrePass();
+    /// Render the visible shadow casters to the depth buffer of a depth
+    /// render-to-texture camera using the depth-only shader
+    void RenderShadowCasters(Camera *camera);
+    /// Add the fragment counts of the previous frame of the camera to the
+    /// render stats
+    void ReadDepthPrePassQueries(DepthPrePassQueries &queries);
+    /// Returns the depth-only shader (loaded on first use)
+    Shader *GetDepthOnlyShader();
+    /// Returns the light pass shader of deferred shading (loaded on first
+    /// use)
+    Shader *GetDeferredLightShader();
+    /// Fill the render queue with the visible objects and sort it. If
+    /// deferred is true, objects with deferred materials are added to the
+    /// G-buffer queue instead
+    void BuildRenderQueue(Camera *camera, bool deferred = false);
+    /// Render the G-buffer queue and the deferred lights
+    void RenderDeferred(Camera *camera);
+    /// Find the ranges of the render queue that can be drawn using GPU
+    /// instancing or multi-draw indirect and fill the instance buffer and the
+    /// draw commands
+    void BuildInstanceRanges();
     /// Update all objects in scene
     void UpdateScene();
+    /// Update the subtree bounds of all root objects in the scene
+    void UpdateBounds();
+    /// Fill visibleObjects with the objects inside the frustum
+    void CullScene(const Frustum &frustum);
+    void CullSceneObject(SceneObject *sceneObject, const Frustum &frustum, bool parentInside);
+    /// Rasterize the visible occluders of the camera and remove the objects
+    /// hidden behind them from visibleObjects
+    void CullOccludedObjects(Camera *camera);
+    /// Select the level of detail of the visible objects with a LODGroup.
+    /// Shadow passes use the shadow level of the objects instead of
+    /// selecting a level
+    void SelectLevelsOfDetail(Camera *camera, bool shadowPass);
+    /// Select the shadow level of all objects with a LODGroup from the main
+    /// camera of the frame (NULL if none)
+    void SelectShadowLevels(Camera *mainCamera);
+    /// Returns true if the object has no parent in the scene
+    bool IsRootObject(SceneObject *sceneObject);
     static RenderBase *s_instance;
     std::vector<SceneObject*> sceneObjects;
-    std::vector<SceneObject*> cameras;
-    std::vector<SceneObject*> lights;
+    /// objects by name id and tag id (see NameTable)
+    std::vector<std::vector<SceneObject*> > nameIndex;
+    std::vector<std::vector<SceneObject*> > tagIndex;
+    /// objects by component type (cameras and lights are found here)
+    std::vector<SceneObject*> componentIndex[COMPONENT_TYPE_COUNT];
+    std::vector<SceneObjectSlot> slots;
+    std::vector<unsigned int> freeSlots;
+    std::vector<SceneObject*> subtreeBuffer;
+    std::vector<SceneObject*> visibleObjects;
+    RenderQueue renderQueue;
+    /// objects rendered to the G-buffer by deferred cameras
+    RenderQueue gbufferQueue;
+    DeferredRenderer deferredRenderer;
+    Shader *deferredLightShader;
+    RenderGraph renderGraph;
+    InstanceBuffer instanceBuffer;
+    /// Camera and light data of the shared shader library (when supported)
+    FrameUniforms frameUniforms;
+    bool uniformBuffers;
+    /// Lights assigned to the clusters of the camera being rendered (when
+    /// supported, see FrameUniforms::IsClusteringSupported())
+    LightClusters lightClusters;
+    bool clusteredLighting;
+    OcclusionCuller occlusionCuller;
+    bool occlusionCulling;
+    std::vector<InstanceRange> instanceRanges;
+    std::vector<DrawElementsIndirectCommand> drawCommands;
+    bool instancing;
+    /// Components updated on the job system (rebuilt each frame)
+    std::vector<Component*> parallelComponents;
+    RenderStats renderStats;
     std::map<std::string,Shader*> shaders; 
     void (*swapBuffersFunc)();
     bool doubleSpeedZOnlyRendering;
+    Shader *depthOnlyShader;
+    /// opaque render queue items ordered front to back
+    std::vector<int> depthPrePassOrder;
     int width;
     int height;
     ShaderDataSource *shaderDataSource;
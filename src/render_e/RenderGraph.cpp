@@ -0,0 +1,214 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "RenderGraph.h"
+
+#include <cassert>
+#include <algorithm>
+#include <GL/glew.h>
+
+#include "SceneObject.h"
+#include "Camera.h"
+#include "Material.h"
+#include "Log.h"
+#include "math/Frustum.h"
+
+namespace render_e {
+
+RenderGraph::RenderGraph()
+:cycle(false) {
+}
+
+RenderGraph::~RenderGraph(){
+    for (std::vector<TransientDepthBuffer>::iterator iter = depthBuffers.begin();iter != depthBuffers.end();iter++){
+        glDeleteRenderbuffers(1, &iter->renderBufferId);
+    }
+}
+
+void RenderGraph::Build(const std::vector<SceneObject*> &cameras, const std::vector<SceneObject*> &materials){
+    passes.resize(cameras.size());
+    bool hasScreenPass = false;
+    for (unsigned int i=0;i<cameras.size();i++){
+        RenderGraphPass &pass = passes[i];
+        pass.camera = cameras[i]->GetCamera();
+        pass.output = pass.camera->GetRenderTextureId();
+        pass.dependencies.clear();
+        pass.live = false;
+        if (pass.output == 0){
+            hasScreenPass = true;
+        }
+    }
+
+    // the producers used by the material of each rendered object
+    inputBounds.clear();
+    inputOffsets.clear();
+    inputProducers.clear();
+    for (std::vector<SceneObject*>::const_iterator iter = materials.begin();iter != materials.end();iter++){
+        if ((*iter)->GetMesh() == NULL){
+            continue;
+        }
+        textureIds.clear();
+        shadowCameras.clear();
+        (*iter)->GetMaterial()->GetDependencies(textureIds, shadowCameras);
+        int offset = inputProducers.size();
+        for (unsigned int i=0;i<textureIds.size();i++){
+            int producer = FindProducer(textureIds[i]);
+            if (producer != -1){
+                inputProducers.push_back(producer);
+            }
+        }
+        for (unsigned int i=0;i<shadowCameras.size();i++){
+            int producer = FindPass(shadowCameras[i]);
+            if (producer != -1){
+                inputProducers.push_back(producer);
+            }
+        }
+        if (static_cast<int>(inputProducers.size()) > offset){
+            inputBounds.push_back((*iter)->GetWorldBounds());
+            inputOffsets.push_back(offset);
+        }
+    }
+    inputOffsets.push_back(inputProducers.size());
+
+    // a camera binding materials consumes the producers of the objects
+    // inside its frustum (a camera sampling its own output reads the
+    // previous frame)
+    for (unsigned int i=0;i<passes.size();i++){
+        if (passes[i].camera->IsDepthOnly() || inputBounds.empty()){
+            continue;
+        }
+        Camera *camera = passes[i].camera;
+        Frustum frustum;
+        frustum.SetFromMatrix(camera->GetProjectionMatrix()*camera->GetViewMatrix());
+        std::vector<int> &dependencies = passes[i].dependencies;
+        for (unsigned int j=0;j<inputBounds.size();j++){
+            if (frustum.Test(inputBounds[j]) == FRUSTUM_OUTSIDE){
+                continue;
+            }
+            for (int k=inputOffsets[j];k<inputOffsets[j+1];k++){
+                if (inputProducers[k] != (int)i){
+                    dependencies.push_back(inputProducers[k]);
+                }
+            }
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    }
+
+    for (unsigned int i=0;i<passes.size();i++){
+        // without a screen camera there is no consumer to start from
+        if (passes[i].output == 0 || !hasScreenPass){
+            MarkLive(i);
+        }
+    }
+
+    // topological sort keeping the camera order among independent passes
+    pendingDependencies.resize(passes.size());
+    int remaining = 0;
+    for (unsigned int i=0;i<passes.size();i++){
+        pendingDependencies[i] = passes[i].live ? passes[i].dependencies.size() : -1;
+        if (passes[i].live){
+            remaining++;
+        }
+    }
+    schedule.clear();
+    bool hadCycle = cycle;
+    cycle = false;
+    while (remaining > 0){
+        int next = -1;
+        for (unsigned int i=0;i<passes.size() && next == -1;i++){
+            if (pendingDependencies[i] == 0){
+                next = i;
+            }
+        }
+        if (next == -1){
+            // break the cycle at the first remaining pass
+            cycle = true;
+            for (unsigned int i=0;i<passes.size() && next == -1;i++){
+                if (pendingDependencies[i] > 0){
+                    next = i;
+                }
+            }
+        }
+        assert(next != -1);
+        schedule.push_back(next);
+        pendingDependencies[next] = -1;
+        remaining--;
+        for (unsigned int i=0;i<passes.size();i++){
+            if (pendingDependencies[i] <= 0){
+                continue;
+            }
+            const std::vector<int> &dependencies = passes[i].dependencies;
+            pendingDependencies[i] -= std::count(dependencies.begin(), dependencies.end(), next);
+        }
+    }
+    if (cycle && !hadCycle){
+        WARN("Render graph: cameras depend on each other's textures. Some cameras use the textures of the previous frame.");
+    }
+}
+
+int RenderGraph::FindProducer(unsigned int textureId) const{
+    for (unsigned int i=0;i<passes.size();i++){
+        if (passes[i].output == textureId){
+            return i;
+        }
+    }
+    return -1;
+}
+
+int RenderGraph::FindPass(Camera *camera) const{
+    for (unsigned int i=0;i<passes.size();i++){
+        if (passes[i].camera == camera){
+            return i;
+        }
+    }
+    return -1;
+}
+
+void RenderGraph::MarkLive(int index){
+    if (passes[index].live){
+        return;
+    }
+    passes[index].live = true;
+    const std::vector<int> &dependencies = passes[index].dependencies;
+    for (unsigned int i=0;i<dependencies.size();i++){
+        MarkLive(dependencies[i]);
+    }
+}
+
+unsigned int RenderGraph::AcquireDepthBuffer(int width, int height){
+    for (std::vector<TransientDepthBuffer>::iterator iter = depthBuffers.begin();iter != depthBuffers.end();iter++){
+        if (iter->width == width && iter->height == height){
+            iter->usageCount++;
+            return iter->renderBufferId;
+        }
+    }
+    TransientDepthBuffer depthBuffer;
+    glGenRenderbuffers(1, &depthBuffer.renderBufferId);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer.renderBufferId);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    depthBuffer.width = width;
+    depthBuffer.height = height;
+    depthBuffer.usageCount = 1;
+    depthBuffers.push_back(depthBuffer);
+    return depthBuffer.renderBufferId;
+}
+
+void RenderGraph::ReleaseDepthBuffer(unsigned int renderBufferId){
+    for (std::vector<TransientDepthBuffer>::iterator iter = depthBuffers.begin();iter != depthBuffers.end();iter++){
+        if (iter->renderBufferId != renderBufferId){
+            continue;
+        }
+        iter->usageCount--;
+        if (iter->usageCount == 0){
+            glDeleteRenderbuffers(1, &iter->renderBufferId);
+            depthBuffers.erase(iter);
+        }
+        return;
+    }
+}
+}
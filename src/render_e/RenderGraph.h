@@ -0,0 +1,110 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_RENDERGRAPH_H
+#define	RENDER_E_RENDERGRAPH_H
+
+#include <vector>
+
+#include "math/Bounds.h"
+
+namespace render_e {
+
+// forward declaration
+class SceneObject;
+class Camera;
+
+///
+/// Node of the render graph: a camera rendering the scene to the screen or
+/// to a texture
+///
+struct RenderGraphPass {
+    Camera *camera;
+    /// OpenGL name of the texture written by the pass (0 for the screen)
+    unsigned int output;
+    /// Passes producing textures or shadow setups used by this pass
+    std::vector<int> dependencies;
+    /// true if the output is used by a pass rendering to the screen
+    bool live;
+};
+
+/// Render target shared by passes (see RenderGraph::AcquireDepthBuffer())
+struct TransientDepthBuffer {
+    unsigned int renderBufferId;
+    int width;
+    int height;
+    int usageCount;
+};
+
+///
+/// Schedules the cameras of a frame. Each camera is a pass; a pass depends on
+/// the cameras rendering to the textures sampled by the materials of the
+/// objects inside its frustum and on the cameras of their shadow setups (see
+/// Material::GetDependencies()). Passes are topologically sorted, so
+/// producers run before consumers, and passes whose output is not used
+/// (directly or indirectly) by a camera rendering to the screen are skipped.
+/// Depth buffers of render-to-texture cameras are only used while the camera
+/// renders, so cameras with the same size share one depth buffer (see
+/// Camera::SetRenderToTexture()).
+///
+class RenderGraph {
+public:
+    RenderGraph();
+    ~RenderGraph();
+
+    /// Rebuild the graph from the cameras and the objects with materials in
+    /// the scene. The world bounds of the objects must be up to date
+    void Build(const std::vector<SceneObject*> &cameras, const std::vector<SceneObject*> &materials);
+
+    /// Returns the live passes in execution order
+    const std::vector<int> &GetSchedule() const { return schedule; }
+    const RenderGraphPass &GetPass(int index) const { return passes[index]; }
+    int GetPassCount() const { return static_cast<int>(passes.size()); }
+    /// Number of passes skipped since their output is not used
+    int GetSkippedPassCount() const { return static_cast<int>(passes.size()-schedule.size()); }
+    /// Returns true if the dependencies contained a cycle (the passes of the
+    /// cycle are scheduled in the order of the cameras)
+    bool HasCycle() const { return cycle; }
+
+    /// Returns a depth render buffer of the size shared with other
+    /// render-to-texture cameras (created if needed)
+    unsigned int AcquireDepthBuffer(int width, int height);
+    /// Release a render buffer returned by AcquireDepthBuffer(). The buffer
+    /// is deleted when no longer used
+    void ReleaseDepthBuffer(unsigned int renderBufferId);
+    /// Number of depth buffers used by the render-to-texture cameras (the
+    /// number of buffers without sharing is the sum of the usage counts)
+    int GetDepthBufferCount() const { return static_cast<int>(depthBuffers.size()); }
+private:
+    RenderGraph(const RenderGraph& orig); // disallow copy constructor
+    RenderGraph& operator = (const RenderGraph&); // disallow copy constructor
+
+    /// Returns the index of the pass writing the texture (or -1)
+    int FindProducer(unsigned int textureId) const;
+    int FindPass(Camera *camera) const;
+    /// Mark the pass and the passes it depends on as live
+    void MarkLive(int index);
+
+    std::vector<RenderGraphPass> passes;
+    std::vector<int> schedule;
+    bool cycle;
+    /// textures and shadow setup cameras used by a material
+    std::vector<unsigned int> textureIds;
+    std::vector<Camera*> shadowCameras;
+    /// world bounds of the objects using producers. The producers of object i
+    /// are inputProducers[inputOffsets[i]] to inputProducers[inputOffsets[i+1]-1]
+    std::vector<Bounds> inputBounds;
+    std::vector<int> inputOffsets;
+    std::vector<int> inputProducers;
+    /// number of unscheduled dependencies by pass (used while sorting)
+    std::vector<int> pendingDependencies;
+    std::vector<TransientDepthBuffer> depthBuffers;
+};
+}
+
+#endif	/* RENDER_E_RENDERGRAPH_H */
+
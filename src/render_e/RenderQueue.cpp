@@ -0,0 +1,188 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "RenderQueue.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "SceneObject.h"
+#include "Material.h"
+#include "MeshComponent.h"
+
+namespace render_e {
+
+namespace {
+const int PASS_BITS = 2;
+const int PROGRAM_BITS = 10;
+const int MATERIAL_BITS = 12;
+const int TEXTURE_BITS = 10;
+const int MESH_BITS = 14;
+const int DEPTH_BITS = 16;
+/// Number of bits used by program, material, texture and mesh
+const int STATE_BITS = PROGRAM_BITS+MATERIAL_BITS+TEXTURE_BITS+MESH_BITS;
+
+inline RenderKey Field(unsigned int value, int bits){
+    return static_cast<RenderKey>(value & ((1u<<bits)-1));
+}
+
+/// Returns the state part of the key (program, material, texture and mesh)
+inline RenderKey GetState(RenderKey key){
+    RenderPass pass = static_cast<RenderPass>(key>>(64-PASS_BITS));
+    if (pass == RENDER_PASS_BLENDED){
+        return key & ((static_cast<RenderKey>(1)<<STATE_BITS)-1);
+    }
+    return (key>>DEPTH_BITS) & ((static_cast<RenderKey>(1)<<STATE_BITS)-1);
+}
+}
+
+RenderQueue::RenderQueue(){
+}
+
+void RenderQueue::Clear(){
+    items.clear();
+}
+
+RenderKey RenderQueue::CreateKey(RenderPass pass, unsigned int programId, unsigned int materialId,
+        unsigned int textureId, unsigned int meshId, float depth){
+    if (depth < 0.0f){
+        depth = 0.0f;
+    } else if (depth > 1.0f){
+        depth = 1.0f;
+    }
+    unsigned int quantizedDepth = static_cast<unsigned int>(depth*((1<<DEPTH_BITS)-1));
+    RenderKey state = Field(programId, PROGRAM_BITS);
+    state = (state<<MATERIAL_BITS) | Field(materialId, MATERIAL_BITS);
+    state = (state<<TEXTURE_BITS) | Field(textureId, TEXTURE_BITS);
+    state = (state<<MESH_BITS) | Field(meshId, MESH_BITS);
+    RenderKey key = static_cast<RenderKey>(pass)<<(64-PASS_BITS);
+    if (pass == RENDER_PASS_BLENDED){
+        // back to front: far objects must have the lowest keys
+        quantizedDepth = ((1<<DEPTH_BITS)-1)-quantizedDepth;
+        key |= static_cast<RenderKey>(quantizedDepth)<<STATE_BITS;
+        key |= state;
+    } else {
+        key |= state<<DEPTH_BITS;
+        key |= quantizedDepth;
+    }
+    return key;
+}
+
+void RenderQueue::Add(SceneObject *sceneObject, float viewDepth, float farPlane){
+    Material *material = sceneObject->GetMaterial();
+    MeshComponent *mesh = sceneObject->GetMesh();
+    assert(mesh != NULL);
+    float depth = farPlane>0?viewDepth/farPlane:0;
+    RenderQueueItem item;
+    if (material == NULL){
+        item.key = CreateKey(RENDER_PASS_OPAQUE, 0, 0, 0, mesh->GetSortId(), depth);
+    } else {
+        item.key = CreateKey(material->IsBlended()?RENDER_PASS_BLENDED:RENDER_PASS_OPAQUE,
+                material->GetShader()->GetProgramId(),
+                material->GetSource()->GetMaterialId(),
+                material->GetFirstTextureId(),
+                mesh->GetSortId(),
+                depth);
+    }
+    item.sceneObject = sceneObject;
+    items.push_back(item);
+}
+
+void RenderQueue::AddDepthOnly(SceneObject *sceneObject, float viewDepth, float farPlane){
+    MeshComponent *mesh = sceneObject->GetMesh();
+    assert(mesh != NULL);
+    float depth = farPlane>0?viewDepth/farPlane:0;
+    RenderQueueItem item;
+    item.key = CreateKey(RENDER_PASS_OPAQUE, 0, 0, 0, mesh->GetSortId(), depth);
+    item.sceneObject = sceneObject;
+    items.push_back(item);
+}
+
+void RenderQueue::Sort(){
+    int count = items.size();
+    if (count < 2){
+        return;
+    }
+    sortBuffer.resize(count);
+    RenderQueueItem *src = &items[0];
+    RenderQueueItem *dest = &sortBuffer[0];
+    // least significant digit radix sort with 8 bit digits. A pass is skipped
+    // when all keys have the same digit (common for the unused high bits).
+    for (int shift=0;shift<64;shift+=8){
+        int histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (int i=0;i<count;i++){
+            histogram[(src[i].key>>shift) & 0xff]++;
+        }
+        if (histogram[(src[0].key>>shift) & 0xff] == count){
+            continue;
+        }
+        int offset = 0;
+        for (int i=0;i<256;i++){
+            int c = histogram[i];
+            histogram[i] = offset;
+            offset += c;
+        }
+        for (int i=0;i<count;i++){
+            dest[histogram[(src[i].key>>shift) & 0xff]++] = src[i];
+        }
+        RenderQueueItem *tmp = src;
+        src = dest;
+        dest = tmp;
+    }
+    if (src != &items[0]){
+        items.swap(sortBuffer);
+    }
+}
+
+void RenderQueue::GetOpaqueFrontToBack(std::vector<int> &outIndices) const{
+    // sort (depth, index) pairs packed in one key
+    std::vector<RenderKey> depthKeys;
+    for (unsigned int i=0;i<items.size();i++){
+        RenderKey key = items[i].key;
+        if (static_cast<RenderPass>(key>>(64-PASS_BITS)) != RENDER_PASS_OPAQUE){
+            continue;
+        }
+        RenderKey depth = key & ((1<<DEPTH_BITS)-1);
+        depthKeys.push_back((depth<<32) | i);
+    }
+    std::sort(depthKeys.begin(), depthKeys.end());
+    outIndices.resize(depthKeys.size());
+    for (unsigned int i=0;i<depthKeys.size();i++){
+        outIndices[i] = static_cast<int>(depthKeys[i] & 0xffffffff);
+    }
+}
+
+int RenderQueue::CountStateChanges() const{
+    int changes = 0;
+    RenderKey lastState = 0;
+    for (unsigned int i=0;i<items.size();i++){
+        RenderKey state = GetState(items[i].key);
+        if (i==0){
+            changes += 4;
+        } else if (state != lastState){
+            // count each field that differs
+            RenderKey diff = state ^ lastState;
+            if (diff>>(STATE_BITS-PROGRAM_BITS)){
+                changes++;
+            }
+            if ((diff>>(TEXTURE_BITS+MESH_BITS)) & ((1<<MATERIAL_BITS)-1)){
+                changes++;
+            }
+            if ((diff>>MESH_BITS) & ((1<<TEXTURE_BITS)-1)){
+                changes++;
+            }
+            if (diff & ((1<<MESH_BITS)-1)){
+                changes++;
+            }
+        }
+        lastState = state;
+    }
+    return changes;
+}
+}
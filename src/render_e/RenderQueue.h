@@ -0,0 +1,85 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_RENDERQUEUE_H
+#define	RENDER_E_RENDERQUEUE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace render_e {
+
+// forward declaration
+class SceneObject;
+
+/// 64 bit sort key of a draw call
+typedef unsigned long long RenderKey;
+
+enum RenderPass {
+    RENDER_PASS_OPAQUE = 0,
+    RENDER_PASS_BLENDED = 1
+};
+
+struct RenderQueueItem {
+    RenderKey key;
+    SceneObject *sceneObject;
+};
+
+///
+/// Queue of draw calls sorted by a packed 64 bit key. The key layout (from
+/// the most significant bit) is:
+///
+///   opaque:  pass(2) program(10) material(12) texture(10) mesh(14) depth(16)
+///   blended: pass(2) depth(16) program(10) material(12) texture(10) mesh(14)
+///
+/// Opaque draws are grouped by state and sorted front to back within the
+/// same state. Blended draws are sorted back to front (depth is inverted),
+/// since the order is required for correct blending. The material field is
+/// the id of the source material, so instances of the same material (see
+/// Material::Instance()) are adjacent and can be drawn using GPU instancing
+/// (see InstanceBuffer). The mesh field is the sort id of the mesh, which
+/// keeps meshes of the same geometry heap page adjacent. Ids wider than their
+/// field are truncated, which only affects the grouping, never correctness.
+///
+class RenderQueue {
+public:
+    RenderQueue();
+
+    void Clear();
+    /// Add the scene object (which must have a mesh).
+    /// viewDepth is the distance along the view direction and farPlane the
+    /// distance used to quantize the depth.
+    void Add(SceneObject *sceneObject, float viewDepth, float farPlane);
+    /// Add the scene object to a depth-only pass. No material is bound, so
+    /// the key only contains the mesh (objects sharing a mesh are adjacent
+    /// and sorted front to back)
+    void AddDepthOnly(SceneObject *sceneObject, float viewDepth, float farPlane);
+    /// Sort the queue using a radix sort on the keys
+    void Sort();
+
+    int GetSize() const { return static_cast<int>(items.size()); }
+    const RenderQueueItem &GetItem(int index) const { return items[index]; }
+
+    /// Fill outIndices with the indices of the opaque items ordered front to
+    /// back (used by the depth pre-pass, where state changes are cheap)
+    void GetOpaqueFrontToBack(std::vector<int> &outIndices) const;
+
+    /// Returns the number of program, material, texture and mesh changes
+    /// needed to render the items in the current order
+    int CountStateChanges() const;
+
+    /// Packs the key of a draw call
+    static RenderKey CreateKey(RenderPass pass, unsigned int programId, unsigned int materialId,
+            unsigned int textureId, unsigned int meshId, float depth);
+private:
+    std::vector<RenderQueueItem> items;
+    std::vector<RenderQueueItem> sortBuffer;
+};
+}
+
+#endif	/* RENDER_E_RENDERQUEUE_H */
+
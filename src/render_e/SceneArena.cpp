@@ -0,0 +1,66 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "SceneArena.h"
+
+#include <cassert>
+#include <cstdlib>
+
+namespace render_e {
+
+SceneArena::SceneArena(size_t blockSize)
+:blockSize(blockSize), blockUsed(0), blockCapacity(0), bytesAllocated(0) {
+}
+
+SceneArena::~SceneArena(){
+    Release();
+}
+
+void *SceneArena::Allocate(size_t size, size_t alignment){
+    assert(alignment > 0 && (alignment & (alignment-1)) == 0);
+    size_t offset = 0;
+    if (!blocks.empty()){
+        size_t address = reinterpret_cast<size_t>(blocks.back())+blockUsed;
+        offset = blockUsed + ((alignment - (address & (alignment-1))) & (alignment-1));
+    }
+    if (blocks.empty() || offset+size > blockCapacity){
+        // large allocations get a block of their own
+        blockCapacity = size+alignment > blockSize ? size+alignment : blockSize;
+        char *block = static_cast<char*>(malloc(blockCapacity));
+        if (block == NULL){
+            throw std::bad_alloc();
+        }
+        blocks.push_back(block);
+        size_t address = reinterpret_cast<size_t>(block);
+        offset = (alignment - (address & (alignment-1))) & (alignment-1);
+    }
+    blockUsed = offset+size;
+    bytesAllocated += size;
+    return blocks.back()+offset;
+}
+
+void SceneArena::AddDestructor(void *object, void (*function)(void *)){
+    Destructor destructor;
+    destructor.function = function;
+    destructor.object = object;
+    destructors.push_back(destructor);
+}
+
+void SceneArena::Release(){
+    for (std::vector<Destructor>::reverse_iterator iter = destructors.rbegin();iter != destructors.rend();iter++){
+        iter->function(iter->object);
+    }
+    destructors.clear();
+    for (unsigned int i=0;i<blocks.size();i++){
+        free(blocks[i]);
+    }
+    blocks.clear();
+    blockUsed = 0;
+    blockCapacity = 0;
+    bytesAllocated = 0;
+}
+}
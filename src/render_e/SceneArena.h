@@ -0,0 +1,89 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_SCENEARENA_H
+#define	RENDER_E_SCENEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace render_e {
+
+///
+/// Arena that a scene can be allocated from and freed all at once (see
+/// SceneXMLParser::LoadScene). Objects are constructed in large blocks of
+/// memory using Create() and are destroyed in reverse order of creation by
+/// Release(). Heap allocated objects may be handed over using Adopt(), in
+/// which case they are deleted by Release().
+/// Objects created in the arena must not be deleted, and must be removed
+/// from the render base before the arena is released.
+///
+class SceneArena {
+public:
+    explicit SceneArena(size_t blockSize = 64*1024);
+    /// Releases the arena
+    ~SceneArena();
+
+    /// Allocate raw memory (released by Release())
+    void *Allocate(size_t size, size_t alignment = 16);
+
+    template <class T>
+    T *Create(){
+        T *object = new (Allocate(sizeof(T))) T();
+        AddDestructor(object, &Destroy<T>);
+        return object;
+    }
+    template <class T, class A1>
+    T *Create(A1 a1){
+        T *object = new (Allocate(sizeof(T))) T(a1);
+        AddDestructor(object, &Destroy<T>);
+        return object;
+    }
+    /// Take ownership of a heap allocated object
+    template <class T>
+    T *Adopt(T *object){
+        AddDestructor(object, &Delete<T>);
+        return object;
+    }
+
+    /// Destroy all objects and free the memory
+    void Release();
+
+    /// Number of bytes allocated from the arena
+    size_t GetBytesAllocated() const { return bytesAllocated; }
+    int GetBlockCount() const { return static_cast<int>(blocks.size()); }
+    /// Number of objects created or adopted
+    int GetObjectCount() const { return static_cast<int>(destructors.size()); }
+private:
+    SceneArena(const SceneArena& orig); // disallow copy constructor
+    SceneArena& operator = (const SceneArena&); // disallow copy constructor
+
+    template <class T>
+    static void Destroy(void *object){ static_cast<T*>(object)->~T(); }
+    template <class T>
+    static void Delete(void *object){ delete static_cast<T*>(object); }
+
+    struct Destructor {
+        void (*function)(void *);
+        void *object;
+    };
+    void AddDestructor(void *object, void (*function)(void *));
+
+    size_t blockSize;
+    std::vector<char*> blocks;
+    /// Bytes used of the last block
+    size_t blockUsed;
+    /// Size of the last block
+    size_t blockCapacity;
+    size_t bytesAllocated;
+    std::vector<Destructor> destructors;
+};
+}
+
+#endif	/* RENDER_E_SCENEARENA_H */
+
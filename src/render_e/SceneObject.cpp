@@ -11,14 +11,21 @@
 #include <GL/glew.h>
 
 #include "Camera.h"
+#include "LODGroup.h"
 #include "Transform.h"
+#include "NameTable.h"
+#include "RenderBase.h"
 
 namespace render_e {
 
 SceneObject::SceneObject()
-:camera(NULL),mesh(NULL),material(NULL),light(NULL) {
+:camera(NULL),mesh(NULL),material(NULL),renderBase(NULL),light(NULL),lodGroup(NULL),
+        subtreeMeshCount(0),boundsDirty(true),boundsVersion(0),
+        nameId(NameTable::EMPTY_NAME),tagId(NameTable::EMPTY_NAME) {
 	transform = new Transform();
 	transform->SetOwner(this);
+    handle.index = 0;
+    handle.generation = 0; // slot generations start at 1
 }
 
 SceneObject::~SceneObject() {
@@ -45,11 +52,48 @@ Material *SceneObject::GetMaterial(){
 Light *SceneObject::GetLight(){
     return light;
 }
+
+LODGroup *SceneObject::GetLODGroup(){
+    return lodGroup;
+}
     
 const std::vector<Component*> * SceneObject::GetComponents() const{
     return &components;
 }
 
+void SceneObject::SetName(std::string name){
+    int oldNameId = nameId;
+    nameId = NameTable::Instance()->Intern(name);
+    if (renderBase != NULL && oldNameId != nameId){
+        renderBase->NameChanged(this, oldNameId);
+    }
+}
+
+const std::string &SceneObject::GetName() const{
+    return NameTable::Instance()->GetName(nameId);
+}
+
+void SceneObject::SetTag(std::string tag){
+    int oldTagId = tagId;
+    tagId = NameTable::Instance()->Intern(tag);
+    if (renderBase != NULL && oldTagId != tagId){
+        renderBase->TagChanged(this, oldTagId);
+    }
+}
+
+const std::string &SceneObject::GetTag() const{
+    return NameTable::Instance()->GetName(tagId);
+}
+
+bool SceneObject::HasComponent(ComponentType type) const{
+    for (std::vector<Component*>::const_iterator iter = components.begin();iter != components.end();iter++){
+        if ((*iter)->GetComponentType() == type){
+            return true;
+        }
+    }
+    return false;
+}
+
 void SceneObject::RemoveComponent(Component* component){
     std::vector<Component*>::iterator iter = find(components.begin(), components.end(), component);
     if (iter != components.end()){
@@ -61,6 +105,7 @@ void SceneObject::RemoveComponent(Component* component){
                 break;
             case MeshType:
                 mesh = NULL;
+                boundsDirty = true;
                 break;
             case CameraType:
                 camera = NULL;
@@ -71,6 +116,15 @@ void SceneObject::RemoveComponent(Component* component){
             case LightComponentType:
                 light = NULL;
                 break;
+            case LODGroupType:
+                lodGroup = NULL;
+                if (mesh != NULL){
+                    mesh->SetLODAsset(NULL);
+                }
+                break;
+        }
+        if (renderBase != NULL){
+            renderBase->ComponentRemoved(this, component);
         }
     }
 }
@@ -85,6 +139,7 @@ void SceneObject::AddCompnent(Component* component){
         case MeshType:
             assert(mesh==NULL);
             mesh = static_cast<MeshComponent*>(component);
+            boundsDirty = true;
             break;
         case CameraType:
             assert(camera==NULL);
@@ -98,12 +153,47 @@ void SceneObject::AddCompnent(Component* component){
             assert(light==NULL);
             light = static_cast<Light*>(component);
             break;
+        case LODGroupType:
+            assert(lodGroup==NULL);
+            lodGroup = static_cast<LODGroup*>(component);
+            break;
     }
     components.push_back(component);
     component->SetOwner(this);
+    if (renderBase != NULL){
+        renderBase->ComponentAdded(this, component);
+    }
 }
 
 void SceneObject::AddChild(SceneObject *sceneObject){
     this->transform->AddChild(sceneObject->transform);
 }
+
+const Bounds &SceneObject::GetWorldBounds(){
+    unsigned int version = transform->GetGlobalVersion();
+    if (boundsDirty || version != boundsVersion){
+        if (mesh != NULL){
+            worldBounds = mesh->GetBounds().TransformBounds(transform->GetGlobalTransform());
+        } else {
+            worldBounds = Bounds();
+        }
+        boundsDirty = false;
+        boundsVersion = version;
+    }
+    return worldBounds;
+}
+
+void SceneObject::UpdateSubtreeBounds(){
+    subtreeBounds = GetWorldBounds();
+    subtreeMeshCount = mesh!=NULL?1:0;
+    const std::vector<Transform*> *children = transform->GetChildren();
+    for (std::vector<Transform*>::const_iterator iter = children->begin();iter != children->end();iter++){
+        SceneObject *child = (*iter)->GetOwner();
+        if (child != NULL){
+            child->UpdateSubtreeBounds();
+            subtreeBounds.Encapsulate(child->subtreeBounds);
+            subtreeMeshCount += child->subtreeMeshCount;
+        }
+    }
+}
 }
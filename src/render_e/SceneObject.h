@@ -9,11 +9,14 @@
 #define	SCENE_OBJECT_H
 
 #include <vector>
+#include <string>
 #include "Transform.h"
 #include "Component.h"
 #include "MeshComponent.h"
 #include "Material.h"
 #include "Light.h"
+#include "PoolAllocator.h"
+#include "math/Bounds.h"
 
 
 namespace render_e {
@@ -21,8 +24,19 @@ namespace render_e {
 // forward declaration
 class Camera;
 class RenderBase;
+class LODGroup;
 
-class SceneObject {
+///
+/// Generational handle of a scene object added to a RenderBase (see
+/// RenderBase::GetSceneObject()). The handle is invalidated when the object
+/// is removed, and never resolves to another object reusing the same slot.
+///
+struct SceneObjectHandle {
+    unsigned int index;
+    unsigned int generation;
+};
+
+class SceneObject : public PoolAllocated<SceneObject> {
 public:
     SceneObject();
     virtual ~SceneObject();
@@ -34,17 +48,46 @@ public:
     void RemoveComponent(Component* component);
     Material *GetMaterial();
     Light *GetLight();
+    LODGroup *GetLODGroup();
     
     // Delegate call to transform object
     void AddChild(SceneObject *sceneObject);
     
-    void SetName(std::string name) { this->name = name;}
-    std::string GetName() {return name; }
+    /// Set the name. Names are interned (see NameTable) and indexed by the
+    /// render base (see RenderBase::Find)
+    void SetName(std::string name);
+    const std::string &GetName() const;
+    int GetNameId() const { return nameId; }
+    
+    /// Set the tag (used to find groups of objects using RenderBase::FindWithTag)
+    void SetTag(std::string tag);
+    const std::string &GetTag() const;
+    int GetTagId() const { return tagId; }
+    
+    /// Returns true if the object has a component of the type
+    bool HasComponent(ComponentType type) const;
 
 	RenderBase *GetRenderBase() { return renderBase; }
 	void SetRenderBase(RenderBase *renderBase) { this->renderBase = renderBase; }
+    /// Returns the handle of the object (only valid while added to a render base)
+    SceneObjectHandle GetHandle() const { return handle; }
+    
+    /// Returns the world space bounds of the mesh (empty if no mesh is attached)
+    const Bounds &GetWorldBounds();
+    /// Returns the world space bounds of this object and all its descendants.
+    /// Only valid after UpdateSubtreeBounds()
+    const Bounds &GetSubtreeBounds() const { return subtreeBounds; }
+    /// Returns the number of mesh objects in the subtree.
+    /// Only valid after UpdateSubtreeBounds()
+    int GetSubtreeMeshCount() const { return subtreeMeshCount; }
+    /// Recompute the subtree bounds of this object and all its descendants
+    void UpdateSubtreeBounds();
+    /// Invoked when the mesh has changed (transform changes are detected
+    /// automatically)
+    void SetBoundsDirty() { boundsDirty = true; }
 
 private:
+    friend class RenderBase;
     SceneObject(const SceneObject& orig); // disallow copy constructor
     SceneObject& operator = (const SceneObject&); // disallow copy constructor
     
@@ -54,9 +97,18 @@ private:
     Material *material;
 	RenderBase *renderBase;
     Light *light;
+    LODGroup *lodGroup;
     std::vector<Component*> components;
     
-    std::string name;
+    Bounds worldBounds;
+    Bounds subtreeBounds;
+    int subtreeMeshCount;
+    bool boundsDirty;
+    unsigned int boundsVersion; // global version of transform used for worldBounds
+    
+    int nameId;
+    int tagId;
+    SceneObjectHandle handle;
 };
 }
 
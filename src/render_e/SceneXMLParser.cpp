@@ -25,9 +25,11 @@
 #include "Material.h"
 #include "Camera.h"
 #include "FBXLoader.h"
-#include "MeshFactory.h"
+#include "MeshCache.h"
 #include "Light.h"
+#include "LODGroup.h"
 #include "RenderBase.h"
+#include "SceneArena.h"
 #include "Log.h"
 
 // define xerces namespace
@@ -102,6 +104,21 @@ glm::vec2 stringToVector2(const char *s1) {
     return f;
 }
 
+vector<float> stringToFloatList(const char *s1) {
+    static char tmp[512];
+    strncpy (tmp, s1, 512);
+
+    vector<float> f;
+    char * pch;
+    pch = strtok(tmp, ",");
+    while (pch != NULL) {
+        f.push_back((float) atof(pch));
+        pch = strtok(NULL, ",");
+    }
+
+    return f;
+}
+
 enum MyParserState {
     SCENE,
     SHADERS,
@@ -117,7 +134,7 @@ enum MyParserState {
 class MySAXHandler : public HandlerBase {
 public:
 
-    MySAXHandler(RenderBase *renderBase) : renderBase(renderBase), sceneObject(NULL) {
+    MySAXHandler(RenderBase *renderBase, SceneArena *arena) : renderBase(renderBase), sceneObject(NULL), arena(arena) {
     }
     
     void error(const char *tagName){
@@ -289,6 +306,8 @@ public:
         if (stringEqual("material", message)) {
             string matName;
             string shader;
+            bool blended = false;
+            string instanceParameter;
             for (unsigned int i = 0; i < attributes.getLength(); i++) {
                 char *attName = XMLString::transcode(attributes.getName(i));
                 char *attValue = XMLString::transcode(attributes.getValue(i));
@@ -296,6 +315,10 @@ public:
                     matName.append(attValue);
                 } else if (stringEqual("shader", attName)) {
                     shader.append(attValue);
+                } else if (stringEqual("blended", attName)) {
+                    blended = stringEqual("true", attValue);
+                } else if (stringEqual("instanceParameter", attName)) {
+                    instanceParameter.append(attValue);
                 } else {
                     stringstream ss;
                     ss << "Unknown attribute name "<<attName;
@@ -311,8 +334,12 @@ public:
                 ss << "Cannot find shader " << shader;
                 ERROR(ss.str());
             } else {
-                material = new Material(shaderObj);
+                material = arena != NULL ? arena->Create<Material>(shaderObj) : new Material(shaderObj);
                 material->SetName(matName);
+                material->SetBlended(blended);
+                if (instanceParameter.length()>0){
+                    material->SetInstanceParameter(instanceParameter);
+                }
                 materials[matName] = material;
             }
         } else if (stringEqual("parameter", message)) {
@@ -362,6 +389,7 @@ public:
     void parseSceneObjects(const XMLCh * const name, AttributeList& attributes, const char* message) {
         if (stringEqual("object", message)) {
             string objectName;
+            string tag;
             glm::vec3 position;
             glm::vec3 rotation;
             glm::vec3 scale(1,1,1);
@@ -371,6 +399,8 @@ public:
                 char *attValue = XMLString::transcode(attributes.getValue(i));
                 if (stringEqual("name", attName)) {
                     objectName.append(attValue);
+                } else if (stringEqual("tag", attName)) {
+                    tag.append(attValue);
                 } else if (stringEqual("position", attName)) {
                     position = stringToVector3(attValue);
                 } else if (stringEqual("rotation", attName)||stringEqual("rotate", attName)) {
@@ -387,11 +417,12 @@ public:
                 XMLString::release(&attValue);
                 XMLString::release(&attName);
             }
-            sceneObject = new SceneObject();
+            sceneObject = create<SceneObject>();
             sceneObject->GetTransform()->SetPosition(position);
             sceneObject->GetTransform()->SetRotation(rotation);
             sceneObject->GetTransform()->SetScale(scale);
             sceneObject->SetName(objectName);
+            sceneObject->SetTag(tag);
             if (objectName.length() > 0 && parent.length() > 0){
                 parentMap[objectName] = parent;
             }
@@ -402,7 +433,7 @@ public:
     
     void parseComponents(const XMLCh * const name, AttributeList& attributes, const char* message) {
         if (stringEqual("camera", message)) {
-            Camera *cam = new Camera();
+            Camera *cam = create<Camera>();
             bool projection = true;
             float fieldOfView = 40.0f;
             float aspect = 1.0f;
@@ -416,6 +447,8 @@ public:
             CameraBuffer cameraBuffer; // used in renderToTexture
             /*renderToTexture="texture" renderBuffer="COLOR_BUFFER"*/
             glm::vec4 clearColor(0,0,0,1);
+            bool depthPrePass = true;
+            bool deferredShading = false;
             for (unsigned int i = 0; i < attributes.getLength(); i++) {
                 char *attName = XMLString::transcode(attributes.getName(i));
                 char *attValue = XMLString::transcode(attributes.getValue(i));
@@ -468,6 +501,10 @@ public:
                     farPlane = stringToFloat(attValue);
                 } else if (stringEqual("clearColor",attName)){
                     clearColor = stringToVector4(attValue);
+                } else if (stringEqual("depthPrePass",attName)){
+                    depthPrePass = stringEqual("true", attValue);
+                } else if (stringEqual("deferredShading",attName)){
+                    deferredShading = stringEqual("true", attValue);
                 } else {
                     stringstream ss;
                     ss << "Unknown camera attribute name "<<attName;
@@ -482,9 +519,12 @@ public:
                 cam->SetOrthographic(left, right, bottom, top, nearPlane,farPlane);
             }
             if (renderToTexture != NULL){
-                cam->SetRenderToTexture(true, cameraBuffer, static_cast<Texture2D*>(renderToTexture));
+                cam->SetRenderToTexture(true, cameraBuffer, static_cast<Texture2D*>(renderToTexture),
+                        renderBase->GetRenderGraph());
             }
             cam->SetClearColor(clearColor);
+            cam->SetDepthPrePass(depthPrePass);
+            cam->SetDeferredShading(deferredShading);
             sceneObject->AddCompnent(cam);
         } else if (stringEqual("material", message)) {
             string ref;
@@ -508,7 +548,7 @@ public:
                     ss << "Cannot find material " << ref;
                     ERROR(ss.str());
                 } else {
-					sceneObject->AddCompnent(iter->second->Instance());
+					sceneObject->AddCompnent(adopt(iter->second->Instance()));
                 }
             } else {
                 WARN("Warn material ref not set");
@@ -517,6 +557,9 @@ public:
             string meshName;
             string primitive;
             string import;
+            bool castShadows = true;
+            bool occluder = false;
+            string occluderProxy;
             for (int i = 0; i < attributes.getLength(); i++) {
                 char *attName = XMLString::transcode(attributes.getName(i));
                 char *attValue = XMLString::transcode(attributes.getValue(i));
@@ -524,6 +567,12 @@ public:
                     primitive.append(attValue);
                 } else if (stringEqual("import", attName)) {
                     import.append(attValue);
+                } else if (stringEqual("castShadows", attName)) {
+                    castShadows = stringEqual("true", attValue);
+                } else if (stringEqual("occluder", attName)) {
+                    occluder = stringEqual("true", attValue);
+                } else if (stringEqual("occluderProxy", attName)) {
+                    occluderProxy.append(attValue);
                 } else {
                     stringstream ss;
                     ss << "Unknown attribute name "<<attName;
@@ -532,41 +581,59 @@ public:
                 XMLString::release(&attValue);
                 XMLString::release(&attName);
             }
-            Mesh *mesh = NULL;
+            // meshes are shared between scene objects using the mesh cache
+            MeshCache *meshCache = MeshCache::Instance();
+            MeshAsset *meshAsset = NULL;
             if (primitive.length() > 0){
-                if (stringEqual("cube", primitive.c_str())){
-                    mesh = MeshFactory::CreateCube();
-                } else if (stringEqual("sphere", primitive.c_str())){
-                    mesh = MeshFactory::CreateICOSphere();
-                } else if (stringEqual("tetrahedron", primitive.c_str())){
-                    mesh = MeshFactory::CreateTetrahedron();
-                } else if (stringEqual("plane", primitive.c_str())){
-                    mesh = MeshFactory::CreatePlane();
-                } else {
+                meshAsset = meshCache->GetPrimitive(primitive);
+                if (meshAsset == NULL){
                     stringstream ss;
                     ss << "Unknown mesh.primitive name "<<primitive.c_str();
                     ERROR(ss.str());
                 }
             } else if (import.length() > 0){
-				MeshComponent *meshC = fbxLoader.LoadMeshComponent(import.c_str());
-				if (meshC != NULL){
-					meshC->SetOwner(NULL);
-					sceneObject->AddCompnent(meshC);
-				} else {
-                    stringstream ss;
-					ss << "Cannot find mesh in "<<import;
-                    ERROR(ss.str());
-				}
+                string key = MeshCache::GetImportKey(import);
+                meshAsset = meshCache->Find(key);
+                if (meshAsset == NULL){
+                    Mesh *mesh = fbxLoader.LoadMesh(import.c_str());
+                    if (mesh != NULL){
+                        meshAsset = meshCache->Add(key, mesh);
+                    } else {
+                        stringstream ss;
+                        ss << "Cannot find mesh in "<<import;
+                        ERROR(ss.str());
+                    }
+                }
             }
-            if (mesh != NULL){
-                assert(mesh->IsValid());
-                MeshComponent *meshComponent = new MeshComponent();
-                meshComponent->SetMesh(mesh);
+            if (meshAsset != NULL){
+                MeshComponent *meshComponent = create<MeshComponent>();
+                meshComponent->SetMeshAsset(meshAsset);
+                meshComponent->SetCastShadows(castShadows);
+                meshComponent->SetOccluder(occluder || occluderProxy.length() > 0);
+                if (occluderProxy.length() > 0){
+                    // the proxy is imported like a mesh (cached meshes keep
+                    // the data needed by the occlusion culling)
+                    string key = MeshCache::GetImportKey(occluderProxy);
+                    MeshAsset *proxyAsset = meshCache->Find(key);
+                    if (proxyAsset == NULL){
+                        Mesh *mesh = fbxLoader.LoadMesh(occluderProxy.c_str());
+                        if (mesh != NULL){
+                            proxyAsset = meshCache->Add(key, mesh);
+                        } else {
+                            stringstream ss;
+                            ss << "Cannot find occluder proxy in "<<occluderProxy;
+                            ERROR(ss.str());
+                        }
+                    }
+                    if (proxyAsset != NULL){
+                        meshComponent->SetOccluderProxy(proxyAsset);
+                    }
+                }
                 sceneObject->AddCompnent(meshComponent);
             }
         } else if (stringEqual("light", message)){
             string lightName;
-            Light *light = new Light();
+            Light *light = create<Light>();
             
             string lightType;
             for (int i = 0; i < attributes.getLength(); i++) {
@@ -616,6 +683,53 @@ public:
             }
             
             sceneObject->AddCompnent(light);
+        } else if (stringEqual("lod", message)){
+            // levels of detail of the mesh (the mesh element must come first)
+            int levels = 3;
+            float reduction = 0.5f;
+            float maxError = 0.05f;
+            vector<float> screenSizes;
+            float hysteresis = 0.1f;
+            int shadowLevelBias = 0;
+            for (int i = 0; i < attributes.getLength(); i++) {
+                char *attName = XMLString::transcode(attributes.getName(i));
+                char *attValue = XMLString::transcode(attributes.getValue(i));
+                if (stringEqual("levels", attName)) {
+                    levels = stringToInt(attValue);
+                } else if (stringEqual("reduction", attName)) {
+                    reduction = stringToFloat(attValue);
+                } else if (stringEqual("maxError", attName)) {
+                    maxError = stringToFloat(attValue);
+                } else if (stringEqual("screenSizes", attName)) {
+                    screenSizes = stringToFloatList(attValue);
+                } else if (stringEqual("hysteresis", attName)) {
+                    hysteresis = stringToFloat(attValue);
+                } else if (stringEqual("shadowLevelBias", attName)) {
+                    shadowLevelBias = stringToInt(attValue);
+                } else {
+                    stringstream ss;
+                    ss << "Unknown lod attribute name "<<attName;
+                    ERROR(ss.str());
+                }
+                XMLString::release(&attValue);
+                XMLString::release(&attName);
+            }
+            MeshComponent *meshComponent = sceneObject->GetMesh();
+            if (meshComponent == NULL || meshComponent->GetBaseMeshAsset() == NULL){
+                ERROR("Cannot create lod without a mesh");
+            } else if (meshComponent->GetBaseMeshAsset()->GetMesh() == NULL){
+                ERROR("Cannot create lod of a mesh not kept on the CPU");
+            } else {
+                LODGroup *lodGroup = create<LODGroup>();
+                lodGroup->Generate(meshComponent->GetBaseMeshAsset(), levels, reduction, maxError);
+                lodGroup->SetHysteresis(hysteresis);
+                lodGroup->SetShadowLevelBias(shadowLevelBias);
+                // screen sizes of level 1, 2, ...
+                for (int i = 0; i < static_cast<int>(screenSizes.size()) && i+1 < lodGroup->GetLevelCount(); i++) {
+                    lodGroup->SetScreenSize(i+1, screenSizes[i]);
+                }
+                sceneObject->AddCompnent(lodGroup);
+            }
         } else {
             error(message);
         }
@@ -698,6 +812,18 @@ public:
         FATAL(ss.str());
         XMLString::release(&message);
     }
+    
+    /// Create the object in the arena (or on the heap if no arena is used)
+    template <class T>
+    T *create() {
+        return arena != NULL ? arena->Create<T>() : new T();
+    }
+    
+    /// Let the arena (if used) own the heap allocated object
+    template <class T>
+    T *adopt(T *object) {
+        return arena != NULL ? arena->Adopt(object) : object;
+    }
 
     SceneObject *sceneObject;
     RenderBase *renderBase;
@@ -707,6 +833,7 @@ public:
     map<string, TextureBase*> textures;
     map<string, Material*> materials;
     map<string, string> parentMap;
+    SceneArena *arena;
 };
 
 SceneXMLParser::SceneXMLParser() {
@@ -728,11 +855,11 @@ SceneXMLParser::~SceneXMLParser() {
     XMLPlatformUtils::Terminate();
 }
 
-void SceneXMLParser::LoadScene(const char* filename, RenderBase *renderBase) {
+void SceneXMLParser::LoadScene(const char* filename, RenderBase *renderBase, SceneArena *arena) {
     SAXParser* parser = new SAXParser();
     parser->setDoNamespaces(true); // optional
 
-    MySAXHandler* docHandler = new MySAXHandler(renderBase);
+    MySAXHandler* docHandler = new MySAXHandler(renderBase, arena);
     ErrorHandler* errHandler = (ErrorHandler*) docHandler;
     parser->setDocumentHandler(docHandler);
     parser->setErrorHandler(errHandler);
@@ -14,6 +14,7 @@ namespace render_e {
 
 // forward declaration
 class RenderBase;
+class SceneArena;
 
 class SceneXMLParser {
 public:
@@ -21,7 +22,11 @@ public:
     
     virtual ~SceneXMLParser();
     
-    void LoadScene(const char* filename, RenderBase *renderBase);
+    /// Load the scene and add the objects to the render base. If an arena is
+    /// given the objects, components and materials are allocated from the
+    /// arena, and the scene is freed by releasing the arena (after removing
+    /// the objects from the render base, see RenderBase::RemoveSubtree)
+    void LoadScene(const char* filename, RenderBase *renderBase, SceneArena *arena = NULL);
 private:
     SceneXMLParser(const SceneXMLParser& orig); // not allowed (no implementation)
 };
@@ -13,18 +13,26 @@
 #include <glm/gtx/euler_angles.hpp>
 
 #include "math/Mathf.h"
+#include "TransformStore.h"
 
 namespace render_e {
 
 Transform::Transform()
-:Component(TransformType),dirtyFlag(false), dirtyFlagInverse(false),
-        dirtyFlagGlobal(false),dirtyFlagGlobalInverse(false),
-        scale(1,1,1),parent(NULL), rotation(glm::quat(0.0f,0.0f,0.0f,0.0f))
+:Component(TransformType),parent(NULL)
 {
+    id = TransformStore::Instance()->Allocate();
 }
 
 Transform::~Transform(void)
-{}
+{
+    while (!children.empty()){
+        RemoveChild(children.back());
+    }
+    if (parent != NULL){
+        parent->RemoveChild(this);
+    }
+    TransformStore::Instance()->Release(id);
+}
 
 Transform *Transform::GetParent(){
     return parent;
@@ -37,13 +45,16 @@ void Transform::SetParent(Transform *parent){
         assert(res); // if not true, then something serious is wrong with parent-child relationship
     }
     // delegate to parent
-    parent->AddChild(this);
+    if (parent != NULL){
+        parent->AddChild(this);
+    }
 }
 
 void Transform::AddChild(Transform *transform){
     assert (transform->parent == NULL);
     transform->parent = this;
     children.push_back(transform);
+    TransformStore::Instance()->SetParent(transform->id, id);
 }
 
 bool Transform::RemoveChild(Transform *transform){
@@ -53,6 +64,7 @@ bool Transform::RemoveChild(Transform *transform){
     if (index != children.end()){
         children.erase (index);
         transform->parent = NULL;
+        TransformStore::Instance()->SetParent(transform->id, -1);
 		return true;
     }
 	return false;
@@ -62,122 +74,61 @@ const std::vector<Transform *> *Transform::GetChildren() const {
     return &children;
 }
 
-void Transform::UpdateIfDirty(){
-    if (dirtyFlag){
-        // update localTransform to translate*scale*rotate
-        localTransform = glm::mat4(
-                glm::vec4(1,0,0,0),
-                glm::vec4(0,1,0,0),
-                glm::vec4(0,0,1,0),
-                glm::vec4(position,1)
-                );
-        localTransform = glm::gtc::matrix_transform::scale(localTransform,scale);
-        localTransform = localTransform * glm::gtc::quaternion::mat4_cast(rotation);
-        dirtyFlag = false;
-    }
-}
-
-void Transform::UpdateInverseIfDirty(){
-    if (dirtyFlagInverse){
-        // update localTransformInverse to rotate^-1*scale^1*translate^-1
-        localTransformInverse = glm::transpose(glm::gtc::quaternion::mat4_cast(rotation));
-        localTransformInverse = glm::gtc::matrix_transform::scale(localTransformInverse,1.0f / scale);
-        localTransformInverse = glm::gtc::matrix_transform::translate(localTransformInverse,-position);
-        dirtyFlagInverse = false;
-    }
-}
-
-void Transform::UpdateGlobalIfDirty(){
-    if (dirtyFlagGlobal){
-        if (parent != NULL) {
-            parent->UpdateGlobalIfDirty();
-            globalTransform = GetLocalTransform()*parent->GetGlobalTransform();
-        }
-        dirtyFlagGlobal = false;
-    }
-}
-
-void Transform::UpdateGlobalInverseIfDirty(){
-    if (dirtyFlagGlobalInverse){
-        if (parent != NULL){
-            parent->UpdateGlobalInverseIfDirty();
-            globalTransformInverse = GetLocalTransformInverse()*parent->GetGlobalTransformInverse();
-        }
-        dirtyFlagGlobalInverse = false;
-    }
-}
-
 glm::mat4 Transform::GetLocalTransform(){
-    UpdateIfDirty();
-    return localTransform;
+    return TransformStore::Instance()->GetLocalMatrix(id);
 }
 
 glm::mat4 Transform::GetLocalTransformInverse(){
-    UpdateInverseIfDirty();
+    // localTransformInverse is rotate^-1*scale^1*translate^-1
+    TransformStore *store = TransformStore::Instance();
+    glm::mat4 localTransformInverse = glm::transpose(glm::gtc::quaternion::mat4_cast(store->GetRotation(id)));
+    localTransformInverse = glm::gtc::matrix_transform::scale(localTransformInverse,1.0f / store->GetScale(id));
+    localTransformInverse = glm::gtc::matrix_transform::translate(localTransformInverse,-store->GetPosition(id));
     return localTransformInverse;
 }
 
 glm::mat4 Transform::GetGlobalTransform(){
-    if (parent==NULL){
-        return GetLocalTransform();
-    }
-    UpdateGlobalIfDirty();
-    return globalTransform;
+    return TransformStore::Instance()->GetWorldMatrix(id);
 }
 
 glm::mat4 Transform::GetGlobalTransformInverse(){
     if (parent==NULL){
         return GetLocalTransformInverse();
     }
-    UpdateGlobalInverseIfDirty();
-    return globalTransformInverse;
+    return GetLocalTransformInverse()*parent->GetGlobalTransformInverse();
+}
+
+unsigned int Transform::GetGlobalVersion() const{
+    return TransformStore::Instance()->GetWorldVersion(id);
 }
-    
 
 glm::vec3 Transform::GetPosition() const {
-    return position;
+    return TransformStore::Instance()->GetPosition(id);
 }
 
 glm::quat Transform::GetRotation() const {
-    return rotation;
+    return TransformStore::Instance()->GetRotation(id);
 }
 
 glm::vec3  Transform::GetScale() const{
-    return scale;
-}
-
-void Transform::SetGlobalDirtyFlag(){
-    dirtyFlagGlobal = true;
-    dirtyFlagGlobalInverse = true;
-    std::vector<Transform *>::iterator iter = children.begin();
-    for (;iter != children.end();iter++){
-        (*iter)->SetGlobalDirtyFlag();
-    }
-}
-
-void Transform::SetLocalDirty(){
-    dirtyFlag = true;
-    dirtyFlagInverse = true;
-    SetGlobalDirtyFlag();
+    return TransformStore::Instance()->GetScale(id);
 }
 
 void Transform::SetPosition(const glm::vec3 &newPosition) {
-    position = newPosition;
-    SetLocalDirty();
+    TransformStore::Instance()->SetPosition(id, newPosition);
 }
 
 void Transform::SetRotation(const glm::quat &quaternion) {
-    this->rotation = quaternion;
-    SetLocalDirty();
+    TransformStore::Instance()->SetRotation(id, quaternion);
 }
 
 void Transform::SetRotation(const glm::vec3 &euler){
-    Mathf::SetFromEuler(euler[0], euler[1], euler[2], this->rotation);
-    SetLocalDirty();
+    glm::quat rotation;
+    Mathf::SetFromEuler(euler[0], euler[1], euler[2], rotation);
+    TransformStore::Instance()->SetRotation(id, rotation);
 }
 
 void Transform::SetScale(const glm::vec3 &scale){
-    this->scale = scale;
-    SetLocalDirty();
+    TransformStore::Instance()->SetScale(id, scale);
 }
 }
@@ -13,6 +13,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include "Component.h"
+#include "PoolAllocator.h"
 
 namespace render_e {
 
@@ -20,10 +21,17 @@ namespace render_e {
 /// It both contains the local transform and the global transform (where parents 
 /// are taken into account).
 /// This way Transform objects also is used to keep a transforms-hierarchy.
-class Transform : public Component {
+/// The actual data is kept in the TransformStore; the Transform is a handle to
+/// it. The global transform is still computed on demand, so transforms work
+/// the same without a RenderBase (which only updates the stale global
+/// transforms up front each frame).
+class Transform : public Component, public PoolAllocated<Transform> {
 public:
     explicit Transform();
     
+    /// The transform is removed from its parent and its children become
+    /// roots (their global transform is their local transform from then on),
+    /// so no transform is left with a deleted parent
     ~Transform(void);
     
     glm::mat4 GetLocalTransform();
@@ -54,37 +62,16 @@ public:
     
     /// Returns the current children of the transform
     const std::vector<Transform *> *GetChildren() const;
+    
+    /// Returns a counter that changes each time the global transform is
+    /// recomputed (see TransformStore)
+    unsigned int GetGlobalVersion() const;
 private:
     Transform(const Transform& orig); // disallow copy constructor
     Transform& operator = (const Transform&); // disallow copy constructor
     
-    void UpdateIfDirty();
-    void UpdateInverseIfDirty();
-    void UpdateGlobalIfDirty();
-    void UpdateGlobalInverseIfDirty();
-    
-
-    /// Set the global dirty recursively
-    void SetGlobalDirtyFlag();
-    
-    /// Set the global dirty flag on children and set local dirty
-    void SetLocalDirty();
-    
-    /// The reason to use dirty flags is to postpone the matrix calculations as 
-    /// long as possible. This way a few calculations should be avoided
-    bool dirtyFlag;
-    bool dirtyFlagInverse;
-    bool dirtyFlagGlobal;
-    bool dirtyFlagGlobalInverse;
-    
-    glm::vec3 position;
-    glm::vec3 scale;
-    glm::quat rotation;
-    glm::mat4 localTransform;
-    glm::mat4 localTransformInverse;
-    glm::mat4 globalTransform;
-    glm::mat4 globalTransformInverse;
-    
+    /// Id in the TransformStore
+    int id;
     std::vector<Transform *> children;
     Transform *parent;
 };
@@ -0,0 +1,314 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "TransformStore.h"
+
+#include <cassert>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace render_e {
+
+TransformStore *TransformStore::s_instance = NULL;
+
+namespace {
+/// res = a*b (column major). The loops are written so the compiler can
+/// vectorize the inner loop over the rows.
+inline void MultiplyMatrices(const float *a, const float *b, float *res){
+    for (int c=0;c<4;c++){
+        float col[4] = {0,0,0,0};
+        for (int k=0;k<4;k++){
+            float bk = b[c*4+k];
+            for (int r=0;r<4;r++){
+                col[r] += a[k*4+r]*bk;
+            }
+        }
+        for (int r=0;r<4;r++){
+            res[c*4+r] = col[r];
+        }
+    }
+}
+}
+
+TransformStore::TransformStore()
+:orderDirty(false), stamp(0), recomputedCount(0) {
+}
+
+int TransformStore::Allocate(){
+    int id;
+    if (freeIds.empty()){
+        id = slots.size();
+        slots.push_back(-1);
+    } else {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    int slot = ids.size();
+    slots[id] = slot;
+    positions.push_back(glm::vec3(0,0,0));
+    rotations.push_back(glm::quat(0.0f,0.0f,0.0f,0.0f));
+    scales.push_back(glm::vec3(1,1,1));
+    localMatrices.push_back(glm::mat4(1.0f));
+    worldMatrices.push_back(glm::mat4(1.0f));
+    parents.push_back(-1);
+    subtreeSizes.push_back(1);
+    ids.push_back(id);
+    worldVersions.push_back(0);
+    localDirty.push_back(0);
+    // the identity world matrix is valid
+    changeStamps.push_back(stamp);
+    worldStamps.push_back(stamp);
+    queued.push_back(0);
+    // a root appended at the end keeps the depth first order
+    return id;
+}
+
+void TransformStore::Release(int id){
+    int slot = slots[id];
+    assert(slot != -1);
+    assert(subtreeSizes[slot] == 1 || orderDirty); // cannot release transform with children
+    if (parents[slot] != -1){
+        SetParent(id, -1);
+    }
+    ids[slot] = -1;
+    slots[id] = -1;
+    freeIds.push_back(id);
+    // the slot is reclaimed by the next Reorder()
+    orderDirty = true;
+}
+
+void TransformStore::SetParent(int id, int parentId){
+    int slot = slots[id];
+    parents[slot] = parentId==-1?-1:slots[parentId];
+    orderDirty = true;
+    Invalidate(slot);
+}
+
+void TransformStore::SetPosition(int id, const glm::vec3 &position){
+    int slot = slots[id];
+    positions[slot] = position;
+    localDirty[slot] = 1;
+    Invalidate(slot);
+}
+
+void TransformStore::SetRotation(int id, const glm::quat &rotation){
+    int slot = slots[id];
+    rotations[slot] = rotation;
+    localDirty[slot] = 1;
+    Invalidate(slot);
+}
+
+void TransformStore::SetScale(int id, const glm::vec3 &scale){
+    int slot = slots[id];
+    scales[slot] = scale;
+    localDirty[slot] = 1;
+    Invalidate(slot);
+}
+
+void TransformStore::Invalidate(int slot){
+    stamp++;
+    changeStamps[slot] = stamp;
+    if (queued[slot]){
+        return; // already covered by a dirty range
+    }
+    queued[slot] = 1;
+    if (!orderDirty){
+        dirtyRanges.push_back(std::make_pair(slot, slot+subtreeSizes[slot]));
+    }
+}
+
+void TransformStore::UpdateLocalIfDirty(int slot){
+    if (localDirty[slot]){
+        // update localTransform to translate*scale*rotate
+        glm::mat4 m = glm::mat4(
+                glm::vec4(1,0,0,0),
+                glm::vec4(0,1,0,0),
+                glm::vec4(0,0,1,0),
+                glm::vec4(positions[slot],1)
+                );
+        m = glm::gtc::matrix_transform::scale(m,scales[slot]);
+        localMatrices[slot] = m * glm::gtc::quaternion::mat4_cast(rotations[slot]);
+        localDirty[slot] = 0;
+    }
+}
+
+const glm::mat4 &TransformStore::GetLocalMatrix(int id){
+    int slot = slots[id];
+    UpdateLocalIfDirty(slot);
+    return localMatrices[slot];
+}
+
+bool TransformStore::IsStale(int slot) const{
+    int parent = parents[slot];
+    return changeStamps[slot] > worldStamps[slot] ||
+            (parent != -1 && worldStamps[parent] > worldStamps[slot]);
+}
+
+void TransformStore::RecomputeWorld(int slot){
+    UpdateLocalIfDirty(slot);
+    int parent = parents[slot];
+    if (parent == -1){
+        worldMatrices[slot] = localMatrices[slot];
+    } else {
+        MultiplyMatrices(glm::value_ptr(localMatrices[slot]),
+                glm::value_ptr(worldMatrices[parent]),
+                glm::value_ptr(worldMatrices[slot]));
+    }
+    worldStamps[slot] = stamp;
+    worldVersions[slot]++;
+    recomputedCount++;
+}
+
+void TransformStore::ValidateWorld(int slot){
+    if (parents[slot] != -1){
+        ValidateWorld(parents[slot]);
+    }
+    if (IsStale(slot)){
+        RecomputeWorld(slot);
+    }
+}
+
+const glm::mat4 &TransformStore::GetWorldMatrix(int id){
+    int slot = slots[id];
+    ValidateWorld(slot);
+    return worldMatrices[slot];
+}
+
+void TransformStore::UpdateWorldMatrices(){
+    if (orderDirty){
+        Reorder();
+        dirtyRanges.clear();
+        UpdateRange(0, ids.size());
+        return;
+    }
+    if (dirtyRanges.empty()){
+        return;
+    }
+    // merge overlapping ranges (subtree ranges are either nested or disjoint)
+    std::sort(dirtyRanges.begin(), dirtyRanges.end());
+    int begin = dirtyRanges[0].first;
+    int end = dirtyRanges[0].second;
+    for (unsigned int i=1;i<dirtyRanges.size();i++){
+        if (dirtyRanges[i].first <= end){
+            end = std::max(end, dirtyRanges[i].second);
+        } else {
+            UpdateRange(begin, end);
+            begin = dirtyRanges[i].first;
+            end = dirtyRanges[i].second;
+        }
+    }
+    UpdateRange(begin, end);
+    dirtyRanges.clear();
+}
+
+void TransformStore::UpdateRange(int begin, int end){
+    // Parents are always stored before children, so the parent world matrix
+    // is valid when the child is reached. Matrices recomputed since the range
+    // was queued (by GetWorldMatrix()) are skipped.
+    for (int slot=begin;slot<end;slot++){
+        if (IsStale(slot)){
+            RecomputeWorld(slot);
+        }
+        queued[slot] = 0;
+    }
+}
+
+void TransformStore::Reorder(){
+    int count = ids.size();
+    // build child lists (counting sort on parent slot)
+    std::vector<int> childStart(count+1, 0);
+    for (int slot=0;slot<count;slot++){
+        if (ids[slot] != -1 && parents[slot] != -1){
+            childStart[parents[slot]+1]++;
+        }
+    }
+    for (int slot=0;slot<count;slot++){
+        childStart[slot+1] += childStart[slot];
+    }
+    std::vector<int> childList(childStart[count]);
+    std::vector<int> fill(childStart.begin(), childStart.end()-1);
+    for (int slot=0;slot<count;slot++){
+        if (ids[slot] != -1 && parents[slot] != -1){
+            childList[fill[parents[slot]]++] = slot;
+        }
+    }
+
+    // depth first traversal from the roots
+    std::vector<int> order;
+    order.reserve(count);
+    std::vector<int> stack;
+    for (int root=0;root<count;root++){
+        if (ids[root] == -1 || parents[root] != -1){
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty()){
+            int slot = stack.back();
+            stack.pop_back();
+            order.push_back(slot);
+            // push in reverse to keep the child order
+            for (int i=childStart[slot+1]-1;i>=childStart[slot];i--){
+                stack.push_back(childList[i]);
+            }
+        }
+    }
+
+    int newCount = order.size();
+    std::vector<int> newSlotOf(count, -1);
+    for (int i=0;i<newCount;i++){
+        newSlotOf[order[i]] = i;
+    }
+
+    std::vector<glm::vec3> newPositions(newCount);
+    std::vector<glm::quat> newRotations(newCount);
+    std::vector<glm::vec3> newScales(newCount);
+    std::vector<glm::mat4> newLocalMatrices(newCount);
+    std::vector<glm::mat4> newWorldMatrices(newCount);
+    std::vector<int> newParents(newCount);
+    std::vector<int> newIds(newCount);
+    std::vector<unsigned int> newWorldVersions(newCount);
+    std::vector<unsigned char> newLocalDirty(newCount);
+    std::vector<unsigned long long> newChangeStamps(newCount);
+    std::vector<unsigned long long> newWorldStamps(newCount);
+    for (int i=0;i<newCount;i++){
+        int old = order[i];
+        newPositions[i] = positions[old];
+        newRotations[i] = rotations[old];
+        newScales[i] = scales[old];
+        newLocalMatrices[i] = localMatrices[old];
+        newWorldMatrices[i] = worldMatrices[old];
+        newParents[i] = parents[old]==-1?-1:newSlotOf[parents[old]];
+        newIds[i] = ids[old];
+        newWorldVersions[i] = worldVersions[old];
+        newLocalDirty[i] = localDirty[old];
+        newChangeStamps[i] = changeStamps[old];
+        newWorldStamps[i] = worldStamps[old];
+        slots[ids[old]] = i;
+    }
+    positions.swap(newPositions);
+    rotations.swap(newRotations);
+    scales.swap(newScales);
+    localMatrices.swap(newLocalMatrices);
+    worldMatrices.swap(newWorldMatrices);
+    parents.swap(newParents);
+    ids.swap(newIds);
+    worldVersions.swap(newWorldVersions);
+    localDirty.swap(newLocalDirty);
+    changeStamps.swap(newChangeStamps);
+    worldStamps.swap(newWorldStamps);
+    queued.assign(newCount, 0);
+
+    subtreeSizes.assign(newCount, 1);
+    for (int slot=newCount-1;slot>=0;slot--){
+        if (parents[slot] != -1){
+            subtreeSizes[parents[slot]] += subtreeSizes[slot];
+        }
+    }
+    orderDirty = false;
+}
+}
@@ -0,0 +1,143 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_TRANSFORMSTORE_H
+#define	RENDER_E_TRANSFORMSTORE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace render_e {
+
+///
+/// Data oriented storage of the transform hierarchy.
+/// Local position, rotation and scale as well as the local and world matrices
+/// of all transforms are stored in contiguous arrays (structure of arrays).
+/// The slots are kept in depth first order, so a parent is always stored
+/// before its children and every subtree occupies a contiguous range. This
+/// allows all world matrices to be updated in one linear pass over the dirty
+/// ranges (UpdateWorldMatrices).
+///
+/// Invalidation is stamp based: a change stores an increasing stamp in the
+/// changed slot only (O(1), descendants are not visited), and each world
+/// matrix remembers the stamp it was computed at. A world matrix is stale
+/// if the slot changed or its parent was recomputed after it, so only
+/// matrices that are actually stale are recomputed.
+///
+/// Transform objects are thin handles into the store. Each handle owns a
+/// stable id, which is mapped to the current slot (slots move when the
+/// hierarchy changes).
+/// Note that the class is a singleton and a reference is received using the
+/// function Instance()
+///
+class TransformStore {
+public:
+    /// Allocate a new root transform and return its id
+    int Allocate();
+    /// Release the id. The id must not have any children
+    void Release(int id);
+
+    /// Set the parent of the transform (use -1 to make it a root)
+    void SetParent(int id, int parentId);
+
+    glm::vec3 GetPosition(int id) const { return positions[slots[id]]; }
+    glm::quat GetRotation(int id) const { return rotations[slots[id]]; }
+    glm::vec3 GetScale(int id) const { return scales[slots[id]]; }
+    void SetPosition(int id, const glm::vec3 &position);
+    void SetRotation(int id, const glm::quat &rotation);
+    void SetScale(int id, const glm::vec3 &scale);
+
+    /// Returns the local matrix (translate*scale*rotate)
+    const glm::mat4 &GetLocalMatrix(int id);
+    /// Returns the world matrix. If the world matrix (or the world matrix of
+    /// an ancestor) is stale it is recomputed and cached.
+    /// Note that this is not thread safe unless all world matrices are valid
+    /// (after UpdateWorldMatrices()).
+    const glm::mat4 &GetWorldMatrix(int id);
+
+    /// Recompute the stale world matrices in one linear pass over the
+    /// invalidated subtrees. Should be invoked once each frame.
+    void UpdateWorldMatrices();
+
+    /// Returns a counter that is increased each time the world matrix of the
+    /// transform is recomputed
+    unsigned int GetWorldVersion(int id) const { return worldVersions[slots[id]]; }
+
+    /// Number of world matrices recomputed since ResetRecomputedCount()
+    int GetRecomputedCount() const { return recomputedCount; }
+    void ResetRecomputedCount() { recomputedCount = 0; }
+
+    /// Number of transforms (including released slots not yet reclaimed)
+    int GetSlotCount() const { return static_cast<int>(ids.size()); }
+
+    ///
+    /// Singleton pattern.
+    /// return the transform store instance
+    ///
+    static TransformStore* Instance() {
+        if (!s_instance) {
+            s_instance = new TransformStore();
+        }
+        return s_instance;
+    }
+private:
+    TransformStore();
+    TransformStore(const TransformStore& orig); // disallow copy constructor
+    TransformStore& operator = (const TransformStore&); // disallow copy constructor
+
+    /// Stamp the slot as changed and queue its subtree range for the next
+    /// UpdateWorldMatrices()
+    void Invalidate(int slot);
+    void UpdateLocalIfDirty(int slot);
+    /// Returns true if the world matrix of the slot is stale (assuming the
+    /// parent world matrix is valid)
+    bool IsStale(int slot) const;
+    /// Make the world matrix of the slot and its ancestors valid
+    void ValidateWorld(int slot);
+    void RecomputeWorld(int slot);
+    /// Restore depth first order and reclaim released slots
+    void Reorder();
+    /// Recompute the world matrices in the range [begin; end)
+    void UpdateRange(int begin, int end);
+
+    static TransformStore *s_instance;
+
+    // per slot data
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<int> parents;       // parent slot or -1
+    std::vector<int> subtreeSizes;  // number of slots in subtree (including self)
+    std::vector<int> ids;           // id of slot (-1 if released)
+    std::vector<unsigned int> worldVersions;
+    std::vector<unsigned char> localDirty;
+    /// stamp of the last change of the local matrix or parent
+    std::vector<unsigned long long> changeStamps;
+    /// stamp when the world matrix was computed
+    std::vector<unsigned long long> worldStamps;
+    /// true if the subtree range of the slot is in dirtyRanges
+    std::vector<unsigned char> queued;
+
+    // per id data
+    std::vector<int> slots;
+    std::vector<int> freeIds;
+
+    /// Ranges [first; second) of slots with invalid world matrices
+    std::vector<std::pair<int,int> > dirtyRanges;
+    /// True when the slots are no longer in depth first order
+    bool orderDirty;
+    /// Increased on each change
+    unsigned long long stamp;
+    int recomputedCount;
+};
+}
+
+#endif	/* RENDER_E_TRANSFORMSTORE_H */
+
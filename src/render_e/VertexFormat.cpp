@@ -0,0 +1,167 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "VertexFormat.h"
+
+#include <GL/glew.h>
+
+#include "OpenGLHelper.h"
+#include "shaders/Shader.h"
+
+#define BUFFER_OFFSET(bytes) ((GLubyte*) NULL + (bytes))
+
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV 0x8D9F
+#endif
+
+namespace render_e {
+
+namespace {
+/// OpenGL type, component count and normalization of an attribute with the
+/// number of components stored using the encoding
+void getAttributeType(VertexEncoding encoding, int components, GLenum &outType, int &outSize,
+        GLboolean &outNormalized){
+    outSize = components;
+    outNormalized = GL_FALSE;
+    switch (encoding){
+        case VERTEX_ENCODING_INT_2_10_10_10:
+            outType = GL_INT_2_10_10_10_REV;
+            outSize = 4;
+            outNormalized = GL_TRUE;
+            break;
+        case VERTEX_ENCODING_OCTAHEDRAL:
+            outType = GL_SHORT;
+            outSize = 2;
+            outNormalized = GL_TRUE;
+            break;
+        case VERTEX_ENCODING_UNORM8:
+            outType = GL_UNSIGNED_BYTE;
+            outSize = 4;
+            outNormalized = GL_TRUE;
+            break;
+        case VERTEX_ENCODING_HALF:
+            outType = GL_HALF_FLOAT;
+            break;
+        case VERTEX_ENCODING_SHORT:
+            // w is stored as 1
+            outType = GL_SHORT;
+            outSize = 4;
+            break;
+        default:
+            outType = GL_FLOAT;
+            break;
+    }
+}
+
+/// Enable the generic attribute and the fixed function array (if any) at the
+/// offset of the vertex buffer, or disable both if the offset is -1. The
+/// fixed function array is disabled for encodings only the shared vertex
+/// shader can decode
+void setupArray(int location, GLenum array, int components, int stride, int offset,
+        VertexEncoding encoding = VERTEX_ENCODING_FLOAT){
+    if (offset == -1 || encoding == VERTEX_ENCODING_OCTAHEDRAL){
+        if (array != 0){
+            glDisableClientState(array);
+        }
+        if (offset == -1){
+            glDisableVertexAttribArray(location);
+            return;
+        }
+        array = 0;
+    }
+    GLenum type;
+    int size;
+    GLboolean normalized;
+    getAttributeType(encoding, components, type, size, normalized);
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, type, normalized, stride, BUFFER_OFFSET(offset));
+    switch (array){
+        case GL_VERTEX_ARRAY:
+            glVertexPointer(size, type, stride, BUFFER_OFFSET(offset));
+            break;
+        case GL_NORMAL_ARRAY:
+            glNormalPointer(type, stride, BUFFER_OFFSET(offset));
+            break;
+        case GL_COLOR_ARRAY:
+            glColorPointer(size, type, stride, BUFFER_OFFSET(offset));
+            break;
+        case GL_TEXTURE_COORD_ARRAY:
+            glTexCoordPointer(size, type, stride, BUFFER_OFFSET(offset));
+            break;
+    }
+    if (array != 0){
+        glEnableClientState(array);
+    }
+}
+}
+
+VertexCompression::VertexCompression()
+:normals(VERTEX_ENCODING_FLOAT),colors(false),textureCoords(false),positions(false) {
+}
+
+VertexFormat::VertexFormat()
+:normalOffset(-1),tangentOffset(-1),colorOffset(-1),texture1Offset(-1),
+        texture2Offset(-1),vertexOffset(-1),stride(0),normalEncoding(VERTEX_ENCODING_FLOAT),
+        tangentEncoding(VERTEX_ENCODING_FLOAT),colorEncoding(VERTEX_ENCODING_FLOAT),
+        texture1Encoding(VERTEX_ENCODING_FLOAT),texture2Encoding(VERTEX_ENCODING_FLOAT),
+        vertexEncoding(VERTEX_ENCODING_FLOAT) {
+}
+
+int VertexFormat::GetAttributeSize(VertexEncoding encoding, int components){
+    switch (encoding){
+        case VERTEX_ENCODING_INT_2_10_10_10:
+        case VERTEX_ENCODING_OCTAHEDRAL:
+        case VERTEX_ENCODING_UNORM8:
+            return 4;
+        case VERTEX_ENCODING_HALF:
+            return components*2;
+        case VERTEX_ENCODING_SHORT:
+            return 8;
+        default:
+            return components*sizeof(float);
+    }
+}
+
+bool VertexFormat::IsEncodingSupported(VertexEncoding encoding){
+    switch (encoding){
+        case VERTEX_ENCODING_INT_2_10_10_10:
+            return OpenGLHelper::HasExtension("GL_ARB_vertex_type_2_10_10_10_rev");
+        case VERTEX_ENCODING_HALF:
+            return GLEW_ARB_half_float_vertex || GLEW_VERSION_3_0;
+        default:
+            return true;
+    }
+}
+
+bool VertexFormat::operator==(const VertexFormat &other) const{
+    return normalOffset == other.normalOffset && tangentOffset == other.tangentOffset &&
+            colorOffset == other.colorOffset && texture1Offset == other.texture1Offset &&
+            texture2Offset == other.texture2Offset && vertexOffset == other.vertexOffset &&
+            stride == other.stride && normalEncoding == other.normalEncoding &&
+            tangentEncoding == other.tangentEncoding && colorEncoding == other.colorEncoding &&
+            texture1Encoding == other.texture1Encoding && texture2Encoding == other.texture2Encoding &&
+            vertexEncoding == other.vertexEncoding;
+}
+
+void VertexFormat::SetupVertexAttributes() const{
+    setupArray(VERTEX_ATTRIBUTE_NORMAL, GL_NORMAL_ARRAY, 3, stride, normalOffset, normalEncoding);
+    setupArray(VERTEX_ATTRIBUTE_TANGENT, 0, 3, stride, tangentOffset, tangentEncoding);
+    setupArray(VERTEX_ATTRIBUTE_COLOR, GL_COLOR_ARRAY, 3, stride, colorOffset, colorEncoding);
+    setupArray(VERTEX_ATTRIBUTE_TEXCOORD0, GL_TEXTURE_COORD_ARRAY, 2, stride, texture1Offset, texture1Encoding);
+    setupArray(VERTEX_ATTRIBUTE_TEXCOORD1, 0, 2, stride, texture2Offset, texture2Encoding);
+    setupArray(VERTEX_ATTRIBUTE_POSITION, GL_VERTEX_ARRAY, 3, stride, vertexOffset, vertexEncoding);
+}
+
+void VertexFormat::SetupPositionAttribute() const{
+    setupArray(VERTEX_ATTRIBUTE_NORMAL, GL_NORMAL_ARRAY, 3, stride, -1);
+    setupArray(VERTEX_ATTRIBUTE_TANGENT, 0, 3, stride, -1);
+    setupArray(VERTEX_ATTRIBUTE_COLOR, GL_COLOR_ARRAY, 3, stride, -1);
+    setupArray(VERTEX_ATTRIBUTE_TEXCOORD0, GL_TEXTURE_COORD_ARRAY, 2, stride, -1);
+    setupArray(VERTEX_ATTRIBUTE_TEXCOORD1, 0, 2, stride, -1);
+    setupArray(VERTEX_ATTRIBUTE_POSITION, GL_VERTEX_ARRAY, 3, stride, vertexOffset, vertexEncoding);
+}
+}
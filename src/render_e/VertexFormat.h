@@ -0,0 +1,97 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_VERTEXFORMAT_H
+#define	RENDER_E_VERTEXFORMAT_H
+
+namespace render_e {
+
+/// Encoding of a vertex attribute in the vertex buffer
+enum VertexEncoding {
+    /// 32 bit floats
+    VERTEX_ENCODING_FLOAT = 0,
+    /// Normals and tangents: 10:10:10:2 signed normalized integers (4 bytes)
+    VERTEX_ENCODING_INT_2_10_10_10,
+    /// Normals and tangents: octahedral mapping stored in two 16 bit signed
+    /// normalized integers (4 bytes), decoded by the shared vertex shader
+    VERTEX_ENCODING_OCTAHEDRAL,
+    /// Colors: 8 bit unsigned normalized integers (4 bytes)
+    VERTEX_ENCODING_UNORM8,
+    /// Texture coordinates: 16 bit floats (4 bytes)
+    VERTEX_ENCODING_HALF,
+    /// Positions: 16 bit signed integers relative to the center of the mesh
+    /// bounds (8 bytes), dequantized by the shared vertex shader
+    VERTEX_ENCODING_SHORT
+};
+
+///
+/// Compression of the vertex attributes of a mesh (see MeshAsset). The
+/// default is no compression. Encodings not supported by the driver fall
+/// back (10:10:10:2 normals to octahedral normals, half float texture
+/// coordinates to floats). Octahedral normals and compressed positions are
+/// decoded by the shared vertex shader, so they require materials with
+/// shaders.
+///
+struct VertexCompression {
+    VertexCompression();
+
+    /// Encoding of normals and tangents: VERTEX_ENCODING_FLOAT,
+    /// VERTEX_ENCODING_INT_2_10_10_10 or VERTEX_ENCODING_OCTAHEDRAL
+    VertexEncoding normals;
+    /// Store colors as 8 bit unsigned normalized integers
+    bool colors;
+    /// Store texture coordinates as 16 bit floats
+    bool textureCoords;
+    /// Store positions as 16 bit integers dequantized against the mesh
+    /// bounds
+    bool positions;
+};
+
+///
+/// Interleaved vertex layout: the byte offset of each attribute in a vertex
+/// (-1 if the attribute is missing) and the size of a vertex. Meshes with the
+/// same format can share vertex buffers (see GeometryHeap).
+///
+struct VertexFormat {
+    VertexFormat();
+
+    int normalOffset;
+    int tangentOffset;
+    int colorOffset;
+    int texture1Offset;
+    int texture2Offset;
+    int vertexOffset;
+    int stride;
+    /// Encoding of each attribute
+    VertexEncoding normalEncoding;
+    VertexEncoding tangentEncoding;
+    VertexEncoding colorEncoding;
+    VertexEncoding texture1Encoding;
+    VertexEncoding texture2Encoding;
+    VertexEncoding vertexEncoding;
+
+    /// Returns the size in bytes of an attribute with the number of
+    /// components stored using the encoding
+    static int GetAttributeSize(VertexEncoding encoding, int components);
+    /// Returns true if the driver supports the encoding
+    static bool IsEncodingSupported(VertexEncoding encoding);
+
+    bool operator==(const VertexFormat &other) const;
+    bool operator!=(const VertexFormat &other) const { return !(*this == other); }
+
+    /// Set the generic attributes (and the fixed function arrays used by
+    /// objects rendered without a shader) of the buffer bound to
+    /// GL_ARRAY_BUFFER. Attributes missing in the format are disabled
+    void SetupVertexAttributes() const;
+    /// Set only the position attribute (used by depth-only passes, which
+    /// then fetch 12 bytes per vertex instead of the full stride)
+    void SetupPositionAttribute() const;
+};
+}
+
+#endif	/* RENDER_E_VERTEXFORMAT_H */
+
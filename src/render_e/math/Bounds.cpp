@@ -0,0 +1,102 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "Bounds.h"
+
+#include <cmath>
+
+namespace render_e {
+
+Bounds::Bounds()
+:min(0,0,0), max(0,0,0), center(0,0,0), extent(0,0,0), radius(0), empty(true) {
+}
+
+Bounds::Bounds(const glm::vec3 &min, const glm::vec3 &max)
+:min(min), max(max), empty(false) {
+    UpdateCenterExtent();
+    radius = glm::length(extent);
+}
+
+Bounds Bounds::FromPoints(const glm::vec3 *points, int count){
+    Bounds res;
+    if (points == NULL || count <= 0){
+        return res;
+    }
+    res.min = points[0];
+    res.max = points[0];
+    for (int i=1;i<count;i++){
+        res.min = glm::min(res.min, points[i]);
+        res.max = glm::max(res.max, points[i]);
+    }
+    res.empty = false;
+    res.UpdateCenterExtent();
+
+    // the sphere around the box center is often much tighter than the
+    // sphere enclosing the box
+    float radiusSqr = 0;
+    for (int i=0;i<count;i++){
+        glm::vec3 d = points[i]-res.center;
+        float distSqr = glm::dot(d,d);
+        if (distSqr > radiusSqr){
+            radiusSqr = distSqr;
+        }
+    }
+    res.radius = sqrtf(radiusSqr);
+    return res;
+}
+
+void Bounds::Encapsulate(const Bounds &other){
+    if (other.empty){
+        return;
+    }
+    if (empty){
+        *this = other;
+        return;
+    }
+    glm::vec3 oldCenter = center;
+    float oldRadius = radius;
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+    UpdateCenterExtent();
+    // grow the sphere to contain both spheres, but never beyond the box
+    float r1 = glm::length(oldCenter-center)+oldRadius;
+    float r2 = glm::length(other.center-center)+other.radius;
+    radius = glm::min(glm::max(r1, r2), glm::length(extent));
+}
+
+Bounds Bounds::TransformBounds(const glm::mat4 &matrix) const{
+    if (empty){
+        return *this;
+    }
+    Bounds res;
+    res.empty = false;
+    // Transforming Axis-Aligned Bounding Boxes (Jim Arvo, Graphics Gems 1990)
+    glm::vec3 newCenter(matrix[3][0], matrix[3][1], matrix[3][2]);
+    glm::vec3 newExtent(0,0,0);
+    float maxScaleSqr = 0;
+    for (int col=0;col<3;col++){
+        glm::vec3 axis(matrix[col][0], matrix[col][1], matrix[col][2]);
+        newCenter += axis*center[col];
+        newExtent += glm::abs(axis)*extent[col];
+        float scaleSqr = glm::dot(axis, axis);
+        if (scaleSqr > maxScaleSqr){
+            maxScaleSqr = scaleSqr;
+        }
+    }
+    res.center = newCenter;
+    res.extent = newExtent;
+    res.min = newCenter-newExtent;
+    res.max = newCenter+newExtent;
+    res.radius = glm::min(radius*sqrtf(maxScaleSqr), glm::length(newExtent));
+    return res;
+}
+
+void Bounds::UpdateCenterExtent(){
+    center = (min+max)*0.5f;
+    extent = (max-min)*0.5f;
+}
+}
@@ -0,0 +1,55 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_BOUNDS_H
+#define	RENDER_E_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+namespace render_e {
+
+/// Bounding volume consisting of an axis aligned bounding box and a bounding
+/// sphere. The sphere is used for a fast early test and the box for a tighter
+/// fit. A default constructed Bounds is empty (contains no points).
+class Bounds {
+public:
+    Bounds();
+    Bounds(const glm::vec3 &min, const glm::vec3 &max);
+
+    /// Compute the bounds of a point cloud
+    static Bounds FromPoints(const glm::vec3 *points, int count);
+
+    bool IsEmpty() const { return empty; }
+    glm::vec3 GetMin() const { return min; }
+    glm::vec3 GetMax() const { return max; }
+    glm::vec3 GetCenter() const { return center; }
+    /// Returns the half size of the box
+    glm::vec3 GetExtent() const { return extent; }
+    /// Returns the radius of the bounding sphere (centered in GetCenter())
+    float GetRadius() const { return radius; }
+
+    /// Grow the bounds to include the other bounds
+    void Encapsulate(const Bounds &other);
+
+    /// Returns the bounds transformed by the matrix. The box is recomputed as
+    /// the axis aligned box of the transformed box and the sphere radius is
+    /// scaled by the largest axis scale
+    Bounds TransformBounds(const glm::mat4 &matrix) const;
+private:
+    void UpdateCenterExtent();
+
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 center;
+    glm::vec3 extent;
+    float radius;
+    bool empty;
+};
+}
+
+#endif	/* RENDER_E_BOUNDS_H */
+
@@ -0,0 +1,141 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#include "Frustum.h"
+
+#include <cmath>
+#include <cfloat>
+
+#include "SIMD.h"
+
+namespace render_e {
+
+Frustum::Frustum(){
+    for (int i=0;i<8;i++){
+        planeX[i] = 0;
+        planeY[i] = 0;
+        planeZ[i] = 0;
+        planeW[i] = FLT_MAX;
+    }
+}
+
+void Frustum::SetFromMatrix(const glm::mat4 &m){
+    // "Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+    // Matrix" by Gil Gribb and Klaus Hartmann.
+    // glm is column major, so row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    for (int i=0;i<6;i++){
+        int row = i/2;
+        float sign = (i%2==0)?1.0f:-1.0f; // left, right, bottom, top, near, far
+        float a = m[0][3] + sign*m[0][row];
+        float b = m[1][3] + sign*m[1][row];
+        float c = m[2][3] + sign*m[2][row];
+        float d = m[3][3] + sign*m[3][row];
+        float invLength = 1.0f/sqrtf(a*a+b*b+c*c);
+        planeX[i] = a*invLength;
+        planeY[i] = b*invLength;
+        planeZ[i] = c*invLength;
+        planeW[i] = d*invLength;
+    }
+}
+
+#ifdef RENDER_E_SSE
+
+FrustumTestResult Frustum::Test(const Bounds &bounds) const{
+    if (bounds.IsEmpty()){
+        return FRUSTUM_OUTSIDE;
+    }
+    glm::vec3 center = bounds.GetCenter();
+    glm::vec3 extent = bounds.GetExtent();
+    __m128 cx = _mm_set1_ps(center[0]);
+    __m128 cy = _mm_set1_ps(center[1]);
+    __m128 cz = _mm_set1_ps(center[2]);
+    __m128 radius = _mm_set1_ps(bounds.GetRadius());
+    __m128 negRadius = _mm_set1_ps(-bounds.GetRadius());
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    // sphere test
+    int outside = 0;
+    int intersect = 0;
+    __m128 dist[2];
+    for (int i=0;i<2;i++){
+        __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(planeX+i*4), cx),
+                           _mm_mul_ps(_mm_loadu_ps(planeY+i*4), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(planeZ+i*4), cz),
+                           _mm_loadu_ps(planeW+i*4)));
+        dist[i] = d;
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(d, negRadius));
+        intersect |= _mm_movemask_ps(_mm_cmplt_ps(d, radius));
+    }
+    if (outside){
+        return FRUSTUM_OUTSIDE;
+    }
+    if (!intersect){
+        return FRUSTUM_INSIDE;
+    }
+
+    // box test (the distances from the center are reused)
+    __m128 ex = _mm_set1_ps(extent[0]);
+    __m128 ey = _mm_set1_ps(extent[1]);
+    __m128 ez = _mm_set1_ps(extent[2]);
+    intersect = 0;
+    for (int i=0;i<2;i++){
+        __m128 e = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_and_ps(_mm_loadu_ps(planeX+i*4), absMask), ex),
+                           _mm_mul_ps(_mm_and_ps(_mm_loadu_ps(planeY+i*4), absMask), ey)),
+                _mm_mul_ps(_mm_and_ps(_mm_loadu_ps(planeZ+i*4), absMask), ez));
+        __m128 negE = _mm_sub_ps(_mm_setzero_ps(), e);
+        if (_mm_movemask_ps(_mm_cmplt_ps(dist[i], negE))){
+            return FRUSTUM_OUTSIDE;
+        }
+        intersect |= _mm_movemask_ps(_mm_cmplt_ps(dist[i], e));
+    }
+    return intersect?FRUSTUM_INTERSECT:FRUSTUM_INSIDE;
+}
+
+#else
+
+FrustumTestResult Frustum::Test(const Bounds &bounds) const{
+    if (bounds.IsEmpty()){
+        return FRUSTUM_OUTSIDE;
+    }
+    glm::vec3 center = bounds.GetCenter();
+    glm::vec3 extent = bounds.GetExtent();
+    float radius = bounds.GetRadius();
+
+    // sphere test
+    float dist[6];
+    bool intersect = false;
+    for (int i=0;i<6;i++){
+        dist[i] = planeX[i]*center[0]+planeY[i]*center[1]+planeZ[i]*center[2]+planeW[i];
+        if (dist[i] < -radius){
+            return FRUSTUM_OUTSIDE;
+        }
+        if (dist[i] < radius){
+            intersect = true;
+        }
+    }
+    if (!intersect){
+        return FRUSTUM_INSIDE;
+    }
+
+    // box test
+    intersect = false;
+    for (int i=0;i<6;i++){
+        float e = fabsf(planeX[i])*extent[0]+fabsf(planeY[i])*extent[1]+fabsf(planeZ[i])*extent[2];
+        if (dist[i] < -e){
+            return FRUSTUM_OUTSIDE;
+        }
+        if (dist[i] < e){
+            intersect = true;
+        }
+    }
+    return intersect?FRUSTUM_INTERSECT:FRUSTUM_INSIDE;
+}
+
+#endif
+}
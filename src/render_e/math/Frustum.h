@@ -0,0 +1,46 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_FRUSTUM_H
+#define	RENDER_E_FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+namespace render_e {
+
+enum FrustumTestResult {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECT,
+    FRUSTUM_INSIDE
+};
+
+/// View frustum described by six planes (pointing inwards).
+/// The planes are stored as structure of arrays, so four planes can be tested
+/// at a time using SSE (if available).
+class Frustum {
+public:
+    Frustum();
+
+    /// Extract the planes from a projection*view matrix (Gribb and Hartmann)
+    void SetFromMatrix(const glm::mat4 &viewProjection);
+
+    /// Test the bounds against the frustum. Tests the bounding sphere first
+    /// and falls back to the box if the sphere intersects a plane.
+    FrustumTestResult Test(const Bounds &bounds) const;
+private:
+    // Plane i is (planeX[i],planeY[i],planeZ[i],planeW[i]). Two padding planes
+    // that accept everything makes the count a multiple of four.
+    float planeX[8];
+    float planeY[8];
+    float planeZ[8];
+    float planeW[8];
+};
+}
+
+#endif	/* RENDER_E_FRUSTUM_H */
+
@@ -0,0 +1,22 @@
+/*
+ *  RenderE
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: LGPL 3.0 ( http://www.gnu.org/licenses/lgpl-3.0.txt )
+ */
+
+#ifndef RENDER_E_SIMD_H
+#define	RENDER_E_SIMD_H
+
+/// RENDER_E_SSE is defined when SSE2 intrinsics can be used. Code using SIMD
+/// must always provide a scalar fallback. Define RENDER_E_NO_SIMD to force
+/// the scalar code paths.
+#ifndef RENDER_E_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDER_E_SSE
+#include <emmintrin.h>
+#endif
+#endif
+
+#endif	/* RENDER_E_SIMD_H */
+
@@ -13,11 +13,14 @@
 
 #include "ShaderDataSource.h"
 #include "../Log.h"
+#include "../GLStateCache.h"
+#include "../FrameUniforms.h"
+#include "../LightClusters.h"
 
 namespace render_e {
 
 Shader *Shader::CreateShader(std::string assetName, std::string shaderName, ShaderDataSource *shaderDataSource, ShaderLoadStatus &outLoadStatus){
-    Shader* shader = new Shader(shaderName, assetName, shaderDataSource);
+    Shader* shader = new Shader(shaderName, assetName, shaderDataSource, SHADER_VARIANT_DEFAULT);
     outLoadStatus = shader->Reload();
     if (outLoadStatus != SHADER_OK){
         delete shader;
@@ -27,17 +30,31 @@ Shader *Shader::CreateShader(std::string assetName, std::string shaderName, Shad
 }
 
 Shader::Shader(
-        std::string shaderName, std::string assetName, ShaderDataSource *shaderDataSource)
+        std::string shaderName, std::string assetName, ShaderDataSource *shaderDataSource, ShaderVariant variant)
 :shaderProgramId(0),vertexShaderId(0),fragmentShaderId(0), 
-        shaderName(shaderName), assetName(assetName), shaderDataSource(shaderDataSource) {
+        shaderName(shaderName), assetName(assetName), shaderDataSource(shaderDataSource),
+        variant(variant), instancedVariant(NULL), gbufferVariant(NULL) {
 }
 
 Shader::~Shader() {
     Unload();
+    delete instancedVariant;
+    delete gbufferVariant;
     // do not delete sharedShaderLib, since that is shared between different 
     // shader instances
 }
 
+/// Insert the define after the #version line of the shader source
+void insertDefine(std::string &source, const char *define){
+    std::string line = std::string("#define ")+define+"\n";
+    size_t pos = 0;
+    if (source.compare(0, 8, "#version") == 0){
+        pos = source.find('\n');
+        pos = pos == std::string::npos ? source.length() : pos+1;
+    }
+    source.insert(pos, line);
+}
+
 void checkInfoLogShader(unsigned int shaderId){
     int infologlength;
     glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &infologlength);
@@ -132,6 +149,22 @@ ShaderLoadStatus Shader::Link(){
     glAttachShader(shaderProgramId, vertexShaderId);
     glAttachShader(shaderProgramId, fragmentShaderId);
     
+    // Fixed locations of the mesh attributes (see MeshAsset)
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_POSITION, "re_VertexPositionData");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_NORMAL, "re_VertexNormalData");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_COLOR, "re_VertexColor");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_TANGENT, "re_VertexTangentData");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_TEXCOORD0, "re_VertexTexCoord0");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_TEXCOORD1, "re_VertexTexCoord1");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_DECODE_POSITION, "re_VertexDecodePosition");
+    glBindAttribLocation(shaderProgramId, VERTEX_ATTRIBUTE_DECODE_FLAGS, "re_VertexDecodeFlags");
+    // Fixed locations of per instance attributes (unused attributes are ignored)
+    glBindAttribLocation(shaderProgramId, INSTANCE_ATTRIBUTE_MODEL0, "re_InstanceModel0");
+    glBindAttribLocation(shaderProgramId, INSTANCE_ATTRIBUTE_MODEL0+1, "re_InstanceModel1");
+    glBindAttribLocation(shaderProgramId, INSTANCE_ATTRIBUTE_MODEL0+2, "re_InstanceModel2");
+    glBindAttribLocation(shaderProgramId, INSTANCE_ATTRIBUTE_MODEL0+3, "re_InstanceModel3");
+    glBindAttribLocation(shaderProgramId, INSTANCE_ATTRIBUTE_PARAMETER, "re_InstanceParameter");
+    
     glLinkProgram(shaderProgramId);
     checkInfoLogProgram(shaderProgramId);
     
@@ -142,12 +175,13 @@ ShaderLoadStatus Shader::Link(){
         ERROR("Link error");
         return SHADER_LINK_ERROR;
     }
+    FrameUniforms::BindUniformBlocks(shaderProgramId);
     
     return SHADER_OK;
 }
     
 void Shader::Bind(){
-    glUseProgram(shaderProgramId);
+    GLStateCache::Instance()->UseProgram(shaderProgramId);
 }
 
 ShaderLoadStatus Shader::Reload(){
@@ -163,11 +197,85 @@ ShaderLoadStatus Shader::Reload(){
     if (loadStatus != SHADER_OK){
         return loadStatus;
     }
+    if (FrameUniforms::IsSupported()){
+        // the shared library reads the lights and camera from uniform buffers
+        std::stringstream maxLights;
+        maxLights<<"RE_MAX_LIGHTS "<<FrameUniforms::GetMaxLights();
+        insertDefine(sharedVertexData, maxLights.str().c_str());
+        insertDefine(sharedFragmentData, maxLights.str().c_str());
+        insertDefine(sharedVertexData, "RENDER_E_UNIFORM_BUFFER");
+        insertDefine(sharedFragmentData, "RENDER_E_UNIFORM_BUFFER");
+    }
+    if (FrameUniforms::IsClusteringSupported()){
+        // the fragment shaders only process the lights of the cluster
+        std::stringstream clusterSize;
+        clusterSize<<"RE_CLUSTER_SIZE vec3("<<CLUSTER_TILES_X<<".0, "<<CLUSTER_TILES_Y<<".0, "<<CLUSTER_SLICES<<".0)";
+        insertDefine(sharedFragmentData, clusterSize.str().c_str());
+        std::stringstream lightIndexSize;
+        lightIndexSize<<"RE_LIGHT_INDEX_SIZE vec2("<<LIGHT_INDEX_TEXTURE_WIDTH<<".0, "<<LIGHT_INDEX_TEXTURE_HEIGHT<<".0)";
+        insertDefine(sharedFragmentData, lightIndexSize.str().c_str());
+        insertDefine(sharedFragmentData, "RENDER_E_CLUSTERED_LIGHTS");
+    }
+    if (variant == SHADER_VARIANT_INSTANCED){
+        insertDefine(sharedVertexData, "RENDER_E_INSTANCED");
+        insertDefine(sharedFragmentData, "RENDER_E_INSTANCED");
+    } else if (variant == SHADER_VARIANT_GBUFFER){
+        insertDefine(sharedVertexData, "RENDER_E_GBUFFER");
+        insertDefine(sharedFragmentData, "RENDER_E_GBUFFER");
+    }
+    bool gbufferSupported = fragmentData.find("RENDER_E_GBUFFER") != std::string::npos;
     loadStatus = CompileAndLink(sharedVertexData, sharedFragmentData,
         vertexData, fragmentData);
+    if (loadStatus == SHADER_OK && variant == SHADER_VARIANT_DEFAULT){
+        ReloadInstancedVariant();
+        delete gbufferVariant;
+        gbufferVariant = NULL;
+        if (gbufferSupported){
+            ReloadGBufferVariant();
+        }
+    }
     return loadStatus;
 }
 
+void Shader::ReloadInstancedVariant(){
+    delete instancedVariant;
+    instancedVariant = NULL;
+    if (!GLEW_ARB_instanced_arrays || !GLEW_ARB_draw_instanced){
+        return;
+    }
+    Shader *instanced = new Shader(shaderName, assetName, shaderDataSource, SHADER_VARIANT_INSTANCED);
+    if (instanced->Reload() != SHADER_OK){
+        std::stringstream ss;
+        ss<<"Cannot compile instanced variant of "<<shaderName;
+        WARN(ss.str());
+        delete instanced;
+        return;
+    }
+    // only shaders using the vertex transformation functions of shared.vs
+    // (which read the per instance model matrix) can be instanced
+    if (glGetAttribLocation(instanced->shaderProgramId, "re_InstanceModel0") == -1){
+        delete instanced;
+        return;
+    }
+    instancedVariant = instanced;
+}
+
+void Shader::ReloadGBufferVariant(){
+    // writing several color buffers requires OpenGL 2.0
+    if (!GLEW_VERSION_2_0){
+        return;
+    }
+    Shader *gbuffer = new Shader(shaderName, assetName, shaderDataSource, SHADER_VARIANT_GBUFFER);
+    if (gbuffer->Reload() != SHADER_OK){
+        std::stringstream ss;
+        ss<<"Cannot compile G-buffer variant of "<<shaderName;
+        WARN(ss.str());
+        delete gbuffer;
+        return;
+    }
+    gbufferVariant = gbuffer;
+}
+
 void Shader::Unload(){
     if (fragmentShaderId != 0) {
         glDeleteShader(fragmentShaderId);
@@ -179,6 +287,7 @@ void Shader::Unload(){
     }
     if (shaderProgramId != 0) {
         glDeleteProgram(shaderProgramId);
+        GLStateCache::Instance()->ProgramDeleted(shaderProgramId);
         shaderProgramId = 0;
     }
 }
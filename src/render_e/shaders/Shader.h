@@ -23,6 +23,41 @@ enum ShaderLoadStatus {
     SHADER_LINK_ERROR    
 };
 
+/// Generic vertex attribute locations of the mesh data (see MeshAsset), read
+/// by shaders as re_VertexPosition, re_VertexNormal, re_VertexColor,
+/// re_VertexTangent, re_VertexTexCoord0 and re_VertexTexCoord1. The locations
+/// are those of the fixed function attributes they replace on drivers that
+/// alias the two. The decode attributes are constant per mesh and describe
+/// how compressed positions, normals and tangents are decoded (see
+/// shared.vs).
+enum VertexAttribute {
+    VERTEX_ATTRIBUTE_POSITION = 0,
+    VERTEX_ATTRIBUTE_NORMAL = 2,
+    VERTEX_ATTRIBUTE_COLOR = 3,
+    VERTEX_ATTRIBUTE_TANGENT = 6,
+    VERTEX_ATTRIBUTE_DECODE_POSITION = 7,
+    VERTEX_ATTRIBUTE_TEXCOORD0 = 8,
+    VERTEX_ATTRIBUTE_TEXCOORD1 = 9,
+    VERTEX_ATTRIBUTE_DECODE_FLAGS = 10
+};
+
+/// Generic vertex attribute locations of the per instance data used by
+/// instanced shader variants (model matrix columns and instance parameter).
+/// Locations 11-15 are used since they do not alias the fixed function
+/// attributes used by the engine.
+enum InstanceAttribute {
+    INSTANCE_ATTRIBUTE_MODEL0 = 11,
+    INSTANCE_ATTRIBUTE_PARAMETER = 15
+};
+
+/// Compiled variants of a shader. The variants are compiled with
+/// RENDER_E_INSTANCED or RENDER_E_GBUFFER defined
+enum ShaderVariant {
+    SHADER_VARIANT_DEFAULT,
+    SHADER_VARIANT_INSTANCED,
+    SHADER_VARIANT_GBUFFER
+};
+
 class Shader {
 public:
     static Shader *CreateShader(std::string assetName, std::string shaderName, ShaderDataSource *shaderDataSource, ShaderLoadStatus &outLoadStatus);
@@ -39,14 +74,31 @@ public:
     void SetVector4(unsigned int index, float *vector);
     void SetMatrix44(unsigned int index, float *mat);
     std::string GetShaderName() {return shaderName; }
+    /// Returns the OpenGL name of the shader program
+    unsigned int GetProgramId() { return shaderProgramId; }
     /** Returns -1 if not found */
     int GetUniformLocation(const char *location);
     
+    /// Returns the instanced variant of the shader (compiled with
+    /// RENDER_E_INSTANCED defined) or NULL if the shader does not use the
+    /// per instance model matrix (see re_ModelMatrix() in shared.vs)
+    Shader *GetInstancedVariant() { return instancedVariant; }
+    bool IsInstancedVariant() { return variant == SHADER_VARIANT_INSTANCED; }
+    /// Returns the G-buffer variant of the shader (compiled with
+    /// RENDER_E_GBUFFER defined) used by deferred shading, or NULL if the
+    /// shader does not support it (the source must test RENDER_E_GBUFFER and
+    /// write the surface using re_GBufferOutput() in shared.fs)
+    Shader *GetGBufferVariant() { return gbufferVariant; }
+    
     void IncreaseUsageCount() { usageCount++; }
     void DecreaseUsageCount() { usageCount--; }
     int GetUsageCount() { return usageCount;}
 private:
-    Shader(std::string shaderName, std::string assetName, ShaderDataSource *shaderDataSource);
+    Shader(std::string shaderName, std::string assetName, ShaderDataSource *shaderDataSource, ShaderVariant variant);
+    /// Create or reload the instanced variant
+    void ReloadInstancedVariant();
+    /// Create or reload the G-buffer variant
+    void ReloadGBufferVariant();
     ShaderLoadStatus CompileAndLink(std::string sharedVertexData,std::string sharedFragmentData,
         std::string vertexData,std::string fragmentData);
     ShaderLoadStatus Compile(std::string sharedVertexData,std::string sharedFragmentData,
@@ -63,6 +115,9 @@ private:
     std::string shaderName;
     std::string assetName;
     ShaderDataSource *shaderDataSource;
+    ShaderVariant variant;
+    Shader *instancedVariant;
+    Shader *gbufferVariant;
 };
 }
 #endif	/* SHADER_H */
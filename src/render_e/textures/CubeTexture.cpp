@@ -11,6 +11,7 @@
 #include <cassert>
 #include "GL/glew.h"
 #include "../Log.h"
+#include "../GLStateCache.h"
 
 
 namespace render_e {
@@ -39,7 +40,7 @@ void CubeTexture::Create(int width, int height, TextureFormat textureFormat){
     if (textureFormat == RGB || textureFormat == RGBA){
         // color cube map
         glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
+        GLStateCache::Instance()->BindTexture(GL_TEXTURE_CUBE_MAP, textureId);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -52,7 +53,7 @@ void CubeTexture::Create(int width, int height, TextureFormat textureFormat){
     } else if (textureFormat == DEPTH){
         // depth cube map
         glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
+        GLStateCache::Instance()->BindTexture(GL_TEXTURE_CUBE_MAP, textureId);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -73,7 +74,7 @@ void CubeTexture::Create(int width, int height, TextureFormat textureFormat){
 TextureLoadStatus CubeTexture::Load(){
     // allocate a texture name
     glGenTextures( 1, &textureId );
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
+    GLStateCache::Instance()->BindTexture(GL_TEXTURE_CUBE_MAP, textureId);
     
     for (int i=0;i<6;i++){
         TextureFormat textureFormat;
@@ -15,6 +15,7 @@
 
 #include "TextureDataSource.h"
 #include "../Log.h"
+#include "../GLStateCache.h"
 
 using namespace std;
 
@@ -78,7 +79,7 @@ TextureLoadStatus Texture2D::Load() {
         // allocate a texture name
         glGenTextures(1, &textureId);
         // select our current texture
-        glBindTexture(GL_TEXTURE_2D, textureId);
+        GLStateCache::Instance()->BindTexture(GL_TEXTURE_2D, textureId);
 
         // when texture area is small, bilinear filter the closest mipmap
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
@@ -104,7 +105,7 @@ TextureLoadStatus Texture2D::Load() {
             glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height,
                     0, format, GL_UNSIGNED_BYTE, data);
         }
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::Instance()->BindTexture(GL_TEXTURE_2D, 0);
     }
 
     if (data != NULL) {
@@ -121,7 +122,7 @@ void Texture2D::Create(int width, int height, TextureFormat textureFormat) {
     // allocate a texture name
     glGenTextures(1, &textureId);
     // select our current texture
-    glBindTexture(GL_TEXTURE_2D, textureId);
+    GLStateCache::Instance()->BindTexture(GL_TEXTURE_2D, textureId);
 
 	if (textureFormat==DEPTH){
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -153,7 +154,7 @@ void Texture2D::Create(int width, int height, TextureFormat textureFormat) {
 
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height,
             0, format, storageType, NULL);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::Instance()->BindTexture(GL_TEXTURE_2D, 0);
 }
 
 }
@@ -7,6 +7,7 @@
 
 #include "TextureBase.h"
 #include <GL/glew.h>
+#include "../GLStateCache.h"
 
 namespace render_e {
 
@@ -22,17 +23,18 @@ TextureBase::~TextureBase() {
 }
 
 void TextureBase::Bind(){
-    glBindTexture(textureType, textureId );
+    GLStateCache::Instance()->BindTexture(textureType, textureId );
 }
 
 void TextureBase::Unbind(){
-    glBindTexture(textureType , 0 );
+    GLStateCache::Instance()->BindTexture(textureType , 0 );
 }
 
 void TextureBase::Unload(){
     if (textureId!=0){
         Unbind();
         glDeleteTextures(1, &textureId);
+        GLStateCache::Instance()->TextureDeleted(textureId);
         textureId = 0;
     }
 }
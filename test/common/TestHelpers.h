@@ -0,0 +1,40 @@
+/// Helpers shared by the tests that run without OpenGL (light_clusters and
+/// occlusion_culling)
+
+#ifndef RENDER_E_TESTHELPERS_H
+#define	RENDER_E_TESTHELPERS_H
+
+#include <cstdlib>
+#include <glm/glm.hpp>
+
+/// Random number in [minimum, maximum] (seeded using srand)
+inline float randomFloat(float minimum, float maximum){
+    return minimum+(maximum-minimum)*(rand()/(float)RAND_MAX);
+}
+
+/// Same matrix as glFrustum
+inline glm::mat4 frustumMatrix(float left, float right, float bottom, float top, float nearPlane, float farPlane){
+    glm::mat4 m(0.0f);
+    m[0][0] = 2*nearPlane/(right-left);
+    m[1][1] = 2*nearPlane/(top-bottom);
+    m[2][0] = (right+left)/(right-left);
+    m[2][1] = (top+bottom)/(top-bottom);
+    m[2][2] = -(farPlane+nearPlane)/(farPlane-nearPlane);
+    m[2][3] = -1;
+    m[3][2] = -2*farPlane*nearPlane/(farPlane-nearPlane);
+    return m;
+}
+
+/// Same matrix as glOrtho
+inline glm::mat4 orthoMatrix(float left, float right, float bottom, float top, float nearPlane, float farPlane){
+    glm::mat4 m(1.0f);
+    m[0][0] = 2/(right-left);
+    m[1][1] = 2/(top-bottom);
+    m[2][2] = -2/(farPlane-nearPlane);
+    m[3][0] = -(right+left)/(right-left);
+    m[3][1] = -(top+bottom)/(top-bottom);
+    m[3][2] = -(farPlane+nearPlane)/(farPlane-nearPlane);
+    return m;
+}
+
+#endif	/* RENDER_E_TESTHELPERS_H */
@@ -0,0 +1,150 @@
+/// The purpose of this test is to verify that the clustered light assignment
+/// is conservative (every light reaching a point is in the cluster of the
+/// point) and to measure the time of building the clusters. The test does not
+/// need OpenGL.
+/// Usage: light_clusters [lightCount]
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "render_e/LightClusters.h"
+#include "render_e/FrameUniforms.h"
+#include "../common/TestHelpers.h"
+
+using namespace render_e;
+using namespace std;
+
+void createLights(int lightCount, vector<LightUniforms> &lights){
+    lights.resize(lightCount);
+    for (int i=0;i<lightCount;i++){
+        LightUniforms &light = lights[i];
+        memset(&light, 0, sizeof(LightUniforms));
+        light.position[0] = randomFloat(-40, 40);
+        light.position[1] = randomFloat(-20, 20);
+        light.position[2] = randomFloat(-90, 10);
+        light.position[3] = 1;
+        light.spotDirection[3] = -1;
+        if (i%3 == 0){
+            glm::vec3 direction = glm::normalize(glm::vec3(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1)));
+            light.spotDirection[0] = direction.x;
+            light.spotDirection[1] = direction.y;
+            light.spotDirection[2] = direction.z;
+            light.spotDirection[3] = cos(randomFloat(10, 60)*3.14159265f/180);
+        }
+        for (int c=0;c<3;c++){
+            light.diffuse[c] = randomFloat(0.2f, 0.5f);
+        }
+        light.attenuation[0] = 1;
+        light.attenuation[1] = randomFloat(0, 1);
+        light.attenuation[2] = randomFloat(0.2f, 2);
+    }
+}
+
+/// Returns true if the light (eye space) reaches the point
+bool reaches(const LightUniforms &light, const glm::mat4 &view, const glm::vec3 &point){
+    glm::vec3 position = glm::vec3(view*glm::vec4(light.position[0], light.position[1], light.position[2], 1.0f));
+    glm::vec3 toPoint = point-position;
+    float distance = glm::length(toPoint);
+    if (distance > LightClusters::GetLightRange(light)){
+        return false;
+    }
+    if (light.spotDirection[3] > -1){
+        glm::vec3 direction = glm::normalize(glm::vec3(view*glm::vec4(light.spotDirection[0],
+                light.spotDirection[1], light.spotDirection[2], 0.0f)));
+        return glm::dot(toPoint/distance, direction) >= light.spotDirection[3];
+    }
+    return true;
+}
+
+/// Returns the number of lights reaching random points that are missing in
+/// the clusters of the points
+int countMissingLights(const LightClusters &clusters, const vector<LightUniforms> &lights, const glm::mat4 &view,
+        const glm::mat4 &projection, int sampleCount){
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    const vector<float> &clusterData = clusters.GetClusterData();
+    const vector<float> &lightIndices = clusters.GetLightIndices();
+    int missing = 0;
+    for (int i=0;i<sampleCount;i++){
+        glm::vec4 point = inverseProjection*glm::vec4(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1), 1.0f);
+        glm::vec3 eyePoint = glm::vec3(point)/point.w;
+        int cluster = clusters.GetCluster(eyePoint);
+        if (cluster == -1){
+            continue;
+        }
+        int offset = static_cast<int>(clusterData[cluster*2]);
+        int count = static_cast<int>(clusterData[cluster*2+1]);
+        for (unsigned int j=0;j<lights.size();j++){
+            if (!reaches(lights[j], view, eyePoint)){
+                continue;
+            }
+            bool found = false;
+            for (int k=0;k<count && !found;k++){
+                found = static_cast<int>(lightIndices[offset+k]) == (int)j;
+            }
+            if (!found){
+                missing++;
+            }
+        }
+    }
+    return missing;
+}
+
+bool testProjection(const char *name, const vector<LightUniforms> &lights, const glm::mat4 &view,
+        const glm::mat4 &projection, float nearPlane, float farPlane, bool perspective){
+    LightClusters clusters;
+    clusters.SetLights(&lights[0], lights.size());
+    clusters.Build(view, projection, nearPlane, farPlane, perspective);
+    int missing = countMissingLights(clusters, lights, view, projection, 20000);
+    float average = clusters.GetLightIndexCount()/(float)CLUSTER_COUNT;
+    cout << name << ": "<<clusters.GetLightCount()<<" lights, "<<clusters.GetLightIndexCount()
+            <<" indices, "<<average<<" lights per cluster, "<<missing<<" missing"<<endl;
+    if (missing > 0){
+        cout << "Error: lights missing in clusters"<<endl;
+        return false;
+    }
+    if (clusters.GetLightCount() > 0 && average >= clusters.GetLightCount()*0.5f){
+        cout << "Error: clusters are not selective"<<endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int lightCount = argc<2 ? 256 : atoi(argv[1]);
+    srand(1);
+    vector<LightUniforms> lights;
+    createLights(lightCount, lights);
+    glm::mat4 view(1.0f);
+    view[3] = glm::vec4(2.0f, -1.0f, -5.0f, 1.0f);
+
+    bool ok = true;
+    glm::mat4 perspective = frustumMatrix(-0.5f, 0.5f, -0.3f, 0.3f, 0.5f, 100.0f);
+    ok &= testProjection("Perspective", lights, view, perspective, 0.5f, 100.0f, true);
+    glm::mat4 orthographic = orthoMatrix(-40, 40, -20, 20, -1, 100);
+    ok &= testProjection("Orthographic", lights, view, orthographic, -1, 100, false);
+
+    // benchmark (the lights are binned by the job system, so the processor
+    // time is the sum of all threads)
+    LightClusters clusters;
+    clusters.SetLights(&lights[0], lights.size());
+    const int iterations = 100;
+    clock_t start = clock();
+    for (int i=0;i<iterations;i++){
+        view[3][0] = i*0.01f;
+        clusters.Build(view, perspective, 0.5f, 100.0f, true);
+    }
+    double milliseconds = (clock()-start)*1000.0/CLOCKS_PER_SEC/iterations;
+    cout << "Build: "<<milliseconds<<" ms processor time per camera ("<<lightCount<<" lights, "
+            <<CLUSTER_COUNT<<" clusters)"<<endl;
+
+    if (!ok){
+        return EXIT_FAILURE;
+    }
+    cout << "Light clusters ok"<<endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/// The purpose of this test is to verify that the software occlusion culling
+/// only rejects objects hidden behind the occluders and to measure the time of
+/// rasterizing the occluders and testing the objects. The test does not need
+/// OpenGL.
+/// Usage: occlusion_culling [gridSize]
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <glm/glm.hpp>
+#include "render_e/OcclusionCuller.h"
+#include "../common/TestHelpers.h"
+
+using namespace render_e;
+using namespace std;
+
+/// Quad with the corners in counterclockwise order
+void createQuad(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3,
+        vector<glm::vec3> &vertices, vector<int> &indices){
+    int first = vertices.size();
+    vertices.push_back(p0);
+    vertices.push_back(p1);
+    vertices.push_back(p2);
+    vertices.push_back(p3);
+    const int quadIndices[6] = {0, 1, 2, 0, 2, 3};
+    for (int i=0;i<6;i++){
+        indices.push_back(first+quadIndices[i]);
+    }
+}
+
+bool expect(const OcclusionCuller &culler, const char *name, const glm::vec3 &center, float size, bool occluded){
+    glm::vec3 extent(size*0.5f);
+    bool res = culler.IsOccluded(Bounds(center-extent, center+extent));
+    cout << name << ": "<<(res?"occluded":"visible")<<endl;
+    if (res != occluded){
+        cout << "Error: expected "<<(occluded?"occluded":"visible")<<endl;
+        return false;
+    }
+    return true;
+}
+
+/// Returns true if the segment from the eye (origin) to the point passes the
+/// plane z = -10 inside the square of the wall
+bool behindWall(const glm::vec3 &point, float wallSize){
+    if (point.z >= -10){
+        return false;
+    }
+    glm::vec3 hit = point*(-10.0f/point.z);
+    return fabs(hit.x) <= wallSize && fabs(hit.y) <= wallSize;
+}
+
+/// Test random boxes against the wall. Returns the number of boxes occluded
+/// by mistake (the wall is enlarged by a pixel to allow for the sampling at
+/// pixel centers)
+int countFalseOcclusion(const OcclusionCuller &culler, int boxCount, int &outOccluded, int &outHidden){
+    int mistakes = 0;
+    outOccluded = 0;
+    outHidden = 0;
+    for (int i=0;i<boxCount;i++){
+        glm::vec3 center(randomFloat(-12, 12), randomFloat(-8, 8), randomFloat(-40, -5));
+        glm::vec3 extent(randomFloat(0.1f, 2), randomFloat(0.1f, 2), randomFloat(0.1f, 2));
+        bool hidden = true;
+        for (int j=0;j<8 && hidden;j++){
+            glm::vec3 corner(center.x+((j&1)?extent.x:-extent.x), center.y+((j&2)?extent.y:-extent.y),
+                    center.z+((j&4)?extent.z:-extent.z));
+            hidden = behindWall(corner, 2.1f);
+        }
+        bool occluded = culler.IsOccluded(Bounds(center-extent, center+extent));
+        if (occluded){
+            outOccluded++;
+            if (!hidden){
+                mistakes++;
+            }
+        }
+        if (hidden && behindWall(center, 2.0f)){
+            outHidden++;
+        }
+    }
+    return mistakes;
+}
+
+int main(int argc, char **argv) {
+    int gridSize = argc<2 ? 128 : atoi(argv[1]);
+    srand(1);
+    glm::mat4 projection = frustumMatrix(-0.5f, 0.5f, -0.3f, 0.3f, 0.5f, 100.0f);
+    bool ok = true;
+    OcclusionCuller culler;
+
+    // a wall in front of the camera (looking along -z)
+    vector<glm::vec3> vertices;
+    vector<int> indices;
+    createQuad(glm::vec3(-2, -2, -10), glm::vec3(2, -2, -10), glm::vec3(2, 2, -10), glm::vec3(-2, 2, -10),
+            vertices, indices);
+    culler.Begin(projection);
+    culler.AddOccluder(glm::mat4(1.0f), &vertices[0], &indices[0], indices.size());
+    culler.Rasterize();
+    ok &= expect(culler, "Box behind wall", glm::vec3(0, 0, -20), 2, true);
+    ok &= expect(culler, "Box in front of wall", glm::vec3(0, 0, -5), 1, false);
+    ok &= expect(culler, "Box beside wall", glm::vec3(8, 0, -20), 2, false);
+    ok &= expect(culler, "Box partially behind wall", glm::vec3(3.5f, 0, -20), 2, false);
+    ok &= expect(culler, "Box intersecting wall", glm::vec3(0, 0, -10), 1, false);
+    ok &= expect(culler, "Box behind camera", glm::vec3(0, 0, 5), 1, false);
+    int occluded;
+    int hidden;
+    int mistakes = countFalseOcclusion(culler, 20000, occluded, hidden);
+    cout << "Random boxes: "<<occluded<<" occluded ("<<hidden<<" with the center hidden), "
+            <<mistakes<<" visible boxes occluded"<<endl;
+    if (mistakes > 0 || occluded == 0){
+        cout << "Error: visible boxes occluded"<<endl;
+        ok = false;
+    }
+
+    // a sloped wall covering the view which crosses the near plane (must be
+    // clipped, not dropped)
+    vertices.clear();
+    indices.clear();
+    createQuad(glm::vec3(-100, -100, -30), glm::vec3(100, -100, -30), glm::vec3(100, 100, 10),
+            glm::vec3(-100, 100, 10), vertices, indices);
+    culler.Begin(projection);
+    culler.AddOccluder(glm::mat4(1.0f), &vertices[0], &indices[0], indices.size());
+    culler.Rasterize();
+    ok &= expect(culler, "Box behind wall crossing near plane", glm::vec3(0, 0, -40), 2, true);
+    ok &= expect(culler, "Box in front of wall crossing near plane", glm::vec3(0, 0, -5), 2, false);
+
+    // benchmark: a grid of gridSize x gridSize quads with random depths at
+    // the corners (closed, so the grid hides everything behind it)
+    vertices.clear();
+    indices.clear();
+    for (int y=0;y<=gridSize;y++){
+        for (int x=0;x<=gridSize;x++){
+            vertices.push_back(glm::vec3(-12+24.0f*x/gridSize, -7+14.0f*y/gridSize, randomFloat(-22, -18)));
+        }
+    }
+    for (int y=0;y<gridSize;y++){
+        for (int x=0;x<gridSize;x++){
+            int corner = y*(gridSize+1)+x;
+            const int quadIndices[6] = {corner, corner+1, corner+gridSize+2,
+                    corner, corner+gridSize+2, corner+gridSize+1};
+            indices.insert(indices.end(), quadIndices, quadIndices+6);
+        }
+    }
+    const int iterations = 100;
+    clock_t start = clock();
+    for (int i=0;i<iterations;i++){
+        glm::mat4 model(1.0f);
+        model[3][0] = i*0.001f;
+        culler.Begin(projection);
+        culler.AddOccluder(model, &vertices[0], &indices[0], indices.size());
+        culler.Rasterize();
+    }
+    double milliseconds = (clock()-start)*1000.0/CLOCKS_PER_SEC/iterations;
+    cout << "Rasterize: "<<milliseconds<<" ms processor time per camera ("<<culler.GetTriangleCount()
+            <<" triangles, "<<OCCLUSION_BUFFER_WIDTH<<"x"<<OCCLUSION_BUFFER_HEIGHT<<" pixels)"<<endl;
+    const int boxCount = 100000;
+    vector<Bounds> boxes;
+    for (int i=0;i<boxCount;i++){
+        glm::vec3 center(randomFloat(-30, 30), randomFloat(-20, 20), randomFloat(-60, -5));
+        glm::vec3 extent(randomFloat(0.1f, 2), randomFloat(0.1f, 2), randomFloat(0.1f, 2));
+        boxes.push_back(Bounds(center-extent, center+extent));
+    }
+    start = clock();
+    int occludedBoxes = 0;
+    for (int i=0;i<boxCount;i++){
+        if (culler.IsOccluded(boxes[i])){
+            occludedBoxes++;
+        }
+    }
+    milliseconds = (clock()-start)*1000.0/CLOCKS_PER_SEC;
+    cout << "IsOccluded: "<<milliseconds<<" ms for "<<boxCount<<" boxes ("<<occludedBoxes<<" occluded)"<<endl;
+
+    if (!ok){
+        return EXIT_FAILURE;
+    }
+    cout << "Occlusion culling ok"<<endl;
+    return EXIT_SUCCESS;
+}